@@ -1,257 +1,355 @@
-__constant sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP | CLK_FILTER_NEAREST;
-
-float getPixelAsFloat(__read_only image2d_t image, int2 pos) {
-    float value;
-    int dataType = get_image_channel_data_type(image);
-    if(dataType == CLK_FLOAT) {
-        value = read_imagef(image, sampler, pos).x;
-    } else if(dataType == CLK_UNSIGNED_INT8 || dataType == CLK_UNSIGNED_INT16) {
-        value = read_imageui(image, sampler, pos).x;
-    } else {
-        value = read_imagei(image, sampler, pos).x;
-    }
-    return value;
+// BLOCK_SIZE and SEARCH_SIZE are half sizes. BLOCK_SIZE_Z and SEARCH_SIZE_Z are 0 for 2D images.
+// METRIC is 0 for normalized cross correlation, 1 for sum of squared differences and 2 for sum of absolute differences.
+// All metrics are turned into costs which are minimized.
+// Displacements are stored as DIMENSIONS floats per pixel, and point from a pixel in the current frame to
+// the matching block in the previous frame.
+
+#define BLOCK_VOXELS ((BLOCK_SIZE*2+1)*(BLOCK_SIZE*2+1)*(BLOCK_SIZE_Z*2+1))
+
+__kernel void convertToFloat(
+        __global const INPUT_TYPE* input,
+        __global float* output,
+        __private const int channels
+    ) {
+    const int i = get_global_id(0);
+    output[i] = (float)input[i*channels];
 }
 
-float calculateMeanIntensity(__read_only image2d_t frame, int2 pos) {
-    float mean = 0.0f;
-    for(int y = pos.y - BLOCK_SIZE; y <= pos.y + BLOCK_SIZE; ++y) {
-        for(int x = pos.x - BLOCK_SIZE; x <= pos.x + BLOCK_SIZE; ++x) {
-            mean += getPixelAsFloat(frame, (int2)(x,y));
+__kernel void downsample(
+        __global const float* input,
+        __global float* output,
+        __private const int width,
+        __private const int height,
+        __private const int depth
+    ) {
+    const int x = get_global_id(0);
+    const int y = get_global_id(1);
+    const int z = get_global_id(2);
+    float sum = 0.0f;
+    int count = 0;
+    for(int c = z*2; c < min(z*2 + 2, depth); ++c) {
+        for(int b = y*2; b < min(y*2 + 2, height); ++b) {
+            for(int a = x*2; a < min(x*2 + 2, width); ++a) {
+                sum += input[a + (b + c*height)*width];
+                ++count;
+            }
         }
     }
+    output[x + (y + z*get_global_size(1))*get_global_size(0)] = sum / count;
+}
 
-    return mean/((BLOCK_SIZE*2+1)*(BLOCK_SIZE*2+1));
+inline float readClamped(__global const float* image, const int3 pos, const int3 size) {
+    const int3 p = clamp(pos, (int3)(0, 0, 0), size - 1);
+    return image[p.x + (p.y + p.z*size.y)*size.x];
 }
 
+inline void accumulate(const float previous, const float current, float4* sums) {
+#if METRIC == 0
+    sums->x += previous;
+    sums->y += previous*previous;
+    sums->z += previous*current;
+#elif METRIC == 1
+    sums->x += (previous - current)*(previous - current);
+#else
+    sums->x += fabs(previous - current);
+#endif
+}
 
-inline float2 findSubpixelMovement(const float2 movement, const float b[GRID_SIZE][GRID_SIZE]) {
-    const int index_x = (int)movement.x + SEARCH_SIZE+1;
-    const int index_y = (int)movement.y + SEARCH_SIZE+1;
-    // Subpixel parabolic fitting
-    const float A =
-            (b[index_x-1][index_y-1] - 2 * b[index_x][index_y-1] + b[index_x+1][index_y-1] + b[index_x-1][index_y] - 2 * b[index_x][index_y] + b[index_x+1][index_y] + b[index_x-1][index_y+1] - 2 * b[index_x][index_y+1] +
-             b[index_x+1][index_y+1]) / 6.0;
-    const float B = (b[index_x-1][index_y-1] - b[index_x+1][index_y-1] - b[index_x-1][index_y+1] + b[index_x+1][index_y+1]) / 4.0;
-    const float C =
-            (b[index_x-1][index_y-1] + b[index_x][index_y-1] + b[index_x+1][index_y-1] - 2 * b[index_x-1][index_y] - 2 * b[index_x][index_y] - 2 * b[index_x+1][index_y] + b[index_x-1][index_y+1] + b[index_x][index_y+1] +
-             b[index_x+1][index_y+1]) / 6.0;
-    const float D = (-b[index_x-1][index_y-1] + b[index_x+1][index_y-1] - b[index_x-1][index_y] + b[index_x+1][index_y] - b[index_x-1][index_y+1] + b[index_x+1][index_y+1]) / 6.0;
-    const float E = (-b[index_x-1][index_y-1] - b[index_x][index_y-1] - b[index_x+1][index_y-1] + b[index_x-1][index_y+1] + b[index_x][index_y+1] + b[index_x+1][index_y+1]) / 6.0;
-    const float F = (-b[index_x-1][index_y-1] + 2 * b[index_x][index_y-1] - b[index_x+1][index_y-1] + 2 * b[index_x-1][index_y] + 5 * b[index_x][index_y] + 2 * b[index_x+1][index_y] - b[index_x-1][index_y+1] +
-                    2 * b[index_x][index_y+1] - b[index_x+1][index_y+1]) / 9.0;
+/**
+ * The target statistics are the mean and the sum of squared deviations from the mean of the target block
+ */
+inline float getCost(const float4 sums, const float2 target) {
+#if METRIC == 0
+    const float mean = sums.x / BLOCK_VOXELS;
+    const float numerator = sums.z - sums.x*target.x;
+    const float denominator = sqrt((sums.y - sums.x*mean)*target.y);
+    return denominator > 0.0f ? -numerator/denominator : 0.0f;
+#else
+    return sums.x / BLOCK_VOXELS;
+#endif
+}
 
-    return (float2)(movement.x + (B * E - 2.0 * C * D) / (4.0 * A * C - B * B),
-                    movement.y + (B * D - 2.0 * A * E) / (4.0 * A * C - B * B));
+inline float2 getTargetStatistics(const float sum, const float squaredSum) {
+    const float mean = sum / BLOCK_VOXELS;
+    return (float2)(mean, squaredSum - sum*mean);
 }
 
-inline float2 findMovementNCC(
-        __read_only image2d_t previousFrame,
-        __read_only image2d_t currentFrame,
-        const int2 pos,
-        float targetMean
-        ) {
-    // Create grid for subpixel movement calculations
-    float b[GRID_SIZE][GRID_SIZE];
+/**
+ * Sub-pixel offset of the minimum of a parabola through three equally spaced costs
+ */
+inline float getSubpixelOffset(const float minus, const float center, const float plus) {
+    const float denominator = minus - 2.0f*center + plus;
+    if(denominator <= 0.0f)
+        return 0.0f;
+    return clamp(0.5f*(minus - plus)/denominator, -0.5f, 0.5f);
+}
 
-    // For every possible block position
-    float bestScore = -1.0f;
-    float2 movement = {0, 0};
-    for(int y = pos.y - SEARCH_SIZE - 1; y <= pos.y + SEARCH_SIZE + 1; ++y)  {
-        for(int x = pos.x - SEARCH_SIZE - 1; x <= pos.x + SEARCH_SIZE + 1; ++x)  {
-            // previousframe at pos x,y is the current candidate
-            const float candidateMean = calculateMeanIntensity(previousFrame, (int2)(x, y));
-            float upperPart = 0.0f;
-            float lowerPart1 = 0.0f;
-            float lowerPart2 = 0.0f;
-            // Loop over target and candidate block
-            for(int a = -BLOCK_SIZE; a <= BLOCK_SIZE; ++a) {
-                for(int b = -BLOCK_SIZE; b <= BLOCK_SIZE; ++b) {
-                    const float imagePart = getPixelAsFloat(previousFrame, (int2)(x+a, y+b)) - candidateMean;
-                    const float targetPart = getPixelAsFloat(currentFrame, (int2)(pos.x+a, pos.y+b)) - targetMean;
-                    upperPart += imagePart*targetPart;
-                    lowerPart1 += imagePart*imagePart;
-                    lowerPart2 += targetPart*targetPart;
-                }
-            }
+/**
+ * Displacement at a position, predicted by the displacement of the coarser pyramid level
+ */
+inline int3 getPrediction(__global const float* predictor, const int3 pos, const int3 predictorSize) {
+    const int3 p = min(pos / 2, predictorSize - 1);
+    const int i = (p.x + (p.y + p.z*predictorSize.y)*predictorSize.x)*DIMENSIONS;
+#if DIMENSIONS == 3
+    const float3 displacement = (float3)(predictor[i], predictor[i + 1], predictor[i + 2]);
+#else
+    const float3 displacement = (float3)(predictor[i], predictor[i + 1], 0.0f);
+#endif
+    return convert_int3_rte(displacement*2.0f);
+}
 
-            const float result = upperPart / sqrt(lowerPart1*lowerPart2);
-            b[x- pos.x + SEARCH_SIZE + 1][y - pos.y + SEARCH_SIZE + 1] = result;
-            if(result > bestScore && abs(x - pos.x) <= SEARCH_SIZE && abs(y - pos.y) <= SEARCH_SIZE) {
-                bestScore = result;
-                movement = (float2)(x - pos.x, y - pos.y); // Movement is the offset from pos.x, pos.y
+inline void writeDisplacement(__global float* displacement, const int3 pos, const int3 size, const float3 value) {
+    const int i = (pos.x + (pos.y + pos.z*size.y)*size.x)*DIMENSIONS;
+    displacement[i] = value.x;
+    displacement[i + 1] = value.y;
+#if DIMENSIONS == 3
+    displacement[i + 2] = value.z;
+#endif
+}
+
+inline float blockCost(
+        __global const float* previous,
+        __global const float* current,
+        const int3 candidate,
+        const int3 target,
+        const int3 size,
+        const float2 targetStatistics
+    ) {
+    float4 sums = (float4)(0.0f);
+    for(int c = -BLOCK_SIZE_Z; c <= BLOCK_SIZE_Z; ++c) {
+        for(int b = -BLOCK_SIZE; b <= BLOCK_SIZE; ++b) {
+            for(int a = -BLOCK_SIZE; a <= BLOCK_SIZE; ++a) {
+                const int3 offset = (int3)(a, b, c);
+                accumulate(readClamped(previous, candidate + offset, size), readClamped(current, target + offset, size), &sums);
             }
         }
     }
-
-    float2 subpixel_movement = findSubpixelMovement(movement, b);
-    return subpixel_movement;
+    return getCost(sums, targetStatistics);
 }
 
-__kernel void normalizedCrossCorrelation(
-        __read_only image2d_t previousFrame,
-        __read_only image2d_t currentFrame,
-        __write_only image2d_t output,
-        __private const float intensityThreshold,
-        __private const float timeLag,
-        __private const char forwardBackward
+/**
+ * Block matching of 2D and 3D images reading directly from global memory.
+ * Searches SEARCH_SIZE pixels around the displacement predicted by the coarser level, if any.
+ */
+__kernel void matchBlocks(
+        __global const float* previous,
+        __global const float* current,
+        __global const float* predictor,
+        __global float* displacement,
+        __private const int usePredictor,
+        __private const int width,
+        __private const int height,
+        __private const int depth,
+        __private const int predictorWidth,
+        __private const int predictorHeight,
+        __private const int predictorDepth,
+        __private const float intensityThreshold
     ) {
-    const int2 pos = {get_global_id(0), get_global_id(1)};
+    const int3 pos = {get_global_id(0), get_global_id(1), get_global_id(2)};
+    const int3 size = {width, height, depth};
 
     // Template is what we are looking for (target), currentFrame at pos
-    const float targetMean = calculateMeanIntensity(currentFrame, pos);
-    if(targetMean < intensityThreshold) { // if target is all zero/black, just stop here
-        write_imagef(output, pos, (float4)(0, 0, 0, 0));
-        return;
+    float sum = 0.0f;
+    float squaredSum = 0.0f;
+    for(int c = -BLOCK_SIZE_Z; c <= BLOCK_SIZE_Z; ++c) {
+        for(int b = -BLOCK_SIZE; b <= BLOCK_SIZE; ++b) {
+            for(int a = -BLOCK_SIZE; a <= BLOCK_SIZE; ++a) {
+                const float value = readClamped(current, pos + (int3)(a, b, c), size);
+                sum += value;
+                squaredSum += value*value;
+            }
+        }
     }
-
-    float2 movement = findMovementNCC(previousFrame, currentFrame, pos, targetMean);
-    if(forwardBackward == 1) {
-      const float targetMean2 = calculateMeanIntensity(previousFrame, pos);
-      movement = (movement - findMovementNCC(currentFrame, previousFrame, pos, targetMean2))*0.5f;
+    const float2 targetStatistics = getTargetStatistics(sum, squaredSum);
+    if(targetStatistics.x < intensityThreshold) { // if target is all zero/black, just stop here
+        writeDisplacement(displacement, pos, size, (float3)(0.0f));
+        return;
     }
 
-    // If movement is larger than SEARCH_SIZE, zero it out
-    if(length(movement) > SEARCH_SIZE + 1)
-        movement = (float2)(0,0);
-
-    write_imagef(output, pos, movement.xyyy / timeLag);
-}
-
-inline float2 findMovementSSD(
-        __read_only image2d_t previousFrame,
-        __read_only image2d_t currentFrame,
-        const int2 pos,
-        float minIntensity,
-        float maxIntensity
-        ) {
-    // Create grid for subpixel movement calculations
-    float b[GRID_SIZE][GRID_SIZE];
-
-    // For every possible block position
-    float bestScore = 0.0f;
-    float2 movement = {0, 0};
-    for(int y = pos.y - SEARCH_SIZE - 1; y <= pos.y + SEARCH_SIZE + 1; ++y)  {
-        for(int x = pos.x - SEARCH_SIZE - 1; x <= pos.x + SEARCH_SIZE + 1; ++x)  {
-            // previousframe at pos x,y is the current candidate
-            float ssd = 0.0f;
-            // Loop over target and candidate block
-            for(int a = -BLOCK_SIZE; a <= BLOCK_SIZE; ++a) {
-                for(int b = -BLOCK_SIZE; b <= BLOCK_SIZE; ++b) {
-                    float val = (getPixelAsFloat(previousFrame, (int2)(x+a,y+b)) - minIntensity)/(maxIntensity - minIntensity) -
-                            (getPixelAsFloat(currentFrame, (int2)(pos.x+a,pos.y+b)) - minIntensity)/(maxIntensity - minIntensity);
-                    ssd += val*val;
+    int3 center = pos;
+    if(usePredictor == 1)
+        center += getPrediction(predictor, pos, (int3)(predictorWidth, predictorHeight, predictorDepth));
+
+    float bestCost = INFINITY;
+    int3 best = center;
+    for(int z = -SEARCH_SIZE_Z; z <= SEARCH_SIZE_Z; ++z) {
+        for(int y = -SEARCH_SIZE; y <= SEARCH_SIZE; ++y) {
+            for(int x = -SEARCH_SIZE; x <= SEARCH_SIZE; ++x) {
+                const float cost = blockCost(previous, current, center + (int3)(x, y, z), pos, size, targetStatistics);
+                if(cost < bestCost) {
+                    bestCost = cost;
+                    best = center + (int3)(x, y, z);
                 }
             }
+        }
+    }
 
-            const float result = 1.0f - (ssd/((BLOCK_SIZE*2+1)*(BLOCK_SIZE*2+1))); // calculate average and invert
+    // Sub-pixel refinement along each axis
+    float3 movement = convert_float3(best - pos);
+    movement.x += getSubpixelOffset(
+            blockCost(previous, current, best - (int3)(1, 0, 0), pos, size, targetStatistics),
+            bestCost,
+            blockCost(previous, current, best + (int3)(1, 0, 0), pos, size, targetStatistics));
+    movement.y += getSubpixelOffset(
+            blockCost(previous, current, best - (int3)(0, 1, 0), pos, size, targetStatistics),
+            bestCost,
+            blockCost(previous, current, best + (int3)(0, 1, 0), pos, size, targetStatistics));
+#if DIMENSIONS == 3
+    movement.z += getSubpixelOffset(
+            blockCost(previous, current, best - (int3)(0, 0, 1), pos, size, targetStatistics),
+            bestCost,
+            blockCost(previous, current, best + (int3)(0, 0, 1), pos, size, targetStatistics));
+#endif
+
+    writeDisplacement(displacement, pos, size, movement);
+}
 
-            b[x- pos.x + SEARCH_SIZE + 1][y - pos.y + SEARCH_SIZE + 1] = result;
-            if(result > bestScore && abs(x - pos.x) <= SEARCH_SIZE && abs(y - pos.y) <= SEARCH_SIZE) {
-                bestScore = result;
-                movement = (float2)(x - pos.x, y - pos.y); // Movement is the offset from pos.x, pos.y
-            }
-        }
+#ifdef TILE_SIZE
+// Search region of the previous frame for a tile, including the pixels needed for sub-pixel refinement
+#define PREVIOUS_TILE_SIZE (TILE_SIZE + 2*(SEARCH_SIZE + 1 + BLOCK_SIZE))
+#define CURRENT_TILE_SIZE (TILE_SIZE + 2*BLOCK_SIZE)
+
+inline float blockCostLocal(
+        __local const float* previousTile,
+        __local const float* currentTile,
+        const int2 candidate,
+        const int2 target,
+        const float2 targetStatistics
+    ) {
+    float4 sums = (float4)(0.0f);
+    for(int b = -BLOCK_SIZE; b <= BLOCK_SIZE; ++b) {
+        __local const float* previousRow = &previousTile[(candidate.y + b)*PREVIOUS_TILE_SIZE + candidate.x];
+        __local const float* currentRow = &currentTile[(target.y + b)*CURRENT_TILE_SIZE + target.x];
+        for(int a = -BLOCK_SIZE; a <= BLOCK_SIZE; ++a)
+            accumulate(previousRow[a], currentRow[a], &sums);
     }
-    float2 subpixel_movement = findSubpixelMovement(movement, b);
-    return subpixel_movement;
+    return getCost(sums, targetStatistics);
 }
 
-__kernel void sumOfSquaredDifferences(
-        __read_only image2d_t previousFrame,
-        __read_only image2d_t currentFrame,
-        __write_only image2d_t output,
-        __private const float intensityThreshold,
-        __private const float timeLag,
-        __private const char forwardBackward,
-        __private const float minIntensity,
-        __private const float maxIntensity
-) {
+/**
+ * 2D block matching where each work group of TILE_SIZE x TILE_SIZE pixels first loads its target blocks and
+ * search region into local memory, instead of reading each pixel once per search offset.
+ * All pixels in the work group search around the displacement predicted for the center of the work group.
+ */
+__kernel void matchBlocksTiled(
+        __global const float* previous,
+        __global const float* current,
+        __global const float* predictor,
+        __global float* displacement,
+        __private const int usePredictor,
+        __private const int width,
+        __private const int height,
+        __private const int regionEndX,
+        __private const int regionEndY,
+        __private const int predictorWidth,
+        __private const int predictorHeight,
+        __private const float intensityThreshold
+    ) {
+    __local float previousTile[PREVIOUS_TILE_SIZE*PREVIOUS_TILE_SIZE];
+    __local float currentTile[CURRENT_TILE_SIZE*CURRENT_TILE_SIZE];
     const int2 pos = {get_global_id(0), get_global_id(1)};
+    const int2 localPos = {get_local_id(0), get_local_id(1)};
+    const int2 groupOrigin = pos - localPos;
+    const int3 size = {width, height, 1};
+
+    int2 prediction = (int2)(0, 0);
+    if(usePredictor == 1) {
+        const int2 groupCenter = min(groupOrigin + TILE_SIZE/2, (int2)(width - 1, height - 1));
+        prediction = getPrediction(predictor, (int3)(groupCenter, 0), (int3)(predictorWidth, predictorHeight, 1)).xy;
+    }
+
+    // Load tiles cooperatively
+    const int localId = localPos.x + localPos.y*TILE_SIZE;
+    const int2 previousOrigin = groupOrigin + prediction - (SEARCH_SIZE + 1 + BLOCK_SIZE);
+    for(int i = localId; i < PREVIOUS_TILE_SIZE*PREVIOUS_TILE_SIZE; i += TILE_SIZE*TILE_SIZE) {
+        const int2 p = previousOrigin + (int2)(i % PREVIOUS_TILE_SIZE, i / PREVIOUS_TILE_SIZE);
+        previousTile[i] = readClamped(previous, (int3)(p, 0), size);
+    }
+    const int2 currentOrigin = groupOrigin - BLOCK_SIZE;
+    for(int i = localId; i < CURRENT_TILE_SIZE*CURRENT_TILE_SIZE; i += TILE_SIZE*TILE_SIZE) {
+        const int2 p = currentOrigin + (int2)(i % CURRENT_TILE_SIZE, i / CURRENT_TILE_SIZE);
+        currentTile[i] = readClamped(current, (int3)(p, 0), size);
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+    // Work groups are rounded up, skip pixels outside the region (which is at most the entire image)
+    if(pos.x >= regionEndX || pos.y >= regionEndY)
+        return;
 
     // Template is what we are looking for (target), currentFrame at pos
-    const float targetMean = calculateMeanIntensity(currentFrame, pos);
-    if(targetMean < intensityThreshold) { // if target is all zero/black, just stop here
-        write_imagef(output, pos, (float4)(0, 0, 0, 0));
+    const int2 target = localPos + BLOCK_SIZE;
+    float sum = 0.0f;
+    float squaredSum = 0.0f;
+    for(int b = -BLOCK_SIZE; b <= BLOCK_SIZE; ++b) {
+        for(int a = -BLOCK_SIZE; a <= BLOCK_SIZE; ++a) {
+            const float value = currentTile[(target.y + b)*CURRENT_TILE_SIZE + target.x + a];
+            sum += value;
+            squaredSum += value*value;
+        }
+    }
+    const float2 targetStatistics = getTargetStatistics(sum, squaredSum);
+    if(targetStatistics.x < intensityThreshold) { // if target is all zero/black, just stop here
+        writeDisplacement(displacement, (int3)(pos, 0), size, (float3)(0.0f));
         return;
     }
 
-    float2 movement = findMovementSSD(previousFrame, currentFrame, pos, minIntensity, maxIntensity);
-    if(forwardBackward == 1)
-      movement = (movement - findMovementSSD(currentFrame, previousFrame, pos, minIntensity, maxIntensity))*0.5f;
-
-    // If movement is larger than SEARCH_SIZE, zero it out
-    if(length(movement) > SEARCH_SIZE + 1)
-        movement = (float2)(0,0);
-
-    write_imagef(output, pos, movement.xyyy / timeLag);
-}
-
-inline float2 findMovementSAD(
-        __read_only image2d_t previousFrame,
-        __read_only image2d_t currentFrame,
-        const int2 pos,
-        float minIntensity,
-        float maxIntensity
-        ) {
-    // Create grid for subpixel movement calculations
-    float b[GRID_SIZE][GRID_SIZE];
-
-    // For every possible block position
-    float bestScore = 0.0f;
-    float2 movement = {0, 0};
-    for(int y = pos.y - SEARCH_SIZE - 1; y <= pos.y + SEARCH_SIZE + 1; ++y)  {
-        for(int x = pos.x - SEARCH_SIZE - 1; x <= pos.x + SEARCH_SIZE + 1; ++x)  {
-            // previousframe at pos x,y is the current candidate
-            float sad = 0.0f;
-            // Loop over target and candidate block
-            for(int a = -BLOCK_SIZE; a <= BLOCK_SIZE; ++a) {
-                for(int b = -BLOCK_SIZE; b <= BLOCK_SIZE; ++b) {
-                    sad += fabs((getPixelAsFloat(previousFrame, (int2)(x+a,y+b)) - minIntensity)/(maxIntensity - minIntensity) -
-                            (getPixelAsFloat(currentFrame, (int2)(pos.x+a,pos.y+b)) - minIntensity)/(maxIntensity - minIntensity));
-                }
-            }
-
-            const float result = 1.0f - (sad/((BLOCK_SIZE*2+1)*(BLOCK_SIZE*2+1))); // calculate average and invert
-
-            b[x- pos.x + SEARCH_SIZE + 1][y - pos.y + SEARCH_SIZE + 1] = result;
-            if(result > bestScore && abs(x - pos.x) <= SEARCH_SIZE && abs(y - pos.y) <= SEARCH_SIZE) {
-                bestScore = result;
-                movement = (float2)(x - pos.x, y - pos.y); // Movement is the offset from pos.x, pos.y
+    // Position of the predicted match in the previous tile
+    const int2 center = localPos + SEARCH_SIZE + 1 + BLOCK_SIZE;
+    float bestCost = INFINITY;
+    int2 best = center;
+    for(int y = -SEARCH_SIZE; y <= SEARCH_SIZE; ++y) {
+        for(int x = -SEARCH_SIZE; x <= SEARCH_SIZE; ++x) {
+            const float cost = blockCostLocal(previousTile, currentTile, center + (int2)(x, y), target, targetStatistics);
+            if(cost < bestCost) {
+                bestCost = cost;
+                best = center + (int2)(x, y);
             }
         }
     }
 
-    float2 subpixel_movement = findSubpixelMovement(movement, b);
-    return subpixel_movement;
+    // Sub-pixel refinement along each axis
+    float2 movement = convert_float2(best - center + prediction);
+    movement.x += getSubpixelOffset(
+            blockCostLocal(previousTile, currentTile, best - (int2)(1, 0), target, targetStatistics),
+            bestCost,
+            blockCostLocal(previousTile, currentTile, best + (int2)(1, 0), target, targetStatistics));
+    movement.y += getSubpixelOffset(
+            blockCostLocal(previousTile, currentTile, best - (int2)(0, 1), target, targetStatistics),
+            bestCost,
+            blockCostLocal(previousTile, currentTile, best + (int2)(0, 1), target, targetStatistics));
+
+    writeDisplacement(displacement, (int3)(pos, 0), size, (float3)(movement, 0.0f));
 }
+#endif
 
-__kernel void sumOfAbsoluteDifferences(
-        __read_only image2d_t previousFrame,
-        __read_only image2d_t currentFrame,
-        __write_only image2d_t output,
-        __private const float intensityThreshold,
-        __private const float timeLag,
+__kernel void combineDisplacements(
+        __global const float* forward,
+        __global const float* backward,
+        __global float* output,
         __private const char forwardBackward,
-        __private const float minIntensity,
-        __private const float maxIntensity
-) {
-    const int2 pos = {get_global_id(0), get_global_id(1)};
-
-    // Template is what we are looking for (target), currentFrame at pos
-    const float targetMean = calculateMeanIntensity(currentFrame, pos);
-    if(targetMean < intensityThreshold) { // if target is all zero/black, just stop here
-        write_imagef(output, pos, (float4)(0, 0, 0, 0));
-        return;
+        __private const float timeLag,
+        __private const float maxDisplacement
+    ) {
+    const int i = get_global_id(0)*DIMENSIONS;
+    float3 movement = (float3)(forward[i], forward[i + 1], 0.0f);
+#if DIMENSIONS == 3
+    movement.z = forward[i + 2];
+#endif
+    if(forwardBackward == 1) {
+        float3 backwardMovement = (float3)(backward[i], backward[i + 1], 0.0f);
+#if DIMENSIONS == 3
+        backwardMovement.z = backward[i + 2];
+#endif
+        movement = (movement - backwardMovement)*0.5f;
     }
 
-    float2 movement = findMovementSAD(previousFrame, currentFrame, pos, minIntensity, maxIntensity);
-    if(forwardBackward == 1)
-      movement = (movement - findMovementSAD(currentFrame, previousFrame, pos, minIntensity, maxIntensity))*0.5f;
-
-    // If movement is larger than SEARCH_SIZE, zero it out
-    if(length(movement) > SEARCH_SIZE + 1)
-        movement = (float2)(0,0);
+    // If movement is larger than what can be found, zero it out
+    if(length(movement) > maxDisplacement)
+        movement = (float3)(0.0f);
 
-    write_imagef(output, pos, movement.xyyy / timeLag);
+    movement /= timeLag;
+    output[i] = movement.x;
+    output[i + 1] = movement.y;
+#if DIMENSIONS == 3
+    output[i + 2] = movement.z;
+#endif
 }
@@ -10,6 +10,7 @@ void BlockMatching::loadAttributes() {
     setMatchingMetric(BlockMatching::stringToMetric(getStringAttribute("metric")));
     setTimeLag(getIntegerAttribute("time-lag"));
     setForwardBackwardTracking(getBooleanAttribute("forward-backward"));
+    setPyramidLevels(getIntegerAttribute("pyramid-levels"));
     auto roiOffset = getIntegerListAttribute("roi-offset");
     auto roiSize = getIntegerListAttribute("roi-size");
     if(roiOffset.size() == 2 && roiSize.size() == 2) {
@@ -30,76 +31,209 @@ BlockMatching::BlockMatching() {
     createFloatAttribute("intensity-threshold", "Intensity threshold", "Pixels with an intensity below this threshold will not be processed", m_intensityThreshold);
     createStringAttribute("metric", "Matching metric", "Possible values are SSD, SAD, and NCC", "SAD");
     createBooleanAttribute("forward-backward", "Forward-backward tracking", "Do tracking forward and backwards and take the average.", m_forwardBackward);
+    createIntegerAttribute("pyramid-levels", "Pyramid levels", "Number of resolution levels to search, starting at the coarsest level", m_pyramidLevels);
     createIntegerAttribute("roi-offset", "ROI offset", "Offset of region of interest (ROI)", 0);
     createIntegerAttribute("roi-size", "ROI size", "Size of region of interest (ROI), 0 0 means no ROI is used.", 0);
 }
 
-void BlockMatching::execute() {
-    auto currentFrame = getInputData<Image>(0);
+std::vector<cl::Buffer> BlockMatching::createPyramid(SharedPointer<Image> frame, OpenCLDevice::pointer device, cl::Program program) {
+    auto queue = device->getCommandQueue();
+    std::vector<cl::Buffer> pyramid;
 
-    std::map<MatchingMetric, std::string> kernelNames = {
-            {MatchingMetric::NORMALIZED_CROSS_CORRELATION, "normalizedCrossCorrelation"},
-            {MatchingMetric::SUM_OF_SQUARED_DIFFERENCES, "sumOfSquaredDifferences"},
-            {MatchingMetric::SUM_OF_ABSOLUTE_DIFFERENCES, "sumOfAbsoluteDifferences"},
-    };
+    const Vector3i size = m_levelSizes[0];
+    pyramid.emplace_back(device->getContext(), CL_MEM_READ_WRITE, (std::size_t)size.prod()*sizeof(float));
+    auto frameAccess = frame->getOpenCLBufferAccess(ACCESS_READ, device);
+    cl::Kernel convertKernel(program, "convertToFloat");
+    convertKernel.setArg(0, *frameAccess->get());
+    convertKernel.setArg(1, pyramid[0]);
+    convertKernel.setArg(2, (int)frame->getNrOfChannels());
+    queue.enqueueNDRangeKernel(
+        convertKernel,
+        cl::NullRange,
+        cl::NDRange(size.prod()),
+        cl::NullRange
+    );
 
-    if(currentFrame->getDimensions() != 2)
-        throw Exception("Block matching only implemented for 2D");
+    cl::Kernel downsampleKernel(program, "downsample");
+    for(int level = 1; level < m_levelSizes.size(); ++level) {
+        const Vector3i previousSize = m_levelSizes[level-1];
+        const Vector3i levelSize = m_levelSizes[level];
+        pyramid.emplace_back(device->getContext(), CL_MEM_READ_WRITE, (std::size_t)levelSize.prod()*sizeof(float));
+        downsampleKernel.setArg(0, pyramid[level-1]);
+        downsampleKernel.setArg(1, pyramid[level]);
+        downsampleKernel.setArg(2, previousSize.x());
+        downsampleKernel.setArg(3, previousSize.y());
+        downsampleKernel.setArg(4, previousSize.z());
+        queue.enqueueNDRangeKernel(
+            downsampleKernel,
+            cl::NullRange,
+            cl::NDRange(levelSize.x(), levelSize.y(), levelSize.z()),
+            cl::NullRange
+        );
+    }
+
+    return pyramid;
+}
+
+cl::Buffer BlockMatching::matchPyramids(const std::vector<cl::Buffer>& previous, const std::vector<cl::Buffer>& current, OpenCLDevice::pointer device, cl::Program program) {
+    auto queue = device->getCommandQueue();
+    cl::Buffer predictor;
+    Vector3i predictorSize = Vector3i::Zero();
+
+    // Coarse to fine, each level searches around the displacement found at the level above
+    for(int level = m_levelSizes.size() - 1; level >= 0; --level) {
+        const Vector3i size = m_levelSizes[level];
+        const std::size_t bytes = (std::size_t)size.prod()*m_dimensions*sizeof(float);
+        cl::Buffer displacement(device->getContext(), CL_MEM_READ_WRITE, bytes);
+
+        Vector3i offset = Vector3i::Zero();
+        Vector3i regionSize = size;
+        if(m_sizeROI != Vector2i::Zero()) {
+            // Pixels outside of the region of interest have no motion
+            queue.enqueueFillBuffer(displacement, 0.0f, 0, bytes);
+            const int scale = 1 << level;
+            const Vector2i start = m_offsetROI / scale;
+            const Vector2i end = ((m_offsetROI + m_sizeROI + Vector2i::Constant(scale - 1)) / scale).cwiseMin(Vector2i(size.x(), size.y()));
+            offset.head(2) = start;
+            regionSize.head(2) = (end - start).cwiseMax(0);
+        }
+
+        const bool usePredictor = predictorSize != Vector3i::Zero();
+        if(regionSize.prod() > 0) {
+            cl::Kernel kernel(program, m_tileSize > 0 ? "matchBlocksTiled" : "matchBlocks");
+            kernel.setArg(0, previous[level]);
+            kernel.setArg(1, current[level]);
+            kernel.setArg(2, usePredictor ? predictor : displacement);
+            kernel.setArg(3, displacement);
+            kernel.setArg(4, (int)(usePredictor ? 1 : 0));
+            if(m_tileSize > 0) {
+                kernel.setArg(5, size.x());
+                kernel.setArg(6, size.y());
+                kernel.setArg(7, offset.x() + regionSize.x());
+                kernel.setArg(8, offset.y() + regionSize.y());
+                kernel.setArg(9, predictorSize.x());
+                kernel.setArg(10, predictorSize.y());
+                kernel.setArg(11, m_intensityThreshold);
+                queue.enqueueNDRangeKernel(
+                    kernel,
+                    cl::NDRange(offset.x(), offset.y()),
+                    // Round up to whole work groups, the kernel skips pixels outside the region
+                    cl::NDRange((regionSize.x() + m_tileSize - 1) / m_tileSize * m_tileSize,
+                                (regionSize.y() + m_tileSize - 1) / m_tileSize * m_tileSize),
+                    cl::NDRange(m_tileSize, m_tileSize)
+                );
+            } else {
+                kernel.setArg(5, size.x());
+                kernel.setArg(6, size.y());
+                kernel.setArg(7, size.z());
+                kernel.setArg(8, predictorSize.x());
+                kernel.setArg(9, predictorSize.y());
+                kernel.setArg(10, predictorSize.z());
+                kernel.setArg(11, m_intensityThreshold);
+                queue.enqueueNDRangeKernel(
+                    kernel,
+                    cl::NDRange(offset.x(), offset.y(), offset.z()),
+                    cl::NDRange(regionSize.x(), regionSize.y(), regionSize.z()),
+                    cl::NullRange
+                );
+            }
+        }
+
+        predictor = displacement;
+        predictorSize = size;
+    }
+
+    return predictor;
+}
+
+void BlockMatching::execute() {
+    auto currentFrame = getInputData<Image>(0);
+    const int dimensions = currentFrame->getDimensions();
+    if(dimensions == 3 && m_sizeROI != Vector2i::Zero())
+        throw Exception("Region of interest is only supported for 2D block matching");
 
     auto device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
+    auto queue = device->getCommandQueue();
 
     auto output = getOutputData<Image>(0);
-    output->create(currentFrame->getSize(), TYPE_FLOAT, 2);
+    output->create(currentFrame->getSize(), TYPE_FLOAT, dimensions);
     output->setSpacing(currentFrame->getSpacing());
-    m_frameBuffer.push_back(currentFrame);
 
-    if(m_frameBuffer.size() < m_timeLag+1) {
-        // If previous frame is not available, just fill it with zeros and stop
-        output->fill(0);
-        return;
+    // Start over if the frame size has changed
+    const Vector3i size = currentFrame->getSize().cast<int>();
+    if(m_levelSizes.empty() || m_levelSizes[0] != size || m_dimensions != dimensions) {
+        m_frameBuffer.clear();
+        m_dimensions = dimensions;
+        m_levelSizes = {size};
+        for(int level = 1; level < m_pyramidLevels; ++level)
+            m_levelSizes.push_back((m_levelSizes.back() + Vector3i::Ones()) / 2);
     }
 
+    // Use local memory tiles in 2D if the search region of a work group fits
+    m_tileSize = 0;
+    if(dimensions == 2) {
+        const std::size_t localMemorySize = device->getDevice().getInfo<CL_DEVICE_LOCAL_MEM_SIZE>();
+        const std::size_t maxWorkGroupSize = device->getDevice().getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>();
+        for(int tileSize : {16, 8}) {
+            const int previousTileSize = tileSize + 2*(m_searchSizeHalf + 1 + m_blockSizeHalf);
+            const int currentTileSize = tileSize + 2*m_blockSizeHalf;
+            if(tileSize*tileSize <= maxWorkGroupSize &&
+                (previousTileSize*previousTileSize + currentTileSize*currentTileSize)*sizeof(float) <= localMemorySize) {
+                m_tileSize = tileSize;
+                break;
+            }
+        }
+    }
 
-    std::string buildOptions = "-DGRID_SIZE=" + std::to_string(m_searchSizeHalf*2 + 3) + " "
+    std::map<MatchingMetric, int> metrics = {
+            {MatchingMetric::NORMALIZED_CROSS_CORRELATION, 0},
+            {MatchingMetric::SUM_OF_SQUARED_DIFFERENCES, 1},
+            {MatchingMetric::SUM_OF_ABSOLUTE_DIFFERENCES, 2},
+    };
+    std::string buildOptions = "-DMETRIC=" + std::to_string(metrics.at(m_type)) + " "
+                               "-DDIMENSIONS=" + std::to_string(dimensions) + " "
+                               "-DINPUT_TYPE=" + getCTypeAsString(currentFrame->getDataType()) + " "
                                "-DBLOCK_SIZE=" + std::to_string(m_blockSizeHalf) + " "
-                               "-DSEARCH_SIZE=" + std::to_string(m_searchSizeHalf);
-    cl::Kernel kernel(getOpenCLProgram(device, "", buildOptions), kernelNames.at(m_type).c_str());
-    auto queue = device->getCommandQueue();
+                               "-DSEARCH_SIZE=" + std::to_string(m_searchSizeHalf) + " "
+                               "-DBLOCK_SIZE_Z=" + std::to_string(dimensions == 3 ? m_blockSizeHalf : 0) + " "
+                               "-DSEARCH_SIZE_Z=" + std::to_string(dimensions == 3 ? m_searchSizeHalf : 0);
+    if(m_tileSize > 0)
+        buildOptions += " -DTILE_SIZE=" + std::to_string(m_tileSize);
+    auto program = getOpenCLProgram(device, "", buildOptions);
 
-    if(m_type == MatchingMetric::SUM_OF_SQUARED_DIFFERENCES || m_type == MatchingMetric::SUM_OF_ABSOLUTE_DIFFERENCES) {
-        float max = currentFrame->calculateMaximumIntensity();
-        float min = currentFrame->calculateMinimumIntensity();
-        kernel.setArg(6, min);
-        kernel.setArg(7, max);
+    // Each frame is converted and downsampled once, and kept until it is no longer needed
+    m_frameBuffer.push_back(createPyramid(currentFrame, device, program));
+
+    if(m_frameBuffer.size() < m_timeLag+1) {
+        // If previous frame is not available, just fill it with zeros and stop
+        output->fill(0);
+        return;
     }
 
-    auto previousFrame = m_frameBuffer.front();
-    auto previousFrameAccess = previousFrame->getOpenCLImageAccess(ACCESS_READ, device);
-    auto currentFrameAccess = currentFrame->getOpenCLImageAccess(ACCESS_READ, device);
-    auto outputAccess = output->getOpenCLImageAccess(ACCESS_READ_WRITE, device);
+    const auto& previousFrame = m_frameBuffer.front();
+    const auto& currentFramePyramid = m_frameBuffer.back();
+    cl::Buffer forward = matchPyramids(previousFrame, currentFramePyramid, device, program);
+    cl::Buffer backward = forward;
+    if(m_forwardBackward)
+        backward = matchPyramids(currentFramePyramid, previousFrame, device, program);
 
-    kernel.setArg(0, *previousFrameAccess->get2DImage());
-    kernel.setArg(1, *currentFrameAccess->get2DImage());
-    kernel.setArg(2, *outputAccess->get2DImage());
-    kernel.setArg(3, m_intensityThreshold);
-    kernel.setArg(4, (float)m_timeLag);
-    kernel.setArg(5, (char)(m_forwardBackward ? 1 : 0));
+    // Largest displacement the search can find
+    const float maxDisplacement = m_searchSizeHalf*((1 << m_levelSizes.size()) - 1) + 1;
 
-    if(m_sizeROI == Vector2i::Zero()) {
-        queue.enqueueNDRangeKernel(
-            kernel,
-            cl::NullRange,
-            cl::NDRange(output->getWidth(), output->getHeight()),
-            cl::NullRange
-        );
-    } else {
-        queue.enqueueNDRangeKernel(
-            kernel,
-            cl::NDRange(m_offsetROI.x(), m_offsetROI.y()),
-            cl::NDRange(m_sizeROI.x(), m_sizeROI.y()),
-            cl::NullRange
-        );
-    }
+    auto outputAccess = output->getOpenCLBufferAccess(ACCESS_READ_WRITE, device);
+    cl::Kernel kernel(program, "combineDisplacements");
+    kernel.setArg(0, forward);
+    kernel.setArg(1, backward);
+    kernel.setArg(2, *outputAccess->get());
+    kernel.setArg(3, (char)(m_forwardBackward ? 1 : 0));
+    kernel.setArg(4, (float)m_timeLag);
+    kernel.setArg(5, maxDisplacement);
+    queue.enqueueNDRangeKernel(
+        kernel,
+        cl::NullRange,
+        cl::NDRange(size.prod()),
+        cl::NullRange
+    );
     queue.finish();
 
     m_frameBuffer.pop_front();
@@ -138,6 +272,16 @@ void BlockMatching::setForwardBackwardTracking(bool forwardBackward) {
     m_forwardBackward = forwardBackward;
 }
 
+void BlockMatching::setPyramidLevels(int levels) {
+    if(levels < 1)
+        throw Exception("Number of pyramid levels must be >= 1");
+
+    m_pyramidLevels = levels;
+    // Buffered frames must be downsampled again
+    m_levelSizes.clear();
+    m_frameBuffer.clear();
+}
+
 void BlockMatching::setRegionOfInterest(Vector2i offset, Vector2i size) {
     if(offset.x() < 0 || offset.y() < 0)
         throw Exception("Offset ROI must >= 0");
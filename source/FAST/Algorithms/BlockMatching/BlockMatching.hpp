@@ -8,8 +8,13 @@ namespace fast {
 class Image;
 
 /**
- * 2D block matching on the GPU. Input is a stream of input images, output is a stream of images
- * with 2 channels giving the x,y motion of each pixel.
+ * 2D and 3D block matching on the GPU. Input is a stream of input images, output is a stream of images
+ * with 2 or 3 channels giving the x,y(,z) motion of each pixel.
+ *
+ * With more than one pyramid level, the frames are downsampled by 2 for each level, and the search starts at the
+ * coarsest level. Each finer level searches around the motion found at the level above, thus motions up to
+ * (2^levels - 1) times the search size can be tracked at nearly the cost of a single level search.
+ * In 2D, blocks and search regions are loaded into local memory per work group of pixels, when they fit.
  */
 class FAST_EXPORT BlockMatching : public ProcessObject {
     FAST_OBJECT(BlockMatching)
@@ -70,10 +75,17 @@ class FAST_EXPORT BlockMatching : public ProcessObject {
          * @param size of the ROI in pixels
          */
         void setRegionOfInterest(Vector2i offset, Vector2i size);
+        /**
+         * Set number of resolution levels to search. 1 means that only the input resolution is searched. Default is 1.
+         * @param levels
+         */
+        void setPyramidLevels(int levels);
         void loadAttributes() override;
     private:
         BlockMatching();
         void execute() override;
+        std::vector<cl::Buffer> createPyramid(SharedPointer<Image> frame, OpenCLDevice::pointer device, cl::Program program);
+        cl::Buffer matchPyramids(const std::vector<cl::Buffer>& previous, const std::vector<cl::Buffer>& current, OpenCLDevice::pointer device, cl::Program program);
 
         MatchingMetric m_type = MatchingMetric::SUM_OF_ABSOLUTE_DIFFERENCES;
         int m_blockSizeHalf = 5;
@@ -83,7 +95,13 @@ class FAST_EXPORT BlockMatching : public ProcessObject {
         bool m_forwardBackward = false;
         Vector2i m_offsetROI = Vector2i::Zero();
         Vector2i m_sizeROI = Vector2i::Zero();
-        std::deque<SharedPointer<Image>> m_frameBuffer;
+        int m_pyramidLevels = 1;
+        int m_tileSize = 0;
+        int m_dimensions = 0;
+        // Size of each pyramid level
+        std::vector<Vector3i> m_levelSizes;
+        // Pyramid of each buffered frame, converted to float
+        std::deque<std::vector<cl::Buffer>> m_frameBuffer;
 
 };
 
@@ -4,6 +4,7 @@
 #include <FAST/Visualization/SimpleWindow.hpp>
 #include <FAST/Visualization/ImageRenderer/ImageRenderer.hpp>
 #include <FAST/Visualization/VectorFieldRenderer/VectorFieldRenderer.hpp>
+#include <random>
 
 using namespace fast;
 
@@ -34,3 +35,141 @@ TEST_CASE("Block matching 2D", "[fast][BlockMatching][visual]") {
     window->start();
     blockMatching->getRuntime()->print();
 }
+
+/**
+ * Create a smooth random texture, and a copy of it translated by the given motion
+ */
+static std::pair<Image::pointer, Image::pointer> createTranslatedFrames(Vector3i size, Vector3i motion) {
+    std::mt19937 engine(0);
+    std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+    std::vector<float> noise(size.prod());
+    for(auto& value : noise)
+        value = distribution(engine);
+    auto getNoise = [&](Vector3i pos) {
+        pos = pos.cwiseMax(0).cwiseMin(size - Vector3i::Ones());
+        return noise[pos.x() + (pos.y() + pos.z()*size.y())*size.x()];
+    };
+    std::vector<float> previous(size.prod());
+    std::vector<float> current(size.prod());
+    for(int z = 0; z < size.z(); ++z) {
+        for(int y = 0; y < size.y(); ++y) {
+            for(int x = 0; x < size.x(); ++x) {
+                const Vector3i pos(x, y, z);
+                const int i = x + (y + z*size.y())*size.x();
+                // Average of neighbors along x and y gives some texture correlation
+                auto texture = [&](Vector3i p) {
+                    return 100.0f*(getNoise(p) + getNoise(p + Vector3i(1, 0, 0)) + getNoise(p + Vector3i(0, 1, 0)));
+                };
+                previous[i] = texture(pos);
+                current[i] = texture(pos - motion);
+            }
+        }
+    }
+    auto previousFrame = Image::New();
+    auto currentFrame = Image::New();
+    if(size.z() > 1) {
+        previousFrame->create(size.x(), size.y(), size.z(), TYPE_FLOAT, 1, previous.data());
+        currentFrame->create(size.x(), size.y(), size.z(), TYPE_FLOAT, 1, current.data());
+    } else {
+        previousFrame->create(size.x(), size.y(), TYPE_FLOAT, 1, previous.data());
+        currentFrame->create(size.x(), size.y(), TYPE_FLOAT, 1, current.data());
+    }
+    return {previousFrame, currentFrame};
+}
+
+static void checkMotion(Image::pointer output, Vector3i motion, int margin) {
+    const int channels = output->getNrOfChannels();
+    auto access = output->getImageAccess(ACCESS_READ);
+    auto data = (const float*)access->get();
+    const Vector3i size = output->getSize().cast<int>();
+    int correct = 0;
+    int total = 0;
+    for(int z = channels == 3 ? margin : 0; z < (channels == 3 ? size.z() - margin : 1); ++z) {
+        for(int y = margin; y < size.y() - margin; ++y) {
+            for(int x = margin; x < size.x() - margin; ++x) {
+                const std::size_t i = x + (y + (std::size_t)z*size.y())*size.x();
+                // Motion points from the current frame to the matching block in the previous frame
+                bool isCorrect = true;
+                for(int c = 0; c < channels; ++c)
+                    isCorrect = isCorrect && std::fabs(data[i*channels + c] + motion[c]) < 0.5f;
+                if(isCorrect)
+                    ++correct;
+                ++total;
+            }
+        }
+    }
+    CHECK(correct > total*0.95);
+}
+
+TEST_CASE("Block matching with pyramid finds motion larger than search size in 2D", "[fast][BlockMatching]") {
+    const Vector3i motion(9, -6, 0);
+    auto frames = createTranslatedFrames(Vector3i(96, 80, 1), motion);
+    for(auto metric : {BlockMatching::MatchingMetric::NORMALIZED_CROSS_CORRELATION,
+                       BlockMatching::MatchingMetric::SUM_OF_SQUARED_DIFFERENCES,
+                       BlockMatching::MatchingMetric::SUM_OF_ABSOLUTE_DIFFERENCES}) {
+        auto blockMatching = BlockMatching::New();
+        blockMatching->setMatchingMetric(metric);
+        blockMatching->setBlockSize(9);
+        blockMatching->setSearchSize(5);
+        blockMatching->setPyramidLevels(3);
+        blockMatching->setInputData(frames.first);
+        blockMatching->update();
+        blockMatching->setInputData(frames.second);
+        auto output = blockMatching->updateAndGetOutputData<Image>();
+        REQUIRE(output->getNrOfChannels() == 2);
+        checkMotion(output, motion, 20);
+    }
+}
+
+TEST_CASE("Block matching with region of interest only estimates motion inside the region", "[fast][BlockMatching]") {
+    const Vector3i motion(2, -1, 0);
+    auto frames = createTranslatedFrames(Vector3i(96, 80, 1), motion);
+    // Region size is not a multiple of the work group size of the tiled kernel
+    const Vector2i offset(21, 17);
+    const Vector2i size(37, 29);
+    auto blockMatching = BlockMatching::New();
+    blockMatching->setBlockSize(5);
+    blockMatching->setSearchSize(5);
+    blockMatching->setRegionOfInterest(offset, size);
+    blockMatching->setInputData(frames.first);
+    blockMatching->update();
+    blockMatching->setInputData(frames.second);
+    auto output = blockMatching->updateAndGetOutputData<Image>();
+    REQUIRE(output->getNrOfChannels() == 2);
+
+    auto access = output->getImageAccess(ACCESS_READ);
+    auto data = (const float*)access->get();
+    const int width = output->getWidth();
+    int correct = 0;
+    int total = 0;
+    int outside = 0;
+    for(int y = 0; y < (int)output->getHeight(); ++y) {
+        for(int x = 0; x < width; ++x) {
+            const float* displacement = &data[(x + y*width)*2];
+            if(x >= offset.x() && x < offset.x() + size.x() && y >= offset.y() && y < offset.y() + size.y()) {
+                if(std::fabs(displacement[0] + motion.x()) < 0.5f && std::fabs(displacement[1] + motion.y()) < 0.5f)
+                    ++correct;
+                ++total;
+            } else if(displacement[0] != 0.0f || displacement[1] != 0.0f) {
+                ++outside;
+            }
+        }
+    }
+    CHECK(outside == 0);
+    CHECK(correct > total*0.95);
+}
+
+TEST_CASE("Block matching in 3D", "[fast][BlockMatching]") {
+    const Vector3i motion(3, -2, 4);
+    auto frames = createTranslatedFrames(Vector3i(32, 32, 32), motion);
+    auto blockMatching = BlockMatching::New();
+    blockMatching->setBlockSize(5);
+    blockMatching->setSearchSize(5);
+    blockMatching->setPyramidLevels(2);
+    blockMatching->setInputData(frames.first);
+    blockMatching->update();
+    blockMatching->setInputData(frames.second);
+    auto output = blockMatching->updateAndGetOutputData<Image>();
+    REQUIRE(output->getNrOfChannels() == 3);
+    checkMotion(output, motion, 10);
+}
@@ -2,6 +2,7 @@
 #include "FAST/Data/Segmentation.hpp"
 #include "FAST/Data/Mesh.hpp"
 #include "FAST/Utility.hpp"
+#include "FAST/Algorithms/DistanceTransform/DistanceTransform.hpp"
 #include <unordered_set>
 #include <stack>
 #include "FAST/Exporters/MetaImageExporter.hpp"
@@ -16,143 +17,6 @@ CenterlineExtraction::CenterlineExtraction() {
 	createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/CenterlineExtraction/CenterlineExtraction.cl");
 }
 
-Image::pointer CenterlineExtraction::calculateDistanceTransform(Image::pointer input) {
-	OpenCLDevice::pointer device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
-	cl::Program program = getOpenCLProgram(device);
-	cl::CommandQueue queue = device->getCommandQueue();
-	const int width = input->getWidth();
-	const int height = input->getHeight();
-	const int depth = input->getDepth();
-
-	Image::pointer distance = Image::New();
-	distance->create(input->getSize(), TYPE_INT16, 1);
-
-
-	// First initialize
-	cl::Kernel initializeKernel(program, "initialize");
-
-	if(device->isWritingTo3DTexturesSupported()) {
-		OpenCLImageAccess::pointer distanceAccess = distance->getOpenCLImageAccess(ACCESS_READ_WRITE, device);
-		OpenCLImageAccess::pointer inputAccess = input->getOpenCLImageAccess(ACCESS_READ, device);
-		initializeKernel.setArg(0, *inputAccess->get3DImage());
-		initializeKernel.setArg(1, *distanceAccess->get3DImage());
-	} else {
-		OpenCLImageAccess::pointer inputAccess = input->getOpenCLImageAccess(ACCESS_READ, device);
-		OpenCLBufferAccess::pointer distanceAccess = distance->getOpenCLBufferAccess(ACCESS_READ_WRITE, device);
-		initializeKernel.setArg(0, *inputAccess->get3DImage());
-		initializeKernel.setArg(1, *distanceAccess->get());
-	}
-
-	queue.enqueueNDRangeKernel(
-			initializeKernel,
-			cl::NullRange,
-			cl::NDRange(width, height, depth),
-			cl::NullRange
-    );
-
-	// Iteratively calculate distance
-	Image::pointer distance2 = Image::New();
-	distance2->create(input->getSize(), TYPE_INT16, 1);
-
-	cl::Buffer changedBuffer(
-			device->getContext(),
-			CL_MEM_READ_WRITE,
-			sizeof(char)
-    );
-
-	cl::Kernel distanceKernel(program, "calculateDistance");
-	distanceKernel.setArg(2, changedBuffer);
-	int counter = 0;
-	if(device->isWritingTo3DTexturesSupported()) {
-		OpenCLImageAccess::pointer distanceAccess = distance->getOpenCLImageAccess(ACCESS_READ_WRITE, device);
-		OpenCLImageAccess::pointer distance2Access = distance2->getOpenCLImageAccess(ACCESS_READ_WRITE, device);
-		cl::Image3D* clDistance = distanceAccess->get3DImage();
-		cl::Image3D* clDistance2 = distance2Access->get3DImage();
-
-		queue.enqueueCopyImage(
-				*clDistance,
-				*clDistance2,
-				createOrigoRegion(),
-				createOrigoRegion(),
-				createRegion(input->getSize())
-		);
-
-		while(true) {
-			// Write 0 to changedBuffer
-			char zero = 0;
-			queue.enqueueWriteBuffer(changedBuffer,CL_FALSE,0,sizeof(char),&zero);
-
-			if(counter % 2 == 0) {
-				distanceKernel.setArg(0, *clDistance);
-				distanceKernel.setArg(1, *clDistance2);
-			} else {
-				distanceKernel.setArg(1, *clDistance);
-				distanceKernel.setArg(0, *clDistance2);
-			}
-			counter++;
-			queue.enqueueNDRangeKernel(
-				distanceKernel,
-				cl::NullRange,
-				cl::NDRange(width, height, depth),
-				cl::NullRange
-			);
-
-			queue.enqueueReadBuffer(changedBuffer,CL_TRUE,0,sizeof(char),&zero);
-			if(zero == 0) {
-				break;
-			}
-		}
-	} else {
-
-		OpenCLBufferAccess::pointer distanceAccess = distance->getOpenCLBufferAccess(ACCESS_READ_WRITE, device);
-		OpenCLBufferAccess::pointer distance2Access = distance2->getOpenCLBufferAccess(ACCESS_READ_WRITE, device);
-		cl::Buffer* clDistance = distanceAccess->get();
-		cl::Buffer* clDistance2 = distance2Access->get();
-
-		queue.enqueueCopyBuffer(
-				*clDistance,
-				*clDistance2,
-				0,
-				0,
-				input->getSize().x()*input->getSize().y()*input->getSize().z()*sizeof(short)
-		);
-
-		while(true) {
-			// Write 0 to changedBuffer
-			char zero = 0;
-			queue.enqueueWriteBuffer(changedBuffer,CL_FALSE,0,sizeof(char),&zero);
-
-			if(counter % 2 == 0) {
-				distanceKernel.setArg(0, *clDistance);
-				distanceKernel.setArg(1, *clDistance2);
-			} else {
-				distanceKernel.setArg(1, *clDistance);
-				distanceKernel.setArg(0, *clDistance2);
-			}
-			counter++;
-			queue.enqueueNDRangeKernel(
-				distanceKernel,
-				cl::NullRange,
-				cl::NDRange(width, height, depth),
-				cl::NullRange
-			);
-
-			queue.enqueueReadBuffer(changedBuffer,CL_TRUE,0,sizeof(char),&zero);
-			if(zero == 0) {
-				break;
-			}
-		}
-	}
-	reportInfo() << "Calculated distance in " << counter << " steps" << reportEnd();
-
-
-	if(counter % 2 == 0) {
-		return distance;
-	} else {
-		return distance2;
-	}
-}
-
 inline uint linearPosition(Vector3i pos, Vector3i size) {
 	return pos.x() + pos.y()*size.x() + pos.z()*size.x()*size.y();
 }
@@ -252,8 +116,13 @@ void CenterlineExtraction::execute() {
 	Image::pointer input = getInputData<Image>();
 	Vector3f spacing = input->getSpacing();
 
-	// Do distance transform
-	Image::pointer distance = calculateDistanceTransform(input);
+	// Do distance transform, distance in voxels from each voxel inside to the nearest voxel outside
+	auto distanceTransform = DistanceTransform::New();
+	distanceTransform->setInputData(input);
+	distanceTransform->setMainDevice(getMainDevice());
+	distanceTransform->setMode(DistanceTransform::Mode::INSIDE);
+	distanceTransform->setUseSpacing(false);
+	Image::pointer distance = distanceTransform->updateAndGetOutputData<Image>();
 	/*
 	MetaImageExporter::pointer exporter = MetaImageExporter::New();
 	exporter->setInputData(distance);
@@ -308,7 +177,7 @@ void CenterlineExtraction::execute() {
 	ImageAccess::pointer inputAccess = input->getImageAccess(ACCESS_READ);
 	ImageAccess::pointer distanceAccess = distance->getImageAccess(ACCESS_READ);
 	ImageAccess::pointer candidateAccess = candidateCenterpointsImage->getImageAccess(ACCESS_READ);
-	short* distanceArray = (short*)distanceAccess->get();
+	float* distanceArray = (float*)distanceAccess->get();
 	uchar* inputArray = (uchar*)inputAccess->get();
 	uchar* candidateArray = (uchar*)candidateAccess->get();
 	int iteration = 0;
@@ -317,7 +186,7 @@ void CenterlineExtraction::execute() {
 	std::vector<bool> processedVoxels(totalSize, false);
 	while(true) {
 		reportInfo() << "Iteration:" << iteration++ << reportEnd();
-		int maxDistance = 0;
+		float maxDistance = 0;
 		int maxIndex = -1;
 		std::vector<bool> isInL(totalSize, true);
 		std::unordered_set<int> Sc;
@@ -328,7 +197,7 @@ void CenterlineExtraction::execute() {
 
 				// Get max distance
 				if(candidateArray[i] == 1) {
-					short distance = distanceArray[i];
+					float distance = distanceArray[i];
 					if(distance > maxDistance) {
 						maxDistance = distance;
 						maxIndex = i;
@@ -0,0 +1,118 @@
+// Squared distance of voxels without a feature
+#define NO_FEATURE INFINITY
+
+__kernel void initialize(
+        __global const INPUT_TYPE* input,
+        __global float* distance,
+        __global int* feature,
+        __private int objectIsFeature
+    ) {
+    const int i = get_global_id(0);
+    const bool isFeature = (input[i] != 0) == (objectIsFeature == 1);
+    distance[i] = isFeature ? 0.0f : NO_FEATURE;
+    feature[i] = isFeature ? i : -1;
+}
+
+/**
+ * 1D squared distance transform along one line per work item (Felzenszwalb and Huttenlocher).
+ * Lines are numbered by (a, b), and line position i is at a*stepA + b*stepB + i*stride.
+ * The lower envelope of parabolas is stored in the scratch buffers, which have room for one line per work item.
+ */
+__kernel void transformLines(
+        __global float* distance,
+        __global int* feature,
+        __global int* scratchVertex,
+        __global float* scratchIntersection,
+        __global float* scratchDistance,
+        __global int* scratchFeature,
+        __private int lineOffset,
+        __private int linesA,
+        __private int stepA,
+        __private int stepB,
+        __private int stride,
+        __private int length,
+        __private float squaredSpacing
+    ) {
+    const int id = get_global_id(0);
+    const int line = lineOffset + id;
+    __global float* f = &distance[(line % linesA)*stepA + (line / linesA)*stepB];
+    __global int* features = &feature[(line % linesA)*stepA + (line / linesA)*stepB];
+    __global int* v = &scratchVertex[id*length];
+    __global float* z = &scratchIntersection[id*(length + 1)];
+    __global float* vDistance = &scratchDistance[id*length];
+    __global int* vFeature = &scratchFeature[id*length];
+
+    // Find lower envelope
+    int k = -1;
+    for(int q = 0; q < length; ++q) {
+        const float fq = f[q*stride];
+        if(fq == NO_FEATURE)
+            continue;
+        const float fqs = fq + squaredSpacing*q*q;
+        float s = -INFINITY;
+        while(k >= 0) {
+            const int p = v[k];
+            s = (fqs - (vDistance[k] + squaredSpacing*p*p)) / (2.0f*squaredSpacing*(q - p));
+            if(s > z[k])
+                break;
+            --k;
+        }
+        ++k;
+        v[k] = q;
+        z[k] = k == 0 ? -INFINITY : s;
+        z[k + 1] = INFINITY;
+        vDistance[k] = fq;
+        vFeature[k] = features[q*stride];
+    }
+    if(k < 0) // No features on this line
+        return;
+
+    // Fill in distances from the lower envelope
+    k = 0;
+    for(int q = 0; q < length; ++q) {
+        while(z[k + 1] < q)
+            ++k;
+        const float d = (float)(q - v[k]);
+        f[q*stride] = squaredSpacing*d*d + vDistance[k];
+        features[q*stride] = vFeature[k];
+    }
+}
+
+__kernel void finalize(
+        __global const INPUT_TYPE* input,
+        __global const float* outsideDistance,
+        __global const int* outsideFeature,
+        __global const float* insideDistance,
+        __global const int* insideFeature,
+        __global float* output,
+        __global ushort* nearestFeature,
+        __private int isSigned,
+        __private int writeNearestFeature,
+        __private int width,
+        __private int height,
+        __private int channels
+    ) {
+    const int i = get_global_id(0);
+    const bool inside = input[i] != 0;
+    float distance;
+    int feature;
+    if(inside) {
+        distance = isSigned == 1 ? -sqrt(insideDistance[i]) : sqrt(insideDistance[i]);
+        feature = insideFeature[i];
+    } else {
+        distance = sqrt(outsideDistance[i]);
+        feature = outsideFeature[i];
+    }
+    output[i] = distance;
+    if(writeNearestFeature == 1) {
+        if(feature < 0) {
+            for(int c = 0; c < channels; ++c)
+                nearestFeature[i*channels + c] = USHRT_MAX;
+        } else {
+            nearestFeature[i*channels] = feature % width;
+            nearestFeature[i*channels + 1] = (feature / width) % height;
+            if(channels == 3)
+                nearestFeature[i*channels + 2] = feature / (width*height);
+        }
+    }
+}
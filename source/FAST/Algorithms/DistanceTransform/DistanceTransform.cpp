@@ -0,0 +1,363 @@
+#include "DistanceTransform.hpp"
+#include <FAST/Data/Image.hpp>
+#include <FAST/SceneGraph.hpp>
+
+namespace fast {
+
+// Squared distance of voxels without a feature
+static const float NO_FEATURE = std::numeric_limits<float>::infinity();
+
+DistanceTransform::DistanceTransform() {
+    createInputPort<Image>(0);
+    createOutputPort<Image>(0);
+    createOutputPort<Image>(1);
+
+    createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/DistanceTransform/DistanceTransform.cl");
+
+    createStringAttribute("mode", "Mode", "Which distances to calculate: outside, inside or signed", "outside");
+    createBooleanAttribute("use-spacing", "Use spacing", "Calculate distances in millimeters using image spacing", m_useSpacing);
+    createBooleanAttribute("nearest-feature", "Nearest feature output", "Output position of nearest voxel on port 1", m_nearestFeatureOutput);
+}
+
+void DistanceTransform::loadAttributes() {
+    const std::string mode = getStringAttribute("mode");
+    if(mode == "outside") {
+        setMode(Mode::OUTSIDE);
+    } else if(mode == "inside") {
+        setMode(Mode::INSIDE);
+    } else if(mode == "signed") {
+        setMode(Mode::SIGNED);
+    } else {
+        throw Exception("Unknown mode " + mode + " given to DistanceTransform");
+    }
+    setUseSpacing(getBooleanAttribute("use-spacing"));
+    setNearestFeatureOutput(getBooleanAttribute("nearest-feature"));
+}
+
+void DistanceTransform::setMode(Mode mode) {
+    m_mode = mode;
+    mIsModified = true;
+}
+
+void DistanceTransform::setUseSpacing(bool useSpacing) {
+    m_useSpacing = useSpacing;
+    mIsModified = true;
+}
+
+void DistanceTransform::setNearestFeatureOutput(bool output) {
+    m_nearestFeatureOutput = output;
+    mIsModified = true;
+}
+
+template <class T>
+static void initialize(const T* input, float* distance, int64_t* feature, int64_t size, bool objectIsFeature) {
+    #pragma omp parallel for
+    for(int64_t i = 0; i < size; ++i) {
+        const bool isFeature = (input[i] != 0) == objectIsFeature;
+        distance[i] = isFeature ? 0.0f : NO_FEATURE;
+        feature[i] = isFeature ? i : -1;
+    }
+}
+
+/**
+ * 1D squared distance transform of one contiguous line (Felzenszwalb and Huttenlocher), same as the transformLines kernel.
+ * v, z, vDistance and vFeature are scratch buffers for the lower envelope of parabolas.
+ */
+static void transformLine(float* f, int64_t* features, int length, float squaredSpacing,
+        int* v, float* z, float* vDistance, int64_t* vFeature) {
+    // Find lower envelope
+    int k = -1;
+    for(int q = 0; q < length; ++q) {
+        const float fq = f[q];
+        if(fq == NO_FEATURE)
+            continue;
+        const float fqs = fq + squaredSpacing*q*q;
+        float s = -NO_FEATURE;
+        while(k >= 0) {
+            const int p = v[k];
+            s = (fqs - (vDistance[k] + squaredSpacing*p*p)) / (2.0f*squaredSpacing*(q - p));
+            if(s > z[k])
+                break;
+            --k;
+        }
+        ++k;
+        v[k] = q;
+        z[k] = k == 0 ? -NO_FEATURE : s;
+        z[k + 1] = NO_FEATURE;
+        vDistance[k] = fq;
+        vFeature[k] = features[q];
+    }
+    if(k < 0) // No features on this line
+        return;
+
+    // Fill in distances from the lower envelope
+    k = 0;
+    for(int q = 0; q < length; ++q) {
+        while(z[k + 1] < q)
+            ++k;
+        const float d = (float)(q - v[k]);
+        f[q] = squaredSpacing*d*d + vDistance[k];
+        features[q] = vFeature[k];
+    }
+}
+
+/**
+ * 1D transform of all lines along one dimension. Lines are numbered by (a, b), and line position i is at
+ * a*stepA + b*stepB + i*stride. Lines are copied to contiguous memory first. When the stride is larger than 1,
+ * blocks of lines with consecutive a are copied together, so that memory is read and written in whole cache lines.
+ */
+static void transformLines(float* distance, int64_t* feature, int linesA, int linesB, std::size_t stepA, std::size_t stepB,
+        std::size_t stride, int length, float squaredSpacing) {
+    const int blockSize = stride == 1 ? 1 : 16;
+    const int blocksA = (linesA + blockSize - 1)/blockSize;
+    #pragma omp parallel
+    {
+        std::vector<float> lineDistance(blockSize*length);
+        std::vector<int64_t> lineFeature(blockSize*length);
+        std::vector<int> v(length);
+        std::vector<float> z(length + 1);
+        std::vector<float> vDistance(length);
+        std::vector<int64_t> vFeature(length);
+        // Blocks of all lines, as a single signed index
+        #pragma omp for
+        for(int64_t block = 0; block < (int64_t)linesB*blocksA; ++block) {
+            const int b = (int)(block / blocksA);
+            const int startA = (int)(block % blocksA)*blockSize;
+            const int lines = std::min(blockSize, linesA - startA);
+            const std::size_t start = startA*stepA + b*stepB;
+            for(int q = 0; q < length; ++q) {
+                for(int j = 0; j < lines; ++j) {
+                    lineDistance[j*length + q] = distance[start + j*stepA + q*stride];
+                    lineFeature[j*length + q] = feature[start + j*stepA + q*stride];
+                }
+            }
+            for(int j = 0; j < lines; ++j) {
+                transformLine(&lineDistance[j*length], &lineFeature[j*length], length, squaredSpacing,
+                              v.data(), z.data(), vDistance.data(), vFeature.data());
+            }
+            for(int q = 0; q < length; ++q) {
+                for(int j = 0; j < lines; ++j) {
+                    distance[start + j*stepA + q*stride] = lineDistance[j*length + q];
+                    feature[start + j*stepA + q*stride] = lineFeature[j*length + q];
+                }
+            }
+        }
+    }
+}
+
+template <class T>
+static void finalize(const T* input, const float* outsideDistance, const int64_t* outsideFeature,
+        const float* insideDistance, const int64_t* insideFeature, float* output, ushort* nearestFeature, bool isSigned,
+        int64_t size, int width, int height, int channels) {
+    #pragma omp parallel for
+    for(int64_t i = 0; i < size; ++i) {
+        const bool inside = input[i] != 0;
+        int64_t feature;
+        if(inside) {
+            output[i] = isSigned ? -std::sqrt(insideDistance[i]) : std::sqrt(insideDistance[i]);
+            feature = insideFeature[i];
+        } else {
+            output[i] = std::sqrt(outsideDistance[i]);
+            feature = outsideFeature[i];
+        }
+        if(nearestFeature != nullptr) {
+            if(feature < 0) {
+                for(int c = 0; c < channels; ++c)
+                    nearestFeature[i*channels + c] = std::numeric_limits<ushort>::max();
+            } else {
+                nearestFeature[i*channels] = feature % width;
+                nearestFeature[i*channels + 1] = (feature / width) % height;
+                if(channels == 3)
+                    nearestFeature[i*channels + 2] = feature / ((int64_t)width*height);
+            }
+        }
+    }
+}
+
+/**
+ * Squared spacing used in the 1D transforms of each dimension
+ */
+static Vector3f getSquaredSpacing(SharedPointer<Image> input, bool useSpacing) {
+    if(!useSpacing)
+        return Vector3f::Ones();
+    return input->getSpacing().cwiseProduct(input->getSpacing());
+}
+
+void DistanceTransform::executeOnHost(SharedPointer<Image> input, SharedPointer<Image> output, SharedPointer<Image> nearestFeature) {
+    const int width = input->getWidth();
+    const int height = input->getHeight();
+    const int depth = input->getDepth();
+    const int64_t size = (int64_t)width*height*depth;
+    const Vector3f squaredSpacing = getSquaredSpacing(input, m_useSpacing);
+
+    auto inputAccess = input->getImageAccess(ACCESS_READ);
+    // Transform from object voxels for voxels outside, and from background voxels for voxels inside
+    std::vector<float> distance[2];
+    // Feature indices are 64 bit, as volumes may have more than 2^31 voxels
+    std::vector<int64_t> feature[2];
+    for(int inside = 0; inside < 2; ++inside) {
+        if((inside == 1 && m_mode == Mode::OUTSIDE) || (inside == 0 && m_mode == Mode::INSIDE))
+            continue;
+        distance[inside].resize(size);
+        feature[inside].resize(size);
+        float* d = distance[inside].data();
+        int64_t* f = feature[inside].data();
+        switch(input->getDataType()) {
+            fastSwitchTypeMacro(initialize<FAST_TYPE>((FAST_TYPE*)inputAccess->get(), d, f, size, inside == 0));
+        }
+        transformLines(d, f, height, depth, width, (std::size_t)width*height, 1, width, squaredSpacing.x());
+        transformLines(d, f, width, depth, 1, (std::size_t)width*height, width, height, squaredSpacing.y());
+        if(depth > 1)
+            transformLines(d, f, width, height, 1, width, (std::size_t)width*height, depth, squaredSpacing.z());
+    }
+    // In the unsigned modes, voxels of the other class are features in the single transform, and have distance 0
+    const int outside = m_mode == Mode::INSIDE ? 1 : 0;
+    const int inside = m_mode == Mode::OUTSIDE ? 0 : 1;
+
+    auto outputAccess = output->getImageAccess(ACCESS_READ_WRITE);
+    std::unique_ptr<ImageAccess> featureAccess;
+    ushort* featureData = nullptr;
+    if(nearestFeature) {
+        featureAccess = nearestFeature->getImageAccess(ACCESS_READ_WRITE);
+        featureData = (ushort*)featureAccess->get();
+    }
+    switch(input->getDataType()) {
+        fastSwitchTypeMacro(finalize<FAST_TYPE>((FAST_TYPE*)inputAccess->get(),
+                distance[outside].data(), feature[outside].data(), distance[inside].data(), feature[inside].data(),
+                (float*)outputAccess->get(), featureData, m_mode == Mode::SIGNED, size, width, height, input->getDimensions()));
+    }
+}
+
+void DistanceTransform::executeOnOpenCL(SharedPointer<Image> input, SharedPointer<Image> output, SharedPointer<Image> nearestFeature) {
+    auto device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
+    auto program = getOpenCLProgram(device, "", "-DINPUT_TYPE=" + getCTypeAsString(input->getDataType()));
+    auto queue = device->getCommandQueue();
+    const int width = input->getWidth();
+    const int height = input->getHeight();
+    const int depth = input->getDepth();
+    const std::size_t size = (std::size_t)width*height*depth;
+    // The kernels use 32 bit feature indices
+    if(size > (std::size_t)std::numeric_limits<int>::max())
+        throw Exception("DistanceTransform on OpenCL only supports images with less than 2^31 voxels, use the host device instead");
+    const Vector3f squaredSpacing = getSquaredSpacing(input, m_useSpacing);
+
+    auto inputAccess = input->getOpenCLBufferAccess(ACCESS_READ, device);
+    cl::Kernel initializeKernel(program, "initialize");
+    cl::Kernel transformKernel(program, "transformLines");
+    initializeKernel.setArg(0, *inputAccess->get());
+
+    // Scratch buffers for the lower envelopes are limited to a batch of lines to bound memory usage
+    const int maxLength = std::max(std::max(width, height), depth);
+    const int batchSize = std::max(1, (int)std::min<std::size_t>(size/std::min(std::min(width, height), depth),
+            (64*1024*1024)/(4*sizeof(float)*(maxLength + 1))));
+    cl::Buffer scratchVertex(device->getContext(), CL_MEM_READ_WRITE, sizeof(int)*batchSize*maxLength);
+    cl::Buffer scratchIntersection(device->getContext(), CL_MEM_READ_WRITE, sizeof(float)*batchSize*(maxLength + 1));
+    cl::Buffer scratchDistance(device->getContext(), CL_MEM_READ_WRITE, sizeof(float)*batchSize*maxLength);
+    cl::Buffer scratchFeature(device->getContext(), CL_MEM_READ_WRITE, sizeof(int)*batchSize*maxLength);
+    transformKernel.setArg(2, scratchVertex);
+    transformKernel.setArg(3, scratchIntersection);
+    transformKernel.setArg(4, scratchDistance);
+    transformKernel.setArg(5, scratchFeature);
+
+    auto transform = [&](int linesA, int linesB, int stepA, int stepB, int stride, int length, float spacing) {
+        const int lines = linesA*linesB;
+        transformKernel.setArg(7, linesA);
+        transformKernel.setArg(8, stepA);
+        transformKernel.setArg(9, stepB);
+        transformKernel.setArg(10, stride);
+        transformKernel.setArg(11, length);
+        transformKernel.setArg(12, spacing);
+        for(int lineOffset = 0; lineOffset < lines; lineOffset += batchSize) {
+            transformKernel.setArg(6, lineOffset);
+            queue.enqueueNDRangeKernel(
+                    transformKernel,
+                    cl::NullRange,
+                    cl::NDRange(std::min(batchSize, lines - lineOffset)),
+                    cl::NullRange
+            );
+        }
+    };
+
+    // Transform from object voxels for voxels outside, and from background voxels for voxels inside
+    cl::Buffer distance[2];
+    cl::Buffer feature[2];
+    for(int inside = 0; inside < 2; ++inside) {
+        if((inside == 1 && m_mode == Mode::OUTSIDE) || (inside == 0 && m_mode == Mode::INSIDE))
+            continue;
+        distance[inside] = cl::Buffer(device->getContext(), CL_MEM_READ_WRITE, sizeof(float)*size);
+        feature[inside] = cl::Buffer(device->getContext(), CL_MEM_READ_WRITE, sizeof(int)*size);
+        initializeKernel.setArg(1, distance[inside]);
+        initializeKernel.setArg(2, feature[inside]);
+        initializeKernel.setArg(3, inside == 0 ? 1 : 0);
+        queue.enqueueNDRangeKernel(
+                initializeKernel,
+                cl::NullRange,
+                cl::NDRange(size),
+                cl::NullRange
+        );
+        transformKernel.setArg(0, distance[inside]);
+        transformKernel.setArg(1, feature[inside]);
+        transform(height, depth, width, width*height, 1, width, squaredSpacing.x());
+        transform(width, depth, 1, width*height, width, height, squaredSpacing.y());
+        if(depth > 1)
+            transform(width, height, 1, width, width*height, depth, squaredSpacing.z());
+    }
+    // In the unsigned modes, voxels of the other class are features in the single transform, and have distance 0
+    const int outside = m_mode == Mode::INSIDE ? 1 : 0;
+    const int inside = m_mode == Mode::OUTSIDE ? 0 : 1;
+
+    auto outputAccess = output->getOpenCLBufferAccess(ACCESS_READ_WRITE, device);
+    cl::Kernel finalizeKernel(program, "finalize");
+    finalizeKernel.setArg(0, *inputAccess->get());
+    finalizeKernel.setArg(1, distance[outside]);
+    finalizeKernel.setArg(2, feature[outside]);
+    finalizeKernel.setArg(3, distance[inside]);
+    finalizeKernel.setArg(4, feature[inside]);
+    finalizeKernel.setArg(5, *outputAccess->get());
+    std::unique_ptr<OpenCLBufferAccess> featureAccess;
+    if(nearestFeature) {
+        featureAccess = nearestFeature->getOpenCLBufferAccess(ACCESS_READ_WRITE, device);
+        finalizeKernel.setArg(6, *featureAccess->get());
+    } else {
+        // Not written to
+        finalizeKernel.setArg(6, *outputAccess->get());
+    }
+    finalizeKernel.setArg(7, m_mode == Mode::SIGNED ? 1 : 0);
+    finalizeKernel.setArg(8, nearestFeature ? 1 : 0);
+    finalizeKernel.setArg(9, width);
+    finalizeKernel.setArg(10, height);
+    finalizeKernel.setArg(11, (int)input->getDimensions());
+    queue.enqueueNDRangeKernel(
+            finalizeKernel,
+            cl::NullRange,
+            cl::NDRange(size),
+            cl::NullRange
+    );
+    queue.finish();
+}
+
+void DistanceTransform::execute() {
+    auto input = getInputData<Image>(0);
+    if(input->getNrOfChannels() != 1)
+        throw Exception("DistanceTransform only supports images with 1 channel");
+
+    auto output = getOutputData<Image>(0);
+    output->create(input->getSize(), TYPE_FLOAT, 1);
+    output->setSpacing(input->getSpacing());
+    SceneGraph::setParentNode(output, input);
+    Image::pointer nearestFeature;
+    if(m_nearestFeatureOutput) {
+        nearestFeature = getOutputData<Image>(1);
+        nearestFeature->create(input->getSize(), TYPE_UINT16, input->getDimensions());
+        nearestFeature->setSpacing(input->getSpacing());
+        SceneGraph::setParentNode(nearestFeature, input);
+    }
+
+    if(getMainDevice()->isHost()) {
+        executeOnHost(input, output, nearestFeature);
+    } else {
+        executeOnOpenCL(input, output, nearestFeature);
+    }
+}
+
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <FAST/ProcessObject.hpp>
+
+namespace fast {
+
+class Image;
+
+/**
+ * Exact Euclidean distance transform of a 2D or 3D image, where all non-zero voxels are object voxels.
+ *
+ * Uses the separable algorithm of Felzenszwalb and Huttenlocher, which does one linear time pass
+ * of 1D distance transforms along each dimension. Thus runtime only depends on image size, not on object thickness.
+ * Runs on OpenCL devices and in parallel on the host.
+ *
+ * Output port 0 is the distance image of TYPE_FLOAT. If there is no voxel to measure the distance to, the
+ * distance is infinity.
+ * Output port 1 is the position of the voxel which each distance was measured to, as a TYPE_UINT16 image
+ * with 2 or 3 channels (x, y, z). It is only created if enabled with setNearestFeatureOutput.
+ */
+class FAST_EXPORT DistanceTransform : public ProcessObject {
+    FAST_OBJECT(DistanceTransform)
+    public:
+        enum class Mode {
+            // Distance from each voxel to the nearest object voxel, 0 inside the object
+            OUTSIDE,
+            // Distance from each object voxel to the nearest background voxel, 0 outside the object
+            INSIDE,
+            // Distance to the nearest voxel of the other class, negative inside the object and positive outside
+            SIGNED,
+        };
+        /**
+         * Set which distances to calculate. Default is Mode::OUTSIDE
+         * @param mode
+         */
+        void setMode(Mode mode);
+        /**
+         * Use image spacing to calculate distances in millimeters. If disabled, distances are in voxels.
+         * Default is true.
+         * @param useSpacing
+         */
+        void setUseSpacing(bool useSpacing);
+        /**
+         * Output the position of the nearest voxel on output port 1. Default is false.
+         * @param output
+         */
+        void setNearestFeatureOutput(bool output);
+        void loadAttributes() override;
+    private:
+        DistanceTransform();
+        void execute() override;
+        void executeOnHost(SharedPointer<Image> input, SharedPointer<Image> output, SharedPointer<Image> nearestFeature);
+        void executeOnOpenCL(SharedPointer<Image> input, SharedPointer<Image> output, SharedPointer<Image> nearestFeature);
+
+        Mode m_mode = Mode::OUTSIDE;
+        bool m_useSpacing = true;
+        bool m_nearestFeatureOutput = false;
+};
+
+}
@@ -0,0 +1,108 @@
+#include "DistanceTransform.hpp"
+#include <FAST/Data/Image.hpp>
+#include <FAST/Testing.hpp>
+#include <random>
+
+using namespace fast;
+
+static Image::pointer createRandomSegmentation(int width, int height, int depth, std::mt19937& engine) {
+    std::bernoulli_distribution distribution(0.05);
+    std::vector<uchar> data(width*height*depth);
+    for(auto& value : data)
+        value = distribution(engine) ? 1 : 0;
+    // A thick object in the middle
+    for(int z = depth/4; z < depth - depth/4; ++z) {
+        for(int y = height/4; y < height - height/4; ++y) {
+            for(int x = width/4; x < width - width/4; ++x)
+                data[x + y*width + z*width*height] = 1;
+        }
+    }
+    auto image = Image::New();
+    if(depth > 1) {
+        image->create(width, height, depth, TYPE_UINT8, 1, data.data());
+    } else {
+        image->create(width, height, TYPE_UINT8, 1, data.data());
+    }
+    return image;
+}
+
+/**
+ * Check distance and nearest feature output against the distance to every voxel of the other class
+ */
+static void checkDistanceTransform(Image::pointer input, ExecutionDevice::pointer device) {
+    const Vector3f spacing(0.5f, 1.3f, 2.1f);
+    input->setSpacing(spacing);
+    const int width = input->getWidth();
+    const int height = input->getHeight();
+    const int depth = input->getDepth();
+    const int channels = input->getDimensions();
+    for(auto mode : {DistanceTransform::Mode::OUTSIDE, DistanceTransform::Mode::INSIDE, DistanceTransform::Mode::SIGNED}) {
+        auto transform = DistanceTransform::New();
+        transform->setInputData(input);
+        transform->setMainDevice(device);
+        transform->setMode(mode);
+        transform->setNearestFeatureOutput(true);
+        auto distancePort = transform->getOutputPort(0);
+        auto featurePort = transform->getOutputPort(1);
+        transform->update();
+        auto distance = distancePort->getNextFrame<Image>();
+        auto nearestFeature = featurePort->getNextFrame<Image>();
+        REQUIRE(distance->getDataType() == TYPE_FLOAT);
+        REQUIRE(nearestFeature->getNrOfChannels() == channels);
+
+        auto inputAccess = input->getImageAccess(ACCESS_READ);
+        auto distanceAccess = distance->getImageAccess(ACCESS_READ);
+        auto featureAccess = nearestFeature->getImageAccess(ACCESS_READ);
+        auto segmentation = (const uchar*)inputAccess->get();
+        auto distances = (const float*)distanceAccess->get();
+        auto features = (const ushort*)featureAccess->get();
+        const int size = width*height*depth;
+        for(int i = 0; i < size; ++i) {
+            const Vector3f position(i % width, (i / width) % height, i / (width*height));
+            const bool inside = segmentation[i] != 0;
+            float expected = 0.0f;
+            if((inside && mode != DistanceTransform::Mode::OUTSIDE) || (!inside && mode != DistanceTransform::Mode::INSIDE)) {
+                expected = std::numeric_limits<float>::max();
+                for(int j = 0; j < size; ++j) {
+                    if((segmentation[j] != 0) == inside)
+                        continue;
+                    const Vector3f otherPosition(j % width, (j / width) % height, j / (width*height));
+                    expected = std::min(expected, (position - otherPosition).cwiseProduct(spacing).norm());
+                }
+                if(inside && mode == DistanceTransform::Mode::SIGNED)
+                    expected = -expected;
+            }
+            CHECK(distances[i] == Approx(expected).margin(1e-4));
+            Vector3f feature = Vector3f::Zero();
+            for(int c = 0; c < channels; ++c)
+                feature[c] = features[i*channels + c];
+            CHECK((position - feature).cwiseProduct(spacing).norm() == Approx(std::fabs(expected)).margin(1e-4));
+        }
+    }
+}
+
+TEST_CASE("Distance transform of 2D image is exact", "[fast][DistanceTransform]") {
+    std::mt19937 engine(0);
+    auto input = createRandomSegmentation(32, 24, 1, engine);
+    checkDistanceTransform(input, Host::getInstance());
+    checkDistanceTransform(input, DeviceManager::getInstance()->getDefaultComputationDevice());
+}
+
+TEST_CASE("Distance transform of 3D image is exact", "[fast][DistanceTransform]") {
+    std::mt19937 engine(0);
+    auto input = createRandomSegmentation(20, 16, 12, engine);
+    checkDistanceTransform(input, Host::getInstance());
+    checkDistanceTransform(input, DeviceManager::getInstance()->getDefaultComputationDevice());
+}
+
+TEST_CASE("Distance transform without object gives infinite distance", "[fast][DistanceTransform]") {
+    auto input = Image::New();
+    input->create(16, 16, TYPE_UINT8, 1);
+    input->fill(0);
+    auto transform = DistanceTransform::New();
+    transform->setInputData(input);
+    transform->setMainDevice(Host::getInstance());
+    auto distance = transform->updateAndGetOutputData<Image>();
+    auto access = distance->getImageAccess(ACCESS_READ);
+    CHECK(std::isinf(((float*)access->get())[0]));
+}
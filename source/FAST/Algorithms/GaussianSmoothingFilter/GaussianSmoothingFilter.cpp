@@ -2,6 +2,8 @@
 #include "FAST/Exception.hpp"
 #include "FAST/DeviceManager.hpp"
 #include "FAST/Data/Image.hpp"
+#include <algorithm>
+#include <type_traits>
 using namespace fast;
 
 void GaussianSmoothingFilter::setMaskSize(unsigned char maskSize) {
@@ -49,13 +51,25 @@ GaussianSmoothingFilter::~GaussianSmoothingFilter() {
 
 // TODO have to set mRecreateMask to true if input change dimension
 void GaussianSmoothingFilter::createMask(Image::pointer input, uchar maskSize, bool useSeperableFilter) {
-    if(!mRecreateMask)
+    if(!mRecreateMask && useSeperableFilter == mMaskIsSeperable)
         return;
 
     unsigned char halfSize = (maskSize-1)/2;
     float sum = 0.0f;
 
-    if(input->getDimensions() == 2) {
+    if(useSeperableFilter) {
+        // 1D mask which is applied in each direction
+        mMask = std::make_unique<float[]>(maskSize);
+
+        for(int x = -halfSize; x <= halfSize; x++) {
+            float value = exp(-(float)(x*x)/(2.0f*mStdDev*mStdDev));
+            mMask[x+halfSize] = value;
+            sum += value;
+        }
+
+        for(int i = 0; i < maskSize; ++i)
+            mMask[i] /= sum;
+    } else if(input->getDimensions() == 2) {
         mMask = std::make_unique<float[]>(maskSize*maskSize);
 
         for(int x = -halfSize; x <= halfSize; x++) {
@@ -68,32 +82,18 @@ void GaussianSmoothingFilter::createMask(Image::pointer input, uchar maskSize, b
         for(int i = 0; i < maskSize*maskSize; ++i)
             mMask[i] /= sum;
     } else if(input->getDimensions() == 3) {
-        // Use separable filtering for 3D
-        if(useSeperableFilter) {
-            mMask = std::make_unique<float[]>(maskSize);
+        mMask = std::make_unique<float[]>(maskSize*maskSize*maskSize);
 
-            for(int x = -halfSize; x <= halfSize; x++) {
-                float value = exp(-(float)(x*x)/(2.0f*mStdDev*mStdDev));
-                mMask[x+halfSize] = value;
-                sum += value;
-            }
+        for(int x = -halfSize; x <= halfSize; x++) {
+        for(int y = -halfSize; y <= halfSize; y++) {
+        for(int z = -halfSize; z <= halfSize; z++) {
+            float value = exp(-(float)(x*x+y*y+z*z)/(2.0f*mStdDev*mStdDev));
+            mMask[x+halfSize+(y+halfSize)*maskSize+(z+halfSize)*maskSize*maskSize] = value;
+            sum += value;
+        }}}
 
-            for(int i = 0; i < maskSize; ++i)
-                mMask[i] /= sum;
-        } else {
-            mMask = std::make_unique<float[]>(maskSize*maskSize*maskSize);
-
-            for(int x = -halfSize; x <= halfSize; x++) {
-            for(int y = -halfSize; y <= halfSize; y++) {
-            for(int z = -halfSize; z <= halfSize; z++) {
-                float value = exp(-(float)(x*x+y*y+z*z)/(2.0f*mStdDev*mStdDev));
-                mMask[x+halfSize+(y+halfSize)*maskSize+(z+halfSize)*maskSize*maskSize] = value;
-                sum += value;
-            }}}
-
-            for(int i = 0; i < maskSize*maskSize*maskSize; ++i)
-                mMask[i] /= sum;
-        }
+        for(int i = 0; i < maskSize*maskSize*maskSize; ++i)
+            mMask[i] /= sum;
     }
 
     ExecutionDevice::pointer device = getMainDevice();
@@ -114,6 +114,7 @@ void GaussianSmoothingFilter::createMask(Image::pointer input, uchar maskSize, b
     }
 
     mRecreateMask = false;
+    mMaskIsSeperable = useSeperableFilter;
 }
 
 void GaussianSmoothingFilter::recompileOpenCLCode(Image::pointer input) {
@@ -139,60 +140,109 @@ void GaussianSmoothingFilter::recompileOpenCLCode(Image::pointer input) {
 }
 
 template <class T>
-void executeAlgorithmOnHost(Image::pointer input, Image::pointer output, const float* const mask, unsigned char maskSize) {
-    // TODO: this method currently only processes the first component
-    unsigned int nrOfComponents = input->getNrOfChannels();
-    ImageAccess::pointer inputAccess = input->getImageAccess(ACCESS_READ);
-    ImageAccess::pointer outputAccess = output->getImageAccess(ACCESS_READ_WRITE);
+static void convertToFloat(const T* input, float* output, std::size_t size) {
+    #pragma omp parallel for
+    for(int64_t i = 0; i < (int64_t)size; ++i)
+        output[i] = (float)input[i];
+}
 
-    T * inputData = (T*)inputAccess->get();
-    T * outputData = (T*)outputAccess->get();
-
-    const unsigned char halfSize = (maskSize-1)/2;
-    unsigned int width = input->getWidth();
-    unsigned int height = input->getHeight();
-    if(input->getDimensions() == 3) {
-        unsigned int depth = input->getDepth();
-        for(unsigned int z = 0; z < depth; z++) {
-        for(unsigned int y = 0; y < height; y++) {
-        for(unsigned int x = 0; x < width; x++) {
-
-            if(x < halfSize || x >= width-halfSize ||
-            y < halfSize || y >= height-halfSize ||
-            z < halfSize || z >= depth-halfSize) {
-                // on border only copy values
-                outputData[x*nrOfComponents+y*nrOfComponents*width+z*nrOfComponents*width*height] = inputData[x*nrOfComponents+y*nrOfComponents*width+z*nrOfComponents*width*height];
-                continue;
-            }
+template <class T>
+static void convertFromFloat(const float* input, T* output, std::size_t size) {
+    // Round when converting to integer types, same as the OpenCL kernels
+    const bool isInteger = std::is_integral<T>::value;
+    #pragma omp parallel for
+    for(int64_t i = 0; i < (int64_t)size; ++i)
+        output[i] = isInteger ? (T)std::round(input[i]) : (T)input[i];
+}
 
-            double sum = 0.0;
-            for(int c = -halfSize; c <= halfSize; c++) {
-            for(int b = -halfSize; b <= halfSize; b++) {
-            for(int a = -halfSize; a <= halfSize; a++) {
-                sum += mask[a+halfSize+(b+halfSize)*maskSize+(c+halfSize)*maskSize*maskSize]*
-                        inputData[(x+a)*nrOfComponents+(y+b)*nrOfComponents*width+(z+c)*nrOfComponents*width*height];
-            }}}
-            outputData[x*nrOfComponents+y*nrOfComponents*width+z*nrOfComponents*width*height] = (T)sum;
-        }}}
-    } else {
-        for(unsigned int y = halfSize; y < height-halfSize; y++) {
-        for(unsigned int x = halfSize; x < width-halfSize; x++) {
-
-            if(x < halfSize || x >= width-halfSize ||
-            y < halfSize || y >= height-halfSize) {
-                // on border only copy values
-                outputData[x*nrOfComponents+y*nrOfComponents*width] = inputData[x*nrOfComponents+y*nrOfComponents*width];
-                continue;
+/**
+ * Convolve every row (x direction) with the 1D mask.
+ * Borders are clamped to edge, same as the sampler in the OpenCL kernels.
+ */
+static void convolveRows(const float* input, float* output, const float* mask, int halfSize,
+        int width, int rows, int channels) {
+    #pragma omp parallel
+    {
+        // Padded copy of one row of a single channel, so that the inner loop has no branches
+        std::vector<float> padded(width + 2*halfSize);
+        std::vector<float> result(width);
+        #pragma omp for
+        for(int row = 0; row < rows; ++row) {
+            for(int c = 0; c < channels; ++c) {
+                const float* in = &input[(std::size_t)row*width*channels + c];
+                for(int x = -halfSize; x < width + halfSize; ++x)
+                    padded[x + halfSize] = in[std::min(std::max(x, 0), width - 1)*channels];
+                std::fill(result.begin(), result.end(), 0.0f);
+                for(int k = 0; k <= 2*halfSize; ++k) {
+                    const float weight = mask[k];
+                    const float* src = &padded[k];
+                    float* dst = result.data();
+                    for(int x = 0; x < width; ++x)
+                        dst[x] += weight*src[x];
+                }
+                float* out = &output[(std::size_t)row*width*channels + c];
+                for(int x = 0; x < width; ++x)
+                    out[x*channels] = result[x];
             }
+        }
+    }
+}
 
-            double sum = 0.0;
-            for(int b = -halfSize; b <= halfSize; b++) {
-            for(int a = -halfSize; a <= halfSize; a++) {
-                sum += mask[a+halfSize+(b+halfSize)*maskSize]*
-                        inputData[(x+a)*nrOfComponents+(y+b)*nrOfComponents*width];
-            }}
-            outputData[x*nrOfComponents+y*nrOfComponents*width] = (T)sum;
-        }}
+/**
+ * Convolve along an outer direction (y or z), where neighbours are whole lines of
+ * lineSize contiguous values separated by stride. Each output line is a weighted sum of input lines.
+ */
+static void convolveLines(const float* input, float* output, const float* mask, int halfSize,
+        int size, std::size_t lineSize, std::size_t stride, int blocks) {
+    #pragma omp parallel for
+    for(int line = 0; line < blocks*size; ++line) {
+        const int block = line / size;
+        const int i = line % size;
+        const float* in = &input[(std::size_t)block*size*stride];
+        float* out = &output[(std::size_t)block*size*stride + (std::size_t)i*stride];
+        std::fill(out, out + lineSize, 0.0f);
+        for(int k = -halfSize; k <= halfSize; ++k) {
+            const float weight = mask[k + halfSize];
+            const float* src = &in[(std::size_t)std::min(std::max(i + k, 0), size - 1)*stride];
+            for(std::size_t j = 0; j < lineSize; ++j)
+                out[j] += weight*src[j];
+        }
+    }
+}
+
+void GaussianSmoothingFilter::executeOnHost(Image::pointer input, Image::pointer output, uchar maskSize) {
+    // Gaussian is separable: do one 1D pass per dimension in single precision using all cores
+    createMask(input, maskSize, true);
+    const int halfSize = (maskSize-1)/2;
+    const float* mask = mMask.get();
+
+    const int width = input->getWidth();
+    const int height = input->getHeight();
+    const int depth = input->getDimensions() == 3 ? input->getDepth() : 1;
+    const int channels = input->getNrOfChannels();
+    const std::size_t size = (std::size_t)width*height*depth*channels;
+    const std::size_t lineSize = (std::size_t)width*channels;
+
+    auto buffer1 = std::make_unique<float[]>(size);
+    auto buffer2 = std::make_unique<float[]>(size);
+    {
+        ImageAccess::pointer inputAccess = input->getImageAccess(ACCESS_READ);
+        switch(input->getDataType()) {
+            fastSwitchTypeMacro(convertToFloat<FAST_TYPE>((FAST_TYPE*)inputAccess->get(), buffer1.get(), size));
+        }
+    }
+
+    convolveRows(buffer1.get(), buffer2.get(), mask, halfSize, width, height*depth, channels);
+    convolveLines(buffer2.get(), buffer1.get(), mask, halfSize, height, lineSize, lineSize, depth);
+    float* result = buffer1.get();
+    if(depth > 1) {
+        convolveLines(buffer1.get(), buffer2.get(), mask, halfSize, depth, lineSize*height, lineSize*height, 1);
+        result = buffer2.get();
+    }
+
+    ImageAccess::pointer outputAccess = output->getImageAccess(ACCESS_READ_WRITE);
+    switch(output->getDataType()) {
+        fastSwitchTypeMacro(convertFromFloat<FAST_TYPE>(result, (FAST_TYPE*)outputAccess->get(), size));
     }
 }
 
@@ -220,10 +270,7 @@ void GaussianSmoothingFilter::execute() {
 
 
     if(device->isHost()) {
-        createMask(input, maskSize, false);
-        switch(input->getDataType()) {
-            fastSwitchTypeMacro(executeAlgorithmOnHost<FAST_TYPE>(input, output, mMask.get(), maskSize));
-        }
+        executeOnHost(input, output, maskSize);
     } else {
         OpenCLDevice::pointer clDevice = std::static_pointer_cast<OpenCLDevice>(device);
 
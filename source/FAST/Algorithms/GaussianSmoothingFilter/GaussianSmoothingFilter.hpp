@@ -20,6 +20,7 @@ class FAST_EXPORT  GaussianSmoothingFilter : public ProcessObject {
         void waitToFinish();
         void createMask(Image::pointer input, uchar maskSize, bool useSeperableFilter);
         void recompileOpenCLCode(Image::pointer input);
+        void executeOnHost(Image::pointer input, Image::pointer output, uchar maskSize);
 
         char mMaskSize;
         float mStdDev;
@@ -27,6 +28,7 @@ class FAST_EXPORT  GaussianSmoothingFilter : public ProcessObject {
         cl::Buffer mCLMask;
         std::unique_ptr<float[]> mMask;
         bool mRecreateMask;
+        bool mMaskIsSeperable = false;
 
         cl::Kernel mKernel;
         unsigned char mDimensionCLCodeCompiledFor;
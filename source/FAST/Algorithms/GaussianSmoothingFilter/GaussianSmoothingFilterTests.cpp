@@ -24,6 +24,65 @@ TEST_CASE("Even input as mask size throws exception in GaussianSmoothingFilter",
     CHECK_THROWS(filter->setMaskSize(2));
 }
 
+static Image::pointer createRandomImage(Vector3ui size, DataType type) {
+    auto image = Image::New();
+    if(size.z() > 1) {
+        image->create(size, type, 1);
+    } else {
+        image->create(size.x(), size.y(), type, 1);
+    }
+    auto access = image->getImageAccess(ACCESS_READ_WRITE);
+    for(uint i = 0; i < size.prod(); ++i)
+        access->setScalar(i, rand() % 255);
+    return image;
+}
+
+static Image::pointer runGaussianSmoothing(Image::pointer input, ExecutionDevice::pointer device, uchar maskSize, float stdDev, float& runtime) {
+    auto filter = GaussianSmoothingFilter::New();
+    filter->setMainDevice(device);
+    filter->setMaskSize(maskSize);
+    filter->setStandardDeviation(stdDev);
+    filter->setInputData(input);
+    filter->enableRuntimeMeasurements();
+    auto port = filter->getOutputPort();
+    filter->update();
+    runtime = filter->getRuntime()->getSum();
+    return port->getNextFrame<Image>();
+}
+
+static void checkHostAndOpenCLOutputEqual(Image::pointer input, uchar maskSize, float stdDev) {
+    float runtime;
+    auto hostOutput = runGaussianSmoothing(input, Host::getInstance(), maskSize, stdDev, runtime);
+    auto clOutput = runGaussianSmoothing(input, DeviceManager::getInstance()->getDefaultComputationDevice(), maskSize, stdDev, runtime);
+    auto hostAccess = hostOutput->getImageAccess(ACCESS_READ);
+    auto clAccess = clOutput->getImageAccess(ACCESS_READ);
+    float maxDifference = 0;
+    for(uint i = 0; i < input->getNrOfVoxels(); ++i)
+        maxDifference = std::max(maxDifference, std::fabs(hostAccess->getScalar(i) - clAccess->getScalar(i)));
+    // Allow difference of one because of rounding to integer
+    CHECK(maxDifference <= 1.0f);
+}
+
+TEST_CASE("GaussianSmoothingFilter on Host gives same output as OpenCL 2D", "[fast][GaussianSmoothingFilter]") {
+    checkHostAndOpenCLOutputEqual(createRandomImage(Vector3ui(67, 45, 1), TYPE_UINT8), 7, 1.5f);
+    checkHostAndOpenCLOutputEqual(createRandomImage(Vector3ui(67, 45, 1), TYPE_FLOAT), 5, 1.0f);
+}
+
+TEST_CASE("GaussianSmoothingFilter on Host gives same output as OpenCL 3D", "[fast][GaussianSmoothingFilter]") {
+    checkHostAndOpenCLOutputEqual(createRandomImage(Vector3ui(33, 27, 19), TYPE_UINT8), 7, 1.5f);
+    checkHostAndOpenCLOutputEqual(createRandomImage(Vector3ui(33, 27, 19), TYPE_FLOAT), 5, 1.0f);
+}
+
+TEST_CASE("GaussianSmoothingFilter Host vs OpenCL benchmark", "[fast][GaussianSmoothingFilter][benchmark]") {
+    auto input = createRandomImage(Vector3ui(256, 256, 256), TYPE_UINT16);
+    for(uchar maskSize : {3, 7, 11}) {
+        float hostRuntime, clRuntime;
+        runGaussianSmoothing(input, Host::getInstance(), maskSize, maskSize/3.0f, hostRuntime);
+        runGaussianSmoothing(input, DeviceManager::getInstance()->getDefaultComputationDevice(), maskSize, maskSize/3.0f, clRuntime);
+        std::cout << "Mask size " << (int)maskSize << ": Host " << hostRuntime << " ms, OpenCL " << clRuntime << " ms" << std::endl;
+    }
+}
+
 /*
 TEST_CASE("Correct output with small 3x3 2D image as input to GaussianSmoothingFilter on OpenCLDevice", "[fast][GaussianSmoothingFilter]") {
     DeviceManager* deviceManager = DeviceManager::getInstance();
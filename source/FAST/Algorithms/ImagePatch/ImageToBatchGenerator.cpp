@@ -9,56 +9,127 @@ ImageToBatchGenerator::ImageToBatchGenerator() {
     createOutputPort<Batch>(0);
 
     m_maxBatchSize = -1;
+    createIntegerAttribute("max-batch-size", "Max batch size", "Maximum number of images in a batch", m_maxBatchSize);
+    createIntegerAttribute("max-latency", "Max latency", "Max time in milliseconds to wait for a batch to fill up, 0 or less disables it", m_maxLatency);
+    createBooleanAttribute("padding", "Padding", "Pad batches to the max batch size", m_padding);
 }
 
-void ImageToBatchGenerator::generateStream() {
-    std::vector<Image::pointer> imageList;
-    imageList.reserve(m_maxBatchSize);
-    int i = 0;
-    bool lastFrame = false;
-    // Update will eventually block, therefore we need to call this in a separate thread
+void ImageToBatchGenerator::loadAttributes() {
+    // Max batch size has no valid default, and is checked in execute if it is not set
+    const int maxBatchSize = getIntegerAttribute("max-batch-size");
+    if(maxBatchSize > 0)
+        setMaxBatchSize(maxBatchSize);
+    setMaxLatency(getIntegerAttribute("max-latency"));
+    setPadding(getBooleanAttribute("padding"));
+}
+
+void ImageToBatchGenerator::readFrames() {
+    // Update will eventually block, therefore this is done in a separate thread from the one creating batches
     auto po = mParent->getProcessObject();
     bool firstTime = true;
+    bool lastFrame = false;
     while(!lastFrame) {
         {
-            std::unique_lock<std::mutex> lock(m_stopMutex);
-            if(m_stop) {
-                m_streamIsStarted = false;
-                m_firstFrameIsInserted = false;
+            // Don't read further ahead than one batch
+            std::unique_lock<std::mutex> lock(m_framesMutex);
+            m_framesCondition.wait(lock, [this] { return (int)m_frames.size() < m_maxBatchSize || m_stopReader; });
+            if(m_stopReader)
                 break;
-            }
         }
-        if(!firstTime) // parent is execute the first time, thus drop it here
-            po->update(); // Make sure execute is called on previous
-        firstTime = false;
         Image::pointer image;
         try {
+            if(!firstTime) // parent is execute the first time, thus drop it here
+                po->update(); // Make sure execute is called on previous
+            firstTime = false;
             image = mParent->getNextFrame<Image>();
         } catch(ThreadStopped &e) {
             break;
         }
         lastFrame = image->isLastFrame();
-        imageList.push_back(image);
-        if(imageList.size() == m_maxBatchSize || lastFrame) {
-            auto batch = Batch::New();
-            batch->create(imageList);
-            if(lastFrame)
-                batch->setLastFrame(getNameOfClass());
-            try {
-                addOutputData(0, batch);
-            } catch(ThreadStopped &e) {
+        {
+            std::lock_guard<std::mutex> lock(m_framesMutex);
+            m_frames.push_back(image);
+        }
+        m_framesCondition.notify_all();
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_framesMutex);
+        m_readerFinished = true;
+    }
+    m_framesCondition.notify_all();
+}
+
+void ImageToBatchGenerator::generateStream() {
+    m_readerFinished = false;
+    m_stopReader = false;
+    std::thread reader(std::bind(&ImageToBatchGenerator::readFrames, this));
+    std::vector<Image::pointer> imageList;
+    imageList.reserve(m_maxBatchSize);
+    bool lastFrame = false;
+    while(!lastFrame) {
+        {
+            std::unique_lock<std::mutex> lock(m_framesMutex);
+            const auto canEmit = [this, &imageList]() {
+                return (int)(imageList.size() + m_frames.size()) >= m_maxBatchSize || m_readerFinished || m_stop;
+            };
+            // Wait for the first frame of the batch
+            m_framesCondition.wait(lock, [this, &canEmit]() { return !m_frames.empty() || canEmit(); });
+            // Wait for the batch to fill up, or for the deadline to expire
+            if(m_maxLatency > 0) {
+                const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(m_maxLatency);
+                m_framesCondition.wait_until(lock, deadline, canEmit);
+            } else {
+                m_framesCondition.wait(lock, canEmit);
+            }
+            if(m_stop) {
+                m_streamIsStarted = false;
+                m_firstFrameIsInserted = false;
                 break;
             }
-            frameAdded();
-            imageList.clear();
-            i++;
+            while(!m_frames.empty() && (int)imageList.size() < m_maxBatchSize) {
+                imageList.push_back(m_frames.front());
+                m_frames.pop_front();
+            }
+            if(imageList.empty()) // Reader was stopped without delivering the last frame
+                break;
+            lastFrame = imageList.back()->isLastFrame();
+        }
+        // Reader may be waiting for room
+        m_framesCondition.notify_all();
+
+        const int batchSize = imageList.size();
+        if(m_padding) {
+            while((int)imageList.size() < m_maxBatchSize)
+                imageList.push_back(imageList.back());
+        }
+        auto batch = Batch::New();
+        batch->create(imageList);
+        batch->setFrameData("batch-size", std::to_string(batchSize));
+        if(lastFrame)
+            batch->setLastFrame(getNameOfClass());
+        try {
+            addOutputData(0, batch);
+        } catch(ThreadStopped &e) {
+            break;
         }
+        frameAdded();
+        imageList.clear();
     }
-    //updateThread.join();
+
+    bool readerFinished;
+    {
+        std::lock_guard<std::mutex> lock(m_framesMutex);
+        m_stopReader = true;
+        readerFinished = m_readerFinished;
+    }
+    m_framesCondition.notify_all();
+    if(!readerFinished)
+        mParent->stop(); // Unblock the reader if it is waiting for the parent
+    reader.join();
 }
 
 void ImageToBatchGenerator::execute() {
-    if(m_maxBatchSize == 1)
+    if(m_maxBatchSize < 1)
         throw Exception("Max batch size must be given to the ImageToBatchGenerator");
 
     if(!m_streamIsStarted) {
@@ -78,8 +149,28 @@ void ImageToBatchGenerator::setMaxBatchSize(int size) {
     mIsModified = true;
 }
 
+void ImageToBatchGenerator::setMaxLatency(int milliseconds) {
+    m_maxLatency = milliseconds;
+    mIsModified = true;
+}
+
+void ImageToBatchGenerator::setPadding(bool padding) {
+    m_padding = padding;
+    mIsModified = true;
+}
+
+void ImageToBatchGenerator::stop() {
+    {
+        // Wake up the stream thread if it is waiting for frames
+        std::lock_guard<std::mutex> lock(m_framesMutex);
+        m_stop = true;
+    }
+    m_framesCondition.notify_all();
+    Streamer::stop();
+}
+
 ImageToBatchGenerator::~ImageToBatchGenerator() {
     stop();
 }
 
-}
\ No newline at end of file
+}
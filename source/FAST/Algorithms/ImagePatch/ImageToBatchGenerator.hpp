@@ -2,24 +2,59 @@
 
 #include <FAST/Streamers/Streamer.hpp>
 #include <thread>
+#include <deque>
+#include <condition_variable>
 
 namespace fast {
 
 class Image;
 
+/**
+ * Collects a stream of images into batches.
+ *
+ * A batch is emitted when it has reached the max batch size, or when the last frame arrives.
+ * If a max latency is set, a batch is also emitted when the max latency has passed since
+ * its first frame arrived, thus batches on a live stream can be smaller than the max batch size.
+ * With padding enabled, such batches are padded to the max batch size by repeating the last image,
+ * and the number of real images is stored in the "batch-size" frame data of the batch.
+ * The frame data of each image is kept, and NeuralNetwork copies it to the corresponding output.
+ */
 class FAST_EXPORT ImageToBatchGenerator : public Streamer {
     FAST_OBJECT(ImageToBatchGenerator)
     public:
         void setMaxBatchSize(int size);
+        /**
+         * Set the maximum time to wait for a batch to fill up, measured from when its first frame arrived.
+         * A value of 0 or less disables the deadline. Default is disabled.
+         * @param milliseconds
+         */
+        void setMaxLatency(int milliseconds);
+        /**
+         * Pad batches which are smaller than the max batch size. Useful for inference engines
+         * which require a fixed batch size; set the max batch size to the engine's getMaxBatchSize().
+         * @param padding
+         */
+        void setPadding(bool padding);
+        void loadAttributes() override;
+        void stop() override;
         ~ImageToBatchGenerator() override;
     protected:
         void execute() override;
         void generateStream() override;
+        void readFrames();
         int m_maxBatchSize;
+        int m_maxLatency = -1;
+        bool m_padding = false;
 
         DataChannel::pointer mParent;
+        // Frames received from the parent which have not been added to a batch yet
+        std::deque<SharedPointer<Image>> m_frames;
+        std::mutex m_framesMutex;
+        std::condition_variable m_framesCondition;
+        bool m_readerFinished = false;
+        bool m_stopReader = false;
     private:
         ImageToBatchGenerator();
 };
 
-}
\ No newline at end of file
+}
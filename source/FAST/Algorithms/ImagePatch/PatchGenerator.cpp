@@ -1,6 +1,7 @@
 #include <FAST/Data/ImagePyramid.hpp>
 #include <FAST/Data/Image.hpp>
 #include "PatchGenerator.hpp"
+#include <condition_variable>
 
 namespace fast {
 
@@ -17,10 +18,18 @@ PatchGenerator::PatchGenerator() {
     m_streamIsStarted = false;
     m_firstFrameIsInserted = false;
     m_level = 0;
+    m_overlap = 0.0f;
+    m_maskThreshold = 0.0f;
+    m_decoderThreads = 4;
+    m_readAhead = 16;
     mIsModified = true;
 
     createIntegerAttribute("patch-size", "Patch size", "", 0);
     createIntegerAttribute("patch-level", "Patch level", "Patch level used for image pyramid inputs", m_level);
+    createFloatAttribute("patch-overlap", "Patch overlap", "Overlap of neighbouring patches as a fraction of patch size", m_overlap);
+    createFloatAttribute("mask-threshold", "Mask threshold", "Minimum fraction of a patch which has to be covered by the mask", m_maskThreshold);
+    createIntegerAttribute("decoder-threads", "Decoder threads", "Number of threads decoding image pyramid patches", m_decoderThreads);
+    createIntegerAttribute("read-ahead", "Read ahead", "Maximum number of image pyramid patches to decode ahead of the patch being emitted", m_readAhead);
 }
 
 void PatchGenerator::loadAttributes() {
@@ -34,6 +43,39 @@ void PatchGenerator::loadAttributes() {
     }
 
     setPatchLevel(getIntegerAttribute("patch-level"));
+    setOverlap(getFloatAttribute("patch-overlap"));
+    setMaskThreshold(getFloatAttribute("mask-threshold"));
+    setNumberOfDecoderThreads(getIntegerAttribute("decoder-threads"));
+    setReadAheadLimit(getIntegerAttribute("read-ahead"));
+}
+
+/**
+ * Number of patches needed to cover size pixels, when patches of patchSize pixels are placed stride pixels apart
+ */
+static int getNumberOfPatches(int size, int patchSize, int stride) {
+    if(size <= patchSize)
+        return 1;
+    return 1 + (int)std::ceil((float)(size - patchSize) / stride);
+}
+
+/**
+ * Fraction of the pixels in the mask, covering the given region of an image of size width x height, which are not zero
+ */
+static float getMaskCoverage(Image::pointer mask, const ImageAccess::pointer& maskAccess, int width, int height, int offsetX, int offsetY, int patchWidth, int patchHeight) {
+    const int maskWidth = mask->getWidth();
+    const int maskHeight = mask->getHeight();
+    const int startX = std::min((int)std::floor((float)offsetX * maskWidth / width), maskWidth - 1);
+    const int startY = std::min((int)std::floor((float)offsetY * maskHeight / height), maskHeight - 1);
+    const int endX = std::min(std::max((int)std::ceil((float)(offsetX + patchWidth) * maskWidth / width), startX + 1), maskWidth);
+    const int endY = std::min(std::max((int)std::ceil((float)(offsetY + patchHeight) * maskHeight / height), startY + 1), maskHeight);
+    int count = 0;
+    for(int y = startY; y < endY; ++y) {
+        for(int x = startX; x < endX; ++x) {
+            if(maskAccess->getScalar(Vector2i(x, y)) != 0)
+                ++count;
+        }
+    }
+    return (float)count / ((endX - startX)*(endY - startY));
 }
 
 PatchGenerator::~PatchGenerator() {
@@ -46,73 +88,155 @@ void PatchGenerator::generateStream() {
     if(m_inputImagePyramid) {
         const int levelWidth = m_inputImagePyramid->getLevelWidth(m_level);
         const int levelHeight = m_inputImagePyramid->getLevelHeight(m_level);
-        const int patchesX = std::ceil((float) levelWidth / m_width);
-        const int patchesY = std::ceil((float) levelHeight / m_height);
-
-        for(int patchY = 0; patchY < patchesY; ++patchY) {
-            for(int patchX = 0; patchX < patchesX; ++patchX) {
-                mRuntimeManager->startRegularTimer("create patch");
-                int patchWidth = m_width;
-                if(patchX == patchesX - 1)
-                    patchWidth = levelWidth - patchX * m_width - 1;
-                int patchHeight = m_height;
-                if(patchY == patchesY - 1)
-                    patchHeight = levelHeight - patchY * m_height - 1;
-
-                if(m_inputMask) {
-                    // If a mask exist, check if this patch should be included or not
-                    auto access = m_inputMask->getImageAccess(ACCESS_READ);
-                    // Take center of patch
-                    Vector2i position(
-                            round(m_inputMask->getWidth() * ((float) patchX / patchesX + 0.5f / patchesX)),
-                            round(m_inputMask->getHeight() * ((float) patchY / patchesY + 0.5f / patchesY))
-                    );
-                    float value = access->getScalar(position);
-                    if(value != 1)
-                        continue;
+        const int overlapX = std::min((int)std::round(m_width * m_overlap), m_width - 1);
+        const int overlapY = std::min((int)std::round(m_height * m_overlap), m_height - 1);
+        const int strideX = m_width - overlapX;
+        const int strideY = m_height - overlapY;
+        const int patchesX = getNumberOfPatches(levelWidth, m_width, strideX);
+        const int patchesY = getNumberOfPatches(levelHeight, m_height, strideY);
+
+        // Find all patches to generate before decoding any of them, skipping patches without tissue in the mask
+        struct PatchRegion {
+            int patchX, patchY;
+            int offsetX, offsetY;
+            int width, height;
+        };
+        std::vector<PatchRegion> regions;
+        {
+            ImageAccess::pointer maskAccess;
+            if(m_inputMask)
+                maskAccess = m_inputMask->getImageAccess(ACCESS_READ);
+            for(int patchY = 0; patchY < patchesY; ++patchY) {
+                for(int patchX = 0; patchX < patchesX; ++patchX) {
+                    PatchRegion region;
+                    region.patchX = patchX;
+                    region.patchY = patchY;
+                    region.offsetX = patchX * strideX;
+                    region.offsetY = patchY * strideY;
+                    region.width = m_width;
+                    if(patchX == patchesX - 1)
+                        region.width = levelWidth - region.offsetX - 1;
+                    region.height = m_height;
+                    if(patchY == patchesY - 1)
+                        region.height = levelHeight - region.offsetY - 1;
+
+                    if(maskAccess) {
+                        const float coverage = getMaskCoverage(m_inputMask, maskAccess, levelWidth, levelHeight,
+                                region.offsetX, region.offsetY, region.width, region.height);
+                        if(coverage == 0.0f || coverage < m_maskThreshold)
+                            continue;
+                    }
+                    regions.push_back(region);
+                }
+            }
+        }
+        reportInfo() << "Generating " << regions.size() << " of " << patchesX*patchesY << " patches" << reportEnd();
+
+        // Patch data is read and decoded by a pool of threads, while this thread creates the images and emits them in order.
+        // Decoding may run at most m_readAhead patches ahead of the patch being emitted.
+        auto access = m_inputImagePyramid->getAccess(ACCESS_READ);
+        std::vector<std::unique_ptr<uchar[]>> decodedPatches(regions.size());
+        std::mutex decodeMutex;
+        std::condition_variable decodeCondition;
+        int nextToDecode = 0;
+        int nextToEmit = 0;
+        bool stopDecoding = false;
+        std::string decodeError;
+        auto decoder = [&]() {
+            while(true) {
+                int index;
+                {
+                    std::unique_lock<std::mutex> lock(decodeMutex);
+                    decodeCondition.wait(lock, [&]() {
+                        return stopDecoding || nextToDecode >= (int)regions.size() || nextToDecode < nextToEmit + m_readAhead;
+                    });
+                    if(stopDecoding || nextToDecode >= (int)regions.size())
+                        return;
+                    index = nextToDecode++;
                 }
-                reportInfo() << "Generating patch " << patchX << " " << patchY << reportEnd();
-                auto access = m_inputImagePyramid->getAccess(ACCESS_READ);
-                auto patch = access->getPatchAsImage(m_level, patchX * m_width, patchY * m_height,
-                                                                  patchWidth,
-                                                                  patchHeight);
-
-                // Store some frame data useful for patch stitching
-                patch->setFrameData("original-width", std::to_string(levelWidth));
-                patch->setFrameData("original-height", std::to_string(levelHeight));
-                patch->setFrameData("patchid-x", std::to_string(patchX));
-                patch->setFrameData("patchid-y", std::to_string(patchY));
-                // Target width/height of patches
-                patch->setFrameData("patch-width", std::to_string(m_width));
-                patch->setFrameData("patch-height", std::to_string(m_height));
-                patch->setFrameData("patch-spacing-x", std::to_string(patch->getSpacing().x()));
-                patch->setFrameData("patch-spacing-y", std::to_string(patch->getSpacing().y()));
-
-                mRuntimeManager->stopRegularTimer("create patch");
+                const auto& region = regions[index];
+                std::unique_ptr<uchar[]> data;
                 try {
-                    if(previousPatch) {
-                        addOutputData(0, previousPatch);
-                        frameAdded();
-                    }
-                } catch(ThreadStopped &e) {
-                    std::unique_lock<std::mutex> lock(m_stopMutex);
-                    m_stop = true;
+                    data = access->getPatchData(m_level, region.offsetX, region.offsetY, region.width, region.height);
+                } catch(std::exception &e) {
+                    std::unique_lock<std::mutex> lock(decodeMutex);
+                    decodeError = e.what();
+                    stopDecoding = true;
+                    decodeCondition.notify_all();
+                    return;
+                }
+                {
+                    std::unique_lock<std::mutex> lock(decodeMutex);
+                    decodedPatches[index] = std::move(data);
+                }
+                decodeCondition.notify_all();
+            }
+        };
+        std::vector<std::thread> decoderThreads;
+        for(int i = 0; i < std::min(m_decoderThreads, (int)regions.size()); ++i)
+            decoderThreads.emplace_back(decoder);
+
+        for(int i = 0; i < (int)regions.size(); ++i) {
+            mRuntimeManager->startRegularTimer("create patch");
+            std::unique_ptr<uchar[]> data;
+            {
+                std::unique_lock<std::mutex> lock(decodeMutex);
+                decodeCondition.wait(lock, [&]() { return decodedPatches[i] || stopDecoding; });
+                if(!decodedPatches[i])
                     break;
+                data = std::move(decodedPatches[i]);
+                ++nextToEmit;
+            }
+            decodeCondition.notify_all();
+            const auto& region = regions[i];
+            reportInfo() << "Generating patch " << region.patchX << " " << region.patchY << reportEnd();
+            auto patch = access->getPatchDataAsImage(m_level, region.width, region.height, std::move(data));
+
+            // Store some frame data useful for patch stitching
+            patch->setFrameData("original-width", std::to_string(levelWidth));
+            patch->setFrameData("original-height", std::to_string(levelHeight));
+            patch->setFrameData("patchid-x", std::to_string(region.patchX));
+            patch->setFrameData("patchid-y", std::to_string(region.patchY));
+            // Target width/height of patches
+            patch->setFrameData("patch-width", std::to_string(m_width));
+            patch->setFrameData("patch-height", std::to_string(m_height));
+            patch->setFrameData("patch-offset-x", std::to_string(region.offsetX));
+            patch->setFrameData("patch-offset-y", std::to_string(region.offsetY));
+            patch->setFrameData("patch-overlap-x", std::to_string(overlapX));
+            patch->setFrameData("patch-overlap-y", std::to_string(overlapY));
+            patch->setFrameData("patch-spacing-x", std::to_string(patch->getSpacing().x()));
+            patch->setFrameData("patch-spacing-y", std::to_string(patch->getSpacing().y()));
+            mRuntimeManager->stopRegularTimer("create patch");
+            try {
+                if(previousPatch) {
+                    addOutputData(0, previousPatch);
+                    frameAdded();
                 }
-                previousPatch = patch;
+            } catch(ThreadStopped &e) {
                 std::unique_lock<std::mutex> lock(m_stopMutex);
-                if(m_stop)
-                    break;
+                m_stop = true;
+                break;
             }
+            previousPatch = patch;
             std::unique_lock<std::mutex> lock(m_stopMutex);
             if(m_stop) {
-                //m_streamIsStarted = false;
                 m_firstFrameIsInserted = false;
                 break;
             }
         }
+        {
+            std::unique_lock<std::mutex> lock(decodeMutex);
+            stopDecoding = true;
+        }
+        decodeCondition.notify_all();
+        for(auto&& thread : decoderThreads)
+            thread.join();
+        if(!decodeError.empty()) {
+            // Do not mark the patches emitted so far as a complete stream
+            streamError("Error decoding patch in PatchGenerator: " + decodeError);
+            return;
+        }
     } else if(m_inputVolume) {
-        // TODO Support patching in x and y direction as well for volumes. For now, only depth
         const int width = m_inputVolume->getWidth();
         const int height = m_inputVolume->getHeight();
         const int depth = m_inputVolume->getDepth();
@@ -121,16 +245,31 @@ void PatchGenerator::generateStream() {
         for(int i = 0; i < 16; ++i)
             transformString += std::to_string(transformData[i]) + " ";
 
-        for(int z = 0; z < depth; z += m_depth) {
+        // Patches which are larger than the volume in x and y cover the entire volume in that direction
+        const Vector3i patchSize(std::min(m_width, width), std::min(m_height, height), m_depth);
+        const Vector3i overlap = (patchSize.cast<float>() * m_overlap).array().round().cast<int>().cwiseMin(patchSize.array() - 1);
+        const Vector3i stride = patchSize - overlap;
+        const int patchesX = getNumberOfPatches(width, patchSize.x(), stride.x());
+        const int patchesY = getNumberOfPatches(height, patchSize.y(), stride.y());
+        const int patchesZ = getNumberOfPatches(depth, patchSize.z(), stride.z());
+
+        for(int i = 0; i < patchesX * patchesY * patchesZ; ++i) {
             mRuntimeManager->startRegularTimer("create patch");
-            auto patch = m_inputVolume->crop(Vector3i(0, 0, z), Vector3i(width, height, m_depth), true);
+            const int patchX = i % patchesX;
+            const int patchY = (i / patchesX) % patchesY;
+            const int patchZ = i / (patchesX * patchesY);
+            const Vector3i offset(patchX * stride.x(), patchY * stride.y(), patchZ * stride.z());
+            auto patch = m_inputVolume->crop(offset, patchSize, true);
             patch->setFrameData("original-width", std::to_string(width));
             patch->setFrameData("original-height", std::to_string(height));
             patch->setFrameData("original-depth", std::to_string(depth));
             patch->setFrameData("original-transform", transformString);
-            patch->setFrameData("patch-offset-x", std::to_string(0));
-            patch->setFrameData("patch-offset-y", std::to_string(0));
-            patch->setFrameData("patch-offset-z", std::to_string(z));
+            patch->setFrameData("patch-offset-x", std::to_string(offset.x()));
+            patch->setFrameData("patch-offset-y", std::to_string(offset.y()));
+            patch->setFrameData("patch-offset-z", std::to_string(offset.z()));
+            patch->setFrameData("patch-overlap-x", std::to_string(overlap.x()));
+            patch->setFrameData("patch-overlap-y", std::to_string(overlap.y()));
+            patch->setFrameData("patch-overlap-z", std::to_string(overlap.z()));
             Vector3f spacing = m_inputVolume->getSpacing();
             patch->setFrameData("patch-spacing-x", std::to_string(spacing.x()));
             patch->setFrameData("patch-spacing-y", std::to_string(spacing.y()));
@@ -155,6 +294,16 @@ void PatchGenerator::generateStream() {
     } else {
         throw Exception("Unsupported data object given to PatchGenerator");
     }
+    if(!previousPatch) {
+        bool stopped;
+        {
+            std::unique_lock<std::mutex> lock(m_stopMutex);
+            stopped = m_stop;
+        }
+        if(!stopped)
+            streamError("PatchGenerator did not generate any patches");
+        return;
+    }
     // Add final patch, and mark it has last frame
     previousPatch->setLastFrame(getNameOfClass());
     try {
@@ -194,4 +343,32 @@ void PatchGenerator::setPatchLevel(int level) {
     mIsModified = true;
 }
 
+void PatchGenerator::setOverlap(float overlap) {
+    if(overlap < 0.0f || overlap >= 1.0f)
+        throw Exception("Patch overlap must be in the range [0, 1)");
+    m_overlap = overlap;
+    mIsModified = true;
+}
+
+void PatchGenerator::setMaskThreshold(float threshold) {
+    if(threshold < 0.0f || threshold > 1.0f)
+        throw Exception("Mask threshold must be in the range [0, 1]");
+    m_maskThreshold = threshold;
+    mIsModified = true;
+}
+
+void PatchGenerator::setNumberOfDecoderThreads(int threads) {
+    if(threads <= 0)
+        throw Exception("Number of decoder threads must be larger than 0");
+    m_decoderThreads = threads;
+    mIsModified = true;
+}
+
+void PatchGenerator::setReadAheadLimit(int patches) {
+    if(patches <= 0)
+        throw Exception("Read ahead limit must be larger than 0");
+    m_readAhead = patches;
+    mIsModified = true;
+}
+
 }
\ No newline at end of file
@@ -14,6 +14,36 @@ class FAST_EXPORT PatchGenerator : public Streamer {
     public:
         void setPatchSize(int width, int height, int depth = 1);
         void setPatchLevel(int level);
+        /**
+         * Set how much neighbouring patches should overlap, as a fraction of the patch size.
+         * Default is 0, no overlap. E.g. 0.125 with a patch size of 512 gives 64 pixels of overlap.
+         * The overlap is stored as frame data, so that PatchStitcher can blend the overlapping regions.
+         *
+         * @param overlap fraction of patch size, in range [0, 1)
+         */
+        void setOverlap(float overlap);
+        /**
+         * Set the minimum fraction of a patch which has to be covered by the mask (input port 1),
+         * e.g. from TissueSegmentation, for the patch to be generated. Patches without any coverage are always
+         * skipped, before they are read from the image pyramid. Default is 0.
+         *
+         * @param threshold fraction in range [0, 1]
+         */
+        void setMaskThreshold(float threshold);
+        /**
+         * Set the number of threads which read and decode patches from image pyramids in parallel. Default is 4.
+         * Patches are still emitted in the same order as with a single thread.
+         *
+         * @param threads
+         */
+        void setNumberOfDecoderThreads(int threads);
+        /**
+         * Set the maximum number of image pyramid patches which are decoded ahead of the patch being emitted.
+         * This limits the memory used by the decoder threads. Default is 16.
+         *
+         * @param patches
+         */
+        void setReadAheadLimit(int patches);
         ~PatchGenerator();
         void loadAttributes() override;
     protected:
@@ -23,6 +53,10 @@ class FAST_EXPORT PatchGenerator : public Streamer {
         SharedPointer<Image> m_inputVolume;
         SharedPointer<Image> m_inputMask;
         int m_level;
+        float m_overlap;
+        float m_maskThreshold;
+        int m_decoderThreads;
+        int m_readAhead;
 
         void execute() override;
         void generateStream() override;
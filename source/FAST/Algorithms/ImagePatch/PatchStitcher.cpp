@@ -12,6 +12,57 @@ PatchStitcher::PatchStitcher() {
 
     createOpenCLProgram(Config::getKernelSourcePath() + "/Algorithms/ImagePatch/PatchStitcher2D.cl", "2D");
     createOpenCLProgram(Config::getKernelSourcePath() + "/Algorithms/ImagePatch/PatchStitcher3D.cl", "3D");
+
+    m_blendingMode = PATCH_BLENDING_LINEAR;
+    m_weightsInitialized = false;
+    createStringAttribute("blending", "Blending mode", "How to blend overlapping patches: none, linear or gaussian", "linear");
+}
+
+void PatchStitcher::setBlendingMode(PatchBlendingMode mode) {
+    m_blendingMode = mode;
+    mIsModified = true;
+}
+
+PatchBlendingMode PatchStitcher::getBlendingMode() const {
+    return m_blendingMode;
+}
+
+void PatchStitcher::loadAttributes() {
+    auto mode = getStringAttribute("blending");
+    if(mode == "none") {
+        setBlendingMode(PATCH_BLENDING_NONE);
+    } else if(mode == "linear") {
+        setBlendingMode(PATCH_BLENDING_LINEAR);
+    } else if(mode == "gaussian") {
+        setBlendingMode(PATCH_BLENDING_GAUSSIAN);
+    } else {
+        throw Exception("Unknown blending mode " + mode + " given to PatchStitcher. Expected none, linear or gaussian");
+    }
+}
+
+/**
+ * Get integer frame data, or the default value if the patch does not have it
+ */
+static int getFrameDataAsInteger(SharedPointer<DataObject> patch, std::string name, int defaultValue) {
+    try {
+        return std::stoi(patch->getFrameData(name));
+    } catch(Exception &e) {
+        return defaultValue;
+    }
+}
+
+void PatchStitcher::initializeWeights(SharedPointer<OpenCLDevice> device) {
+    if(m_weightsInitialized)
+        return;
+    // Sum of weighted values has one element per channel, the sum of weights one element per pixel
+    const std::size_t nrOfPixels = (std::size_t)m_outputImage->getWidth()*m_outputImage->getHeight()*m_outputImage->getDepth();
+    const std::size_t channels = m_outputImage->getNrOfChannels();
+    m_weightedSum = cl::Buffer(device->getContext(), CL_MEM_READ_WRITE, nrOfPixels*channels*sizeof(float));
+    m_weightSum = cl::Buffer(device->getContext(), CL_MEM_READ_WRITE, nrOfPixels*sizeof(float));
+    auto queue = device->getCommandQueue();
+    queue.enqueueFillBuffer(m_weightedSum, 0.0f, 0, nrOfPixels*channels*sizeof(float));
+    queue.enqueueFillBuffer(m_weightSum, 0.0f, 0, nrOfPixels*sizeof(float));
+    m_weightsInitialized = true;
 }
 
 void PatchStitcher::execute() {
@@ -61,6 +112,9 @@ void PatchStitcher::processTensor(SharedPointer<Tensor> patch) {
 
     const float patchSpacingX = std::stof(patch->getFrameData("patch-spacing-x"));
     const float patchSpacingY = std::stof(patch->getFrameData("patch-spacing-y"));
+    // With overlapping patches, patch centers are one stride apart
+    const int strideX = patchWidth - getFrameDataAsInteger(patch, "patch-overlap-x", 0);
+    const int strideY = patchHeight - getFrameDataAsInteger(patch, "patch-overlap-y", 0);
 
     auto shape = patch->getShape();
     if(shape.getDimensions() != 1) {
@@ -71,10 +125,14 @@ void PatchStitcher::processTensor(SharedPointer<Tensor> patch) {
     if(!m_outputTensor) {
         // Create output tensor
         m_outputTensor = Tensor::New();
-        TensorShape fullShape({(int)std::ceil((float)fullHeight / patchHeight), (int)std::ceil((float)fullWidth / patchWidth), channels});
+        TensorShape fullShape({
+            fullHeight <= patchHeight ? 1 : 1 + (int)std::ceil((float)(fullHeight - patchHeight) / strideY),
+            fullWidth <= patchWidth ? 1 : 1 + (int)std::ceil((float)(fullWidth - patchWidth) / strideX),
+            channels
+        });
         auto initializedData = std::make_unique<float[]>(fullShape.getTotalSize());
         m_outputTensor->create(std::move(initializedData), fullShape);
-        m_outputTensor->setSpacing(Vector3f(patchHeight*patchSpacingY, patchWidth*patchSpacingX, 1.0f));
+        m_outputTensor->setSpacing(Vector3f(strideY*patchSpacingY, strideX*patchSpacingX, 1.0f));
     }
     reportInfo() << "Stitching " << patch->getFrameData("patchid-x") << " " << patch->getFrameData("patchid-y") << reportEnd();
     reportInfo() << "Stitching data" << patch->getFrameData("patch-spacing-x") << " " << patch->getFrameData("patch-spacing-y") << reportEnd();
@@ -151,9 +209,18 @@ void PatchStitcher::processImage(SharedPointer<Image> patch) {
 
     auto device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
 
+    const int overlapX = getFrameDataAsInteger(patch, "patch-overlap-x", 0);
+    const int overlapY = getFrameDataAsInteger(patch, "patch-overlap-y", 0);
+    const int overlapZ = getFrameDataAsInteger(patch, "patch-overlap-z", 0);
+    const bool blend = m_blendingMode != PATCH_BLENDING_NONE && m_outputImage && (overlapX > 0 || overlapY > 0 || overlapZ > 0);
+    // Values are rounded when blending into images of integer type
+    const int roundValues = m_outputImage && m_outputImage->getDataType() != TYPE_FLOAT ? 1 : 0;
+
     if(fullDepth == 1) {
-		const int startX = std::stoi(patch->getFrameData("patchid-x")) * std::stoi(patch->getFrameData("patch-width"));
-		const int startY = std::stoi(patch->getFrameData("patchid-y")) * std::stoi(patch->getFrameData("patch-height"));
+        const int patchWidth = std::stoi(patch->getFrameData("patch-width"));
+        const int patchHeight = std::stoi(patch->getFrameData("patch-height"));
+		const int startX = getFrameDataAsInteger(patch, "patch-offset-x", std::stoi(patch->getFrameData("patchid-x")) * patchWidth);
+		const int startY = getFrameDataAsInteger(patch, "patch-offset-y", std::stoi(patch->getFrameData("patchid-y")) * patchHeight);
 		const int endX = startX + patch->getWidth();
 		const int endY = startY + patch->getHeight();
 		reportInfo() << "Stitching " << patch->getFrameData("patchid-x") << " " << patch->getFrameData("patchid-y")
@@ -164,7 +231,24 @@ void PatchStitcher::processImage(SharedPointer<Image> patch) {
 			auto patchAccess = patch->getOpenCLImageAccess(ACCESS_READ, device);
             auto outputAccess = m_outputImage->getOpenCLImageAccess(ACCESS_READ_WRITE, device);
 
-            cl::Kernel kernel(program, "applyPatch2D");
+            cl::Kernel kernel;
+            if(blend) {
+                initializeWeights(device);
+                kernel = cl::Kernel(program, "applyPatch2DWeighted");
+                kernel.setArg(4, m_weightedSum);
+                kernel.setArg(5, m_weightSum);
+                kernel.setArg(6, fullWidth);
+                kernel.setArg(7, fullHeight);
+                kernel.setArg(8, m_outputImage->getNrOfChannels());
+                kernel.setArg(9, patchWidth);
+                kernel.setArg(10, patchHeight);
+                kernel.setArg(11, overlapX);
+                kernel.setArg(12, overlapY);
+                kernel.setArg(13, (int)m_blendingMode);
+                kernel.setArg(14, roundValues);
+            } else {
+                kernel = cl::Kernel(program, "applyPatch2D");
+            }
             kernel.setArg(0, *patchAccess->get2DImage());
             kernel.setArg(1, *outputAccess->get2DImage());
             kernel.setArg(2, startX);
@@ -178,13 +262,19 @@ void PatchStitcher::processImage(SharedPointer<Image> patch) {
         } else {
             enableRuntimeMeasurements();
             // Image pyramid, do it on CPU TODO: optimize somehow?
+            // Accumulating weights for the entire pyramid is too expensive, so when patches overlap
+            // only the center part of each patch is used: half of the overlap is cut away on each interior border.
             auto outputAccess = m_outputImagePyramid->getAccess(ACCESS_READ_WRITE);
             auto patchAccess = patch->getImageAccess(ACCESS_READ);
             mRuntimeManager->startRegularTimer("copy patch");
-            const int maxY = std::min(endY, fullHeight);
-            const int maxX = std::min(endX, fullWidth);
-            for(int y = startY; y < maxY; ++y) {
-                for(int x = startX; x < maxX; ++x) {
+            const int cutX = m_blendingMode == PATCH_BLENDING_NONE ? 0 : overlapX;
+            const int cutY = m_blendingMode == PATCH_BLENDING_NONE ? 0 : overlapY;
+            const int minY = startY > 0 ? startY + cutY / 2 : startY;
+            const int minX = startX > 0 ? startX + cutX / 2 : startX;
+            const int maxY = std::min(endY >= fullHeight - 1 ? endY : endY - (cutY - cutY / 2), fullHeight);
+            const int maxX = std::min(endX >= fullWidth - 1 ? endX : endX - (cutX - cutX / 2), fullWidth);
+            for(int y = minY; y < maxY; ++y) {
+                for(int x = minX; x < maxX; ++x) {
                     outputAccess->setScalarFast(x, y, 0, patchAccess->getScalarFast<uchar>(Vector2i(x - startX, y - startY)));
                 }
             }
@@ -193,15 +283,41 @@ void PatchStitcher::processImage(SharedPointer<Image> patch) {
         }
     } else {
         // 3D
-        const int startX = 0;
-        const int startY = 0;
+        const int startX = getFrameDataAsInteger(patch, "patch-offset-x", 0);
+        const int startY = getFrameDataAsInteger(patch, "patch-offset-y", 0);
         const int startZ = std::stoi(patch->getFrameData("patch-offset-z"));
-        const int endX = startX + patch->getWidth();
-        const int endY = startY + patch->getHeight();
-        reportInfo() << "Stitching " << startZ << reportEnd();
+        reportInfo() << "Stitching " << startX << " " << startY << " " << startZ << reportEnd();
 		auto patchAccess = patch->getOpenCLImageAccess(ACCESS_READ, device);
 
-        if(device->isWritingTo3DTexturesSupported()) {
+        if(blend) {
+            initializeWeights(device);
+            auto outputAccess = m_outputImage->getOpenCLBufferAccess(ACCESS_READ_WRITE, device);
+            cl::Program program = getOpenCLProgram(device, "3D", "-DTYPE=" + getCTypeAsString(m_outputImage->getDataType()));
+            cl::Kernel kernel(program, "applyPatch3DWeighted");
+            kernel.setArg(0, *patchAccess->get3DImage());
+            kernel.setArg(1, *outputAccess->get());
+            kernel.setArg(2, m_weightedSum);
+            kernel.setArg(3, m_weightSum);
+            kernel.setArg(4, startX);
+            kernel.setArg(5, startY);
+            kernel.setArg(6, startZ);
+            kernel.setArg(7, fullWidth);
+            kernel.setArg(8, fullHeight);
+            kernel.setArg(9, fullDepth);
+            kernel.setArg(10, m_outputImage->getNrOfChannels());
+            kernel.setArg(11, overlapX);
+            kernel.setArg(12, overlapY);
+            kernel.setArg(13, overlapZ);
+            kernel.setArg(14, (int)m_blendingMode);
+            kernel.setArg(15, roundValues);
+
+            device->getCommandQueue().enqueueNDRangeKernel(
+                kernel,
+                cl::NullRange,
+                cl::NDRange(patch->getWidth(), patch->getHeight(), patch->getDepth()),
+                cl::NullRange
+            );
+        } else if(device->isWritingTo3DTexturesSupported()) {
             auto outputAccess = m_outputImage->getOpenCLImageAccess(ACCESS_READ_WRITE, device);
             cl::Program program = getOpenCLProgram(device, "3D");
             cl::Kernel kernel(program, "applyPatch3D");
@@ -244,4 +360,4 @@ void PatchStitcher::processImage(SharedPointer<Image> patch) {
 }
 
 
-}
\ No newline at end of file
+}
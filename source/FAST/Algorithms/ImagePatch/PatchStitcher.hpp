@@ -8,21 +8,50 @@ class Image;
 class ImagePyramid;
 class Tensor;
 
+/**
+ * How overlapping patches are combined by the PatchStitcher
+ */
+enum PatchBlendingMode {
+    PATCH_BLENDING_NONE, // Last patch overwrites the overlapping region
+    PATCH_BLENDING_LINEAR, // Weights increase linearly from the patch border across the overlap
+    PATCH_BLENDING_GAUSSIAN // Gaussian weights centered in the patch
+};
+
+/**
+ * Stitches patches created by PatchGenerator back into a full image, volume or tensor.
+ *
+ * If the patches overlap (see PatchGenerator::setOverlap), the overlapping regions are blended
+ * with a weighted average to avoid seams between patches.
+ */
 class FAST_EXPORT PatchStitcher : public ProcessObject {
     FAST_OBJECT(PatchStitcher)
     public:
+        /**
+         * Set how overlapping patches are blended. Default is PATCH_BLENDING_LINEAR.
+         * Has no effect if the patches do not overlap.
+         * @param mode
+         */
+        void setBlendingMode(PatchBlendingMode mode);
+        PatchBlendingMode getBlendingMode() const;
+        void loadAttributes() override;
     protected:
         void execute() override;
 
         SharedPointer<Image> m_outputImage;
         SharedPointer<Tensor> m_outputTensor;
         SharedPointer<ImagePyramid> m_outputImagePyramid;
+        PatchBlendingMode m_blendingMode;
+        // Accumulated weighted patch values and weights, used when blending overlapping patches
+        cl::Buffer m_weightedSum;
+        cl::Buffer m_weightSum;
+        bool m_weightsInitialized;
 
         void processTensor(SharedPointer<Tensor> tensor);
         void processImage(SharedPointer<Image> tensor);
+        void initializeWeights(SharedPointer<OpenCLDevice> device);
     private:
         PatchStitcher();
 
 };
 
-}
\ No newline at end of file
+}
@@ -16,3 +16,77 @@ __kernel void applyPatch2D(
 		write_imagei(image, pos, read_imagei(patch, sampler, pos - (int2)(startX, startY)));
     }
 }
+
+/**
+ * Blending weight of a pixel at position x in a patch of the given size.
+ * blending 1: Linear ramp which increases from the patch border across the overlap
+ * blending 2: Gaussian centered in the patch
+ */
+float getPatchWeight(int x, int size, int overlap, int blending) {
+    if(blending == 1) {
+        const int distance = min(x, size - 1 - x);
+        return min(1.0f, (distance + 1.0f) / (overlap + 1.0f));
+    } else {
+        const float sigma = size / 8.0f;
+        const float distance = x - (size - 1) * 0.5f;
+        return max(exp(-distance*distance/(2.0f*sigma*sigma)), 1e-4f);
+    }
+}
+
+__kernel void applyPatch2DWeighted(
+        __read_only image2d_t patch,
+        __write_only image2d_t image,
+        __private int startX,
+        __private int startY,
+        __global float* weightedSum,
+        __global float* weightSum,
+        __private int width,
+        __private int height,
+        __private int channels,
+        __private int patchWidth,
+        __private int patchHeight,
+        __private int overlapX,
+        __private int overlapY,
+        __private int blending,
+        __private int roundValues
+    ) {
+    const int2 patchPos = {get_global_id(0), get_global_id(1)};
+    const int2 pos = patchPos + (int2)(startX, startY);
+    if(pos.x >= width || pos.y >= height)
+        return;
+
+    int dataType = get_image_channel_data_type(patch);
+    float4 value;
+    if(dataType == CLK_FLOAT) {
+		value = read_imagef(patch, sampler, patchPos);
+	} else if(dataType == CLK_UNSIGNED_INT8 || dataType == CLK_UNSIGNED_INT16) {
+		value = convert_float4(read_imageui(patch, sampler, patchPos));
+	} else {
+		value = convert_float4(read_imagei(patch, sampler, patchPos));
+    }
+
+    const float weight = getPatchWeight(patchPos.x, patchWidth, overlapX, blending)*
+                         getPatchWeight(patchPos.y, patchHeight, overlapY, blending);
+
+    // Each pixel is only updated by one work-item, and patches are applied in order, so no atomics are needed
+    const int index = pos.x + pos.y*width;
+    const float totalWeight = weightSum[index] + weight;
+    weightSum[index] = totalWeight;
+    float values[4] = {value.x, value.y, value.z, value.w};
+    float result[4] = {0, 0, 0, 0};
+    for(int c = 0; c < channels; ++c) {
+        const float sum = weightedSum[index*channels + c] + weight*values[c];
+        weightedSum[index*channels + c] = sum;
+        result[c] = roundValues == 1 ? round(sum / totalWeight) : sum / totalWeight;
+    }
+
+    int outputDataType = get_image_channel_data_type(image);
+    float4 output = {result[0], result[1], result[2], result[3]};
+    if(outputDataType == CLK_FLOAT) {
+		write_imagef(image, pos, output);
+	} else if(outputDataType == CLK_UNSIGNED_INT8 || outputDataType == CLK_UNSIGNED_INT16) {
+		write_imageui(image, pos, convert_uint4(output));
+	} else {
+		write_imagei(image, pos, convert_int4(output));
+    }
+}
@@ -1,5 +1,73 @@
 __constant sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_NONE | CLK_FILTER_NEAREST;
 
+/**
+ * Blending weight of a pixel at position x in a patch of the given size.
+ * blending 1: Linear ramp which increases from the patch border across the overlap
+ * blending 2: Gaussian centered in the patch
+ */
+float getPatchWeight(int x, int size, int overlap, int blending) {
+    if(blending == 1) {
+        const int distance = min(x, size - 1 - x);
+        return min(1.0f, (distance + 1.0f) / (overlap + 1.0f));
+    } else {
+        const float sigma = size / 8.0f;
+        const float distance = x - (size - 1) * 0.5f;
+        return max(exp(-distance*distance/(2.0f*sigma*sigma)), 1e-4f);
+    }
+}
+
+#ifdef TYPE
+__kernel void applyPatch3DWeighted(
+        __read_only image3d_t patch,
+        __global TYPE* image,
+        __global float* weightedSum,
+        __global float* weightSum,
+        __private int startX,
+        __private int startY,
+        __private int startZ,
+        __private int width,
+        __private int height,
+        __private int depth,
+        __private int channels,
+        __private int overlapX,
+        __private int overlapY,
+        __private int overlapZ,
+        __private int blending,
+        __private int roundValues
+    ) {
+    const int4 patchPos = {get_global_id(0), get_global_id(1), get_global_id(2), 0};
+    const int4 pos = patchPos + (int4)(startX, startY, startZ, 0);
+    // Patches can be padded beyond the border of the volume
+    if(pos.x >= width || pos.y >= height || pos.z >= depth)
+        return;
+
+    int dataType = get_image_channel_data_type(patch);
+    float4 value;
+    if(dataType == CLK_FLOAT) {
+		value = read_imagef(patch, sampler, patchPos);
+	} else if(dataType == CLK_UNSIGNED_INT8 || dataType == CLK_UNSIGNED_INT16) {
+		value = convert_float4(read_imageui(patch, sampler, patchPos));
+	} else {
+		value = convert_float4(read_imagei(patch, sampler, patchPos));
+    }
+
+    const float weight = getPatchWeight(patchPos.x, get_global_size(0), overlapX, blending)*
+                         getPatchWeight(patchPos.y, get_global_size(1), overlapY, blending)*
+                         getPatchWeight(patchPos.z, get_global_size(2), overlapZ, blending);
+
+    // Each voxel is only updated by one work-item, and patches are applied in order, so no atomics are needed
+    const int index = pos.x + pos.y*width + pos.z*width*height;
+    const float totalWeight = weightSum[index] + weight;
+    weightSum[index] = totalWeight;
+    float values[4] = {value.x, value.y, value.z, value.w};
+    for(int c = 0; c < channels; ++c) {
+        const float sum = weightedSum[index*channels + c] + weight*values[c];
+        weightedSum[index*channels + c] = sum;
+        image[index*channels + c] = roundValues == 1 ? round(sum / totalWeight) : sum / totalWeight;
+    }
+}
+#endif
+
 #ifdef fast_3d_image_writes
 __kernel void applyPatch3D(
         __read_only image3d_t patch,
@@ -10,6 +10,8 @@
 #include <FAST/Algorithms/ImagePatch/ImageToBatchGenerator.hpp>
 #include <FAST/Algorithms/NeuralNetwork/NeuralNetwork.hpp>
 #include <FAST/Importers/ImageFileImporter.hpp>
+#include <FAST/Streamers/ImageFileStreamer.hpp>
+#include <FAST/Algorithms/TissueSegmentation/TissueSegmentation.hpp>
 #include <FAST/Visualization/VolumeRenderer/AlphaBlendingVolumeRenderer.hpp>
 
 using namespace fast;
@@ -69,6 +71,97 @@ TEST_CASE("Patch generator and stitcher for volumes", "[fast][volume][patchgener
     window->start();
 }
 
+TEST_CASE("Patch generator and stitcher with overlap and blending for volumes", "[fast][volume][PatchGenerator][PatchStitcher]") {
+    const int width = 64;
+    const int height = 48;
+    const int depth = 40;
+    auto data = std::make_unique<float[]>(width*height*depth);
+    for(int i = 0; i < width*height*depth; ++i)
+        data[i] = (float)(i % 97);
+    auto volume = Image::New();
+    volume->create(width, height, depth, TYPE_FLOAT, 1, data.get());
+
+    for(auto mode : {PATCH_BLENDING_LINEAR, PATCH_BLENDING_GAUSSIAN}) {
+        auto generator = PatchGenerator::New();
+        generator->setPatchSize(32, 32, 16);
+        generator->setOverlap(0.25f);
+        generator->setInputData(volume);
+
+        auto stitcher = PatchStitcher::New();
+        stitcher->setBlendingMode(mode);
+        stitcher->setInputConnection(generator->getOutputPort());
+        auto port = stitcher->getOutputPort();
+
+        Image::pointer result;
+        do {
+            stitcher->update();
+            result = port->getNextFrame<Image>();
+        } while(!result->isLastFrame());
+
+        // Blending overlapping patches of the same image should give back the original image
+        REQUIRE(result->getSize() == volume->getSize());
+        auto access = result->getImageAccess(ACCESS_READ);
+        auto resultData = (float*)access->get();
+        float maxError = 0.0f;
+        for(int i = 0; i < width*height*depth; ++i)
+            maxError = std::max(maxError, std::fabs(resultData[i] - data[i]));
+        CHECK(maxError < 0.01f);
+    }
+}
+
+TEST_CASE("Patch generator for WSI with tissue mask and parallel decoding", "[fast][wsi][PatchGenerator]") {
+    auto importer = WholeSlideImageImporter::New();
+    importer->setFilename(Config::getTestDataPath() + "/WSI/A05.svs");
+
+    auto segmentation = TissueSegmentation::New();
+    segmentation->setInputConnection(importer->getOutputPort());
+
+    // Patches should be emitted in the same order regardless of the number of decoder threads
+    std::vector<std::vector<std::string>> patchIds;
+    for(int threads : {1, 4}) {
+        auto generator = PatchGenerator::New();
+        generator->setPatchSize(512, 512);
+        generator->setPatchLevel(2);
+        generator->setNumberOfDecoderThreads(threads);
+        generator->setReadAheadLimit(8);
+        generator->setInputConnection(importer->getOutputPort());
+        generator->setInputConnection(1, segmentation->getOutputPort());
+        auto port = generator->getOutputPort();
+
+        std::vector<std::string> ids;
+        Image::pointer patch;
+        do {
+            generator->update();
+            patch = port->getNextFrame<Image>();
+            ids.push_back(patch->getFrameData("patchid-x") + " " + patch->getFrameData("patchid-y"));
+        } while(!patch->isLastFrame());
+        patchIds.push_back(ids);
+    }
+    CHECK(patchIds[0].size() > 0);
+    CHECK(patchIds[0] == patchIds[1]);
+}
+
+TEST_CASE("Patch generator with image pyramid which fails to decode patches", "[fast][wsi][PatchGenerator]") {
+    // An image pyramid level without data makes every read of patch data throw
+    ImagePyramidLevel level;
+    level.width = 1024;
+    level.height = 1024;
+    level.memoryMapped = false;
+    level.data = nullptr;
+    auto pyramid = ImagePyramid::New();
+    pyramid->create(nullptr, {level});
+
+    auto generator = PatchGenerator::New();
+    generator->setPatchSize(256, 256);
+    generator->setNumberOfDecoderThreads(2);
+    generator->setInputData(pyramid);
+    auto port = generator->getOutputPort();
+
+    // The error should be surfaced, and no partial stream marked as complete
+    CHECK_THROWS_AS(generator->update(), Exception);
+    CHECK(generator->getStreamError().find("has no data") != std::string::npos);
+}
+
 TEST_CASE("Patch generator and stitcher for WSI", "[fast][wsi][PatchStitcher][visual]") {
     auto importer = WholeSlideImageImporter::New();
     importer->setFilename(Config::getTestDataPath() + "/WSI/A05.svs");
@@ -112,4 +205,38 @@ TEST_CASE("Patch generator, sticher and image to batch generator for WSI", "[fas
         std::cout << "Got a batch" << std::endl;
     } while(!batch->isLastFrame());
     std::cout << "Done" << std::endl;
-}
\ No newline at end of file
+}
+TEST_CASE("Image to batch generator with max latency and padding", "[fast][ImageToBatchGenerator]") {
+    auto streamer = ImageFileStreamer::New();
+    streamer->setFilenameFormat(Config::getTestDataPath() + "US/CarotidArtery/Right/US-2D_#.mhd");
+    streamer->setMaximumNumberOfFrames(10);
+    streamer->setSleepTime(50);
+
+    auto batchGenerator = ImageToBatchGenerator::New();
+    batchGenerator->setInputConnection(streamer->getOutputPort());
+    batchGenerator->setMaxBatchSize(8);
+    batchGenerator->setMaxLatency(10);
+    batchGenerator->setPadding(true);
+    auto port = batchGenerator->getOutputPort();
+
+    // Frames arrive slower than the deadline, thus batches should be emitted before they are full
+    Batch::pointer batch;
+    int batches = 0;
+    int frames = 0;
+    do {
+        batchGenerator->update();
+        batch = port->getNextFrame<Batch>();
+        auto access = batch->getAccess(ACCESS_READ);
+        auto images = access->getData().getImages();
+        CHECK(images.size() == 8);
+        const int batchSize = std::stoi(batch->getFrameData("batch-size"));
+        CHECK(batchSize >= 1);
+        CHECK(batchSize < 8);
+        // Padding repeats the last image
+        CHECK(images.back() == images[batchSize - 1]);
+        frames += batchSize;
+        ++batches;
+    } while(!batch->isLastFrame());
+    CHECK(frames == 10);
+    CHECK(batches > 1);
+}
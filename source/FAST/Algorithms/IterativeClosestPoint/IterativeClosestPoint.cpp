@@ -1,7 +1,10 @@
 #include "FAST/Algorithms/IterativeClosestPoint/IterativeClosestPoint.hpp"
 #include "FAST/SceneGraph.hpp"
+#include "FAST/Algorithms/SpatialIndex/KDTree.hpp"
+#include "FAST/Algorithms/SpatialIndex/VoxelHashGrid.hpp"
 #undef min
 #undef max
+#include <functional>
 #include <limits>
 #include <random>
 #include <unordered_set>
@@ -16,6 +19,8 @@ IterativeClosestPoint::IterativeClosestPoint() {
     mError = -1;
     mRandomSamplingPoints = 0;
     mDistanceThreshold = -1;
+    mApproximateSearchEpsilon = 0;
+    mSpatialIndexType = IterativeClosestPoint::KD_TREE;
     mTransformationType = IterativeClosestPoint::RIGID;
     mIsModified = true;
     mTransformation = AffineTransformation::New();
@@ -68,44 +73,52 @@ inline Vector3f RGB2YIQ(Vector3f rgb) {
 }
 
 /**
- * Create a new matrix which is matrix A rearranged.
- * This matrix has the same size as B
+ * Convert RGB colors to the color part of the points used to find the closest points.
+ * The color distance is weighted in YIQ color space.
+ * @param colors 3xN matrix of RGB colors
+ * @return 3xN matrix
  */
-inline MatrixXf rearrangeMatrixToClosestPoints(const MatrixXf& A, const MatrixXf& B, const MatrixXf& Acolors, const MatrixXf& Bcolors, float colorWeight) {
-    MatrixXf result = MatrixXf::Constant(B.rows(), B.cols(), 0);
-
+inline MatrixXf getColorFeatures(const MatrixXf& colors) {
     Vector3f colorWeights(100.0, 1000.0, 1000.0);
-    // For each point in B, find the closest point in A
+    MatrixXf features(3, colors.cols());
+    for(int i = 0; i < colors.cols(); ++i)
+        features.col(i) = RGB2YIQ(colors.col(i)).cwiseProduct(colorWeights);
+    return features;
+}
+
+/**
+ * For each point in B, find the closest point in A with the spatial index of A.
+ * Point pairs which are farther apart than maxDistance are rejected, if maxDistance is above 0.
+ * The matched points are stored as columns in matchedA and matchedB, in the same order.
+ */
+inline void matchClosestPoints(const std::function<int(const VectorXf&)>& findClosestPointInA, const MatrixXf& A,
+        const MatrixXf& B, const MatrixXf& BcolorFeatures, float maxDistance, MatrixXf& matchedA, MatrixXf& matchedB) {
+    std::vector<int> closestPoints(B.cols());
 #pragma omp parallel for
     for(int b = 0; b < B.cols(); ++b) {
-        Vector3f pointInB = B.col(b);
-        Vector3f Bcolor = RGB2YIQ(Bcolors.col(b));
-        float minDistance = std::numeric_limits<float>::max();
-        uint closestPoint = 0;
-        for(int a = 0; a < A.cols(); ++a) {
-            Vector3f pointInA = A.col(a);
-            Vector3f Acolor = RGB2YIQ(Acolors.col(a));
-            VectorXf distanceVector = VectorXf::Zero(6);
-            distanceVector.head(3) = pointInA - pointInB;
-            distanceVector(3) = (Acolor.x() - Bcolor.x())*colorWeights.x();
-            distanceVector(4) = (Acolor.y() - Bcolor.y())*colorWeights.y();
-            distanceVector(5) = (Acolor.z() - Bcolor.z())*colorWeights.z();
-            //std::cout << distanceVector.tail(3) << std::endl;
-            float distance = distanceVector.norm();
-            //float distance = (pointInA-pointInB).norm();
-            //std::cout << colorDistance(Acolor, Bcolor) << std::endl;
-            //if(colorDistance(Acolor, Bcolor) < 100) {
-                if(distance < minDistance) {
-                    minDistance = distance;
-                    closestPoint = a;
-                }
-            //}
-        }
-        result.col(b) = A.col(closestPoint);
+        VectorXf query(6);
+        query << B.col(b), BcolorFeatures.col(b);
+        closestPoints[b] = findClosestPointInA(query);
     }
 
-    return result;
-
+    int matches = 0;
+    for(int b = 0; b < B.cols(); ++b) {
+        if(maxDistance > 0 && (A.col(closestPoints[b]) - B.col(b)).norm() > maxDistance) {
+            closestPoints[b] = -1;
+        } else {
+            ++matches;
+        }
+    }
+    matchedA.resize(3, matches);
+    matchedB.resize(3, matches);
+    int counter = 0;
+    for(int b = 0; b < B.cols(); ++b) {
+        if(closestPoints[b] < 0)
+            continue;
+        matchedA.col(counter) = A.col(closestPoints[b]);
+        matchedB.col(counter) = B.col(b);
+        ++counter;
+    }
 }
 
 /*
@@ -242,25 +255,47 @@ void IterativeClosestPoint::execute() {
     }
     fixedPoints = fixedPointTransform*fixedPoints.colwise().homogeneous();
 
-    float colorWeight = 1.0f;
+    // Build spatial index of the fixed points once, the color is included as extra dimensions
+    MatrixXf fixedFeatures(6, fixedPoints.cols());
+    fixedFeatures << fixedPoints, getColorFeatures(fixedColors);
+    const MatrixXf movingColorFeatures = getColorFeatures(movingColors);
+    KDTree tree;
+    VoxelHashGrid grid;
+    std::function<int(const VectorXf&)> findClosestFixedPoint;
+    mRuntimeManager->startRegularTimer("build_spatial_index");
+    if(mSpatialIndexType == IterativeClosestPoint::KD_TREE) {
+        tree.build(fixedFeatures);
+        const float epsilon = mApproximateSearchEpsilon;
+        findClosestFixedPoint = [&tree, epsilon](const VectorXf& point) {
+            return tree.findNearest(point, nullptr, std::numeric_limits<float>::max(), epsilon);
+        };
+    } else {
+        grid.build(fixedFeatures);
+        findClosestFixedPoint = [&grid](const VectorXf& point) {
+            return grid.findNearest(point);
+        };
+    }
+    mRuntimeManager->stopRegularTimer("build_spatial_index");
 
     // Want to choose the smallest one as moving
     bool invertTransform = false;
 	MatrixXf movedPoints = currentTransformation*(movingPoints.colwise().homogeneous());
     // Match closest points using current transformation
-    MatrixXf rearrangedFixedPoints = rearrangeMatrixToClosestPoints(
-            fixedPoints, movedPoints, fixedColors, movingColors, colorWeight);
+    MatrixXf matchedFixedPoints, matchedMovedPoints;
+    matchClosestPoints(findClosestFixedPoint, fixedPoints, movedPoints, movingColorFeatures, mDistanceThreshold,
+            matchedFixedPoints, matchedMovedPoints);
+    if(matchedFixedPoints.cols() == 0) {
+        reportWarning() << "No points within the distance threshold in ICP" << reportEnd();
+        mTransformation->setTransform(currentTransformation);
+        return;
+    }
     do {
         previousError = error;        
 
-        reportInfo() << "Processing " << rearrangedFixedPoints.cols() << " points in ICP" << reportEnd();
+        reportInfo() << "Processing " << matchedFixedPoints.cols() << " points in ICP" << reportEnd();
         // Get centroids
-        Vector3f centroidFixed = getCentroid(rearrangedFixedPoints);
-        //reportInfo() << "Centroid fixed: " << Reporter::end();
-        //reportInfo() << centroidFixed << Reporter::end();
-        Vector3f centroidMoving = getCentroid(movedPoints);
-        //reportInfo() << "Centroid moving: " << Reporter::end();
-        //reportInfo() << centroidMoving << Reporter::end();
+        Vector3f centroidFixed = getCentroid(matchedFixedPoints);
+        Vector3f centroidMoving = getCentroid(matchedMovedPoints);
 
         Eigen::Affine3f updateTransform = Eigen::Affine3f::Identity();
 
@@ -268,8 +303,8 @@ void IterativeClosestPoint::execute() {
             // See http://se.mathworks.com/matlabcentral/fileexchange/27804-iterative-closest-point for ref
             // eq_point
             // Create correlation matrix H of the deviations from centroid
-            MatrixXf H = (movedPoints.colwise() - centroidMoving)*
-                    (rearrangedFixedPoints.colwise() - centroidFixed).transpose();
+            MatrixXf H = (matchedMovedPoints.colwise() - centroidMoving)*
+                    (matchedFixedPoints.colwise() - centroidFixed).transpose();
 
             // Do SVD on H
             Eigen::JacobiSVD<Eigen::MatrixXf> svd(H, Eigen::ComputeFullU | Eigen::ComputeFullV);
@@ -298,19 +333,22 @@ void IterativeClosestPoint::execute() {
 		movedPoints = currentTransformation*(movingPoints.colwise().homogeneous());
 
         // Calculate RMS error
-        // Should we rearrange the points here?
         mRuntimeManager->startRegularTimer("find_closest");
-        rearrangedFixedPoints = rearrangeMatrixToClosestPoints(
-                fixedPoints, movedPoints, fixedColors, movingColors, colorWeight);
+        matchClosestPoints(findClosestFixedPoint, fixedPoints, movedPoints, movingColorFeatures, mDistanceThreshold,
+                matchedFixedPoints, matchedMovedPoints);
         mRuntimeManager->stopRegularTimer("find_closest");
-		MatrixXf distance = rearrangedFixedPoints - movedPoints;
+        iterations++;
+        if(matchedFixedPoints.cols() == 0) {
+            reportWarning() << "No points within the distance threshold in ICP" << reportEnd();
+            break;
+        }
+		MatrixXf distance = matchedFixedPoints - matchedMovedPoints;
         error = 0;
         for(uint i = 0; i < distance.cols(); i++) {
             error += square(distance.col(i).norm());
         }
         error = sqrt(error / distance.cols());
 
-        iterations++;
         reportInfo() << "ICP error: " << error << Reporter::end();
         // To continue, change in error has to be above min error change and nr of iterations less than max iterations
     } while(previousError-error > mMinErrorChange && iterations < mMaxIterations);
@@ -337,6 +375,19 @@ void IterativeClosestPoint::setRandomPointSampling(uint nrOfPointsToSample) {
 
 void IterativeClosestPoint::setDistanceThreshold(float distance) {
     mDistanceThreshold = distance;
+    mIsModified = true;
+}
+
+void IterativeClosestPoint::setSpatialIndexType(IterativeClosestPoint::SpatialIndexType type) {
+    mSpatialIndexType = type;
+    mIsModified = true;
+}
+
+void IterativeClosestPoint::setApproximateSearch(float epsilon) {
+    if(epsilon < 0)
+        throw Exception("Epsilon for approximate search in ICP can't be negative");
+    mApproximateSearchEpsilon = epsilon;
+    mIsModified = true;
 }
 
 void IterativeClosestPoint::setMinimumErrorChange(float errorChange) {
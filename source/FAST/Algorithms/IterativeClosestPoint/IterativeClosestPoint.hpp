@@ -11,6 +11,7 @@ class FAST_EXPORT  IterativeClosestPoint : public ProcessObject {
     FAST_OBJECT(IterativeClosestPoint)
     public:
         typedef enum { RIGID, TRANSLATION } TransformationType;
+        typedef enum { KD_TREE, VOXEL_GRID } SpatialIndexType;
         void setFixedMeshPort(DataChannel::pointer port);
         void setFixedMesh(Mesh::pointer data);
         void setMovingMeshPort(DataChannel::pointer port);
@@ -21,7 +22,24 @@ class FAST_EXPORT  IterativeClosestPoint : public ProcessObject {
         void setMinimumErrorChange(float errorChange);
         void setMaximumNrOfIterations(uint iterations);
         void setRandomPointSampling(uint nrOfPointsToSample);
+        /**
+         * Only use fixed points closer than this distance to the centroid of the moving points,
+         * and reject matched points which are farther apart than this distance. Default is -1, which disables both.
+         * @param distance
+         */
         void setDistanceThreshold(float distance);
+        /**
+         * Set which spatial index of the fixed points is used to find the closest fixed point of each moving point.
+         * Default is KD_TREE.
+         * @param type
+         */
+        void setSpatialIndexType(SpatialIndexType type);
+        /**
+         * Use approximate search with the k-d tree: The fixed point matched to each moving point is at most
+         * (1 + epsilon) times farther away than the closest fixed point. Default is 0, which gives exact search.
+         * @param epsilon
+         */
+        void setApproximateSearch(float epsilon);
     private:
         IterativeClosestPoint();
         void execute();
@@ -30,6 +48,8 @@ class FAST_EXPORT  IterativeClosestPoint : public ProcessObject {
         uint mMaxIterations;
         int mRandomSamplingPoints;
         float mDistanceThreshold;
+        float mApproximateSearchEpsilon;
+        SpatialIndexType mSpatialIndexType;
         float mError;
         AffineTransformation::pointer mTransformation;
         IterativeClosestPoint::TransformationType mTransformationType;
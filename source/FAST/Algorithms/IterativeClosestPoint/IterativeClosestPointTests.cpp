@@ -173,5 +173,56 @@ TEST_CASE("ICP on two point sets which are already transformed by scene graph",
 }
 
 
+TEST_CASE("ICP with voxel grid and approximate search", "[fast][IterativeClosestPoint][icp]") {
+
+    Vector3f translation(0.01, 0, 0.01);
+    Vector3f rotation(0.5, 0, 0);
+
+    VTKMeshFileImporter::pointer importerA = VTKMeshFileImporter::New();
+    importerA->setFilename(Config::getTestDataPath() + "Surface_LV.vtk");
+    auto importerAPort = importerA->getOutputPort();
+    importerA->update();
+    Mesh::pointer A = importerAPort->getNextFrame<Mesh>();
+    VTKMeshFileImporter::pointer importerB = VTKMeshFileImporter::New();
+    importerB->setFilename(Config::getTestDataPath() + "Surface_LV.vtk");
+    auto importerBPort = importerB->getOutputPort();
+    importerB->update();
+    Mesh::pointer B = importerBPort->getNextFrame<Mesh>();
+
+    // Apply a transformation to B surface
+    Affine3f transform = Affine3f::Identity();
+    transform.translate(translation);
+    Matrix3f R;
+    R = Eigen::AngleAxisf(rotation.x(), Vector3f::UnitX())
+    * Eigen::AngleAxisf(rotation.y(), Vector3f::UnitY())
+    * Eigen::AngleAxisf(rotation.z(), Vector3f::UnitZ());
+    transform.rotate(R);
+    AffineTransformation::pointer T = AffineTransformation::New();
+    T->setTransform(transform);
+    B->getSceneGraphNode()->setTransformation(T);
+
+    for(auto type : {IterativeClosestPoint::KD_TREE, IterativeClosestPoint::VOXEL_GRID}) {
+        // Do ICP registration
+        IterativeClosestPoint::pointer icp = IterativeClosestPoint::New();
+        icp->setMovingMesh(A);
+        icp->setFixedMesh(B);
+        icp->setSpatialIndexType(type);
+        if(type == IterativeClosestPoint::KD_TREE)
+            icp->setApproximateSearch(0.1f);
+        icp->update();
+
+        // Validate result
+        Vector3f detectedRotation = icp->getOutputTransformation()->getEulerAngles();
+        Vector3f detectedTranslation = icp->getOutputTransformation()->getTransform().translation();
+
+        CHECK(detectedTranslation.x() == Approx(translation.x()).margin(0.01));
+        CHECK(detectedTranslation.y() == Approx(translation.y()).margin(0.01));
+        CHECK(detectedTranslation.z() == Approx(translation.z()).margin(0.01));
+        CHECK(detectedRotation.x() == Approx(rotation.x()).margin(0.01));
+        CHECK(detectedRotation.y() == Approx(rotation.y()).margin(0.01));
+        CHECK(detectedRotation.z() == Approx(rotation.z()).margin(0.01));
+    }
+}
+
 
 } // end namespace fast
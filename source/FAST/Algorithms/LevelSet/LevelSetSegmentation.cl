@@ -119,15 +119,3 @@ __kernel void updateLevelSetFunction(
     // Update the level set function phi
     WRITE_RESULT(phi_write, pos, read_imagef(phi_read,sampler,pos).x + deltaT*speed*length(gradient));
 }
-
-__kernel void initializeLevelSetFunction(
-        PHI_WRITE_TYPE phi,
-        __private int seedX,
-        __private int seedY,
-        __private int seedZ,
-        __private float radius
-) {
-    const int4 pos = {get_global_id(0), get_global_id(1), get_global_id(2), 0};
-
-    WRITE_RESULT(phi, pos, distance((float3)(seedX,seedY,seedZ), convert_float3(pos.xyz)) - radius);
-}
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "LevelSetSegmentation.hpp"
 #include "FAST/Data/Segmentation.hpp"
 #include "FAST/Algorithms/BinaryThresholding/BinaryThresholding.hpp"
+#include "FAST/Algorithms/DistanceTransform/DistanceTransform.hpp"
 
 namespace fast {
 
@@ -57,33 +58,43 @@ void LevelSetSegmentation::execute() {
     cl::CommandQueue queue = device->getCommandQueue();
     cl::Program program = getOpenCLProgram(device);
 
-    Image::pointer phi = Image::New();
-    phi->create(input->getSize(), TYPE_FLOAT, 1);
-
-    OpenCLImageAccess::pointer phiAccess = phi->getOpenCLImageAccess(ACCESS_READ_WRITE, device);
-    cl::Image3D phi_1 = *phiAccess->get3DImage();
-
     if(mSeeds.size() == 0)
         throw Exception("The LevelSetSegmentation algorithm must be given a seed point");
 
-    Vector3i seedPos = mSeeds[0].first;
-    reportInfo() << "Using seed: " << seedPos.transpose() << reportEnd();
-    float seedRadius = mSeeds[0].second;
+    // Create mask of all seed spheres
     Vector3ui size = input->getSize();
+    auto seeds = Image::New();
+    seeds->create(size, TYPE_UINT8, 1);
+    seeds->fill(0);
+    {
+        ImageAccess::pointer seedAccess = seeds->getImageAccess(ACCESS_READ_WRITE);
+        uchar* seedData = (uchar*)seedAccess->get();
+        for(auto&& seed : mSeeds) {
+            const Vector3i seedPos = seed.first;
+            const float seedRadius = seed.second;
+            reportInfo() << "Using seed: " << seedPos.transpose() << reportEnd();
+            const Vector3i radius = Vector3i::Constant((int)std::ceil(seedRadius));
+            const Vector3i start = (seedPos - radius).cwiseMax(0);
+            const Vector3i end = (seedPos + radius).cwiseMin(size.cast<int>() - Vector3i::Ones());
+            for(int z = start.z(); z <= end.z(); ++z) {
+            for(int y = start.y(); y <= end.y(); ++y) {
+            for(int x = start.x(); x <= end.x(); ++x) {
+                if((Vector3i(x, y, z) - seedPos).cast<float>().norm() <= seedRadius)
+                    seedData[x + y*size.x() + z*size.x()*size.y()] = 1;
+            }}}
+        }
+    }
+
+    // Initialize level set function as the signed distance to the seeds, in voxels
+    auto distanceTransform = DistanceTransform::New();
+    distanceTransform->setInputData(seeds);
+    distanceTransform->setMainDevice(device);
+    distanceTransform->setMode(DistanceTransform::Mode::SIGNED);
+    distanceTransform->setUseSpacing(false);
+    Image::pointer phi = distanceTransform->updateAndGetOutputData<Image>();
 
-    // Create seed
-    cl::Kernel createSeedKernel(program, "initializeLevelSetFunction");
-    createSeedKernel.setArg(0, phi_1);
-    createSeedKernel.setArg(1, seedPos.x());
-    createSeedKernel.setArg(2, seedPos.y());
-    createSeedKernel.setArg(3, seedPos.z());
-    createSeedKernel.setArg(4, seedRadius);
-    queue.enqueueNDRangeKernel(
-            createSeedKernel,
-            cl::NullRange,
-            cl::NDRange(size.x(),size.y(),size.z()),
-            cl::NullRange
-    );
+    OpenCLImageAccess::pointer phiAccess = phi->getOpenCLImageAccess(ACCESS_READ_WRITE, device);
+    cl::Image3D phi_1 = *phiAccess->get3DImage();
 
     cl::Kernel kernel(program, "updateLevelSetFunction");
     cl::size_t<3> origin = createOrigoRegion();
@@ -8,7 +8,7 @@ using namespace InferenceEngine;
 
 void OpenVINOEngine::run() {
 	try {
-		// Copy input data
+		// Bind input data
 		reportInfo() << "OpenVINO: Processing input nodes.." << reportEnd();
 		int batchSize = -1;
 		for(const auto& node : mInputNodes) {
@@ -16,29 +16,42 @@ void OpenVINOEngine::run() {
 			batchSize = tensor->getShape()[0];
 			auto access = tensor->getAccess(ACCESS_READ);
 			float* tensorData = access->getRawData();
-			Blob::Ptr input = m_inferRequest->GetBlob(node.first);
+			Blob::Ptr input = m_blobs.at(node.first);
 
 			// Dynamic batch size
 			if(m_maxBatchSize > 1)
                 m_inferRequest->SetBatch(batchSize);
 
-			auto input_data = input->buffer().as<PrecisionTrait<Precision::FP32>::value_type * >();
-			std::memcpy(input_data, tensorData, input->byteSize());
+			if(tensor->getShape().getTotalSize()*sizeof(float) == input->byteSize()) {
+				// Same size as the network input: Let OpenVINO read the FAST tensor memory directly.
+				// The tensor is kept alive by the input node until the next run.
+				m_inferRequest->SetBlob(node.first, make_shared_blob<float>(input->getTensorDesc(), tensorData));
+			} else {
+				// Batch is smaller than the maximum batch size, copy into the blob of the network
+				m_inferRequest->SetBlob(node.first, input);
+				auto input_data = input->buffer().as<PrecisionTrait<Precision::FP32>::value_type * >();
+				std::memcpy(input_data, tensorData, tensor->getShape().getTotalSize()*sizeof(float));
+			}
 		}
 		reportInfo() << "OpenVINO: Finished processing input nodes." << reportEnd();
 
+		// Let the network write its output directly into new FAST tensor storage, which is handed over to the output tensors
+		std::unordered_map<std::string, std::shared_ptr<float>> outputData;
+		for(auto& node : mOutputNodes) {
+			Blob::Ptr output = m_blobs.at(node.first);
+			auto data = make_uninitialized_unique<float[]>(output->size());
+			auto sharedData = std::shared_ptr<float>(data.release(), std::default_delete<float[]>());
+			m_inferRequest->SetBlob(node.first, make_shared_blob<float>(output->getTensorDesc(), sharedData.get()));
+			outputData[node.first] = sharedData;
+		}
+
 		// Execute network
         m_inferRequest->Infer();
 		reportInfo() << "OpenVINO: Network executed." << reportEnd();
 
-		// Copy output data
-		for (auto& node : mOutputNodes) {
-			Blob::Ptr output = m_inferRequest->GetBlob(node.first);
-			auto outputData = (output->buffer().as<::InferenceEngine::PrecisionTrait<Precision::FP32>::value_type *>());
-			auto copied_data = make_uninitialized_unique<float[]>(output->byteSize());
-			std::memcpy(copied_data.get(), outputData, output->byteSize());
+		for(auto& node : mOutputNodes) {
 			auto tensor = Tensor::New();
-			tensor->create(std::move(copied_data), node.second.shape);
+			tensor->create(outputData[node.first], node.second.shape);
 			node.second.data = tensor;
 		}
 		reportInfo() << "OpenVINO: Finished processing output nodes." << reportEnd();
@@ -116,6 +129,12 @@ void OpenVINOEngine::loadPlugin(std::string deviceName) {
     ExecutableNetwork executable_network = m_inferenceCore->LoadNetwork(network, deviceName, config);
 
     m_inferRequest = executable_network.CreateInferRequestPtr();
+    // Store the blobs allocated by OpenVINO, since run replaces them with blobs using FAST memory
+    m_blobs.clear();
+    for(auto& input : network.getInputsInfo())
+        m_blobs[input.first] = m_inferRequest->GetBlob(input.first);
+    for(auto& output : network.getOutputsInfo())
+        m_blobs[output.first] = m_inferRequest->GetBlob(output.first);
     setIsLoaded(true);
     reportInfo() << "OpenVINO: Network fully loaded." << reportEnd();
 }
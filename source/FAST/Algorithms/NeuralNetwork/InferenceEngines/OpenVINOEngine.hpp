@@ -6,6 +6,7 @@
 namespace InferenceEngine {
 class InferRequest;
 class Core;
+class Blob;
 }
 
 namespace fast {
@@ -26,6 +27,8 @@ class INFERENCEENGINEOPENVINO_EXPORT OpenVINOEngine : public InferenceEngine {
         ~OpenVINOEngine();
     private:
         std::shared_ptr<::InferenceEngine::Core> m_inferenceCore;
+        // Blobs allocated by OpenVINO for each input and output node
+        std::unordered_map<std::string, std::shared_ptr<::InferenceEngine::Blob>> m_blobs;
         // This has to be last, because then inferRequest will be deleted before the plugin, which is necessary to avoid a crash on delete
         std::shared_ptr<::InferenceEngine::InferRequest> m_inferRequest;
 		
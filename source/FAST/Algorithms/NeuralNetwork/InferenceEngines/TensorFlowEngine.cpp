@@ -19,6 +19,7 @@
 //#include <tensorflow/core/platform/mutex.h>
 //#include <tensorflow/core/platform/types.h>
 #include <tensorflow/core/public/session.h>
+#include <tensorflow/core/framework/allocation_description.pb.h>
 //#include <tensorflow/core/graph/default_device.h>
 //#include <tensorflow/core/platform/init_main.h>
 //#include <tensorflow/cc/framework/ops.h>
@@ -36,39 +37,36 @@ class TensorFlowTensorWrapper {
 };
 
 void TensorFlowTensor::create(TensorFlowTensorWrapper* wrapper) {
-    m_tensorflowTensor = wrapper;
-    auto shape = m_tensorflowTensor->tensor.shape();
+    auto shape = wrapper->tensor.shape();
     TensorShape fastShape;
     for(int i = 0; i < shape.dims(); ++i)
         fastShape.addDimension(shape.dim_size(i));
 
-    m_shape = fastShape;
-    m_spacing = VectorXf::Ones(m_shape.getDimensions());
-    mHostDataIsUpToDate = true;
-    if(m_shape.getDimensions() >= 3) {
-        const int width = m_shape[m_shape.getDimensions() - 2];
-        const int height = m_shape[m_shape.getDimensions() - 3];
-        mBoundingBox = BoundingBox(Vector3f(width, height, 1));
-    }
-    /*
-    // Unnecessary copy..
-    auto data = make_uninitialized_unique<float[]>(fastShape.getTotalSize());
-    std::memcpy(data.get(), tensorflowTensor.flat<float>().data(), fastShape.getTotalSize()*sizeof(float));
-    Tensor::create(std::move(data), fastShape);
-     */
-}
-
-bool TensorFlowTensor::hasAnyData() {
-    return true;
+    // No copy: The storage deleter owns the TensorFlow tensor
+    Tensor::create(std::shared_ptr<float>(
+            wrapper->tensor.flat<float>().data(),
+            [wrapper](float*) { delete wrapper; }
+    ), fastShape);
 }
 
-TensorFlowTensor::~TensorFlowTensor() {
-    delete m_tensorflowTensor;
-}
-
-float* TensorFlowTensor::getHostDataPointer() {
-    return m_tensorflowTensor->tensor.flat<float>().data();
-}
+/**
+ * Lets TensorFlow use the memory of a FAST tensor as the buffer of a TensorFlow tensor, without copying it.
+ * The buffer keeps the FAST storage alive as long as TensorFlow uses it.
+ */
+class FASTTensorBuffer : public tensorflow::TensorBuffer {
+    public:
+        FASTTensorBuffer(std::shared_ptr<float> data, std::size_t size) : tensorflow::TensorBuffer(data.get()), m_data(data), m_size(size) {};
+        std::size_t size() const override { return m_size; };
+        tensorflow::TensorBuffer* root_buffer() override { return this; };
+        void FillAllocationDescription(tensorflow::AllocationDescription* proto) const override {
+            proto->set_requested_bytes(m_size);
+            proto->set_allocator_name("FAST");
+        };
+        bool OwnsMemory() const override { return false; };
+    private:
+        std::shared_ptr<float> m_data;
+        std::size_t m_size;
+};
 
 static TensorShape getShape(const tensorflow::NodeDef& node) {
     TensorShape resultShape;
@@ -102,33 +100,22 @@ void TensorFlowEngine::run() {
         for(auto i : shape.getAll()) {
             tensorShape.AddDim(i);
         }
+        TensorAccess::pointer access = inputNode.second.data->getAccess(ACCESS_READ);
+        auto data = access->getSharedRawData();
+        if(((std::uintptr_t)data.get() % EIGEN_MAX_ALIGN_BYTES) == 0) {
+            // Give the FAST tensor memory directly to tensorflow
+            auto buffer = new FASTTensorBuffer(data, shape.getTotalSize()*sizeof(float));
+            input_tensors.push_back(std::make_pair(name, tensorflow::Tensor(tensorflow::DT_FLOAT, tensorShape, buffer)));
+            buffer->Unref(); // The tensorflow tensor now holds the only reference to the buffer
+            continue;
+        }
+
+        // TensorFlow requires aligned memory, copy the data
         tensorflow::Tensor input_tensor(
                 tensorflow::DT_FLOAT,
                 tensorShape
         );
-
-        // Give tensor data to tensorflow
-        // TODO is the data here actually moved?
-        TensorAccess::pointer access = inputNode.second.data->getAccess(ACCESS_READ);
-        switch(shape.getDimensions()) {
-            case 2:
-                input_tensor.tensor<float, 2>() = std::move(access->getData<2>());
-                break;
-            case 3:
-                input_tensor.tensor<float, 3>() = std::move(access->getData<3>());
-                break;
-            case 4:
-                input_tensor.tensor<float, 4>() = std::move(access->getData<4>());
-                break;
-            case 5:
-                input_tensor.tensor<float, 5>() = std::move(access->getData<5>());
-                break;
-			case 6:
-				input_tensor.tensor<float, 6>() = std::move(access->getData<6>());
-				break;
-            default:
-                throw Exception("Invalid tensor dimension size");
-		}
+        std::memcpy(input_tensor.flat<float>().data(), data.get(), shape.getTotalSize()*sizeof(float));
 
 		// Add tensorflow tensor to list of input tensors
 		input_tensors.push_back(std::make_pair(name, input_tensor));
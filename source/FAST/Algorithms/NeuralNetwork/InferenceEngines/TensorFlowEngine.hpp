@@ -31,16 +31,14 @@ class TensorFlowTensorWrapper;
 
 /**
  * This specialized Tensor Data class, allow us to store Tensorflow type tensors as FAST tensors.
+ * The TensorFlow tensor is the storage of the FAST tensor, and is released when the tensor and all its views are deleted.
  */
 class TensorFlowTensor : public Tensor {
     FAST_OBJECT(TensorFlowTensor)
     public:
         void create(TensorFlowTensorWrapper* tensorflowTensor);
-        ~TensorFlowTensor();
     private:
-        TensorFlowTensorWrapper* m_tensorflowTensor;
-        float* getHostDataPointer() override;
-        bool hasAnyData() override;
+        TensorFlowTensor() = default;
 };
 
 }
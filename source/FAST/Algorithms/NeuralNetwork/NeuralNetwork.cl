@@ -12,9 +12,12 @@ __kernel void normalize2DInput(
 	__private float minIntensity,
 	__private float maxIntensity,
 	__private int clipIntensity,
-	__private int channelFirst
+	__private int channelFirst,
+	__private int outputOffset
 	) {
-	
+	// Images of a batch are written to the same buffer, outputOffset is the position of this image
+	output += outputOffset;
+
 	const int2 pos = {get_global_id(0), get_global_id(1)};
 	const int dataType = get_image_channel_data_type(input);
 	float4 value;
@@ -43,7 +46,7 @@ __kernel void normalize2DInput(
 	const int width = get_global_size(0);
 	const int height = get_global_size(1);
     if(channelFirst == 0) {
-        int position = (pos.x + pos.y*width)*channels;
+        int position = (x + pos.y*width)*channels;
         output[position] = value.x;
         if(channels > 1)
             output[position+1] = value.y;
@@ -52,7 +55,7 @@ __kernel void normalize2DInput(
         if(channels > 3)
             output[position+3] = value.w;
     } else {
-        int position = pos.x + pos.y*width;
+        int position = x + pos.y*width;
         output[position] = value.x;
         if(channels > 1)
             output[position + 1*width*height] = value.y;
@@ -75,8 +78,11 @@ __kernel void normalize3DInput(
 	__private float minIntensity,
 	__private float maxIntensity,
 	__private int clipIntensity,
-	__private int channelFirst
+	__private int channelFirst,
+	__private int outputOffset
 	) {
+	// Images of a batch are written to the same buffer, outputOffset is the position of this image
+	output += outputOffset;
 
 	const int4 pos = {get_global_id(0), get_global_id(1), get_global_id(2), 0};
 	const int dataType = get_image_channel_data_type(input);
@@ -100,8 +106,14 @@ __kernel void normalize3DInput(
     const int width = get_global_size(0);
 	const int height = get_global_size(1);
 	const int depth = get_global_size(2);
+    int x;
+	if(horizontalFlip == 1) {
+		x = (width - pos.x - 1);
+	} else {
+		x = pos.x;
+	}
     if(channelFirst == 0) {
-        int position = (pos.x + pos.y*width + pos.z*width*height)*channels;
+        int position = (x + pos.y*width + pos.z*width*height)*channels;
         output[position] = value.x;
         if(channels > 1)
             output[position+1] = value.y;
@@ -110,7 +122,7 @@ __kernel void normalize3DInput(
         if(channels > 3)
             output[position+3] = value.w;
     } else {
-        int position = pos.x + pos.y*width + pos.z*width*height;
+        int position = x + pos.y*width + pos.z*width*height;
         output[position] = value.x;
         if(channels > 1)
             output[position + 1*width*height*depth] = value.y;
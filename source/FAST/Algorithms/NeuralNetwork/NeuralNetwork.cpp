@@ -39,6 +39,7 @@ void NeuralNetwork::loadAttributes() {
 
 NeuralNetwork::NeuralNetwork() {
 	mPreserveAspectRatio = false;
+	m_stagingBufferSize = 0;
 	mScaleFactor = 1.0f;
 	mMean = 0.0;
 	mStd = 1.0f;
@@ -58,6 +59,7 @@ NeuralNetwork::NeuralNetwork() {
 std::unordered_map<std::string, Tensor::pointer> NeuralNetwork::processInputData() {
     std::unordered_map<std::string, Tensor::pointer> tensors;
     m_batchSize = -1;
+    m_validBatchSize = -1;
     for(auto inputNode : m_engine->getInputNodes()) {
         auto shape = inputNode.second.shape;
         if(shape.getDimensions() == 0)
@@ -89,6 +91,9 @@ std::unordered_map<std::string, Tensor::pointer> NeuralNetwork::processInputData
                 
                 if(m_batchSize == -1) {
                     m_batchSize = dataList.getSize();
+                    auto batchFrameData = batch->getFrameData();
+                    if(batchFrameData.count("batch-size") > 0)
+                        m_validBatchSize = std::min(std::stoi(batchFrameData["batch-size"]), m_batchSize);
                 } else {
                     throw Exception("Inconsistent batch size accross input nodes");
                 }
@@ -169,17 +174,34 @@ std::unordered_map<std::string, Tensor::pointer> NeuralNetwork::processInputData
                 // TODO fix ordering if necessary
                 // We have a list of tensors, convert the list of tensors into a single tensor
                 auto shape = inputTensors.front()->getShape();
-                m_batchSize = shape[0];
+                const std::size_t totalSize = shape.getTotalSize();
                 shape.insertDimension(0, inputTensors.size());
+                if(containsSequence)
+                    shape.insertDimension(0, 1);
                 auto tensor = Tensor::New();
-                tensor->create(shape);
-                auto access = tensor->getAccess(ACCESS_READ_WRITE);
-                float* data = access->getRawData();
-                for(int i = 0; i < inputTensors.size(); ++i) {
-                    auto accessRead = inputTensors[i]->getAccess(ACCESS_READ);
-                    const int totalSize = accessRead->getShape().getTotalSize();
-                    std::memcpy(&data[i*totalSize], accessRead->getRawData(), totalSize*sizeof(float));
+                // If the tensors are consecutive slices of the same storage, e.g. from Tensor::getSlice,
+                // the combined tensor is a view of that storage and no data is copied
+                std::vector<std::shared_ptr<float>> inputData;
+                for(auto&& inputTensor : inputTensors)
+                    inputData.push_back(inputTensor->getAccess(ACCESS_READ)->getSharedRawData());
+                bool consecutive = true;
+                for(int i = 1; i < inputData.size(); ++i) {
+                    const bool sameOwner = !inputData[i].owner_before(inputData[0]) && !inputData[0].owner_before(inputData[i]);
+                    if(!sameOwner || inputData[i].get() != inputData[0].get() + i*totalSize) {
+                        consecutive = false;
+                        break;
+                    }
+                }
+                if(consecutive) {
+                    tensor->create(inputData[0], shape);
+                } else {
+                    tensor->create(shape);
+                    auto access = tensor->getAccess(ACCESS_READ_WRITE);
+                    float* data = access->getRawData();
+                    for(int i = 0; i < inputData.size(); ++i)
+                        std::memcpy(&data[i*totalSize], inputData[i].get(), totalSize*sizeof(float));
                 }
+                tensors[inputNode.first] = tensor;
             }
         } else {
             // TODO fix ordering if necessary
@@ -188,6 +210,8 @@ std::unordered_map<std::string, Tensor::pointer> NeuralNetwork::processInputData
         }
         mRuntimeManager->stopRegularTimer("input_processing");
 	}
+    if(m_validBatchSize < 0)
+        m_validBatchSize = m_batchSize;
 
 	return tensors;
 }
@@ -200,6 +224,7 @@ void NeuralNetwork::run() {
 
     // Prepare input data
 	auto inputTensors = processInputData();
+	waitForInputTransfers();
 	// Give input tensors to inference engine
     for(const auto &node : m_engine->getInputNodes()) {
         m_engine->setInputData(node.first, inputTensors[node.first]);
@@ -211,6 +236,16 @@ void NeuralNetwork::run() {
     mRuntimeManager->stopRegularTimer("inference");
 }
 
+void NeuralNetwork::waitForInputTransfers() {
+    if(m_pendingTransfers.empty())
+        return;
+    mRuntimeManager->startRegularTimer("input_transfer");
+    cl::Event::waitForEvents(m_pendingTransfers);
+    m_pendingTransfers.clear();
+    m_pendingTransferImages.clear();
+    mRuntimeManager->stopRegularTimer("input_transfer");
+}
+
 void NeuralNetwork::execute() {
     // Load, prepare input and run network
     run();
@@ -223,24 +258,11 @@ void NeuralNetwork::execute() {
         auto tensor = m_engine->getOutputData(node.first);
 
         if(m_batchSize > 1) {
-            // Create a batch of tensors
+            // Create a batch of tensors. Each tensor is a view of the network output, no data is copied.
+            // Output of padded batch entries is discarded.
             std::vector<Tensor::pointer> tensorList;
-            auto tensorAccess = tensor->getAccess(ACCESS_READ);
-            const float* rawTensorData = tensorAccess->getRawData();
-            // Calculate sample size
-            auto shape = tensor->getShape();
-            int size = 1;
-            auto newShape = TensorShape();
-            for(int i = 1; i < shape.getDimensions(); ++i) {
-                size *= shape[i];
-                newShape.addDimension(shape[i]);
-            }
-
-            for(int i = 0; i < m_batchSize; ++i) {
-                auto newTensor = Tensor::New();
-                auto newData = make_uninitialized_unique<float[]>(size);
-                std::memcpy(newData.get(), &(rawTensorData[i*size]), size*sizeof(float));
-                newTensor->create(std::move(newData), newShape);
+            for(int i = 0; i < m_validBatchSize; ++i) {
+                auto newTensor = tensor->getSlice(i);
                 tensorList.push_back(newTensor);
                 for(auto& inputNode : m_engine->getInputNodes()) {
                     // TODO assuming input are images here:
@@ -279,7 +301,6 @@ Tensor::pointer NeuralNetwork::convertImagesToTensor(std::vector<Image::pointer>
     auto values = make_uninitialized_unique<float[]>(shape.getTotalSize());
 
     OpenCLDevice::pointer device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
-    cl::Program program = getOpenCLProgram(device);
     int depth = 1;
     int timesteps = 0;
     std::string kernelName;
@@ -297,6 +318,9 @@ Tensor::pointer NeuralNetwork::convertImagesToTensor(std::vector<Image::pointer>
         if(shape[0] != 1)
             throw Exception("Batch of sequences for NN processing not supported yet!");
     }
+    cl::Program program;
+    if(device)
+        program = getOpenCLProgram(device);
     if(images[0]->getDimensions() == 2) {
         kernelName = "normalize2DInput";
         if((!temporal && shape.getDimensions() != 4) || (temporal && shape.getDimensions() != 5))
@@ -315,7 +339,6 @@ Tensor::pointer NeuralNetwork::convertImagesToTensor(std::vector<Image::pointer>
             depth = shape[dims - 4];
         }
     }
-    cl::Kernel kernel(program, kernelName.c_str());
     const std::size_t size = width*height*depth*channels; // nr of elements per image
     for(int i = 0; i < images.size(); ++i) {
         auto image = images[i];
@@ -329,23 +352,58 @@ Tensor::pointer NeuralNetwork::convertImagesToTensor(std::vector<Image::pointer>
         if(image->getNrOfChannels() != channels)
             throw Exception("Input image sent to executeNetwork has incorrect nr of channels: " +
                     std::to_string(image->getNrOfChannels())+ ". Expected: " + std::to_string(channels) + ".");
-        OpenCLImageAccess::pointer access = image->getOpenCLImageAccess(ACCESS_READ, device);
-        cl::Buffer buffer(
+    }
+    const bool channelFirst = m_engine->getPreferredImageOrdering() == ImageOrdering::ChannelFirst;
+
+    if(getMainDevice()->isHost()) {
+        // Normalize on the CPU, avoiding the round trip through OpenCL
+        std::vector<ImageAccess::pointer> accesses;
+        for(auto&& image : images)
+            accesses.push_back(image->getImageAccess(ACCESS_READ));
+        const std::size_t imageSize = (std::size_t)width*height*depth;
+        const int64_t rows = (int64_t)height*depth;
+        // Rows of all images in the batch, as a single signed index
+        #pragma omp parallel for
+        for(int64_t batchRow = 0; batchRow < (int64_t)images.size()*rows; ++batchRow) {
+            const int i = (int)(batchRow / rows);
+            const std::size_t row = (std::size_t)(batchRow % rows);
+            switch(images[i]->getDataType()) {
+                fastSwitchTypeMacro(normalizeInputRowOnHost<FAST_TYPE>((const FAST_TYPE*)accesses[i]->get(), values.get() + i*size,
+                        row, width, imageSize, channels, channelFirst));
+            }
+        }
+        auto tensor = Tensor::New();
+        tensor->create(std::move(values), shape);
+        return tensor;
+    }
+
+    // The entire batch is normalized into one staging buffer, which is reused as long as the size does not change.
+    // It is allocated in host accessible (pinned) memory to speed up the transfer back to the host.
+    if(m_stagingBufferSize != size*images.size()) {
+        m_stagingBufferSize = size*images.size();
+        m_stagingBuffer = cl::Buffer(
                 device->getContext(),
-                CL_MEM_WRITE_ONLY,
-                sizeof(float) * size
+                CL_MEM_WRITE_ONLY | CL_MEM_ALLOC_HOST_PTR,
+                sizeof(float) * m_stagingBufferSize
         );
-        kernel.setArg(1, buffer);
-        kernel.setArg(2, mScaleFactor);
-        kernel.setArg(3, mMean);
-        kernel.setArg(4, mStd);
-        kernel.setArg(5, (int) (mSignedInputNormalization ? 1 : 0));
-        kernel.setArg(6, (int) (mHorizontalImageFlipping ? 1 : 0));
-        kernel.setArg(7, image->getNrOfChannels());
-        kernel.setArg(8, mMinIntensity);
-        kernel.setArg(9, mMaxIntensity);
-        kernel.setArg(10, (int)(mMinAndMaxIntensitySet ? 1 : 0));
-        kernel.setArg(11, (int)(m_engine->getPreferredImageOrdering() == ImageOrdering::ChannelFirst ? 1 : 0));
+    }
+    cl::Kernel kernel(program, kernelName.c_str());
+    kernel.setArg(1, m_stagingBuffer);
+    kernel.setArg(2, mScaleFactor);
+    kernel.setArg(3, mMean);
+    kernel.setArg(4, mStd);
+    kernel.setArg(5, (int) (mSignedInputNormalization ? 1 : 0));
+    kernel.setArg(6, (int) (mHorizontalImageFlipping ? 1 : 0));
+    kernel.setArg(7, channels);
+    kernel.setArg(8, mMinIntensity);
+    kernel.setArg(9, mMaxIntensity);
+    kernel.setArg(10, (int)(mMinAndMaxIntensitySet ? 1 : 0));
+    kernel.setArg(11, (int)(channelFirst ? 1 : 0));
+    // The images are separate OpenCL images, so one launch is needed per image.
+    // The launches are not blocking, and are followed by a single read of the entire batch.
+    for(int i = 0; i < images.size(); ++i) {
+        auto image = images[i];
+        auto access = image->getOpenCLImageAccess(ACCESS_READ, device);
         cl::NDRange globalSize;
         if(image->getDimensions() == 2) {
             kernel.setArg(0, *access->get2DImage());
@@ -354,6 +412,7 @@ Tensor::pointer NeuralNetwork::convertImagesToTensor(std::vector<Image::pointer>
             kernel.setArg(0, *access->get3DImage());
             globalSize = cl::NDRange(width, height, depth);
         }
+        kernel.setArg(12, (int)(i*size));
 
         device->getCommandQueue().enqueueNDRangeKernel(
                 kernel,
@@ -361,17 +420,52 @@ Tensor::pointer NeuralNetwork::convertImagesToTensor(std::vector<Image::pointer>
                 globalSize,
                 cl::NullRange
         );
-
-        // Read data directly into slice
-        device->getCommandQueue().enqueueReadBuffer(buffer, CL_TRUE, 0, sizeof(float) * size,
-                                                    values.get() + i*size);
     }
 
+    // Read the entire batch without blocking. NeuralNetwork::run waits for it before giving the tensor to the engine,
+    // so the transfer of one input node overlaps the processing of the next.
+    cl::Event readEvent;
+    device->getCommandQueue().enqueueReadBuffer(m_stagingBuffer, CL_FALSE, 0, sizeof(float) * size * images.size(),
+                                                values.get(), nullptr, &readEvent);
+    device->getCommandQueue().flush();
+    m_pendingTransfers.push_back(readEvent);
+    // Keep the images alive until the kernels are done
+    m_pendingTransferImages.insert(m_pendingTransferImages.end(), images.begin(), images.end());
+
     auto tensor = Tensor::New();
     tensor->create(std::move(values), shape);
     return tensor;
 }
 
+template <class T>
+void NeuralNetwork::normalizeInputRowOnHost(const T* input, float* output, std::size_t row, int width, std::size_t imageSize, int channels, bool channelFirst) {
+    const bool clip = mMinAndMaxIntensitySet;
+    const float minIntensity = mMinIntensity;
+    const float maxIntensity = mMaxIntensity;
+    // Same operations as the normalize kernels: new_i = ((i - mean)/std)*scale
+    const float scale = mScaleFactor / mStd;
+    const float offset = -mMean * mScaleFactor / mStd;
+    const bool signedNormalization = mSignedInputNormalization;
+    const bool flip = mHorizontalImageFlipping;
+    const std::size_t start = row*width;
+    for(int c = 0; c < channels; ++c) {
+        const T* in = input + start*channels + c;
+        // Output positions of this row: Either interleaved (channel last) or planar (channel first)
+        float* out = channelFirst ? output + c*imageSize + start : output + start*channels + c;
+        const std::size_t outStride = channelFirst ? 1 : channels;
+        for(int x = 0; x < width; ++x) {
+            float value = (float)in[x*channels];
+            if(clip)
+                value = std::min(std::max(value, minIntensity), maxIntensity);
+            value = value*scale + offset;
+            if(signedNormalization)
+                value = value*2.0f - 1.0f;
+            const int outX = flip ? width - x - 1 : x;
+            out[outX*outStride] = value;
+        }
+    }
+}
+
 std::vector<SharedPointer<Image>> NeuralNetwork::resizeImages(const std::vector<SharedPointer<Image>> &images, int width, int height, int depth) {
     mRuntimeManager->startRegularTimer("image input resize");
     std::vector<Image::pointer> resizedImages;
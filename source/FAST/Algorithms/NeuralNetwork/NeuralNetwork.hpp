@@ -151,6 +151,8 @@ class FAST_EXPORT NeuralNetwork : public ProcessObject {
         bool mSignedInputNormalization = false;
         int mTemporalWindow = 0;
         int m_batchSize;
+        // Number of entries in the batch which are not padding, see ImageToBatchGenerator::setPadding
+        int m_validBatchSize;
         float mScaleFactor, mMean, mStd, mMinIntensity, mMaxIntensity;
         bool mMinAndMaxIntensitySet = false;
         Vector3f mNewInputSpacing;
@@ -163,7 +165,26 @@ class FAST_EXPORT NeuralNetwork : public ProcessObject {
 
         std::unordered_map<std::string, Tensor::pointer> processInputData();
         std::vector<SharedPointer<Image>> resizeImages(const std::vector<SharedPointer<Image>>& images, int width, int height, int depth);
+        /**
+         * Normalize images and convert them to a tensor. On OpenCL devices the transfer of the tensor data back
+         * to the host is not blocking, call waitForInputTransfers before using the tensor data.
+         */
         Tensor::pointer convertImagesToTensor(std::vector<SharedPointer<Image>> image, const TensorShape& shape, bool temporal);
+        /**
+         * Block until all tensor data from convertImagesToTensor has been transferred to the host
+         */
+        void waitForInputTransfers();
+        /**
+         * Normalize a row of an input image on the host. The row is the index of the row of the entire image.
+         */
+        template <class T>
+        void normalizeInputRowOnHost(const T* input, float* output, std::size_t row, int width, std::size_t imageSize, int channels, bool channelFirst);
+
+        // Reused staging buffer for the normalized input of a batch, and its size in nr of elements
+        cl::Buffer m_stagingBuffer;
+        std::size_t m_stagingBufferSize;
+        std::vector<cl::Event> m_pendingTransfers;
+        std::vector<SharedPointer<Image>> m_pendingTransferImages;
 
     private:
         void execute();
@@ -291,6 +291,49 @@ TEST_CASE("Execute NN on batch of 2D images", "[fast][neuralnetwork][batch]") {
     }
 }
 
+TEST_CASE("Execute NN on batch of 2D images with input normalization on host", "[fast][neuralnetwork][batch]") {
+    for(auto&& engine : InferenceEngineManager::getEngineList()) {
+        if(engine.substr(0, 10) == "TensorFlow" || engine == "TensorRT")
+            continue;
+
+        auto importer = ImageFileImporter::New();
+        importer->setFilename(Config::getTestDataPath() + "US/JugularVein/US-2D_0.mhd");
+        auto port = importer->getOutputPort();
+        importer->update();
+        auto image = port->getNextFrame<Image>();
+        auto batch = Batch::New();
+        batch->create({image, image, image});
+
+        // Normalization on the host and with OpenCL should give the same network output
+        std::vector<Batch::pointer> results;
+        for(bool host : {false, true}) {
+            auto network = NeuralNetwork::New();
+            network->setInferenceEngine(engine);
+            network->getInferenceEngine()->setMaxBatchSize(3);
+            network->load(Config::getTestDataPath() + "NeuralNetworkModels/single_input_multi_output.xml");
+            network->setScaleFactor(1.0f/255.0f);
+            network->setHorizontalFlipping(true);
+            if(host)
+                network->setMainDevice(Host::getInstance());
+            network->setInputData(batch);
+            auto outputPort = network->getOutputPort(0);
+            network->update();
+            results.push_back(outputPort->getNextFrame<Batch>());
+        }
+
+        auto list1 = results[0]->getAccess(ACCESS_READ)->getData().getTensors();
+        auto list2 = results[1]->getAccess(ACCESS_READ)->getData().getTensors();
+        REQUIRE(list1.size() == 3);
+        REQUIRE(list2.size() == 3);
+        for(int i = 0; i < 3; ++i) {
+            auto access1 = list1[i]->getAccess(ACCESS_READ);
+            auto access2 = list2[i]->getAccess(ACCESS_READ);
+            for(int j = 0; j < 6; ++j)
+                CHECK(access1->getRawData()[j] == Approx(access2->getRawData()[j]).epsilon(0.001));
+        }
+    }
+}
+
 TEST_CASE("NN: temporal input static output", "[fast][neuralnetwork][sequence]") {
     for(const std::string& engine : {"TensorFlowCPU", "TensorFlowCUDA"}) {
         if(!InferenceEngineManager::isEngineAvailable(engine)) {
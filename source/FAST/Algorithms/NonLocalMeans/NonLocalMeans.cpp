@@ -1,5 +1,6 @@
 #include "NonLocalMeans.hpp"
 #include <FAST/Data/Image.hpp>
+#include <FAST/Utility.hpp>
 
 namespace fast {
 
@@ -14,6 +15,7 @@ NonLocalMeans::NonLocalMeans() {
     createIntegerAttribute("filter-size", "Filter size", "Filter size", 3);
     createIntegerAttribute("iterations", "Iterations", "Number of multiscale iterations", 3);
     createBooleanAttribute("preprocess", "Preprocess", "Apply preprocessing (5x5 median filter) or not", true);
+    createBooleanAttribute("fast", "Fast mode", "Use fast host implementation also for 2D 8 bit images", false);
 }
 
 void NonLocalMeans::loadAttributes() {
@@ -22,12 +24,248 @@ void NonLocalMeans::loadAttributes() {
     setFilterSize(getIntegerAttribute("filter-size"));
     setMultiscaleIterations(getIntegerAttribute("iterations"));
     setPreProcess(getBooleanAttribute("preprocess"));
+    setFastMode(getBooleanAttribute("fast"));
+}
+
+template <class T>
+static void convertToFloat(const T* input, float* output, std::size_t size, float offset, float scale) {
+    #pragma omp parallel for
+    for(int64_t i = 0; i < (int64_t)size; ++i)
+        output[i] = ((float)input[i] - offset)*scale;
+}
+
+template <class T>
+static void convertFromFloat(const float* input, T* output, std::size_t size, float offset, float scale) {
+    // Round and clamp when converting to integer types
+    const bool isInteger = std::is_integral<T>::value;
+    const float minimum = isInteger ? (float)std::numeric_limits<T>::lowest() : -std::numeric_limits<float>::max();
+    const float maximum = isInteger ? (float)std::numeric_limits<T>::max() : std::numeric_limits<float>::max();
+    #pragma omp parallel for
+    for(int64_t i = 0; i < (int64_t)size; ++i) {
+        const float value = std::min(std::max(input[i]*scale + offset, minimum), maximum);
+        output[i] = isInteger ? (T)std::round(value) : (T)value;
+    }
+}
+
+/**
+ * Same as the preprocess kernel: Pixels which are much darker than the 5x5 median around them are darkened further.
+ * 3D images are processed slice by slice.
+ */
+static void preprocess(const float* input, float* output, int width, int height, int depth) {
+    const float threshold = 150.0f/255.0f;
+    #pragma omp parallel for
+    for(int row = 0; row < depth*height; ++row) {
+        const int z = row / height;
+        const int y = row % height;
+        float elements[25];
+        const float* slice = &input[(std::size_t)z*width*height];
+        for(int x = 0; x < width; ++x) {
+            int counter = 0;
+            for(int a = -2; a <= 2; ++a) {
+                for(int b = -2; b <= 2; ++b) {
+                    const int nx = std::min(std::max(x + a, 0), width - 1);
+                    const int ny = std::min(std::max(y + b, 0), height - 1);
+                    elements[counter] = slice[nx + ny*width];
+                    ++counter;
+                }
+            }
+            std::nth_element(elements, elements + 12, elements + 25);
+            const float median = elements[12];
+            const float current = slice[x + y*width];
+            output[(std::size_t)z*width*height + x + y*width] = current - std::max(median - current - threshold, 0.0f);
+        }
+    }
+}
+
+/**
+ * Sum of every row (x direction) over a window of size 2*radius+1 using a running sum.
+ * Borders are clamped to edge, same as the sampler in the OpenCL kernels.
+ */
+static void boxSumRows(const float* input, float* output, int radius, int width, int rows) {
+    #pragma omp parallel for
+    for(int row = 0; row < rows; ++row) {
+        const float* in = &input[(std::size_t)row*width];
+        float* out = &output[(std::size_t)row*width];
+        float sum = 0.0f;
+        for(int x = -radius; x <= radius; ++x)
+            sum += in[std::min(std::max(x, 0), width - 1)];
+        for(int x = 0; x < width; ++x) {
+            out[x] = sum;
+            sum += in[std::min(x + radius + 1, width - 1)] - in[std::max(x - radius, 0)];
+        }
+    }
+}
+
+/**
+ * Sum along an outer direction (y or z) over a window of size 2*radius+1, where neighbours are whole lines of
+ * lineSize contiguous values separated by stride. Each output line is the previous output line plus the line entering
+ * the window minus the line leaving it.
+ */
+static void boxSumLines(const float* input, float* output, int radius, int size, std::size_t lineSize, std::size_t stride, int blocks) {
+    const int chunkSize = 256;
+    const int chunks = (int)((lineSize + chunkSize - 1)/chunkSize);
+    #pragma omp parallel for
+    for(int blockChunk = 0; blockChunk < blocks*chunks; ++blockChunk) {
+        const int block = blockChunk / chunks;
+        const int chunk = blockChunk % chunks;
+        const std::size_t start = (std::size_t)block*size*stride + (std::size_t)chunk*chunkSize;
+        const int length = (int)std::min<std::size_t>(chunkSize, lineSize - (std::size_t)chunk*chunkSize);
+        Eigen::Map<Eigen::ArrayXf> out(&output[start], length);
+        out.setZero();
+        for(int k = -radius; k <= radius; ++k)
+            out += Eigen::Map<const Eigen::ArrayXf>(&input[start + (std::size_t)std::min(std::max(k, 0), size - 1)*stride], length);
+        for(int i = 1; i < size; ++i) {
+            Eigen::Map<Eigen::ArrayXf>(&output[start + (std::size_t)i*stride], length) =
+                Eigen::Map<const Eigen::ArrayXf>(&output[start + (std::size_t)(i - 1)*stride], length) +
+                Eigen::Map<const Eigen::ArrayXf>(&input[start + (std::size_t)std::min(i + radius, size - 1)*stride], length) -
+                Eigen::Map<const Eigen::ArrayXf>(&input[start + (std::size_t)std::max(i - radius - 1, 0)*stride], length);
+        }
+    }
+}
+
+/**
+ * One iteration of non local means. For each search offset, the squared difference between the image and the
+ * shifted image is summed over the patch with box sums, which gives the patch distance for all pixels at once.
+ * The patch distance is symmetric, thus the weights for an offset are also used for the opposite offset,
+ * and only half of the offsets are computed. Samples outside the image are not used.
+ */
+static void nonLocalMeansFilter(const float* input, float* output, int width, int height, int depth,
+        int searchSize, int filterSize, float parameterH, int scale) {
+    const std::size_t size = (std::size_t)width*height*depth;
+    const std::size_t sliceSize = (std::size_t)width*height;
+    // The center pixel has weight 1
+    std::vector<float> sumTop(input, input + size);
+    std::vector<float> sumBottom(size, 1.0f);
+    std::vector<float> difference(size);
+    std::vector<float> patchDifference(size);
+    std::vector<float> weights(size);
+    const float weightScale = -1.0f/(2.0f*parameterH*parameterH);
+    const int searchSizeZ = depth > 1 ? searchSize : 0;
+
+    for(int searchOffsetZ = 0; searchOffsetZ <= searchSizeZ; ++searchOffsetZ) {
+        for(int searchOffsetY = searchOffsetZ > 0 ? -searchSize : 0; searchOffsetY <= searchSize; ++searchOffsetY) {
+            for(int searchOffsetX = searchOffsetZ > 0 || searchOffsetY > 0 ? -searchSize : 1; searchOffsetX <= searchSize; ++searchOffsetX) {
+                const int offsetX = searchOffsetX*scale;
+                const int offsetY = searchOffsetY*scale;
+                const int offsetZ = searchOffsetZ*scale;
+                if(std::abs(offsetX) >= width || std::abs(offsetY) >= height || offsetZ >= depth)
+                    continue;
+                // Squared difference to the shifted image
+                #pragma omp parallel for
+                for(int row = 0; row < depth*height; ++row) {
+                    const int z = row / height;
+                    const int y = row % height;
+                    const int shiftedY = std::min(std::max(y + offsetY, 0), height - 1);
+                    const int shiftedZ = std::min(std::max(z + offsetZ, 0), depth - 1);
+                    const float* in = &input[z*sliceSize + (std::size_t)y*width];
+                    const float* shifted = &input[shiftedZ*sliceSize + (std::size_t)shiftedY*width];
+                    float* out = &difference[z*sliceSize + (std::size_t)y*width];
+                    for(int x = 0; x < width; ++x) {
+                        const float diff = in[x] - shifted[std::min(std::max(x + offsetX, 0), width - 1)];
+                        out[x] = diff*diff;
+                    }
+                }
+
+                // Sum over patches
+                boxSumRows(difference.data(), patchDifference.data(), filterSize, width, height*depth);
+                boxSumLines(patchDifference.data(), difference.data(), filterSize, height, width, width, depth);
+                const float* distance = difference.data();
+                if(depth > 1) {
+                    boxSumLines(difference.data(), patchDifference.data(), filterSize, depth, sliceSize, sliceSize, 1);
+                    distance = patchDifference.data();
+                }
+
+                // Pixels x in [startX, endX) have their shifted pixel x + offsetX inside the image
+                const int startX = std::max(0, -offsetX);
+                const int endX = std::min(width, width - offsetX);
+                const int length = endX - startX;
+                const std::ptrdiff_t shift = offsetX + (std::ptrdiff_t)offsetY*width + (std::ptrdiff_t)offsetZ*sliceSize;
+                // Accumulate shifted pixels weighted by patch distance
+                // Rows y in [startY, startY + rows) have their shifted row y + offsetY inside the image
+                const int startY = std::max(0, -offsetY);
+                const int rows = height - std::abs(offsetY);
+                #pragma omp parallel for
+                for(int row = 0; row < (depth - offsetZ)*rows; ++row) {
+                    const int z = row / rows;
+                    const int y = startY + row % rows;
+                    const std::size_t start = z*sliceSize + (std::size_t)y*width + startX;
+                    Eigen::Map<Eigen::ArrayXf> weight(&weights[start], length);
+                    weight = (Eigen::Map<const Eigen::ArrayXf>(&distance[start], length)*weightScale).exp();
+                    Eigen::Map<Eigen::ArrayXf>(&sumBottom[start], length) += weight;
+                    Eigen::Map<Eigen::ArrayXf>(&sumTop[start], length) += weight*Eigen::Map<const Eigen::ArrayXf>(&input[start + shift], length);
+                }
+                // Same for the opposite offset, using the weights of the shifted pixels
+                #pragma omp parallel for
+                for(int row = 0; row < (depth - offsetZ)*rows; ++row) {
+                    const int z = offsetZ + row / rows;
+                    const int y = startY + offsetY + row % rows;
+                    const std::size_t start = z*sliceSize + (std::size_t)y*width + startX + offsetX;
+                    Eigen::Map<const Eigen::ArrayXf> weight(&weights[start - shift], length);
+                    Eigen::Map<Eigen::ArrayXf>(&sumBottom[start], length) += weight;
+                    Eigen::Map<Eigen::ArrayXf>(&sumTop[start], length) += weight*Eigen::Map<const Eigen::ArrayXf>(&input[start - shift], length);
+                }
+            }
+        }
+    }
+
+    #pragma omp parallel for
+    for(int64_t i = 0; i < (int64_t)size; ++i)
+        output[i] = sumTop[i]/sumBottom[i];
+}
+
+void NonLocalMeans::executeOnHost(SharedPointer<Image> input, SharedPointer<Image> output) {
+    const int width = input->getWidth();
+    const int height = input->getHeight();
+    const int depth = input->getDimensions() == 3 ? input->getDepth() : 1;
+    const std::size_t size = (std::size_t)width*height*depth;
+
+    // The smoothing amount is relative to intensities in the range [0, 1]. 8 bit images are scaled by 255, same as
+    // the OpenCL implementation, while other images are scaled by their intensity range.
+    float intensityOffset = 0.0f;
+    float intensityRange = 255.0f;
+    if(input->getDataType() != TYPE_UINT8) {
+        intensityOffset = input->calculateMinimumIntensity();
+        intensityRange = std::max(input->calculateMaximumIntensity() - intensityOffset, std::numeric_limits<float>::min());
+    }
+
+    auto buffer1 = std::make_unique<float[]>(size);
+    auto buffer2 = std::make_unique<float[]>(size);
+    {
+        auto inputAccess = input->getImageAccess(ACCESS_READ);
+        switch(input->getDataType()) {
+            fastSwitchTypeMacro(convertToFloat<FAST_TYPE>((FAST_TYPE*)inputAccess->get(), buffer1.get(), size, intensityOffset, 1.0f/intensityRange));
+        }
+    }
+
+    if(m_preProcess) {
+        preprocess(buffer1.get(), buffer2.get(), width, height, depth);
+        std::swap(buffer1, buffer2);
+    }
+
+    for(int iteration = 0; iteration < m_iterations; ++iteration) {
+        nonLocalMeansFilter(buffer1.get(), buffer2.get(), width, height, depth, m_searchSize, (m_filterSize - 1)/2,
+                            m_parameterH*(1.0f/(float)std::pow(2, iteration)), iteration + 1);
+        std::swap(buffer1, buffer2);
+    }
+
+    auto outputAccess = output->getImageAccess(ACCESS_READ_WRITE);
+    switch(output->getDataType()) {
+        fastSwitchTypeMacro(convertFromFloat<FAST_TYPE>(buffer1.get(), (FAST_TYPE*)outputAccess->get(), size, intensityOffset, intensityRange));
+    }
 }
 
 void NonLocalMeans::execute() {
     auto input = getInputData<Image>(0);
     auto output = getOutputData<Image>(0);
     output->createFromImage(input);
+    if(input->getNrOfChannels() != 1)
+        throw Exception("NonLocalMeans only supports images with 1 channel");
+
+    if(m_fastMode || getMainDevice()->isHost() || input->getDimensions() != 2 || input->getDataType() != TYPE_UINT8) {
+        executeOnHost(input, output);
+        return;
+    }
+
     auto auxImage = Image::New();
     auxImage->createFromImage(input);
 
@@ -97,6 +335,11 @@ void NonLocalMeans::execute() {
     queue.finish();
 }
 
+void NonLocalMeans::setFastMode(bool fast) {
+    m_fastMode = fast;
+    mIsModified = true;
+}
+
 void NonLocalMeans::setSmoothingAmount(float parameterH) {
     if(parameterH <= 0)
         throw Exception("Smoothing amount must be larger than 0");
@@ -3,6 +3,17 @@
 #include <FAST/ProcessObject.hpp>
 
 namespace fast {
+    class Image;
+
+    /**
+     * Multiscale non local means filter.
+     *
+     * The OpenCL implementation only supports 2D images of type TYPE_UINT8. All other images, and all images when
+     * fast mode is enabled or the main device is the host, are filtered with the fast multi-threaded host implementation.
+     * Instead of comparing every patch pair pixel by pixel, it computes the squared difference image for each search offset
+     * once and sums it over the patches with separable running box sums. This makes the cost per pixel independent
+     * of the filter size, and it supports 2D and 3D images of any scalar type.
+     */
     class FAST_EXPORT NonLocalMeans : public ProcessObject {
         FAST_OBJECT(NonLocalMeans);
     public:
@@ -11,15 +22,22 @@ namespace fast {
         void setMultiscaleIterations(int iterations);
         void setSearchSize(int searchSize);
         void setFilterSize(int filterSize);
+        /**
+         * Use the fast host implementation also for 2D 8 bit images. Default is false.
+         * @param fast
+         */
+        void setFastMode(bool fast);
         void loadAttributes() override;
     private:
         NonLocalMeans();
         void execute() override;
+        void executeOnHost(SharedPointer<Image> input, SharedPointer<Image> output);
 
         float m_parameterH = 0.15f;
         bool m_preProcess = true;
         int m_iterations = 3; // How many multiscale iterations to do
         int m_searchSize = 11; // How large the pixel search area should be
         int m_filterSize = 3;
+        bool m_fastMode = false;
     };
-}
\ No newline at end of file
+}
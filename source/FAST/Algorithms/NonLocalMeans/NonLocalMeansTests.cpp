@@ -1,12 +1,20 @@
 #include "FAST/Tests/catch.hpp"
 #include "NonLocalMeans.hpp"
+#include <FAST/Data/Image.hpp>
 #include <FAST/Streamers/ImageFileStreamer.hpp>
 #include <FAST/Visualization/ImageRenderer/ImageRenderer.hpp>
 #include <FAST/Visualization/DualViewWindow.hpp>
 #include <FAST/Algorithms/UltrasoundImageEnhancement/UltrasoundImageEnhancement.hpp>
+#include <random>
 
 using namespace fast;
 
+static float getPixel(const std::vector<float>& image, int width, int height, int x, int y) {
+    x = std::min(std::max(x, 0), width - 1);
+    y = std::min(std::max(y, 0), height - 1);
+    return image[x + y*width];
+}
+
 TEST_CASE("Non local means", "[fast][nlm]") {
     auto streamer = ImageFileStreamer::New();
     streamer->setFilenameFormat(Config::getTestDataPath() + "US/Heart/ApicalFourChamber/US-2D_#.mhd");
@@ -35,3 +43,92 @@ TEST_CASE("Non local means", "[fast][nlm]") {
     window->setTimeout(2000);
     window->start();
 }
+
+TEST_CASE("Fast non local means is equal to comparing every patch pair", "[fast][nlm]") {
+    const int width = 48;
+    const int height = 40;
+    const int searchSize = 3;
+    const int filterSize = 3;
+    const float parameterH = 0.15f;
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+    std::vector<float> data(width*height);
+    for(auto& value : data)
+        value = distribution(generator);
+    auto image = Image::New();
+    // Set 0 and 1 so that intensities are not scaled
+    data[0] = 0.0f;
+    data[1] = 1.0f;
+    image->create(width, height, TYPE_FLOAT, 1, data.data());
+
+    auto filter = NonLocalMeans::New();
+    filter->setInputData(image);
+    filter->setFastMode(true);
+    filter->setPreProcess(false);
+    filter->setMultiscaleIterations(1);
+    filter->setSearchSize(searchSize);
+    filter->setFilterSize(filterSize);
+    filter->setSmoothingAmount(parameterH);
+    auto output = filter->updateAndGetOutputData<Image>();
+    REQUIRE(output->getDataType() == TYPE_FLOAT);
+    auto access = output->getImageAccess(ACCESS_READ);
+    auto result = (float*)access->get();
+
+    // Borders are handled differently, thus only compare pixels where all samples are inside the image
+    const int border = searchSize + filterSize/2;
+    for(int y = border; y < height - border; ++y) {
+        for(int x = border; x < width - border; ++x) {
+            float sumTop = 0.0f;
+            float sumBottom = 0.0f;
+            for(int searchY = -searchSize; searchY <= searchSize; ++searchY) {
+                for(int searchX = -searchSize; searchX <= searchSize; ++searchX) {
+                    float diff = 0.0f;
+                    for(int filterY = -filterSize/2; filterY <= filterSize/2; ++filterY) {
+                        for(int filterX = -filterSize/2; filterX <= filterSize/2; ++filterX) {
+                            const float d = getPixel(data, width, height, x + filterX, y + filterY) -
+                                    getPixel(data, width, height, x + searchX + filterX, y + searchY + filterY);
+                            diff += d*d;
+                        }
+                    }
+                    const float weight = std::exp(-diff/(2.0f*parameterH*parameterH));
+                    sumBottom += weight;
+                    sumTop += weight*getPixel(data, width, height, x + searchX, y + searchY);
+                }
+            }
+            CHECK(result[x + y*width] == Approx(sumTop/sumBottom).margin(1e-4));
+        }
+    }
+}
+
+TEST_CASE("Fast non local means on 3D 16 bit image", "[fast][nlm]") {
+    const int size = 24;
+    std::mt19937 generator(42);
+    std::normal_distribution<float> noise(0.0f, 100.0f);
+    std::vector<ushort> data(size*size*size);
+    double inputVariance = 0;
+    for(auto& value : data) {
+        const float noiseValue = noise(generator);
+        value = (ushort)std::round(1000.0f + noiseValue);
+        inputVariance += (value - 1000.0)*(value - 1000.0);
+    }
+    auto image = Image::New();
+    image->create(size, size, size, TYPE_UINT16, 1, data.data());
+
+    auto filter = NonLocalMeans::New();
+    filter->setInputData(image);
+    filter->setSearchSize(3);
+    filter->setMultiscaleIterations(1);
+    filter->setSmoothingAmount(0.5f);
+    auto output = filter->updateAndGetOutputData<Image>();
+    REQUIRE(output->getDataType() == TYPE_UINT16);
+    REQUIRE(output->getDimensions() == 3);
+    CHECK(output->getDepth() == size);
+
+    auto access = output->getImageAccess(ACCESS_READ);
+    auto result = (ushort*)access->get();
+    double outputVariance = 0;
+    for(int i = 0; i < size*size*size; ++i)
+        outputVariance += (result[i] - 1000.0)*(result[i] - 1000.0);
+    // Noise should be reduced
+    CHECK(outputVariance < inputVariance*0.5);
+}
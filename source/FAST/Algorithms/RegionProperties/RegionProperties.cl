@@ -0,0 +1,67 @@
+__constant sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_FILTER_NEAREST | CLK_ADDRESS_NONE;
+
+// A label is the linear index + 1 of a pixel in the same component, 0 is background.
+// When propagation has converged, all pixels have the label of the pixel with the lowest index in the component.
+
+#if DIMENSIONS == 3
+#define IMAGE_TYPE image3d_t
+#define READ_SEGMENTATION(pos) read_imageui(segmentation, sampler, (int4)(pos.x, pos.y, pos.z, 0)).x
+#define GET_POSITION() (int3)(get_global_id(0), get_global_id(1), get_global_id(2))
+#define GET_SIZE() (int3)(get_global_size(0), get_global_size(1), get_global_size(2))
+#define RANGE_Z 1
+#else
+#define IMAGE_TYPE image2d_t
+#define READ_SEGMENTATION(pos) read_imageui(segmentation, sampler, (int2)(pos.x, pos.y)).x
+#define GET_POSITION() (int3)(get_global_id(0), get_global_id(1), 0)
+#define GET_SIZE() (int3)(get_global_size(0), get_global_size(1), 1)
+#define RANGE_Z 0
+#endif
+
+__kernel void initializeLabels(
+        __read_only IMAGE_TYPE segmentation,
+        __global uint* labels
+        ) {
+    const int3 pos = GET_POSITION();
+    const int3 size = GET_SIZE();
+    const uint index = pos.x + (pos.y + pos.z*size.y)*size.x;
+    labels[index] = READ_SEGMENTATION(pos) > 0 ? index + 1 : 0;
+}
+
+__kernel void propagateLabels(
+        __read_only IMAGE_TYPE segmentation,
+        __global uint* labels,
+        __global char* changed
+        ) {
+    const int3 pos = GET_POSITION();
+    const int3 size = GET_SIZE();
+    const uint index = pos.x + (pos.y + pos.z*size.y)*size.x;
+    const uint label = labels[index];
+    if(label == 0)
+        return;
+
+    const uint value = READ_SEGMENTATION(pos);
+    uint minLabel = label;
+    for(int c = -RANGE_Z; c <= RANGE_Z; ++c) {
+    for(int b = -1; b <= 1; ++b) {
+    for(int a = -1; a <= 1; ++a) {
+#ifndef FULL_CONNECTIVITY
+        if(abs(a) + abs(b) + abs(c) != 1)
+            continue;
+#endif
+        const int3 neighbor = pos + (int3)(a, b, c);
+        if(any(neighbor < 0) || any(neighbor >= size))
+            continue;
+        if(READ_SEGMENTATION(neighbor) != value)
+            continue;
+        minLabel = min(minLabel, labels[neighbor.x + (neighbor.y + neighbor.z*size.y)*size.x]);
+    }}}
+
+    // Jump to the label of the pixel this label refers to, which is in the same component
+    minLabel = min(minLabel, labels[minLabel - 1]);
+    if(minLabel < label) {
+        atomic_min(&labels[index], minLabel);
+        // Also lower the label of the pixel the old label referred to, this merges the two trees
+        atomic_min(&labels[label - 1], minLabel);
+        changed[0] = 1;
+    }
+}
@@ -1,152 +1,277 @@
 #include <FAST/Data/Image.hpp>
 #include "RegionProperties.hpp"
-#include <unordered_set>
-#include <queue>
-#include <FAST/Data/Mesh.hpp>
+#include <thread>
+#include <limits>
 
 namespace fast {
 
 RegionProperties::RegionProperties() {
     createInputPort<Image>(0);
     createOutputPort<RegionList>(0);
+    createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/RegionProperties/RegionProperties.cl");
+    setMainDevice(Host::getInstance()); // Default is to label on host
 }
 
-void RegionProperties::execute() {
-    auto input = getInputData<Image>();
-    if(input->getDataType() != TYPE_UINT8)
-        throw Exception("Wrong input data type to RegionProperties");
-    if(input->getDimensions() != 2)
-        throw Exception("Region properties is only implemented for 2D segmentations");
+void RegionProperties::setFullConnectivity(bool full) {
+    m_fullConnectivity = full;
+    mIsModified = true;
+}
 
-    std::vector<Region> regions;
+void RegionProperties::setStorePixels(bool store) {
+    m_storePixels = store;
+    mIsModified = true;
+}
 
-    const int width = input->getWidth();
-    const int height = input->getHeight();
-
-    std::unordered_set<uint> visited;
-    auto access = input->getImageAccess(ACCESS_READ);
-    auto pixels = (uchar*)access->get();
-
-    // Get regions by flood fill first
-    std::queue<Vector2i> queue;
-    for(int y = 0; y < height; ++y) {
-        for(int x = 0; x < width; ++x) {
-            uchar currentLabel = pixels[x + y*width];
-            if(currentLabel == 0 || visited.count(x+y*width) > 0)
-                continue;
-
-            // Start flood fill
-
-            // Create region
-            Region region;
-            region.label = currentLabel;
-            region.area = 0;
-            region.centroid = Vector2f::Zero();
-
-            queue.push(Vector2i(x,y));
-            visited.insert(x + y*width);
-            while(!queue.empty()) {
-                Vector2i current = queue.front();
-                queue.pop();
-
-                region.centroid += current.cast<float>();
-                region.pixels.push_back(current);
-
-                ++region.area;
-
-                // Check neighbors
-                for(int a = -1; a <= 1; ++a) {
-                    for(int b = -1; b <= 1; ++b) {
-                        Vector2i next = current + Vector2i(a,b);
-                        // Out of bounds check
-                        if(next.x() < 0 || next.y() < 0 || next.x() >= width || next.y() >= height)
+void RegionProperties::setNumberOfThreads(uint threads) {
+    m_threads = threads;
+    mIsModified = true;
+}
+
+// Union-find where the root of a tree is always the pixel with the lowest index.
+// Thus the parent of a pixel never has a higher index than the pixel itself.
+template <class IndexType>
+static inline IndexType findRoot(IndexType* parent, IndexType index) {
+    while(parent[index] != index) {
+        parent[index] = parent[parent[index]]; // Path halving
+        index = parent[index];
+    }
+    return index;
+}
+
+template <class IndexType>
+static inline void unite(IndexType* parent, IndexType a, IndexType b) {
+    a = findRoot(parent, a);
+    b = findRoot(parent, b);
+    if(a < b) {
+        parent[b] = a;
+    } else if(b < a) {
+        parent[a] = b;
+    }
+}
+
+// Offsets to the neighbors which come before a pixel in scan order
+static std::vector<Vector3i> getPreviousNeighbors(bool is3D, bool fullConnectivity) {
+    std::vector<Vector3i> neighbors;
+    for(int c = is3D ? -1 : 0; c <= 0; ++c) {
+        for(int b = -1; b <= 1; ++b) {
+            for(int a = -1; a <= 1; ++a) {
+                if(c == 0 && (b > 0 || (b == 0 && a >= 0)))
+                    continue;
+                if(!fullConnectivity && abs(a) + abs(b) + abs(c) != 1)
+                    continue;
+                neighbors.push_back(Vector3i(a, b, c));
+            }
+        }
+    }
+    return neighbors;
+}
+
+template <class IndexType>
+void RegionProperties::labelOnHost(const uchar* segmentation, Vector3i size, IndexType* parent) {
+    const bool is3D = size.z() > 1;
+    const auto neighbors = getPreviousNeighbors(is3D, m_fullConnectivity);
+    // Strips are split along the last dimension
+    const int axis = is3D ? 2 : 1;
+
+    // Unite each pixel in the box from lower to upper with its previous neighbors inside the box
+    auto labelBox = [&](Vector3i lower, Vector3i upper, const std::vector<Vector3i>& offsets) {
+        for(int z = lower.z(); z < upper.z(); ++z) {
+            for(int y = lower.y(); y < upper.y(); ++y) {
+                for(int x = lower.x(); x < upper.x(); ++x) {
+                    const IndexType index = x + ((IndexType)y + (IndexType)z*size.y())*size.x();
+                    const uchar value = segmentation[index];
+                    if(value == 0)
+                        continue;
+                    parent[index] = index;
+                    for(auto&& offset : offsets) {
+                        const Vector3i neighbor = Vector3i(x, y, z) + offset;
+                        if((neighbor.array() < lower.array()).any() || (neighbor.array() >= upper.array()).any())
                             continue;
-                        uchar label = pixels[next.x() + next.y() * width];
-                        if(label == currentLabel && visited.count(next.x() + next.y() * width) == 0) {
-                            queue.push(next);
-                            visited.insert(next.x() + next.y()*width);
-                        }
+                        const IndexType neighborIndex = neighbor.x() + ((IndexType)neighbor.y() + (IndexType)neighbor.z()*size.y())*size.x();
+                        if(segmentation[neighborIndex] == value)
+                            unite(parent, index, neighborIndex);
                     }
                 }
             }
+        }
+    };
 
-            region.centroid /= region.area;
+    // First pass: Label each strip in parallel. Strips only look at pixels inside the strip,
+    // thus all trees are inside one strip.
+    uint threads = m_threads == 0 ? std::thread::hardware_concurrency() : m_threads;
+    // Too many strips only adds boundaries to merge
+    threads = std::max(1u, std::min(threads, (uint)(size[axis] / 16)));
+    std::vector<int> stripStart;
+    for(uint i = 0; i <= threads; ++i)
+        stripStart.push_back((int)((std::size_t)size[axis]*i/threads));
 
-            regions.push_back(region);
-        }
+    std::vector<std::thread> workers;
+    for(uint i = 0; i < threads; ++i) {
+        Vector3i lower = Vector3i::Zero();
+        Vector3i upper = size;
+        lower[axis] = stripStart[i];
+        upper[axis] = stripStart[i+1];
+        workers.emplace_back(labelBox, lower, upper, std::cref(neighbors));
     }
+    for(auto&& worker : workers)
+        worker.join();
 
-    visited.clear();
-    std::vector<Vector2i> vertices;
-
-    // TODO do contour tracing for each region if enabled
-    // TODO handle holes
-    for(auto region : regions) {
-        // Start moore neigbhorhood tracing
-        int checkLocationNr = 1;  // The neighbor number of the location we want to check for a new border point
-        Vector2i checkPosition;      // The corresponding absolute array address of checkLocationNr
-        int newCheckLocationNr;   // Variable that holds the neighborhood position we want to check if we find a new border at checkLocationNr
-        Vector2i startPos = region.pixels[0];      // Set start position
-        int counter = 0;       // Counter is used for the jacobi stop criterion
-        int counter2 = 0;       // Counter2 is used to determine if the point we have discovered is one single point
-
-        // Defines the neighborhood offset position from current position and the neighborhood
-        // position we want to check next if we find a new border at checkLocationNr
-        Vector3i neighborhood[8] = {
-                {-1, 0, 7},
-                {-1, -1, 7},
-                {0, -1, 1},
-                {1, -1, 1},
-                {1, 0, 3},
-                {1, 1, 3},
-                {0, 1, 5},
-                {-1, 1, 5},
-        };
-        Vector2i pos = startPos;
-        // Trace around the neighborhood
-        while(true)
-        {
-            checkPosition = pos + neighborhood[checkLocationNr-1].head(2);
-            newCheckLocationNr = neighborhood[checkLocationNr-1].z();
-
-            if(pixels[checkPosition.x() + checkPosition.y()*width] == 2 && visited.count(checkPosition.x() + checkPosition.y()*width) == 0) // Next border point found
-            {
-                if(checkPosition == startPos) { // Should we stop?
-                    counter ++;
-
-                    // Stopping criterion (jacob)
-                    if(newCheckLocationNr == 1 || counter >= 3)
-                    {
-                        // Close loop
-                        //inside = true; // Since we are starting the search at were we first started we must set inside to true
-                        break;
+    // Merge trees across the strip boundaries, using the neighbors in the previous strip only
+    std::vector<Vector3i> boundaryNeighbors;
+    for(auto&& offset : neighbors) {
+        if(offset[axis] == -1)
+            boundaryNeighbors.push_back(offset);
+    }
+    for(uint i = 1; i < threads; ++i) {
+        // The first slice of the strip
+        Vector3i lower = Vector3i::Zero();
+        Vector3i upper = size;
+        lower[axis] = stripStart[i];
+        upper[axis] = stripStart[i] + 1;
+        for(int z = lower.z(); z < upper.z(); ++z) {
+            for(int y = lower.y(); y < upper.y(); ++y) {
+                for(int x = 0; x < size.x(); ++x) {
+                    const IndexType index = x + ((IndexType)y + (IndexType)z*size.y())*size.x();
+                    const uchar value = segmentation[index];
+                    if(value == 0)
+                        continue;
+                    for(auto&& offset : boundaryNeighbors) {
+                        const Vector3i neighbor = Vector3i(x, y, z) + offset;
+                        if(neighbor.x() < 0 || neighbor.x() >= size.x() || neighbor.y() < 0 || neighbor.y() >= size.y())
+                            continue;
+                        const IndexType neighborIndex = neighbor.x() + ((IndexType)neighbor.y() + (IndexType)neighbor.z()*size.y())*size.x();
+                        if(segmentation[neighborIndex] == value)
+                            unite(parent, index, neighborIndex);
                     }
                 }
+            }
+        }
+    }
+}
 
-                checkLocationNr = newCheckLocationNr; // Update which neighborhood position we should check next
-                pos = checkPosition;
-                counter2 = 0;             // Reset the counter that keeps track of how many neighbors we have visited
-                //borderImage[checkPosition] = BLACK; // Set the border pixel
-                visited.insert(pos.x() + pos.y()*width);
-                vertices.push_back(Vector2i(pos.x(), pos.y()));
-            } else {
-                // No match
-                // Rotate clockwise in the neighborhood
-                checkLocationNr = 1 + (checkLocationNr % 8);
-                if(counter2 > 8) {
-                    // If counter2 is above 8 we have traced around the neighborhood and
-                    // therefor the border is a single black pixel and we can exit
-                    counter2 = 0;
-                    break;
+template <class IndexType>
+std::vector<Region> RegionProperties::createRegions(const uchar* segmentation, Vector3i size, IndexType* parent) {
+    // Second pass: Give each tree a region number, and calculate the region properties.
+    // Since a parent always comes before its children in scan order, the parent of a pixel has already
+    // been replaced by its region number, stored as totalSize + region number.
+    const IndexType totalSize = (IndexType)size.x()*size.y()*size.z();
+    std::vector<Region> regions;
+    std::vector<Eigen::Vector3d> sums;
+    for(int z = 0; z < size.z(); ++z) {
+        for(int y = 0; y < size.y(); ++y) {
+            for(int x = 0; x < size.x(); ++x) {
+                const IndexType index = x + ((IndexType)y + (IndexType)z*size.y())*size.x();
+                if(segmentation[index] == 0)
+                    continue;
+                const Vector3i position(x, y, z);
+                IndexType regionNr;
+                if(parent[index] == index) {
+                    regionNr = regions.size();
+                    Region region;
+                    region.area = 0;
+                    region.label = segmentation[index];
+                    region.minimum = position;
+                    region.maximum = position;
+                    regions.push_back(region);
+                    sums.push_back(Eigen::Vector3d::Zero());
                 } else {
-                    counter2 ++;
+                    regionNr = parent[parent[index]] - totalSize;
                 }
+                parent[index] = totalSize + regionNr;
+
+                Region& region = regions[regionNr];
+                region.area += 1;
+                sums[regionNr] += position.cast<double>();
+                region.minimum = region.minimum.cwiseMin(position);
+                region.maximum = region.maximum.cwiseMax(position);
+                if(m_storePixels)
+                    region.pixels.push_back(position);
             }
         }
+    }
+    for(std::size_t i = 0; i < regions.size(); ++i)
+        regions[i].centroid = (sums[i] / (double)regions[i].area).cast<float>();
+
+    return regions;
+}
+
+void RegionProperties::labelOnDevice(SharedPointer<Image> input, uint* parent) {
+    auto device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
+    const std::size_t totalSize = input->getNrOfVoxels();
+
+    std::string buildOptions = "-DDIMENSIONS=" + std::to_string(input->getDimensions());
+    if(m_fullConnectivity)
+        buildOptions += " -DFULL_CONNECTIVITY";
+    cl::Program program = getOpenCLProgram(device, "", buildOptions);
+    cl::Kernel initializeKernel(program, "initializeLabels");
+    cl::Kernel propagateKernel(program, "propagateLabels");
+
+    auto access = input->getOpenCLImageAccess(ACCESS_READ, device);
+    cl::Buffer labels(device->getContext(), CL_MEM_READ_WRITE, totalSize*sizeof(uint));
+    cl::Buffer changed(device->getContext(), CL_MEM_READ_WRITE, sizeof(char));
+    cl::NDRange globalSize;
+    if(input->getDimensions() == 2) {
+        globalSize = cl::NDRange(input->getWidth(), input->getHeight());
+        initializeKernel.setArg(0, *access->get2DImage());
+        propagateKernel.setArg(0, *access->get2DImage());
+    } else {
+        globalSize = cl::NDRange(input->getWidth(), input->getHeight(), input->getDepth());
+        initializeKernel.setArg(0, *access->get3DImage());
+        propagateKernel.setArg(0, *access->get3DImage());
+    }
+    initializeKernel.setArg(1, labels);
+    propagateKernel.setArg(1, labels);
+    propagateKernel.setArg(2, changed);
+
+    auto queue = device->getCommandQueue();
+    queue.enqueueNDRangeKernel(initializeKernel, cl::NullRange, globalSize, cl::NullRange);
+    // Propagate labels until they don't change. To avoid waiting for the device after every iteration,
+    // several iterations are done before checking.
+    const char zero = 0;
+    char result;
+    do {
+        queue.enqueueWriteBuffer(changed, CL_FALSE, 0, sizeof(char), &zero);
+        for(int i = 0; i < 8; ++i)
+            queue.enqueueNDRangeKernel(propagateKernel, cl::NullRange, globalSize, cl::NullRange);
+        queue.enqueueReadBuffer(changed, CL_TRUE, 0, sizeof(char), &result);
+    } while(result == 1);
+
+    queue.enqueueReadBuffer(labels, CL_TRUE, 0, totalSize*sizeof(uint), parent);
+    // The labels are the index + 1 of the pixel with the lowest index in the component
+    for(std::size_t i = 0; i < totalSize; ++i)
+        parent[i] -= 1;
+}
+
+void RegionProperties::execute() {
+    auto input = getInputData<Image>();
+    if(input->getDataType() != TYPE_UINT8)
+        throw Exception("Wrong input data type to RegionProperties");
 
-        // TODO Create mesh
-        //region.contour = Mesh::New();
-        //region.contour->create(vertices);
+    const Vector3i size(input->getWidth(), input->getHeight(), input->getDepth());
+    const std::size_t totalSize = input->getNrOfVoxels();
+
+    std::vector<Region> regions;
+    // Region numbers are stored as totalSize + region number in the second pass, thus 32 bit indices
+    // can only be used when this fits.
+    if(!getMainDevice()->isHost()) {
+        if(totalSize >= std::numeric_limits<uint>::max()/2)
+            throw Exception("Image is too large for RegionProperties on an OpenCL device, use the host instead");
+        auto parent = std::make_unique<uint[]>(totalSize);
+        labelOnDevice(input, parent.get());
+        auto access = input->getImageAccess(ACCESS_READ);
+        regions = createRegions((const uchar*)access->get(), size, parent.get());
+    } else {
+        auto access = input->getImageAccess(ACCESS_READ);
+        auto segmentation = (const uchar*)access->get();
+        if(totalSize < std::numeric_limits<uint>::max()/2) {
+            auto parent = std::make_unique<uint[]>(totalSize);
+            labelOnHost(segmentation, size, parent.get());
+            regions = createRegions(segmentation, size, parent.get());
+        } else {
+            auto parent = std::make_unique<uint64_t[]>(totalSize);
+            labelOnHost(segmentation, size, parent.get());
+            regions = createRegions(segmentation, size, parent.get());
+        }
     }
 
     auto regionList = RegionList::New();
@@ -4,24 +4,63 @@
 #include <FAST/Data/SimpleDataObject.hpp>
 namespace fast {
 
-class Mesh;
+class Image;
 
 struct FAST_EXPORT Region {
-    int area;
+    // Nr of pixels/voxels in the region
+    std::size_t area;
+    // Segmentation label of the region
     uchar label;
-    Vector2f centroid;
-    SharedPointer<Mesh> contour;
-    std::vector<Vector2i> pixels;
+    // Centroid in pixel coordinates. z is 0 for 2D images
+    Vector3f centroid;
+    // Bounding box in pixel coordinates, both corners are inside the region's bounding box
+    Vector3i minimum;
+    Vector3i maximum;
+    // Position of every pixel in the region, only stored if enabled with RegionProperties::setStorePixels
+    std::vector<Vector3i> pixels;
 };
 
 FAST_SIMPLE_DATA_OBJECT(RegionList, std::vector<Region>)
 
+/**
+ * Finds the connected components of a segmentation, and calculates the area, centroid and bounding box
+ * of each component. Pixels are connected if they are neighbors and have the same label, 0 is background.
+ *
+ * Labeling is done with union-find in two passes over the image. On the host, the first pass is
+ * split into strips which are labeled in parallel. If the main device is set to an OpenCL device,
+ * the labels are found by label propagation on the device instead. Default is the host.
+ */
 class FAST_EXPORT RegionProperties : public ProcessObject {
     FAST_OBJECT(RegionProperties)
     public:
+        /**
+         * Set whether diagonal neighbors are connected, giving 8 connectivity in 2D and 26 connectivity in 3D.
+         * If false, 4 and 6 connectivity is used. Default is true.
+         * @param full
+         */
+        void setFullConnectivity(bool full);
+        /**
+         * Store the position of every pixel in each region. Default is false.
+         * @param store
+         */
+        void setStorePixels(bool store);
+        /**
+         * Set nr of threads to use for labeling on the host. Default is 0, which uses all hardware threads.
+         * @param threads
+         */
+        void setNumberOfThreads(uint threads);
     protected:
         RegionProperties();
         void execute() override;
+        template <class IndexType>
+        void labelOnHost(const uchar* segmentation, Vector3i size, IndexType* parent);
+        void labelOnDevice(SharedPointer<Image> input, uint* parent);
+        template <class IndexType>
+        std::vector<Region> createRegions(const uchar* segmentation, Vector3i size, IndexType* parent);
+
+        bool m_fullConnectivity = true;
+        bool m_storePixels = false;
+        uint m_threads = 0;
 };
 
-}
\ No newline at end of file
+}
@@ -2,6 +2,8 @@
 #include <FAST/Testing.hpp>
 #include <FAST/Importers/ImageFileImporter.hpp>
 #include <FAST/Algorithms/BinaryThresholding/BinaryThresholding.hpp>
+#include <FAST/Data/Image.hpp>
+#include <FAST/DeviceManager.hpp>
 
 using namespace fast;
 
@@ -20,9 +22,119 @@ TEST_CASE("Region properties", "[regionproperties][fast]") {
     auto access = regionList->getAccess(ACCESS_READ);
     auto regions = access->getData();
 
-    // TODO validate
+    std::size_t area = 0;
     for(auto& region : regions) {
-        //std::cout << "Area: " << region.area << std::endl;
-        //std::cout << "Label: " << (int)region.label << std::endl;
+        CHECK(region.label == 1);
+        CHECK(region.area > 0);
+        area += region.area;
     }
-}
\ No newline at end of file
+    // Compare with the nr of foreground pixels
+    auto segmentationImage = segmentation->updateAndGetOutputData<Image>();
+    auto segmentationAccess = segmentationImage->getImageAccess(ACCESS_READ);
+    auto pixels = (uchar*)segmentationAccess->get();
+    std::size_t foreground = 0;
+    for(std::size_t i = 0; i < segmentationImage->getNrOfVoxels(); ++i) {
+        if(pixels[i] > 0)
+            ++foreground;
+    }
+    CHECK(area == foreground);
+}
+
+static void fillBox(Image::pointer image, Vector3i start, Vector3i size, uchar label) {
+    auto access = image->getImageAccess(ACCESS_READ_WRITE);
+    auto data = (uchar*)access->get();
+    for(int z = start.z(); z < start.z() + size.z(); ++z) {
+        for(int y = start.y(); y < start.y() + size.y(); ++y) {
+            for(int x = start.x(); x < start.x() + size.x(); ++x) {
+                data[x + (y + (std::size_t)z*image->getHeight())*image->getWidth()] = label;
+            }
+        }
+    }
+}
+
+static std::vector<Region> getRegions(Image::pointer image, bool fullConnectivity, ExecutionDevice::pointer device, uint threads = 0) {
+    auto regionProperties = RegionProperties::New();
+    regionProperties->setInputData(image);
+    regionProperties->setFullConnectivity(fullConnectivity);
+    regionProperties->setNumberOfThreads(threads);
+    regionProperties->setMainDevice(device);
+    auto regionList = regionProperties->updateAndGetOutputData<RegionList>();
+    return regionList->getAccess(ACCESS_READ)->getData();
+}
+
+TEST_CASE("Region properties labels 2D components with 4 and 8 connectivity", "[regionproperties][fast]") {
+    auto image = Image::New();
+    image->create(64, 48, TYPE_UINT8, 1);
+    image->fill(0);
+    // Two squares which only touch diagonally, and a square with another label
+    fillBox(image, Vector3i(2, 3, 0), Vector3i(10, 10, 1), 1);
+    fillBox(image, Vector3i(12, 13, 0), Vector3i(5, 5, 1), 1);
+    fillBox(image, Vector3i(30, 30, 0), Vector3i(4, 4, 1), 2);
+
+    auto regions = getRegions(image, true, Host::getInstance());
+    REQUIRE(regions.size() == 2);
+    CHECK(regions[0].label == 1);
+    CHECK(regions[0].area == 125);
+    CHECK(regions[0].minimum == Vector3i(2, 3, 0));
+    CHECK(regions[0].maximum == Vector3i(16, 17, 0));
+    CHECK(regions[1].label == 2);
+    CHECK(regions[1].area == 16);
+    CHECK(regions[1].centroid.x() == Approx(31.5f));
+    CHECK(regions[1].centroid.y() == Approx(31.5f));
+    CHECK(regions[1].pixels.empty());
+
+    regions = getRegions(image, false, Host::getInstance());
+    REQUIRE(regions.size() == 3);
+    CHECK(regions[0].area == 100);
+    CHECK(regions[0].centroid.x() == Approx(6.5f));
+    CHECK(regions[0].centroid.y() == Approx(7.5f));
+    CHECK(regions[1].area == 25);
+    CHECK(regions[1].minimum == Vector3i(12, 13, 0));
+    CHECK(regions[2].area == 16);
+}
+
+TEST_CASE("Region properties labels 3D components with several threads", "[regionproperties][fast]") {
+    auto image = Image::New();
+    image->create(32, 32, 128, TYPE_UINT8, 1);
+    image->fill(0);
+    // A U shaped component crossing all strips twice, and a small box
+    fillBox(image, Vector3i(2, 2, 0), Vector3i(3, 3, 120), 1);
+    fillBox(image, Vector3i(20, 20, 0), Vector3i(3, 3, 120), 1);
+    fillBox(image, Vector3i(2, 2, 120), Vector3i(21, 21, 2), 1);
+    fillBox(image, Vector3i(10, 10, 10), Vector3i(2, 2, 2), 3);
+
+    for(uint threads : {1, 4, 7}) {
+        auto regions = getRegions(image, false, Host::getInstance(), threads);
+        REQUIRE(regions.size() == 2);
+        CHECK(regions[0].label == 1);
+        CHECK(regions[0].area == 2*9*120 + 21*21*2);
+        CHECK(regions[0].minimum == Vector3i(2, 2, 0));
+        CHECK(regions[0].maximum == Vector3i(22, 22, 121));
+        CHECK(regions[1].label == 3);
+        CHECK(regions[1].area == 8);
+        CHECK(regions[1].centroid.z() == Approx(10.5f));
+    }
+}
+
+TEST_CASE("Region properties on OpenCL device gives same regions as on host", "[regionproperties][fast]") {
+    auto image = Image::New();
+    image->create(64, 64, 64, TYPE_UINT8, 1);
+    image->fill(0);
+    fillBox(image, Vector3i(2, 2, 2), Vector3i(10, 10, 10), 1);
+    fillBox(image, Vector3i(12, 12, 12), Vector3i(10, 10, 10), 1);
+    fillBox(image, Vector3i(40, 2, 2), Vector3i(20, 50, 3), 2);
+    fillBox(image, Vector3i(40, 2, 5), Vector3i(3, 3, 50), 2);
+
+    for(bool fullConnectivity : {false, true}) {
+        auto hostRegions = getRegions(image, fullConnectivity, Host::getInstance());
+        auto deviceRegions = getRegions(image, fullConnectivity, DeviceManager::getInstance()->getOneOpenCLDevice());
+        REQUIRE(hostRegions.size() == (fullConnectivity ? 2 : 3));
+        REQUIRE(hostRegions.size() == deviceRegions.size());
+        for(int i = 0; i < hostRegions.size(); ++i) {
+            CHECK(hostRegions[i].label == deviceRegions[i].label);
+            CHECK(hostRegions[i].area == deviceRegions[i].area);
+            CHECK(hostRegions[i].minimum == deviceRegions[i].minimum);
+            CHECK(hostRegions[i].maximum == deviceRegions[i].maximum);
+        }
+    }
+}
@@ -0,0 +1,134 @@
+__constant sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_FILTER_NEAREST | CLK_ADDRESS_CLAMP_TO_EDGE;
+
+#ifdef TYPE_FLOAT
+#define READ_IMAGE(image, pos) read_imagef(image, sampler, pos).x
+#elif TYPE_INT
+#define READ_IMAGE(image, pos) (float)read_imagei(image, sampler, pos).x
+#else
+#define READ_IMAGE(image, pos) (float)read_imageui(image, sampler, pos).x
+#endif
+
+#ifdef SEGMENTATION
+#define OUTPUT_TYPE uchar
+#else
+#define OUTPUT_TYPE float
+#endif
+
+inline size_t getIndex(int x, int y, int z, int4 size) {
+    return x + ((size_t)z*size.y + y)*size.x;
+}
+
+/**
+ * One work item per column of voxels along axes.z, which is the axis closest to the normal of the frame.
+ * Only the voxels within the splat radius of the frame are visited.
+ */
+__kernel void reconstructFrame(
+        __read_only image2d_t frame,
+        __global float* accumulation,
+        __global float* weights,
+        __private float4 row0,
+        __private float4 row1,
+        __private float4 row2,
+        __private int4 size,
+        __private int4 boxMinimum,
+        __private int4 boxMaximum,
+        __private int4 axes,
+        __private float radius
+        ) {
+    int voxel[3];
+    const int* minimum = (const int*)&boxMinimum;
+    const int* maximum = (const int*)&boxMaximum;
+    voxel[axes.x] = minimum[axes.x] + get_global_id(0);
+    voxel[axes.y] = minimum[axes.y] + get_global_id(1);
+    const float* plane = (const float*)&row2;
+
+    // Distance to plane is plane[axes.z]*voxel[axes.z] + base
+    const float base = plane[axes.x]*voxel[axes.x] + plane[axes.y]*voxel[axes.y] + row2.w;
+#ifdef PIXEL_NEAREST_NEIGHBOR
+    int columnStart = (int)round(-base / plane[axes.z]);
+    int columnEnd = columnStart;
+#else
+    const float a = (-radius - base) / plane[axes.z];
+    const float b = (radius - base) / plane[axes.z];
+    int columnStart = (int)ceil(min(a, b));
+    int columnEnd = (int)floor(max(a, b));
+#endif
+    columnStart = max(columnStart, minimum[axes.z]);
+    columnEnd = min(columnEnd, maximum[axes.z]);
+
+    const int width = get_image_width(frame);
+    const int height = get_image_height(frame);
+    for(int c = columnStart; c <= columnEnd; ++c) {
+        voxel[axes.z] = c;
+        const float4 position = (float4)(voxel[0], voxel[1], voxel[2], 1.0f);
+        const int x = (int)round(dot(row0, position));
+        const int y = (int)round(dot(row1, position));
+        if(x < 0 || y < 0 || x >= width || y >= height)
+            continue;
+#ifdef PIXEL_NEAREST_NEIGHBOR
+        const float weight = 1.0f;
+#else
+        const float weight = 1.0f - fabs(dot(row2, position)) / radius;
+        if(weight <= 0.0f)
+            continue;
+#endif
+        const float value = READ_IMAGE(frame, (int2)(x, y));
+        const size_t index = getIndex(voxel[0], voxel[1], voxel[2], size);
+#ifdef SEGMENTATION
+        // The closest pixel decides the label
+        if(weight >= weights[index]) {
+            accumulation[index] = value;
+            weights[index] = weight;
+        }
+#else
+        accumulation[index] += weight*value;
+        weights[index] += weight;
+#endif
+    }
+}
+
+/**
+ * Update the output volume from the accumulated values, and fill holes
+ */
+__kernel void normalizeVolume(
+        __global const float* accumulation,
+        __global const float* weights,
+        __global OUTPUT_TYPE* output,
+        __private int4 size
+        ) {
+    const int x = get_global_id(0);
+    const int y = get_global_id(1);
+    const int z = get_global_id(2);
+    const size_t index = getIndex(x, y, z, size);
+
+    float value = 0.0f;
+    if(weights[index] > 0.0f) {
+#ifdef SEGMENTATION
+        value = accumulation[index];
+#else
+        value = accumulation[index] / weights[index];
+#endif
+    } else if(HOLE_FILLING_RADIUS > 0) {
+        float sum = 0.0f;
+        float weightSum = 0.0f;
+        for(int c = max(0, z - HOLE_FILLING_RADIUS); c <= min(size.z - 1, z + HOLE_FILLING_RADIUS); ++c) {
+        for(int b = max(0, y - HOLE_FILLING_RADIUS); b <= min(size.y - 1, y + HOLE_FILLING_RADIUS); ++b) {
+        for(int a = max(0, x - HOLE_FILLING_RADIUS); a <= min(size.x - 1, x + HOLE_FILLING_RADIUS); ++a) {
+            const size_t neighbor = getIndex(a, b, c, size);
+#ifdef SEGMENTATION
+            if(weights[neighbor] > weightSum) {
+                weightSum = weights[neighbor];
+                value = accumulation[neighbor];
+            }
+#else
+            sum += accumulation[neighbor];
+            weightSum += weights[neighbor];
+#endif
+        }}}
+#ifndef SEGMENTATION
+        if(weightSum > 0.0f)
+            value = sum / weightSum;
+#endif
+    }
+    output[index] = (OUTPUT_TYPE)value;
+}
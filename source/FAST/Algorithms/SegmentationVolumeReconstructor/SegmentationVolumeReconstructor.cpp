@@ -1,84 +1,416 @@
-#include <FAST/Algorithms/GaussianSmoothingFilter/GaussianSmoothingFilter.hpp>
 #include "SegmentationVolumeReconstructor.hpp"
 #include "FAST/Data/Segmentation.hpp"
+#include "FAST/SceneGraph.hpp"
+#include <thread>
+#include <functional>
+#include <cstring>
+#include <limits>
 
 namespace fast {
 
 SegmentationVolumeReconstructor::SegmentationVolumeReconstructor() {
     createInputPort<Image>(0);
-    createOutputPort<Segmentation>(0);
+    createOutputPort<Image>(0);
+    createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/SegmentationVolumeReconstructor/SegmentationVolumeReconstructor.cl");
 }
 
-void SegmentationVolumeReconstructor::execute() {
-    Image::pointer input = getInputData<Image>();
+void SegmentationVolumeReconstructor::setReconstructionMethod(ReconstructionMethod method) {
+    m_method = method;
+    mIsModified = true;
+}
 
-    auto T_I = SceneGraph::getEigenAffineTransformationFromData(input);
-    if(!m_volume) {
-        // Initialize volume
+void SegmentationVolumeReconstructor::setVoxelSpacing(float spacing) {
+    if(spacing <= 0)
+        throw Exception("Voxel spacing must be larger than 0");
+    m_voxelSpacing = spacing;
+    mIsModified = true;
+}
+
+void SegmentationVolumeReconstructor::setSplatRadius(float radius) {
+    if(radius <= 0)
+        throw Exception("Splat radius must be larger than 0");
+    m_splatRadius = radius;
+    mIsModified = true;
+}
+
+void SegmentationVolumeReconstructor::setHoleFillingRadius(int radius) {
+    if(radius < 0)
+        throw Exception("Hole filling radius can't be negative");
+    m_holeFillingRadius = radius;
+    mIsModified = true;
+}
+
+void SegmentationVolumeReconstructor::setMaximumVolumeSize(int size) {
+    if(size <= 0)
+        throw Exception("Maximum volume size must be larger than 0");
+    m_maximumVolumeSize = size;
+    mIsModified = true;
+}
+
+void SegmentationVolumeReconstructor::setNumberOfThreads(uint threads) {
+    m_threads = threads;
+    mIsModified = true;
+}
+
+void SegmentationVolumeReconstructor::reset() {
+    m_volume.reset();
+    m_accumulation.reset();
+    m_weights.reset();
+    mIsModified = true;
+}
+
+float SegmentationVolumeReconstructor::getSplatRadius() const {
+    if(m_method == ReconstructionMethod::PIXEL_NEAREST_NEIGHBOR)
+        return m_voxelSpacing*0.5f;
+    return m_splatRadius > 0 ? m_splatRadius : m_voxelSpacing*2.0f;
+}
+
+// Run function for each value in the range from start to end (exclusive), split into strips on several threads
+static void parallelFor(int start, int end, uint threads, std::function<void(int, int)> function) {
+    if(threads == 0)
+        threads = std::thread::hardware_concurrency();
+    threads = std::max(1u, std::min(threads, (uint)std::max(0, end - start)));
+    std::vector<std::thread> workers;
+    for(uint i = 0; i < threads; ++i) {
+        const int stripStart = start + (int)((std::size_t)(end - start)*i/threads);
+        const int stripEnd = start + (int)((std::size_t)(end - start)*(i+1)/threads);
+        workers.emplace_back(function, stripStart, stripEnd);
+    }
+    for(auto&& worker : workers)
+        worker.join();
+}
+
+void SegmentationVolumeReconstructor::createVolume(Vector3i size, DataType outputType) {
+    if(m_isSegmentation) {
         m_volume = Segmentation::New();
-        m_volume->create(512, 512, 512, TYPE_UINT8, 1);
-        m_volume->fill(0);
-        // TODO calculate transformation
-
-        float spacingX = input->getSpacing().x();
-        m_volume->setSpacing(Vector3f(spacingX, spacingX, spacingX));
-
-        // Create transformation
-        auto T_C = Affine3f::Identity();
-        T_C.translation() = -m_volume->getSize().cast<float>()/2.0f*m_volume->getSpacing().x();
-        //auto T_T = Affine3f::Identity();
-        //T_T.translation() = Vector3f(input->getWidth(), input->getHeight(), 0)/2.0f*input->getSpacing().x();
-        auto transform = T_I*T_C;
-        m_volume->getSceneGraphNode()->getTransformation()->setTransform(transform);
+    } else {
+        m_volume = Image::New();
     }
+    m_volume->create(size.x(), size.y(), size.z(), outputType, 1);
+    m_volume->fill(0);
+    m_volume->setSpacing(Vector3f(m_voxelSpacing, m_voxelSpacing, m_voxelSpacing));
+    m_accumulation = Image::New();
+    m_accumulation->create(size.x(), size.y(), size.z(), TYPE_FLOAT, 1);
+    m_accumulation->fill(0);
+    m_weights = Image::New();
+    m_weights->create(size.x(), size.y(), size.z(), TYPE_FLOAT, 1);
+    m_weights->fill(0);
+}
 
-    // Add input to m_volume
-    // Calculate transform form current image to the volume
-    auto T_V = SceneGraph::getEigenAffineTransformationFromData(m_volume);
+bool SegmentationVolumeReconstructor::growVolume(Vector3f boxMinimum, Vector3f boxMaximum) {
+    Vector3i size = Vector3i::Zero();
+    if(m_volume)
+        size = m_volume->getSize().cast<int>();
+    Vector3i lower = boxMinimum.array().floor().cast<int>();
+    Vector3i upper = boxMaximum.array().ceil().cast<int>() + 1;
+    if(m_volume) {
+        if((lower.array() >= 0).all() && (upper.array() <= size.array()).all())
+            return false;
+        lower = lower.cwiseMin(0);
+        upper = upper.cwiseMax(size);
+    }
+    for(int i = 0; i < 3; ++i) {
+        // Grow more than needed, so that the volume is not reallocated for every frame of a sweep
+        const int margin = std::max(16, size[i]/4);
+        if(lower[i] < 0 || !m_volume)
+            lower[i] -= margin;
+        if(upper[i] > size[i] || !m_volume)
+            upper[i] += margin;
+        if(upper[i] - lower[i] <= m_maximumVolumeSize)
+            continue;
+        if(!m_volume) {
+            // Center the first volume on the frame
+            const int center = (int)std::floor((boxMinimum[i] + boxMaximum[i])*0.5f);
+            lower[i] = center - m_maximumVolumeSize/2;
+            upper[i] = lower[i] + m_maximumVolumeSize;
+        } else {
+            // Keep the existing volume, and grow as much as allowed towards the new frame
+            const int available = std::max(0, m_maximumVolumeSize - size[i]);
+            const int requiredLower = -lower[i];
+            const int requiredUpper = upper[i] - size[i];
+            const int growLower = (int)((int64_t)available*requiredLower/std::max(1, requiredLower + requiredUpper));
+            lower[i] = -growLower;
+            upper[i] = size[i] + available - growLower;
+        }
+    }
+    const Vector3i newSize = upper - lower;
+    if(m_volume && newSize == size)
+        return false;
 
-    auto T_C = Affine3f::Identity();
-    T_C.translation() = m_volume->getSize().cast<float>()/2.0f*m_volume->getSpacing().x();
+    auto oldVolume = m_volume;
+    auto oldAccumulation = m_accumulation;
+    auto oldWeights = m_weights;
+    createVolume(newSize, m_isSegmentation ? TYPE_UINT8 : TYPE_FLOAT);
+    m_origin += lower.cast<float>()*m_voxelSpacing;
+    auto transform = AffineTransformation::New();
+    transform->setTransform(m_referenceTransform*Eigen::Translation3f(m_origin));
+    m_volume->getSceneGraphNode()->setTransformation(transform);
+    reportInfo() << "Volume reconstruction size is now " << newSize.transpose() << reportEnd();
+    if(!oldVolume)
+        return true;
 
-    auto imageToVolumeTransform = T_V.inverse()*T_I;
+    // Copy the old volume into the new one
+    const Vector3i offset = -lower;
+    for(auto images : std::vector<std::pair<SharedPointer<Image>, SharedPointer<Image>>>{
+            {oldVolume, m_volume}, {oldAccumulation, m_accumulation}, {oldWeights, m_weights}}) {
+        auto source = images.first->getImageAccess(ACCESS_READ);
+        auto destination = images.second->getImageAccess(ACCESS_READ_WRITE);
+        const std::size_t elementSize = getSizeOfDataType(images.first->getDataType(), 1);
+        const auto sourceData = (const uchar*)source->get();
+        auto destinationData = (uchar*)destination->get();
+        for(int z = 0; z < size.z(); ++z) {
+            for(int y = 0; y < size.y(); ++y) {
+                const std::size_t sourceIndex = ((std::size_t)z*size.y() + y)*size.x();
+                const std::size_t destinationIndex = offset.x() + ((std::size_t)(z + offset.z())*newSize.y() + y + offset.y())*newSize.x();
+                std::memcpy(destinationData + destinationIndex*elementSize, sourceData + sourceIndex*elementSize, size.x()*elementSize);
+            }
+        }
+    }
+    return true;
+}
+
+template <class T>
+static void readFrame(const T* data, std::size_t size, float* frame) {
+    for(std::size_t i = 0; i < size; ++i)
+        frame[i] = (float)data[i];
+}
 
+void SegmentationVolumeReconstructor::reconstructOnHost(Image::pointer input, Affine3f voxelToPixel, Vector3i boxMinimum, Vector3i boxMaximum) {
+    const int width = input->getWidth();
+    const int height = input->getHeight();
+    auto frame = std::make_unique<float[]>((std::size_t)width*height);
     {
-        // TODO transfer these calculations to GPU
-        ImageAccess::pointer access = input->getImageAccess(ACCESS_READ);
-        ImageAccess::pointer accessVolume = m_volume->getImageAccess(ACCESS_READ_WRITE);
-        for(int y = 0; y < input->getHeight(); ++y) {
-            for(int x = 0; x < input->getWidth(); ++x) {
-                //for(int z_offset = -6; z_offset <= 6; ++z_offset) {
-                    if(access->getScalar(Vector2i(x, y)) > 0) {
-                        Vector3f position = (imageToVolumeTransform *
-                                             Vector3f(x * input->getSpacing().x(), y * input->getSpacing().y(), 0));
-                        position.x() /= m_volume->getSpacing().x(); // Go back to pixel coordinates
-                        position.y() /= m_volume->getSpacing().y(); // Go back to pixel coordinates
-                        position.z() /= m_volume->getSpacing().z(); // Go back to pixel coordinates
-                        //std::cout << position.transpose() << std::endl;
-                        try {
-                            //accessVolume->setScalar(position.cast<int>() + Vector3i(0,0,z_offset), access->getScalar(Vector2i(x, y)));
-                            accessVolume->setScalar(position.cast<int>(), access->getScalar(Vector2i(x, y)));
-                        } catch(OutOfBoundsException &e) {
+        auto access = input->getImageAccess(ACCESS_READ);
+        switch(input->getDataType()) {
+            fastSwitchTypeMacro(readFrame<FAST_TYPE>((const FAST_TYPE*)access->get(), (std::size_t)width*height, frame.get()));
+        }
+    }
+    const Vector3i size = m_volume->getSize().cast<int>();
+    auto accumulationAccess = m_accumulation->getImageAccess(ACCESS_READ_WRITE);
+    auto weightsAccess = m_weights->getImageAccess(ACCESS_READ_WRITE);
+    auto accumulation = (float*)accumulationAccess->get();
+    auto weights = (float*)weightsAccess->get();
+
+    // Visit the voxels along the axis which is closest to the normal of the image plane.
+    // For each column of voxels along this axis, only the voxels within the splat radius of the plane are visited.
+    const Eigen::RowVector4f plane = voxelToPixel.matrix().row(2);
+    int axis;
+    plane.head(3).cwiseAbs().maxCoeff(&axis);
+    const int u = (axis + 1) % 3;
+    const int v = (axis + 2) % 3;
+    const float radius = getSplatRadius();
+    const bool nearestNeighbor = m_method == ReconstructionMethod::PIXEL_NEAREST_NEIGHBOR;
+
+    parallelFor(boxMinimum[v], boxMaximum[v] + 1, m_threads, [&](int start, int end) {
+        Vector3i voxel;
+        for(voxel[v] = start; voxel[v] < end; ++voxel[v]) {
+            for(voxel[u] = boxMinimum[u]; voxel[u] <= boxMaximum[u]; ++voxel[u]) {
+                // Distance to plane is plane(axis)*voxel[axis] + base
+                const float base = plane(u)*voxel[u] + plane(v)*voxel[v] + plane(3);
+                int columnStart, columnEnd;
+                if(nearestNeighbor) {
+                    columnStart = columnEnd = (int)std::round(-base / plane(axis));
+                } else {
+                    const float a = (-radius - base) / plane(axis);
+                    const float b = (radius - base) / plane(axis);
+                    columnStart = (int)std::ceil(std::min(a, b));
+                    columnEnd = (int)std::floor(std::max(a, b));
+                }
+                columnStart = std::max(columnStart, boxMinimum[axis]);
+                columnEnd = std::min(columnEnd, boxMaximum[axis]);
+                for(voxel[axis] = columnStart; voxel[axis] <= columnEnd; ++voxel[axis]) {
+                    const Vector3f position = voxelToPixel*voxel.cast<float>();
+                    const int x = (int)std::round(position.x());
+                    const int y = (int)std::round(position.y());
+                    if(x < 0 || y < 0 || x >= width || y >= height)
+                        continue;
+                    const float weight = nearestNeighbor ? 1.0f : 1.0f - std::fabs(position.z()) / radius;
+                    if(weight <= 0.0f)
+                        continue;
+                    const float value = frame[x + (std::size_t)y*width];
+                    const std::size_t index = voxel.x() + ((std::size_t)voxel.z()*size.y() + voxel.y())*size.x();
+                    if(m_isSegmentation) {
+                        // The closest pixel decides the label
+                        if(weight >= weights[index]) {
+                            accumulation[index] = value;
+                            weights[index] = weight;
+                        }
+                    } else {
+                        accumulation[index] += weight*value;
+                        weights[index] += weight;
+                    }
+                }
+            }
+        }
+    });
 
+    // Update the output volume around the new frame, and fill holes
+    auto outputAccess = m_volume->getImageAccess(ACCESS_READ_WRITE);
+    auto output = outputAccess->get();
+    const int holeRadius = m_holeFillingRadius;
+    const Vector3i lower = (boxMinimum.array() - holeRadius).cwiseMax(0);
+    const Vector3i upper = (boxMaximum.array() + holeRadius).cwiseMin(size.array() - 1);
+    parallelFor(lower.z(), upper.z() + 1, m_threads, [&](int start, int end) {
+        for(int z = start; z < end; ++z) {
+            for(int y = lower.y(); y <= upper.y(); ++y) {
+                for(int x = lower.x(); x <= upper.x(); ++x) {
+                    const std::size_t index = x + ((std::size_t)z*size.y() + y)*size.x();
+                    float value = 0.0f;
+                    if(weights[index] > 0.0f) {
+                        value = m_isSegmentation ? accumulation[index] : accumulation[index] / weights[index];
+                    } else if(holeRadius > 0) {
+                        float sum = 0.0f;
+                        float weightSum = 0.0f;
+                        for(int c = std::max(0, z - holeRadius); c <= std::min(size.z() - 1, z + holeRadius); ++c) {
+                            for(int b = std::max(0, y - holeRadius); b <= std::min(size.y() - 1, y + holeRadius); ++b) {
+                                for(int a = std::max(0, x - holeRadius); a <= std::min(size.x() - 1, x + holeRadius); ++a) {
+                                    const std::size_t neighbor = a + ((std::size_t)c*size.y() + b)*size.x();
+                                    if(m_isSegmentation) {
+                                        if(weights[neighbor] > weightSum) {
+                                            weightSum = weights[neighbor];
+                                            value = accumulation[neighbor];
+                                        }
+                                    } else {
+                                        sum += accumulation[neighbor];
+                                        weightSum += weights[neighbor];
+                                    }
+                                }
+                            }
                         }
+                        if(!m_isSegmentation && weightSum > 0.0f)
+                            value = sum / weightSum;
                     }
-                //}
+                    if(m_isSegmentation) {
+                        ((uchar*)output)[index] = (uchar)value;
+                    } else {
+                        ((float*)output)[index] = value;
+                    }
+                }
             }
         }
+    });
+}
+
+void SegmentationVolumeReconstructor::reconstructOnDevice(Image::pointer input, Affine3f voxelToPixel, Vector3i boxMinimum, Vector3i boxMaximum) {
+    auto device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
+    std::string buildOptions = "-DHOLE_FILLING_RADIUS=" + std::to_string(m_holeFillingRadius);
+    if(input->getDataType() == TYPE_FLOAT || input->getDataType() == TYPE_UNORM_INT16 || input->getDataType() == TYPE_SNORM_INT16) {
+        buildOptions += " -DTYPE_FLOAT";
+    } else if(input->getDataType() == TYPE_INT8 || input->getDataType() == TYPE_INT16) {
+        buildOptions += " -DTYPE_INT";
+    } else {
+        buildOptions += " -DTYPE_UINT";
+    }
+    if(m_isSegmentation)
+        buildOptions += " -DSEGMENTATION";
+    if(m_method == ReconstructionMethod::PIXEL_NEAREST_NEIGHBOR)
+        buildOptions += " -DPIXEL_NEAREST_NEIGHBOR";
+    cl::Program program = getOpenCLProgram(device, "", buildOptions);
+    cl::Kernel reconstructKernel(program, "reconstructFrame");
+    cl::Kernel normalizeKernel(program, "normalizeVolume");
+
+    const Vector3i size = m_volume->getSize().cast<int>();
+    const Eigen::Matrix4f matrix = voxelToPixel.matrix();
+    int axis;
+    matrix.row(2).head(3).cwiseAbs().maxCoeff(&axis);
+    const int u = (axis + 1) % 3;
+    const int v = (axis + 2) % 3;
+
+    auto inputAccess = input->getOpenCLImageAccess(ACCESS_READ, device);
+    auto accumulationAccess = m_accumulation->getOpenCLBufferAccess(ACCESS_READ_WRITE, device);
+    auto weightsAccess = m_weights->getOpenCLBufferAccess(ACCESS_READ_WRITE, device);
+    auto outputAccess = m_volume->getOpenCLBufferAccess(ACCESS_READ_WRITE, device);
+
+    reconstructKernel.setArg(0, *inputAccess->get2DImage());
+    reconstructKernel.setArg(1, *accumulationAccess->get());
+    reconstructKernel.setArg(2, *weightsAccess->get());
+    for(int row = 0; row < 3; ++row)
+        reconstructKernel.setArg(3 + row, cl_float4{matrix(row, 0), matrix(row, 1), matrix(row, 2), matrix(row, 3)});
+    reconstructKernel.setArg(6, cl_int4{size.x(), size.y(), size.z(), 0});
+    reconstructKernel.setArg(7, cl_int4{boxMinimum.x(), boxMinimum.y(), boxMinimum.z(), 0});
+    reconstructKernel.setArg(8, cl_int4{boxMaximum.x(), boxMaximum.y(), boxMaximum.z(), 0});
+    reconstructKernel.setArg(9, cl_int4{u, v, axis, 0});
+    reconstructKernel.setArg(10, getSplatRadius());
+
+    auto queue = device->getCommandQueue();
+    queue.enqueueNDRangeKernel(
+            reconstructKernel,
+            cl::NullRange,
+            cl::NDRange(boxMaximum[u] - boxMinimum[u] + 1, boxMaximum[v] - boxMinimum[v] + 1),
+            cl::NullRange
+    );
+
+    const Vector3i lower = (boxMinimum.array() - m_holeFillingRadius).cwiseMax(0);
+    const Vector3i upper = (boxMaximum.array() + m_holeFillingRadius).cwiseMin(size.array() - 1);
+    normalizeKernel.setArg(0, *accumulationAccess->get());
+    normalizeKernel.setArg(1, *weightsAccess->get());
+    normalizeKernel.setArg(2, *outputAccess->get());
+    normalizeKernel.setArg(3, cl_int4{size.x(), size.y(), size.z(), 0});
+    queue.enqueueNDRangeKernel(
+            normalizeKernel,
+            cl::NDRange(lower.x(), lower.y(), lower.z()),
+            cl::NDRange(upper.x() - lower.x() + 1, upper.y() - lower.y() + 1, upper.z() - lower.z() + 1),
+            cl::NullRange
+    );
+}
+
+void SegmentationVolumeReconstructor::execute() {
+    Image::pointer input = getInputData<Image>();
+    if(input->getDimensions() != 2)
+        throw Exception("Input to SegmentationVolumeReconstructor must be 2D images");
+    if(input->getNrOfChannels() != 1)
+        throw Exception("Input to SegmentationVolumeReconstructor must have a single channel");
+
+    const Affine3f T_I = SceneGraph::getEigenAffineTransformationFromData(input);
+    if(!m_volume) {
+        m_isSegmentation = std::dynamic_pointer_cast<Segmentation>(input) != nullptr;
+        if(m_voxelSpacing <= 0)
+            m_voxelSpacing = std::min(input->getSpacing().x(), input->getSpacing().y());
+        m_referenceTransform = T_I;
+        m_origin = Vector3f::Zero();
+    }
+
+    // Transform from voxel to pixel coordinates of the input frame. The z coordinate is the distance to the plane in mm.
+    auto getVoxelToPixel = [&]() {
+        Affine3f voxelToPixel = Eigen::Scaling(Vector3f(1.0f / input->getSpacing().x(), 1.0f / input->getSpacing().y(), 1.0f)) *
+                T_I.inverse() * m_referenceTransform * Eigen::Translation3f(m_origin) * Eigen::Scaling(m_voxelSpacing);
+        return voxelToPixel;
+    };
+
+    // Find the bounding box of the frame, including the splat radius, in voxel coordinates
+    auto getBoundingBox = [&](Vector3f& minimum, Vector3f& maximum) {
+        const Affine3f pixelToVoxel = getVoxelToPixel().inverse();
+        const float radius = getSplatRadius();
+        minimum = Vector3f::Constant(std::numeric_limits<float>::max());
+        maximum = Vector3f::Constant(std::numeric_limits<float>::lowest());
+        for(float x : {-0.5f, input->getWidth() - 0.5f}) {
+            for(float y : {-0.5f, input->getHeight() - 0.5f}) {
+                for(float z : {-radius, radius}) {
+                    const Vector3f corner = pixelToVoxel*Vector3f(x, y, z);
+                    minimum = minimum.cwiseMin(corner);
+                    maximum = maximum.cwiseMax(corner);
+                }
+            }
+        }
+    };
+
+    Vector3f minimum, maximum;
+    getBoundingBox(minimum, maximum);
+    if(growVolume(minimum, maximum))
+        getBoundingBox(minimum, maximum); // Origin may have changed
+
+    const Vector3i size = m_volume->getSize().cast<int>();
+    const Vector3i boxMinimum = minimum.array().floor().cast<int>().cwiseMax(0);
+    const Vector3i boxMaximum = maximum.array().ceil().cast<int>().cwiseMin(size.array() - 1);
+    if((boxMinimum.array() <= boxMaximum.array()).all()) {
+        if(getMainDevice()->isHost()) {
+            reconstructOnHost(input, getVoxelToPixel(), boxMinimum, boxMaximum);
+        } else {
+            reconstructOnDevice(input, getVoxelToPixel(), boxMinimum, boxMaximum);
+        }
     }
 
     addOutputData(0, m_volume);
-    /*
-    GaussianSmoothingFilter::pointer smoother = GaussianSmoothingFilter::New();
-    smoother->setInputData(m_volume);
-    smoother->setStandardDeviation(1);
-    //smoother->setMaskSize(3);
-    //smoother->setOutputType(TYPE_FLOAT);
-    auto port = smoother->getOutputPort();
-    smoother->update( STREAMING_MODE_NEWEST_FRAME_ONLY);
-
-    addOutputData(0, port->getNextFrame());
-     */
 }
 
 }
@@ -4,16 +4,94 @@
 
 namespace fast {
 
-class Segmentation;
+class Image;
 
+/**
+ * Freehand 3D reconstruction of a stream of tracked 2D images, such as ultrasound, into a volume.
+ * Works on both intensity images and segmentations. Intensities are compounded with a weighted average,
+ * while each voxel of a segmentation gets the label of the closest pixel.
+ *
+ * The reconstruction is voxel driven: For each frame, only the voxels within the splat radius of the image plane
+ * are visited, and each voxel is updated by one thread. This runs on the main device, which can be
+ * an OpenCL device or the host.
+ *
+ * The volume is oriented as the first frame, and grows as frames outside it arrive.
+ * Each output frame is the same volume, updated with the new input frame.
+ */
 class FAST_EXPORT SegmentationVolumeReconstructor : public ProcessObject {
     FAST_OBJECT(SegmentationVolumeReconstructor)
     public:
+        enum class ReconstructionMethod {
+            // Each pixel is put in the voxel closest to it
+            PIXEL_NEAREST_NEIGHBOR,
+            // Each pixel is splatted into all voxels within the splat radius, weighted by distance to the image plane
+            DISTANCE_WEIGHTED,
+        };
+        void setReconstructionMethod(ReconstructionMethod method);
+        /**
+         * Set spacing of the volume in millimeters. Default is the smallest pixel spacing of the first frame.
+         * @param spacing
+         */
+        void setVoxelSpacing(float spacing);
+        /**
+         * Set distance in millimeters from the image plane a pixel is splatted when using
+         * ReconstructionMethod::DISTANCE_WEIGHTED. Default is 2 voxels.
+         * @param radius
+         */
+        void setSplatRadius(float radius);
+        /**
+         * Voxels which have not been hit by any pixel are filled from neighbors within this nr of voxels.
+         * Default is 1, 0 disables hole filling.
+         * @param radius
+         */
+        void setHoleFillingRadius(int radius);
+        /**
+         * Set the maximum size of the volume in each dimension in voxels. Pixels which would make
+         * the volume larger are skipped. Default is 1024.
+         * @param size
+         */
+        void setMaximumVolumeSize(int size);
+        /**
+         * Set nr of threads to use when reconstructing on the host. Default is 0, which uses all hardware threads.
+         * @param threads
+         */
+        void setNumberOfThreads(uint threads);
+        /**
+         * Start a new volume with the next frame
+         */
+        void reset();
     private:
         SegmentationVolumeReconstructor();
         void execute() override;
+        /**
+         * Make sure the volume contains the given box, which is in voxel coordinates of the current volume.
+         * The volume is never larger than the maximum size, thus it may not contain the entire box.
+         * @return true if the volume was reallocated, which changes the origin
+         */
+        bool growVolume(Vector3f boxMinimum, Vector3f boxMaximum);
+        void createVolume(Vector3i size, DataType outputType);
+        void reconstructOnHost(SharedPointer<Image> frame, Affine3f voxelToPixel, Vector3i boxMinimum, Vector3i boxMaximum);
+        void reconstructOnDevice(SharedPointer<Image> frame, Affine3f voxelToPixel, Vector3i boxMinimum, Vector3i boxMaximum);
+        float getSplatRadius() const;
 
-        SharedPointer<Segmentation> m_volume;
+        ReconstructionMethod m_method = ReconstructionMethod::DISTANCE_WEIGHTED;
+        float m_voxelSpacing = -1;
+        float m_splatRadius = -1;
+        int m_holeFillingRadius = 1;
+        int m_maximumVolumeSize = 1024;
+        uint m_threads = 0;
+        bool m_isSegmentation;
+
+        // Output volume
+        SharedPointer<Image> m_volume;
+        // Weighted sum of intensities, or the label for segmentations
+        SharedPointer<Image> m_accumulation;
+        // Sum of weights, or the weight of the current label for segmentations
+        SharedPointer<Image> m_weights;
+        // Transform of the first frame, which the volume is aligned to
+        Affine3f m_referenceTransform;
+        // Position of voxel 0 in millimeters in the coordinate system of the first frame
+        Vector3f m_origin;
 };
 
-}
\ No newline at end of file
+}
@@ -6,6 +6,9 @@
 #include <FAST/Testing.hpp>
 #include <FAST/Algorithms/SegmentationVolumeReconstructor/SegmentationVolumeReconstructor.hpp>
 #include <FAST/Visualization/ImageRenderer/ImageRenderer.hpp>
+#include <FAST/Data/Segmentation.hpp>
+#include <FAST/Data/Image.hpp>
+#include <FAST/SceneGraph.hpp>
 
 using namespace fast;
 
@@ -43,3 +46,79 @@ TEST_CASE("Segmentation volume reconstructor", "[SegmentationVolumeReconstructor
     window->setTimeout(1000);
     window->start();
 }
+
+// Create a sweep of frames translated 0.5 mm in the z direction, where the intensity of each pixel is its x coordinate
+static std::vector<Image::pointer> createSweep(bool segmentation) {
+    std::vector<Image::pointer> frames;
+    for(int i = 0; i < 20; ++i) {
+        Image::pointer frame;
+        if(segmentation) {
+            frame = Segmentation::New();
+            frame->create(64, 48, TYPE_UINT8, 1);
+        } else {
+            frame = Image::New();
+            frame->create(64, 48, TYPE_FLOAT, 1);
+        }
+        frame->setSpacing(Vector3f(0.5f, 0.5f, 1.0f));
+        {
+            auto access = frame->getImageAccess(ACCESS_READ_WRITE);
+            for(int y = 0; y < 48; ++y) {
+                for(int x = 0; x < 64; ++x) {
+                    access->setScalar(Vector2i(x, y), segmentation ? (x < 32 ? 1 : 2) : x);
+                }
+            }
+        }
+        auto transform = AffineTransformation::New();
+        Affine3f affine = Affine3f::Identity();
+        affine.translation() = Vector3f(0, 0, i*0.5f);
+        transform->setTransform(affine);
+        frame->getSceneGraphNode()->setTransformation(transform);
+        frames.push_back(frame);
+    }
+    return frames;
+}
+
+static float getVolumeValue(Image::pointer volume, Vector3f position) {
+    Affine3f T_V = SceneGraph::getEigenAffineTransformationFromData(volume);
+    Vector3i voxel = ((T_V.inverse()*position) / volume->getSpacing().x()).array().round().cast<int>();
+    return volume->getImageAccess(ACCESS_READ)->getScalar(voxel);
+}
+
+TEST_CASE("Volume reconstruction of intensity sweep on host and OpenCL device", "[SegmentationVolumeReconstructor][fast]") {
+    for(auto device : {(ExecutionDevice::pointer)Host::getInstance(), (ExecutionDevice::pointer)DeviceManager::getInstance()->getOneOpenCLDevice()}) {
+        for(auto method : {SegmentationVolumeReconstructor::ReconstructionMethod::PIXEL_NEAREST_NEIGHBOR,
+                           SegmentationVolumeReconstructor::ReconstructionMethod::DISTANCE_WEIGHTED}) {
+            auto reconstructor = SegmentationVolumeReconstructor::New();
+            reconstructor->setMainDevice(device);
+            reconstructor->setReconstructionMethod(method);
+            Image::pointer volume;
+            for(auto frame : createSweep(false)) {
+                reconstructor->setInputData(frame);
+                volume = reconstructor->updateAndGetOutputData<Image>();
+            }
+            CHECK(volume->getDataType() == TYPE_FLOAT);
+            CHECK(volume->getSpacing().x() == Approx(0.5f));
+            // The volume grows to contain the entire sweep
+            CHECK(volume->getDepth() >= 20);
+            CHECK(getVolumeValue(volume, Vector3f(10*0.5f, 20*0.5f, 5.0f)) == Approx(10.0f).margin(0.5f));
+            CHECK(getVolumeValue(volume, Vector3f(40*0.5f, 10*0.5f, 2.0f)) == Approx(40.0f).margin(0.5f));
+            // Outside the sweep
+            CHECK(getVolumeValue(volume, Vector3f(10*0.5f, 20*0.5f, 9.5f + 3.0f)) == 0.0f);
+        }
+    }
+}
+
+TEST_CASE("Volume reconstruction of segmentation sweep", "[SegmentationVolumeReconstructor][fast]") {
+    auto reconstructor = SegmentationVolumeReconstructor::New();
+    reconstructor->setMainDevice(Host::getInstance());
+    reconstructor->setNumberOfThreads(3);
+    Image::pointer volume;
+    for(auto frame : createSweep(true)) {
+        reconstructor->setInputData(frame);
+        volume = reconstructor->updateAndGetOutputData<Image>();
+    }
+    CHECK(std::dynamic_pointer_cast<Segmentation>(volume) != nullptr);
+    CHECK(volume->getDataType() == TYPE_UINT8);
+    CHECK(getVolumeValue(volume, Vector3f(10*0.5f, 20*0.5f, 5.0f)) == 1.0f);
+    CHECK(getVolumeValue(volume, Vector3f(50*0.5f, 20*0.5f, 5.0f)) == 2.0f);
+}
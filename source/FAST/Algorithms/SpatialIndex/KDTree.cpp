@@ -0,0 +1,165 @@
+#include "KDTree.hpp"
+#include "FAST/Exception.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace fast {
+
+KDTree::KDTree() {
+    mDimensions = 0;
+}
+
+KDTree::KDTree(const MatrixXf& points, int maxLeafSize) {
+    build(points, maxLeafSize);
+}
+
+void KDTree::build(const MatrixXf& points, int maxLeafSize) {
+    if(maxLeafSize < 1)
+        throw Exception("Max leaf size of k-d tree must be at least 1");
+    mDimensions = points.rows();
+    const int size = points.cols();
+    mIndices.resize(size);
+    std::iota(mIndices.begin(), mIndices.end(), 0);
+    mNodes.clear();
+    // Eigen matrices are column major, thus each point is already contiguous
+    mPoints.assign(points.data(), points.data() + points.size());
+    if(size > 0)
+        buildNode(0, size, maxLeafSize);
+
+    // Store the points in the order of the leaves, so that each leaf is contiguous in memory
+    std::vector<float> sortedPoints(mPoints.size());
+    for(int i = 0; i < size; ++i) {
+        std::copy_n(&mPoints[(std::size_t)mIndices[i]*mDimensions], mDimensions, &sortedPoints[(std::size_t)i*mDimensions]);
+    }
+    mPoints = std::move(sortedPoints);
+}
+
+int KDTree::buildNode(int begin, int end, int maxLeafSize) {
+    // Nodes may be reallocated by the recursion, thus refer to them by index only
+    const int nodeIndex = mNodes.size();
+    mNodes.push_back({-1, 0.0f, begin, end, -1});
+    if(end - begin <= maxLeafSize)
+        return nodeIndex;
+
+    // Split along the dimension with the largest spread
+    int splitDimension = -1;
+    float largestSpread = 0.0f;
+    for(int d = 0; d < mDimensions; ++d) {
+        float minimum = std::numeric_limits<float>::max();
+        float maximum = std::numeric_limits<float>::lowest();
+        for(int i = begin; i < end; ++i) {
+            const float value = mPoints[(std::size_t)mIndices[i]*mDimensions + d];
+            minimum = std::min(minimum, value);
+            maximum = std::max(maximum, value);
+        }
+        if(maximum - minimum > largestSpread) {
+            largestSpread = maximum - minimum;
+            splitDimension = d;
+        }
+    }
+    // All points are equal
+    if(splitDimension == -1)
+        return nodeIndex;
+
+    const int middle = begin + (end - begin) / 2;
+    std::nth_element(mIndices.begin() + begin, mIndices.begin() + middle, mIndices.begin() + end, [this, splitDimension](int a, int b) {
+        return mPoints[(std::size_t)a*mDimensions + splitDimension] < mPoints[(std::size_t)b*mDimensions + splitDimension];
+    });
+    const float splitValue = mPoints[(std::size_t)mIndices[middle]*mDimensions + splitDimension];
+
+    buildNode(begin, middle, maxLeafSize);
+    const int upper = buildNode(middle, end, maxLeafSize);
+    mNodes[nodeIndex].splitDimension = splitDimension;
+    mNodes[nodeIndex].splitValue = splitValue;
+    mNodes[nodeIndex].upper = upper;
+
+    return nodeIndex;
+}
+
+float KDTree::getSquaredDistance(const float* query, int point) const {
+    const float* coordinates = &mPoints[(std::size_t)point*mDimensions];
+    float distance = 0.0f;
+    for(int d = 0; d < mDimensions; ++d) {
+        const float difference = coordinates[d] - query[d];
+        distance += difference*difference;
+    }
+    return distance;
+}
+
+void KDTree::findNearest(int nodeIndex, const float* query, int& nearest, float& nearestDistance, float epsilonFactor) const {
+    const Node& node = mNodes[nodeIndex];
+    if(node.splitDimension < 0) {
+        for(int i = node.begin; i < node.end; ++i) {
+            const float distance = getSquaredDistance(query, i);
+            if(distance < nearestDistance) {
+                nearestDistance = distance;
+                nearest = i;
+            }
+        }
+        return;
+    }
+
+    // Search the side of the split the query is on first
+    const float difference = query[node.splitDimension] - node.splitValue;
+    const int lower = nodeIndex + 1;
+    findNearest(difference < 0 ? lower : node.upper, query, nearest, nearestDistance, epsilonFactor);
+    // The other side can only contain a closer point if the split plane is closer than the nearest point found
+    if(difference*difference < nearestDistance*epsilonFactor)
+        findNearest(difference < 0 ? node.upper : lower, query, nearest, nearestDistance, epsilonFactor);
+}
+
+int KDTree::findNearest(const VectorXf& query, float* distance, float maxDistance, float epsilon) const {
+    if(query.size() != mDimensions)
+        throw Exception("Query point must have the same nr of dimensions as the k-d tree");
+    if(epsilon < 0)
+        throw Exception("Epsilon for approximate nearest neighbor search can't be negative");
+
+    int nearest = -1;
+    float nearestDistance = maxDistance < std::numeric_limits<float>::max() ? maxDistance*maxDistance : std::numeric_limits<float>::infinity();
+    if(!mNodes.empty())
+        findNearest(0, query.data(), nearest, nearestDistance, 1.0f / ((1.0f + epsilon)*(1.0f + epsilon)));
+    if(nearest == -1)
+        return -1;
+
+    if(distance != nullptr)
+        *distance = std::sqrt(nearestDistance);
+    return mIndices[nearest];
+}
+
+void KDTree::findWithinRadius(int nodeIndex, const float* query, float squaredRadius, std::vector<int>& result) const {
+    const Node& node = mNodes[nodeIndex];
+    if(node.splitDimension < 0) {
+        for(int i = node.begin; i < node.end; ++i) {
+            if(getSquaredDistance(query, i) <= squaredRadius)
+                result.push_back(mIndices[i]);
+        }
+        return;
+    }
+
+    const float difference = query[node.splitDimension] - node.splitValue;
+    if(difference <= 0 || difference*difference <= squaredRadius)
+        findWithinRadius(nodeIndex + 1, query, squaredRadius, result);
+    if(difference >= 0 || difference*difference <= squaredRadius)
+        findWithinRadius(node.upper, query, squaredRadius, result);
+}
+
+std::vector<int> KDTree::findWithinRadius(const VectorXf& query, float radius) const {
+    if(query.size() != mDimensions)
+        throw Exception("Query point must have the same nr of dimensions as the k-d tree");
+
+    std::vector<int> result;
+    if(!mNodes.empty())
+        findWithinRadius(0, query.data(), radius*radius, result);
+    return result;
+}
+
+int KDTree::getNrOfPoints() const {
+    return mIndices.size();
+}
+
+int KDTree::getNrOfDimensions() const {
+    return mDimensions;
+}
+
+}
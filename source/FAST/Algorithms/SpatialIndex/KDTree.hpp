@@ -0,0 +1,78 @@
+#pragma once
+
+#include "FAST/Data/DataTypes.hpp"
+#include <limits>
+
+namespace fast {
+
+/**
+ * k-d tree for nearest neighbor queries on a static set of points of any dimension.
+ * The tree is built once in O(N log N), after which each query is O(log N) on average.
+ * Queries are const and can be done from several threads at the same time.
+ *
+ * Points with extra features, such as color, can be indexed by adding the features as extra
+ * dimensions, scaled by how much they should count compared to the position.
+ */
+class FAST_EXPORT KDTree {
+    public:
+        /**
+         * Create an empty tree. Use build to add points.
+         */
+        KDTree();
+        /**
+         * Build tree of a set of points
+         * @param points DxN matrix, one point per column
+         * @param maxLeafSize Max nr of points in each leaf of the tree
+         */
+        explicit KDTree(const MatrixXf& points, int maxLeafSize = 8);
+        /**
+         * Build tree of a set of points, replacing any points already in the tree
+         * @param points DxN matrix, one point per column
+         * @param maxLeafSize Max nr of points in each leaf of the tree
+         */
+        void build(const MatrixXf& points, int maxLeafSize = 8);
+        /**
+         * Find the point closest to the query point.
+         *
+         * @param query Point with the same nr of dimensions as the tree
+         * @param distance If not null, the distance to the point found is stored here
+         * @param maxDistance Only points closer than this are considered
+         * @param epsilon Approximate search: The point found is at most (1 + epsilon) times farther
+         *      away than the closest point. 0 gives exact search.
+         * @return index of the closest point, or -1 if there are no points within maxDistance
+         */
+        int findNearest(const VectorXf& query, float* distance = nullptr,
+                float maxDistance = std::numeric_limits<float>::max(), float epsilon = 0.0f) const;
+        /**
+         * Find all points within a radius of the query point.
+         * @param query Point with the same nr of dimensions as the tree
+         * @param radius
+         * @return indices of the points, in no particular order
+         */
+        std::vector<int> findWithinRadius(const VectorXf& query, float radius) const;
+        int getNrOfPoints() const;
+        int getNrOfDimensions() const;
+    private:
+        struct Node {
+            // Leaf nodes have splitDimension -1, and contain the points begin to end in mIndices
+            int splitDimension;
+            float splitValue;
+            int begin;
+            int end;
+            // Child nodes in mNodes, the lower child is always the node after this one
+            int upper;
+        };
+        int buildNode(int begin, int end, int maxLeafSize);
+        float getSquaredDistance(const float* query, int point) const;
+        void findNearest(int node, const float* query, int& nearest, float& nearestDistance, float epsilonFactor) const;
+        void findWithinRadius(int node, const float* query, float squaredRadius, std::vector<int>& result) const;
+
+        int mDimensions;
+        // Coordinates of each point stored contiguously, in the order of mIndices
+        std::vector<float> mPoints;
+        // Original index of each point
+        std::vector<int> mIndices;
+        std::vector<Node> mNodes;
+};
+
+}
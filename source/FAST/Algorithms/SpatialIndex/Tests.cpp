@@ -0,0 +1,95 @@
+#include "KDTree.hpp"
+#include "VoxelHashGrid.hpp"
+#include <FAST/Testing.hpp>
+#include <random>
+#include <algorithm>
+
+using namespace fast;
+
+static int findNearestBruteForce(const MatrixXf& points, const VectorXf& query, float& distance) {
+    int nearest = -1;
+    distance = std::numeric_limits<float>::max();
+    for(int i = 0; i < points.cols(); ++i) {
+        const float pointDistance = (points.col(i) - query).norm();
+        if(pointDistance < distance) {
+            distance = pointDistance;
+            nearest = i;
+        }
+    }
+    return nearest;
+}
+
+static MatrixXf createRandomPoints(int dimensions, int size, std::mt19937& engine) {
+    std::uniform_real_distribution<float> distribution(-50.0f, 50.0f);
+    MatrixXf points(dimensions, size);
+    for(int i = 0; i < size; ++i) {
+        for(int d = 0; d < dimensions; ++d)
+            points(d, i) = distribution(engine);
+    }
+    return points;
+}
+
+TEST_CASE("k-d tree and voxel hash grid find same nearest point as brute force", "[fast][spatialindex]") {
+    std::mt19937 engine(0);
+    for(int dimensions : {3, 6}) {
+        const MatrixXf points = createRandomPoints(dimensions, 2000, engine);
+        KDTree tree(points);
+        VoxelHashGrid grid(points);
+        REQUIRE(tree.getNrOfPoints() == 2000);
+        REQUIRE(grid.getNrOfPoints() == 2000);
+
+        // Queries both inside and far outside the points
+        const MatrixXf queries = createRandomPoints(dimensions, 200, engine)*1.5f;
+        for(int i = 0; i < queries.cols(); ++i) {
+            float expectedDistance;
+            findNearestBruteForce(points, queries.col(i), expectedDistance);
+
+            float distance;
+            REQUIRE(tree.findNearest(queries.col(i), &distance) >= 0);
+            CHECK(distance == Approx(expectedDistance));
+            REQUIRE(grid.findNearest(queries.col(i), &distance) >= 0);
+            CHECK(distance == Approx(expectedDistance));
+
+            // Approximate search
+            REQUIRE(tree.findNearest(queries.col(i), &distance, std::numeric_limits<float>::max(), 0.5f) >= 0);
+            CHECK(distance <= expectedDistance*1.5f + 1e-4f);
+
+            // No points closer than max distance
+            CHECK(tree.findNearest(queries.col(i), nullptr, expectedDistance*0.99f) == -1);
+            CHECK(grid.findNearest(queries.col(i), nullptr, expectedDistance*0.99f) == -1);
+        }
+    }
+}
+
+TEST_CASE("k-d tree and voxel hash grid find points within radius", "[fast][spatialindex]") {
+    std::mt19937 engine(0);
+    const MatrixXf points = createRandomPoints(3, 2000, engine);
+    KDTree tree(points);
+    VoxelHashGrid grid(points, 4.0f);
+    CHECK(grid.getCellSize() == 4.0f);
+
+    const MatrixXf queries = createRandomPoints(3, 50, engine);
+    for(int i = 0; i < queries.cols(); ++i) {
+        std::vector<int> expected;
+        for(int j = 0; j < points.cols(); ++j) {
+            if((points.col(j) - queries.col(i)).norm() <= 10.0f)
+                expected.push_back(j);
+        }
+        auto treeResult = tree.findWithinRadius(queries.col(i), 10.0f);
+        auto gridResult = grid.findWithinRadius(queries.col(i), 10.0f);
+        std::sort(treeResult.begin(), treeResult.end());
+        std::sort(gridResult.begin(), gridResult.end());
+        CHECK(treeResult == expected);
+        CHECK(gridResult == expected);
+    }
+}
+
+TEST_CASE("Spatial index of no points", "[fast][spatialindex]") {
+    KDTree tree(MatrixXf(3, 0));
+    VoxelHashGrid grid(MatrixXf(3, 0));
+    CHECK(tree.findNearest(Vector3f(1, 2, 3)) == -1);
+    CHECK(grid.findNearest(Vector3f(1, 2, 3)) == -1);
+    CHECK(tree.findWithinRadius(Vector3f(1, 2, 3), 10.0f).empty());
+    CHECK(grid.findWithinRadius(Vector3f(1, 2, 3), 10.0f).empty());
+    CHECK_THROWS(tree.findNearest(Vector2f(1, 2)));
+}
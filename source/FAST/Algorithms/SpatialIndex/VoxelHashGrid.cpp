@@ -0,0 +1,242 @@
+#include "VoxelHashGrid.hpp"
+#include "FAST/Exception.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace fast {
+
+// Each cell coordinate is stored with 21 bits in the key
+static const int maxCellCoordinate = 1 << 20;
+
+VoxelHashGrid::VoxelHashGrid() {
+    mDimensions = 0;
+    mCellSize = 1.0f;
+}
+
+VoxelHashGrid::VoxelHashGrid(const MatrixXf& points, float cellSize) {
+    build(points, cellSize);
+}
+
+uint64_t VoxelHashGrid::getKey(Vector3i cell) {
+    return ((uint64_t)(cell.x() + maxCellCoordinate) << 42) |
+           ((uint64_t)(cell.y() + maxCellCoordinate) << 21) |
+            (uint64_t)(cell.z() + maxCellCoordinate);
+}
+
+void VoxelHashGrid::build(const MatrixXf& points, float cellSize) {
+    if(points.rows() < 3)
+        throw Exception("Points of a voxel hash grid must have at least 3 dimensions");
+    mDimensions = points.rows();
+    const int size = points.cols();
+    mCells.clear();
+    mPoints.clear();
+    mIndices.clear();
+    if(size == 0)
+        return;
+
+    const Vector3f minimum = points.topRows(3).rowwise().minCoeff();
+    const Vector3f maximum = points.topRows(3).rowwise().maxCoeff();
+    if(cellSize <= 0) {
+        // About one point per cell if the points were spread evenly. Flat dimensions are ignored,
+        // so that points on a plane or a line also get about one point per cell.
+        double volume = 1.0;
+        int dimensions = 0;
+        for(int i = 0; i < 3; ++i) {
+            if(maximum[i] > minimum[i]) {
+                volume *= maximum[i] - minimum[i];
+                ++dimensions;
+            }
+        }
+        cellSize = dimensions == 0 ? 1.0f : (float)std::pow(volume / size, 1.0 / dimensions);
+    }
+    mCellSize = cellSize;
+
+    // Find the cell of each point, and sort the points by cell
+    std::vector<uint64_t> keys(size);
+    mMinimumCell = Vector3i::Constant(maxCellCoordinate);
+    mMaximumCell = Vector3i::Constant(-maxCellCoordinate);
+    for(int i = 0; i < size; ++i) {
+        Vector3i cell;
+        for(int j = 0; j < 3; ++j) {
+            const double coordinate = std::floor((double)points(j, i) / mCellSize);
+            if(coordinate < -maxCellCoordinate || coordinate >= maxCellCoordinate)
+                throw Exception("Points span too many cells in voxel hash grid, increase the cell size");
+            cell[j] = (int)coordinate;
+        }
+        mMinimumCell = mMinimumCell.cwiseMin(cell);
+        mMaximumCell = mMaximumCell.cwiseMax(cell);
+        keys[i] = getKey(cell);
+    }
+    mIndices.resize(size);
+    std::iota(mIndices.begin(), mIndices.end(), 0);
+    std::sort(mIndices.begin(), mIndices.end(), [&keys](int a, int b) {
+        return keys[a] < keys[b];
+    });
+
+    mPoints.resize((std::size_t)size*mDimensions);
+    int cellStart = 0;
+    for(int i = 0; i < size; ++i) {
+        std::copy_n(&points(0, mIndices[i]), mDimensions, &mPoints[(std::size_t)i*mDimensions]);
+        if(i == size - 1 || keys[mIndices[i + 1]] != keys[mIndices[i]]) {
+            mCells[keys[mIndices[i]]] = std::make_pair(cellStart, i + 1);
+            cellStart = i + 1;
+        }
+    }
+}
+
+Vector3i VoxelHashGrid::getCell(const float* point) const {
+    // Queries outside the grid are moved to just outside the occupied cells, which keeps the coordinates in range
+    Vector3i cell;
+    for(int j = 0; j < 3; ++j) {
+        const double coordinate = std::floor((double)point[j] / mCellSize);
+        cell[j] = (int)std::min(std::max(coordinate, (double)mMinimumCell[j] - 1), (double)mMaximumCell[j] + 1);
+    }
+    return cell;
+}
+
+float VoxelHashGrid::getSquaredDistance(const float* query, int point) const {
+    const float* coordinates = &mPoints[(std::size_t)point*mDimensions];
+    float distance = 0.0f;
+    for(int d = 0; d < mDimensions; ++d) {
+        const float difference = coordinates[d] - query[d];
+        distance += difference*difference;
+    }
+    return distance;
+}
+
+void VoxelHashGrid::searchCell(Vector3i cell, const float* query, int& nearest, float& nearestDistance) const {
+    auto it = mCells.find(getKey(cell));
+    if(it == mCells.end())
+        return;
+    for(int i = it->second.first; i < it->second.second; ++i) {
+        const float distance = getSquaredDistance(query, i);
+        if(distance < nearestDistance) {
+            nearestDistance = distance;
+            nearest = i;
+        }
+    }
+}
+
+int VoxelHashGrid::findNearest(const VectorXf& query, float* distance, float maxDistance) const {
+    if(query.size() != mDimensions)
+        throw Exception("Query point must have the same nr of dimensions as the voxel hash grid");
+
+    int nearest = -1;
+    float nearestDistance = maxDistance < std::numeric_limits<float>::max() ? maxDistance*maxDistance : std::numeric_limits<float>::infinity();
+    if(mCells.empty())
+        return -1;
+
+    // Search shells of cells of increasing size around the cell of the query point
+    const Vector3i center = getCell(query.data());
+    // Distance along one axis from the query point to a row of cells
+    auto getAxisDistance = [this, &query](int axis, int cell) {
+        return std::max(std::max(cell*mCellSize - query[axis], query[axis] - (cell + 1)*mCellSize), 0.0f);
+    };
+    auto searchCellIfCloser = [&](int x, int y, int z, float distanceYZ) {
+        const float distanceX = getAxisDistance(0, x);
+        if(distanceX*distanceX + distanceYZ < nearestDistance)
+            searchCell(Vector3i(x, y, z), query.data(), nearest, nearestDistance);
+    };
+    for(int r = 0; ; ++r) {
+        // Points in shell r are outside the box of the cells within r - 1 of the center cell
+        if(r > 0) {
+            float shellDistance = std::numeric_limits<float>::max();
+            for(int j = 0; j < 3; ++j) {
+                shellDistance = std::min(shellDistance, std::min(
+                        query[j] - (center[j] - r + 1)*mCellSize, (center[j] + r)*mCellSize - query[j]));
+            }
+            shellDistance = std::max(shellDistance, 0.0f);
+            if(shellDistance*shellDistance >= nearestDistance)
+                break;
+        }
+
+        for(int z = std::max(center.z() - r, mMinimumCell.z()); z <= std::min(center.z() + r, mMaximumCell.z()); ++z) {
+            const float distanceZ = getAxisDistance(2, z);
+            for(int y = std::max(center.y() - r, mMinimumCell.y()); y <= std::min(center.y() + r, mMaximumCell.y()); ++y) {
+                // Skip cells which can't contain a point closer than the nearest point found
+                const float distanceY = getAxisDistance(1, y);
+                const float distanceYZ = distanceY*distanceY + distanceZ*distanceZ;
+                if(distanceYZ >= nearestDistance)
+                    continue;
+                if(std::abs(z - center.z()) == r || std::abs(y - center.y()) == r) {
+                    // Face of the shell, search the entire row
+                    for(int x = std::max(center.x() - r, mMinimumCell.x()); x <= std::min(center.x() + r, mMaximumCell.x()); ++x)
+                        searchCellIfCloser(x, y, z, distanceYZ);
+                } else {
+                    // Inside of the shell, only the two ends of the row are part of the shell
+                    if(center.x() - r >= mMinimumCell.x())
+                        searchCellIfCloser(center.x() - r, y, z, distanceYZ);
+                    if(r > 0 && center.x() + r <= mMaximumCell.x())
+                        searchCellIfCloser(center.x() + r, y, z, distanceYZ);
+                }
+            }
+        }
+
+        // Stop when the shell contains all occupied cells
+        if((center.array() - r <= mMinimumCell.array()).all() && (center.array() + r >= mMaximumCell.array()).all())
+            break;
+    }
+    if(nearest == -1)
+        return -1;
+
+    if(distance != nullptr)
+        *distance = std::sqrt(nearestDistance);
+    return mIndices[nearest];
+}
+
+std::vector<int> VoxelHashGrid::findWithinRadius(const VectorXf& query, float radius) const {
+    if(query.size() != mDimensions)
+        throw Exception("Query point must have the same nr of dimensions as the voxel hash grid");
+
+    std::vector<int> result;
+    if(mCells.empty())
+        return result;
+
+    const float squaredRadius = radius*radius;
+    const Vector3i center = getCell(query.data());
+    const int cellRadius = (int)std::min(std::ceil(radius / mCellSize), (float)maxCellCoordinate);
+    const Vector3i start = (center.array() - cellRadius).max(mMinimumCell.array());
+    const Vector3i end = (center.array() + cellRadius).min(mMaximumCell.array());
+    if((start.array() > end.array()).any())
+        return result;
+
+    auto searchRange = [&](std::pair<int, int> range) {
+        for(int i = range.first; i < range.second; ++i) {
+            if(getSquaredDistance(query.data(), i) <= squaredRadius)
+                result.push_back(mIndices[i]);
+        }
+    };
+    const Vector3i size = end - start + Vector3i::Ones();
+    if((double)size.x()*size.y()*size.z() > mCells.size()) {
+        // Large radius, faster to go through the occupied cells than all cells within the radius
+        for(auto& cell : mCells)
+            searchRange(cell.second);
+    } else {
+        for(int z = start.z(); z <= end.z(); ++z) {
+            for(int y = start.y(); y <= end.y(); ++y) {
+                for(int x = start.x(); x <= end.x(); ++x) {
+                    auto it = mCells.find(getKey(Vector3i(x, y, z)));
+                    if(it != mCells.end())
+                        searchRange(it->second);
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+int VoxelHashGrid::getNrOfPoints() const {
+    return mIndices.size();
+}
+
+int VoxelHashGrid::getNrOfDimensions() const {
+    return mDimensions;
+}
+
+float VoxelHashGrid::getCellSize() const {
+    return mCellSize;
+}
+
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "FAST/Data/DataTypes.hpp"
+#include <limits>
+#include <unordered_map>
+
+namespace fast {
+
+/**
+ * Uniform voxel grid for nearest neighbor queries on a static set of points.
+ * Only the occupied cells are stored, in a hash map, thus the memory use does not depend on the extent of the points.
+ * Building the grid is O(N), and a query only visits the cells around the query point, which is faster than a
+ * k-d tree when the points are evenly spread, such as the vertices of a surface mesh.
+ * Queries are const and can be done from several threads at the same time.
+ *
+ * The points are put in cells by their first three dimensions. Points may have more dimensions, such as color,
+ * which are included in the distance, but not used to find the cells.
+ */
+class FAST_EXPORT VoxelHashGrid {
+    public:
+        /**
+         * Create an empty grid. Use build to add points.
+         */
+        VoxelHashGrid();
+        /**
+         * Build grid of a set of points
+         * @param points DxN matrix, one point per column, where D is at least 3
+         * @param cellSize Size of each cell. If 0 or less, the cell size is chosen so that there is on average about
+         *      one point per cell if the points were spread evenly in their bounding box.
+         */
+        explicit VoxelHashGrid(const MatrixXf& points, float cellSize = -1);
+        /**
+         * Build grid of a set of points, replacing any points already in the grid
+         * @param points DxN matrix, one point per column, where D is at least 3
+         * @param cellSize Size of each cell. If 0 or less, the cell size is chosen automatically.
+         */
+        void build(const MatrixXf& points, float cellSize = -1);
+        /**
+         * Find the point closest to the query point.
+         *
+         * @param query Point with the same nr of dimensions as the grid
+         * @param distance If not null, the distance to the point found is stored here
+         * @param maxDistance Only points closer than this are considered
+         * @return index of the closest point, or -1 if there are no points within maxDistance
+         */
+        int findNearest(const VectorXf& query, float* distance = nullptr,
+                float maxDistance = std::numeric_limits<float>::max()) const;
+        /**
+         * Find all points within a radius of the query point.
+         * @param query Point with the same nr of dimensions as the grid
+         * @param radius
+         * @return indices of the points, in no particular order
+         */
+        std::vector<int> findWithinRadius(const VectorXf& query, float radius) const;
+        int getNrOfPoints() const;
+        int getNrOfDimensions() const;
+        float getCellSize() const;
+    private:
+        Vector3i getCell(const float* point) const;
+        static uint64_t getKey(Vector3i cell);
+        float getSquaredDistance(const float* query, int point) const;
+        // Update nearest with the closest point in a cell, if any
+        void searchCell(Vector3i cell, const float* query, int& nearest, float& nearestDistance) const;
+
+        int mDimensions;
+        float mCellSize;
+        // Bounds of the occupied cells
+        Vector3i mMinimumCell;
+        Vector3i mMaximumCell;
+        // Coordinates of each point stored contiguously, sorted by cell
+        std::vector<float> mPoints;
+        // Original index of each point
+        std::vector<int> mIndices;
+        // Range of points in each occupied cell
+        std::unordered_map<uint64_t, std::pair<int, int>> mCells;
+};
+
+}
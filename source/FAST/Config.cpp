@@ -27,6 +27,7 @@ namespace fast {
 			std::string mLibraryPath;
 			std::string mQtPluginsPath;
 			StreamingMode m_streamingMode = STREAMING_MODE_PROCESS_ALL_FRAMES;
+			ExecutionMode m_executionMode = EXECUTION_MODE_SEQUENTIAL;
 		}
 
 		std::string getPath() {
@@ -270,6 +271,14 @@ namespace fast {
 		    return m_streamingMode;
 		}
 
+		void setExecutionMode(ExecutionMode mode) {
+		    m_executionMode = mode;
+		}
+
+		ExecutionMode getExecutionMode() {
+		    return m_executionMode;
+		}
+
 	} // end namespace Config
 
 }; // end namespace fast
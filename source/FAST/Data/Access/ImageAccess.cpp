@@ -35,7 +35,7 @@ float getScalarAsFloat(T* data, VectorXi position, Image::pointer image, uchar c
             position.x() > size.x()-1 || position.y() > size.y()-1 || position.z() > size.z()-1 || channel >= image->getNrOfChannels())
         throw OutOfBoundsException();
 
-    T value = data[(position.x() + position.y()*size.x() + position.z()*size.x()*size.y())*image->getNrOfChannels() + channel];
+    T value = data[(position.x() + (std::size_t)position.y()*size.x() + (std::size_t)position.z()*size.x()*size.y())*image->getNrOfChannels() + channel];
     float floatValue;
     if(image->getDataType() == TYPE_SNORM_INT16) {
         floatValue = std::max(-1.0f, (float)value / 32767.0f);
@@ -49,10 +49,9 @@ float getScalarAsFloat(T* data, VectorXi position, Image::pointer image, uchar c
 }
 
 template <typename T>
-float getScalarAsFloat(T* data, uint position, Image::pointer image, uchar channel) {
+float getScalarAsFloat(T* data, std::size_t position, Image::pointer image, uchar channel) {
 
-    Vector3ui size = image->getSize();
-    if(position >= size.x()*size.y()*size.z())
+    if(position >= image->getNrOfVoxels())
         throw OutOfBoundsException();
 
     T value = data[position*image->getNrOfChannels() + channel];
@@ -76,7 +75,7 @@ void setScalarAsFloat(T* data, VectorXi position, Image::pointer image, float va
             position.x() > size.x()-1 || position.y() > size.y()-1 || position.z() > size.z()-1 || channel >= image->getNrOfChannels())
         throw OutOfBoundsException();
 
-    uint address = (position.x() + position.y()*size.x() + position.z()*size.x()*size.y())*image->getNrOfChannels() + channel;
+    std::size_t address = (position.x() + (std::size_t)position.y()*size.x() + (std::size_t)position.z()*size.x()*size.y())*image->getNrOfChannels() + channel;
     if(image->getDataType() == TYPE_SNORM_INT16) {
         data[address] = value * 32767.0f;;
     } else if(image->getDataType() == TYPE_UNORM_INT16) {
@@ -87,13 +86,12 @@ void setScalarAsFloat(T* data, VectorXi position, Image::pointer image, float va
 }
 
 template <typename T>
-void setScalarAsFloat(T* data, uint position, Image::pointer image, float value, uchar channel) {
+void setScalarAsFloat(T* data, std::size_t position, Image::pointer image, float value, uchar channel) {
 
-    Vector3ui size = image->getSize();
-    if(position >= size.x()*size.y()*size.z())
+    if(position >= image->getNrOfVoxels())
         throw OutOfBoundsException();
 
-    uint address = position*image->getNrOfChannels() + channel;
+    std::size_t address = position*image->getNrOfChannels() + channel;
     if(image->getDataType() == TYPE_SNORM_INT16) {
         data[address] = value * 32767.0f;;
     } else if(image->getDataType() == TYPE_UNORM_INT16) {
@@ -111,7 +109,7 @@ float ImageAccess::getScalar(VectorXi position, uchar channel) const {
     }
 }
 
-float ImageAccess::getScalar(uint position, uchar channel) const {
+float ImageAccess::getScalar(std::size_t position, uchar channel) const {
     switch(mImage->getDataType()) {
         fastSwitchTypeMacro(return getScalarAsFloat<FAST_TYPE>((FAST_TYPE*)mData, position, mImage, channel))
     }
@@ -126,7 +124,7 @@ void ImageAccess::setScalar(VectorXi position, float value, uchar channel) {
     }
 }
 
-void ImageAccess::setScalar(uint position, float value, uchar channel) {
+void ImageAccess::setScalar(std::size_t position, float value, uchar channel) {
     switch(mImage->getDataType()) {
         fastSwitchTypeMacro(setScalarAsFloat<FAST_TYPE>((FAST_TYPE*)mData, position, mImage, value, channel))
     }
@@ -146,7 +144,7 @@ void ImageAccess::setVector(VectorXi position, Vector4f value) {
     }
 }
 
-void ImageAccess::setVector(uint position, Vector4f value) {
+void ImageAccess::setVector(std::size_t position, Vector4f value) {
     for(uchar i = 0; i < mImage->getNrOfChannels(); ++i) {
         setScalar(position, value[i], i);
     }
@@ -10,27 +10,27 @@ class FAST_EXPORT  ImageAccess {
         ImageAccess(void* data, SharedPointer<Image> image);
         void* get();
         template <class T>
-        T getScalarFast(uint position, uchar channel = 0) const noexcept;
+        T getScalarFast(std::size_t position, uchar channel = 0) const noexcept;
         template <class T>
         T getScalarFast(VectorXi, uchar channel = 0) const noexcept;
         template <class T>
         T getScalarFast2D(Vector2i, uchar channel = 0) const noexcept;
         template <class T>
         T getScalarFast3D(Vector3i, uchar channel = 0) const noexcept;
-        float getScalar(uint position, uchar channel = 0) const;
+        float getScalar(std::size_t position, uchar channel = 0) const;
         float getScalar(VectorXi position, uchar channel = 0) const;
         Vector4f getVector(VectorXi position) const;
         template <class T>
-        void setScalarFast(uint position, T value, uchar channel = 0) noexcept;
+        void setScalarFast(std::size_t position, T value, uchar channel = 0) noexcept;
         template <class T>
         void setScalarFast(VectorXi position, T value, uchar channel = 0) noexcept;
         template <class T>
         void setScalarFast2D(Vector2i position, T value, uchar channel = 0) noexcept;
         template <class T>
         void setScalarFast3D(Vector3i position, T value, uchar channel = 0) noexcept;
-        void setScalar(uint position, float value, uchar channel = 0);
+        void setScalar(std::size_t position, float value, uchar channel = 0);
         void setScalar(VectorXi position, float value, uchar channel = 0);
-		void setVector(uint position, Vector4f value);
+		void setVector(std::size_t position, Vector4f value);
         void setVector(VectorXi position, Vector4f value);
         void release();
         ~ImageAccess();
@@ -39,13 +39,15 @@ class FAST_EXPORT  ImageAccess {
 		ImageAccess(const ImageAccess::pointer other) = delete;
 		ImageAccess::pointer operator=(const ImageAccess::pointer other) = delete;
         void* mData;
-        const int m_width, m_height, m_depth, m_channels, m_dimensions;
+        // Sizes are stored as size_t so that all address calculations are done in 64 bit
+        const std::size_t m_width, m_height, m_depth, m_channels;
+        const int m_dimensions;
 
         SharedPointer<Image> mImage;
 };
 
 template <class T>
-T ImageAccess::getScalarFast(uint position, uchar channel) const noexcept {
+T ImageAccess::getScalarFast(std::size_t position, uchar channel) const noexcept {
     return ((T*)mData)[position * m_channels + channel];
 }
 
@@ -69,27 +71,27 @@ T ImageAccess::getScalarFast3D(Vector3i position, uchar channel) const noexcept
 }
 
 template <class T>
-void ImageAccess::setScalarFast(uint position, T value, uchar channel) noexcept {
+void ImageAccess::setScalarFast(std::size_t position, T value, uchar channel) noexcept {
     ((T*)mData)[position * m_channels + channel] = value;
 }
 
 template <class T>
-void setScalarFast(VectorXi position, T value, uchar channel) noexcept {
+void ImageAccess::setScalarFast(VectorXi position, T value, uchar channel) noexcept {
 	if(m_dimensions == 2) {
         ((T*)mData)[(position.x() + position.y() * m_width) * m_channels + channel] = value;
     } else {
-        ((T*)mData)[(position.x() + position.y() * m_width + position.z()*m_width*m_height) * m_channels + channel] = value
+        ((T*)mData)[(position.x() + position.y() * m_width + position.z()*m_width*m_height) * m_channels + channel] = value;
     }
 }
 
 template <class T>
-void setScalarFast2D(Vector2i position, T value, uchar channel) noexcept {
+void ImageAccess::setScalarFast2D(Vector2i position, T value, uchar channel) noexcept {
 	((T*)mData)[(position.x() + position.y() * m_width) * m_channels + channel] = value;
 }
 
 template <class T>
-void setScalarFast3D(Vector3i position, T value, uchar channel) noexcept {
-	((T*)mData)[(position.x() + position.y() * m_width + position.z()*m_width*m_height) * m_channels + channel] = value
+void ImageAccess::setScalarFast3D(Vector3i position, T value, uchar channel) noexcept {
+	((T*)mData)[(position.x() + position.y() * m_width + position.z()*m_width*m_height) * m_channels + channel] = value;
 }
 
 
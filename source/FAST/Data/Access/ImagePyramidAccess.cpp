@@ -101,6 +101,10 @@ ImagePyramidPatch ImagePyramidAccess::getPatch(std::string tile) {
 
 
 std::unique_ptr<uchar[]> ImagePyramidAccess::getPatchData(int level, int x, int y, int width, int height) {
+    if(level < 0 || level >= m_image->getNrOfLevels())
+        throw Exception("Incorrect level given to getPatchData " + std::to_string(level));
+    if(m_fileHandle == nullptr && m_levels[level].data == nullptr)
+        throw Exception("Level " + std::to_string(level) + " of image pyramid has no data");
     const int levelWidth = m_image->getLevelWidth(level);
     const int levelHeight = m_image->getLevelHeight(level);
     const int channels = m_image->getNrOfChannels();
@@ -108,6 +112,9 @@ std::unique_ptr<uchar[]> ImagePyramidAccess::getPatchData(int level, int x, int
     if(m_fileHandle != nullptr) {
 		float scale = (float)m_image->getFullWidth()/levelWidth;
         openslide_read_region(m_fileHandle, (uint32_t*)data.get(), x * scale, y * scale, level, width, height);
+        const char* error = openslide_get_error(m_fileHandle);
+        if(error != nullptr)
+            throw Exception("Error reading patch from image pyramid: " + std::string(error));
     } else {
         auto levelData = m_levels[level];
         for(int cy = y; cy < std::min(y + height, levelHeight); ++cy) {
@@ -187,8 +194,11 @@ SharedPointer<Image> ImagePyramidAccess::getPatchAsImage(int level, int offsetX,
     if(offsetX + width >= m_image->getLevelWidth(level) || offsetY + height >= m_image->getLevelHeight(level))
         throw Exception("offset + size exceeds level size");
 
+    return getPatchDataAsImage(level, width, height, getPatchData(level, offsetX, offsetY, width, height));
+}
+
+SharedPointer<Image> ImagePyramidAccess::getPatchDataAsImage(int level, int width, int height, std::unique_ptr<uchar[]> data) {
     auto image = Image::New();
-    auto data = getPatchData(level, offsetX, offsetY, width, height);
     float scale = (float)m_image->getFullWidth()/m_image->getLevelWidth(level);
     image->create(width, height, TYPE_UINT8, 4, std::move(data));
     image->setSpacing(Vector3f(
@@ -45,6 +45,11 @@ public:
 	SharedPointer<Image> getLevelAsImage(int level);
 	SharedPointer<Image> getPatchAsImage(int level, int offsetX, int offsetY, int width, int height);
 	SharedPointer<Image> getPatchAsImage(int level, int patchIdX, int patchIdY);
+	/**
+	 * Create an image from patch data returned by getPatchData. Splitting getPatchAsImage in two
+	 * allows the data to be read by several threads, while the image is created on a single thread.
+	 */
+	SharedPointer<Image> getPatchDataAsImage(int level, int width, int height, std::unique_ptr<uchar[]> data);
 	void release();
 	~ImagePyramidAccess();
 private:
@@ -25,4 +25,8 @@ float* TensorAccess::getRawData() {
     return m_data;
 }
 
+std::shared_ptr<float> TensorAccess::getSharedRawData() {
+    return std::shared_ptr<float>(m_tensor->m_data, m_data);
+}
+
 }
\ No newline at end of file
@@ -18,6 +18,11 @@ class FAST_EXPORT TensorAccess {
         typedef std::unique_ptr<TensorAccess> pointer;
         TensorAccess(float* data, TensorShape shape, SharedPointer<Tensor> tensor);
         float * getRawData();
+        /**
+         * @return the raw data as a shared pointer which shares ownership of the tensor storage.
+         * This allows inference engines to bind the tensor memory directly, keeping it alive as long as they need it.
+         */
+        std::shared_ptr<float> getSharedRawData();
         TensorShape getShape() const;
         ~TensorAccess();
         void release();
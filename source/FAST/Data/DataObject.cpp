@@ -1,5 +1,7 @@
 #include "FAST/Data/DataObject.hpp"
 #include "FAST/ProcessObject.hpp"
+#include "FAST/Data/MemoryPool.hpp"
+#include <algorithm>
 
 namespace fast {
 
@@ -108,4 +110,35 @@ std::unordered_map<std::string, std::string> DataObject::getFrameData() {
     return m_frameData;
 }
 
+void DataObject::setMemoryPool(SharedPointer<MemoryPool> pool) {
+    m_memoryPool = pool;
+}
+
+SharedPointer<MemoryPool> DataObject::getMemoryPool() {
+    if(!m_memoryPool)
+        m_memoryPool = MemoryPool::getDefault();
+    return m_memoryPool;
+}
+
+void DataObject::addHostReadEvent(OpenCLDevice::pointer device, cl::Event event) {
+    // Make sure the transfer is started now, and not when someone waits for it
+    device->getCommandQueue().flush();
+    std::lock_guard<std::mutex> lock(m_hostReadEventsMutex);
+    // Forget transfers which have already finished
+    m_hostReadEvents.erase(std::remove_if(m_hostReadEvents.begin(), m_hostReadEvents.end(), [](const cl::Event& event) {
+        return event.getInfo<CL_EVENT_COMMAND_EXECUTION_STATUS>() == CL_COMPLETE;
+    }), m_hostReadEvents.end());
+    m_hostReadEvents.push_back(event);
+}
+
+void DataObject::waitForHostReads() {
+    std::vector<cl::Event> events;
+    {
+        std::lock_guard<std::mutex> lock(m_hostReadEventsMutex);
+        events.swap(m_hostReadEvents);
+    }
+    if(!events.empty())
+        cl::Event::waitForEvents(events);
+}
+
 } // end namespace fast
@@ -10,6 +10,8 @@
 
 namespace fast {
 
+class MemoryPool;
+
 class FAST_EXPORT  DataObject : public Object {
     public:
         DataObject();
@@ -37,12 +39,32 @@ class FAST_EXPORT  DataObject : public Object {
         std::string getFrameData(std::string name);
         std::unordered_map<std::string, std::string> getFrameData();
         void accessFinished();
+        /**
+         * Set the memory pool which storage of this data object is allocated from.
+         * Has to be set before the data is created.
+         * @param pool
+         */
+        void setMemoryPool(SharedPointer<MemoryPool> pool);
+        /**
+         * @return the memory pool of this data object, the default pool if none has been set
+         */
+        SharedPointer<MemoryPool> getMemoryPool();
     protected:
         virtual void free(ExecutionDevice::pointer device) = 0;
         virtual void freeAll() = 0;
 
         void blockIfBeingWrittenTo();
         void blockIfBeingAccessed();
+        /**
+         * Register a non-blocking transfer which reads from the host data, and flush the queue of the device.
+         * The host data can't be modified or freed before the transfer has finished, see waitForHostReads.
+         */
+        void addHostReadEvent(OpenCLDevice::pointer device, cl::Event event);
+        /**
+         * Wait for all non-blocking transfers reading from the host data to finish.
+         * Must be called before the host data is modified or freed.
+         */
+        void waitForHostReads();
 
         std::mutex mDataIsBeingWrittenToMutex;
         std::condition_variable mDataIsBeingWrittenToCondition;
@@ -67,6 +89,11 @@ class FAST_EXPORT  DataObject : public Object {
         // Indicates whether this data object is the last frame in a stream, and if so, the name of the stream
         std::unordered_set<std::string> m_lastFrame;
 
+        SharedPointer<MemoryPool> m_memoryPool;
+
+        std::vector<cl::Event> m_hostReadEvents;
+        std::mutex m_hostReadEventsMutex;
+
 
 };
 
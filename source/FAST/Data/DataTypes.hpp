@@ -8,6 +8,8 @@
 #include "CL/OpenCL.hpp"
 #include "FAST/ExecutionDevice.hpp"
 #include <iostream>
+#include <functional>
+#include <memory>
 #include <Eigen/Dense>
 
 // These have to be outside of fast namespace or it will not compile with Qt on Windows. Why?
@@ -47,6 +49,10 @@ enum DataType {
 
 enum PlaneType {PLANE_X, PLANE_Y, PLANE_Z};
 
+// Pointer to pixel data, the deleter knows how the pixel data was allocated
+using pixel_deleter_t = std::function<void(void *)>;
+using unique_pixel_ptr = std::unique_ptr<void, pixel_deleter_t>;
+
 // Returns the C type for a DataType as a string
 FAST_EXPORT std::string getCTypeAsString(DataType type);
 
@@ -2,6 +2,7 @@
 #include "FAST/Data/Access/ImageAccess.hpp"
 #include "FAST/Utility.hpp"
 #include "FAST/Exception.hpp"
+#include "FAST/Tracer.hpp"
 #include "FAST/Utility.hpp"
 #include "FAST/SceneGraph.hpp"
 #include "FAST/Config.hpp"
@@ -20,9 +21,9 @@ unique_pixel_ptr allocatePixelArray(std::size_t size, DataType type) {
 
 // Pad data with 1, 2 or 3 channels to 4 channels with 0
 template <class T>
-void * padData(T * data, unsigned int size, unsigned int nrOfChannels) {
+void * padData(T * data, std::size_t size, unsigned int nrOfChannels) {
     T * newData = new T[size*4]();
-    for(unsigned int i = 0; i < size; i++) {
+    for(std::size_t i = 0; i < size; i++) {
     	if(nrOfChannels == 1) {
             newData[i*4] = data[i];
     	} else if(nrOfChannels == 2) {
@@ -37,7 +38,7 @@ void * padData(T * data, unsigned int size, unsigned int nrOfChannels) {
     return (void *)newData;
 }
 
-const void * const adaptDataToImage(const void* const data, cl_channel_order order, unsigned int size, DataType type, unsigned int nrOfChannels) {
+const void * const adaptDataToImage(const void* const data, cl_channel_order order, std::size_t size, DataType type, unsigned int nrOfChannels) {
     // Because no OpenCL images support 3 channels,
     // the data has to be padded to 4 channels if the nr of channels is 3
     // Also, not all CL platforms support CL_R and CL_RG images
@@ -52,9 +53,9 @@ const void * const adaptDataToImage(const void* const data, cl_channel_order ord
 
 // Remove padding from a data array created by padData
 template <class T>
-void * removePadding(T * data, unsigned int size, unsigned int nrOfChannels) {
+void * removePadding(T * data, std::size_t size, unsigned int nrOfChannels) {
      T * newData = new T[size*nrOfChannels];
-    for(unsigned int i = 0; i < size; i++) {
+    for(std::size_t i = 0; i < size; i++) {
     	if(nrOfChannels == 1) {
             newData[i] = data[i*4];
     	} else if(nrOfChannels == 2) {
@@ -69,7 +70,7 @@ void * removePadding(T * data, unsigned int size, unsigned int nrOfChannels) {
     return (void *)newData;
 }
 
-unique_pixel_ptr adaptImageDataToHostData(unique_pixel_ptr data, cl_channel_order order, unsigned int size, DataType type, unsigned int nrOfChannels) {
+unique_pixel_ptr adaptImageDataToHostData(unique_pixel_ptr data, cl_channel_order order, std::size_t size, DataType type, unsigned int nrOfChannels) {
     // Because no OpenCL images support 3 channels,
     // the data has to be padded to 4 channels if the nr of channels is 3.
     // Also, not all CL platforms support CL_R and CL_RG images
@@ -86,37 +87,44 @@ unique_pixel_ptr adaptImageDataToHostData(unique_pixel_ptr data, cl_channel_orde
 
 
 void Image::transferCLImageFromHost(OpenCLDevice::pointer device) {
+    TraceScope trace("Image host to device", "transfer");
 
     // Special treatment for images with 3 channels because an OpenCL image can only have 1, 2 or 4 channels
 	// And if the device does not support 1 or 2 channels
     cl::ImageFormat format = getOpenCLImageFormat(device, mDimensions == 2 ? CL_MEM_OBJECT_IMAGE2D : CL_MEM_OBJECT_IMAGE3D, mType, mChannels);
     if(format.image_channel_order == CL_RGBA && mChannels != 4) {
-        auto tempData = adaptDataToImage(mHostData.get(), CL_RGBA, mWidth*mHeight*mDepth, mType, mChannels);
+        auto tempData = adaptDataToImage(mHostData.get(), CL_RGBA, (std::size_t)mWidth*mHeight*mDepth, mType, mChannels);
         device->getCommandQueue().enqueueWriteImage(*(cl::Image*)mCLImages[device],
         CL_TRUE, createOrigoRegion(), createRegion(mWidth, mHeight, mDepth), 0,
                 0, (void*)tempData);
         deleteArray((void*)tempData, mType);
     } else {
+        // Non-blocking, kernels using the image are enqueued after the write in the same in-order queue.
+        // The host data must not be modified or freed before the write has finished, see waitForHostReads
+        cl::Event event;
         device->getCommandQueue().enqueueWriteImage(*(cl::Image*)mCLImages[device],
-        CL_TRUE, createOrigoRegion(), createRegion(mWidth, mHeight, mDepth), 0,
-                0, mHostData.get());
+        CL_FALSE, createOrigoRegion(), createRegion(mWidth, mHeight, mDepth), 0,
+                0, mHostData.get(), nullptr, &event);
+        addHostReadEvent(device, event);
     }
 }
 
 void Image::transferCLImageToHost(OpenCLDevice::pointer device) {
+    TraceScope trace("Image device to host", "transfer");
+    waitForHostReads();
     // Special treatment for images with 3 channels because an OpenCL image can only have 1, 2 or 4 channels
 	// And if the device does not support 1 or 2 channels
     cl::ImageFormat format = getOpenCLImageFormat(device, mDimensions == 2 ? CL_MEM_OBJECT_IMAGE2D : CL_MEM_OBJECT_IMAGE3D, mType, mChannels);
     if(format.image_channel_order == CL_RGBA && mChannels != 4) {
-        auto tempData = allocatePixelArray(mWidth*mHeight*mDepth*4, mType);
+        auto tempData = allocatePixelArray((std::size_t)mWidth*mHeight*mDepth*4, mType);
         device->getCommandQueue().enqueueReadImage(*(cl::Image*)mCLImages[device],
         CL_TRUE, createOrigoRegion(), createRegion(mWidth, mHeight, mDepth), 0,
                 0, tempData.get());
-        mHostData = adaptImageDataToHostData(std::move(tempData), CL_RGBA, mWidth*mHeight*mDepth,mType,mChannels);
+        mHostData = adaptImageDataToHostData(std::move(tempData), CL_RGBA, (std::size_t)mWidth*mHeight*mDepth,mType,mChannels);
     } else {
         if(!mHostHasData) {
             // Must allocate memory for host data
-            mHostData = allocatePixelArray(mWidth*mHeight*mDepth*mChannels,mType);
+            mHostData = getMemoryPool()->allocateHost(getBufferSize());
 			mHostHasData = true;
         }
         device->getCommandQueue().enqueueReadImage(*(cl::Image*)mCLImages[device],
@@ -125,6 +133,11 @@ void Image::transferCLImageToHost(OpenCLDevice::pointer device) {
     }
 }
 
+cl::Image* Image::createOpenCLImage(OpenCLDevice::pointer device) {
+    cl::ImageFormat format = getOpenCLImageFormat(device, mDimensions == 2 ? CL_MEM_OBJECT_IMAGE2D : CL_MEM_OBJECT_IMAGE3D, mType, mChannels);
+    return getMemoryPool()->allocateImage(device, mDimensions, format, mWidth, mHeight, mDepth);
+}
+
 bool Image::hasAnyData() {
     return mHostHasData || mCLImages.size() > 0 || mCLBuffers.size() > 0;
 }
@@ -139,14 +152,7 @@ void Image::updateOpenCLImageData(OpenCLDevice::pointer device) {
     bool updated = false;
     if (mCLImagesIsUpToDate.count(device) == 0) {
         // Data is not on device, create it
-        cl::Image * newImage;
-        if(mDimensions == 2) {
-            newImage = new cl::Image2D(device->getContext(),
-            CL_MEM_READ_WRITE, getOpenCLImageFormat(device, CL_MEM_OBJECT_IMAGE2D, mType,mChannels), mWidth, mHeight);
-        } else {
-            newImage = new cl::Image3D(device->getContext(),
-            CL_MEM_READ_WRITE, getOpenCLImageFormat(device, CL_MEM_OBJECT_IMAGE3D, mType,mChannels), mWidth, mHeight, mDepth);
-        }
+        cl::Image * newImage = createOpenCLImage(device);
 
         if(hasAnyData()) {
             mCLImagesIsUpToDate[device] = false;
@@ -211,6 +217,7 @@ OpenCLBufferAccess::pointer Image::getOpenCLBufferAccess(
         std::unique_lock<std::mutex> lock(mDataIsBeingWrittenToMutex);
         mDataIsBeingWrittenTo = true;
     }
+    loadAllSlabs();
     updateOpenCLBufferData(device);
     if(type == ACCESS_READ_WRITE) {
         setAllDataToOutOfDate();
@@ -227,8 +234,8 @@ OpenCLBufferAccess::pointer Image::getOpenCLBufferAccess(
 	return std::move(accessObject);
 }
 
-unsigned int Image::getBufferSize() const {
-    unsigned int bufferSize = mWidth*mHeight;
+std::size_t Image::getBufferSize() const {
+    std::size_t bufferSize = (std::size_t)mWidth*mHeight;
     if(mDimensions == 3) {
         bufferSize *= mDepth;
     }
@@ -247,9 +254,7 @@ void Image::updateOpenCLBufferData(OpenCLDevice::pointer device) {
     bool updated = false;
     if (mCLBuffers.count(device) == 0) {
         // Data is not on device, create it
-        unsigned int bufferSize = getBufferSize();
-        cl::Buffer * newBuffer = new cl::Buffer(device->getContext(),
-        CL_MEM_READ_WRITE, bufferSize);
+        cl::Buffer * newBuffer = getMemoryPool()->allocateBuffer(device, getBufferSize());
 
         if(hasAnyData()) {
             mCLBuffersIsUpToDate[device] = false;
@@ -302,18 +307,23 @@ void Image::updateOpenCLBufferData(OpenCLDevice::pointer device) {
 }
 
 void Image::transferCLBufferFromHost(OpenCLDevice::pointer device) {
-    unsigned int bufferSize = getBufferSize();
+    TraceScope trace("Image host to device", "transfer");
+    std::size_t bufferSize = getBufferSize();
+    cl::Event event;
     device->getCommandQueue().enqueueWriteBuffer(*mCLBuffers[device],
-        CL_TRUE, 0, bufferSize, mHostData.get());
+        CL_FALSE, 0, bufferSize, mHostData.get(), nullptr, &event);
+    addHostReadEvent(device, event);
 }
 
 void Image::transferCLBufferToHost(OpenCLDevice::pointer device) {
+    TraceScope trace("Image device to host", "transfer");
+    waitForHostReads();
 	if (!mHostHasData) {
 		// Must allocate memory for host data
-		mHostData = allocatePixelArray(mWidth*mHeight*mDepth*mChannels, mType);
+		mHostData = getMemoryPool()->allocateHost(getBufferSize());
 		mHostHasData = true;
 	}
-    unsigned int bufferSize = getBufferSize();
+    std::size_t bufferSize = getBufferSize();
     device->getCommandQueue().enqueueReadBuffer(*mCLBuffers[device],
         CL_TRUE, 0, bufferSize, mHostData.get());
 }
@@ -326,10 +336,7 @@ void Image::updateHostData() {
     bool updated = false;
     if (!mHostHasData) {
         // Data is not initialized, do that first
-        unsigned int size = mWidth*mHeight*mChannels;
-        if(mDimensions == 3)
-            size *= mDepth;
-        mHostData = allocatePixelArray(mWidth*mHeight*mDepth*mChannels,mType);
+        mHostData = getMemoryPool()->allocateHost(getBufferSize());
         if(hasAnyData()) {
             mHostDataIsUpToDate = false;
         } else {
@@ -392,6 +399,7 @@ OpenCLImageAccess::pointer Image::getOpenCLImageAccess(
     	std::lock_guard<std::mutex> lock(mDataIsBeingWrittenToMutex);
         mDataIsBeingWrittenTo = true;
     }
+    loadAllSlabs();
     updateOpenCLImageData(device);
     if (type == ACCESS_READ_WRITE) {
         setAllDataToOutOfDate();
@@ -433,8 +441,11 @@ ImageAccess::pointer Image::getImageAccess(accessType type) {
         std::unique_lock<std::mutex> lock(mDataIsBeingWrittenToMutex);
         mDataIsBeingWrittenTo = true;
     }
+    loadAllSlabs();
     updateHostData();
     if(type == ACCESS_READ_WRITE) {
+        // Transfers to devices may still be reading the host data
+        waitForHostReads();
         setAllDataToOutOfDate();
         updateModifiedTimestamp();
     }
@@ -448,6 +459,16 @@ ImageAccess::pointer Image::getImageAccess(accessType type) {
 	return std::move(accessObject);
 }
 
+void Image::prefetch(OpenCLDevice::pointer device) {
+    if(!isInitialized())
+        throw Exception("Image has not been initialized.");
+
+    blockIfBeingWrittenTo();
+    loadAllSlabs();
+    updateOpenCLImageData(device);
+    mCLImagesIsUpToDate[device] = true;
+}
+
 void Image::create(
         VectorXui size,
         DataType type,
@@ -585,44 +606,71 @@ void Image::create(
 	create(width, height, type, nrOfChannels, DeviceManager::getInstance()->getDefaultComputationDevice(), data);
 }
 
+void Image::create(VectorXui size, DataType type, uint nrOfChannels, unique_pixel_ptr data) {
+    create(size, type, nrOfChannels);
+    mHostData = std::move(data);
+    mHostHasData = true;
+    mHostDataIsUpToDate = true;
+    updateModifiedTimestamp();
+}
+
+void Image::createLazy(VectorXui size, DataType type, uint nrOfChannels, uint slabSize, SlabLoader slabLoader) {
+    if(slabSize == 0)
+        throw Exception("Slab size must be larger than 0");
+    create(size, type, nrOfChannels);
+    // Memory which is never written to is not committed by the OS, thus memory usage scales with the slabs loaded
+    mHostData = allocatePixelArray((std::size_t)mWidth*mHeight*mDepth*mChannels, type);
+    mHostHasData = true;
+    mHostDataIsUpToDate = true;
+    updateModifiedTimestamp();
+    const uint slices = mDimensions == 3 ? mDepth : mHeight;
+    std::lock_guard<std::mutex> lock(m_slabMutex);
+    m_slabSize = slabSize;
+    m_slabLoader = std::move(slabLoader);
+    m_slabIsLoaded = std::vector<bool>((slices + slabSize - 1) / slabSize, false);
+}
+
+void Image::loadSlabs(uint start, uint end) {
+    std::lock_guard<std::mutex> lock(m_slabMutex);
+    if(!m_slabLoader)
+        return;
+    const std::size_t sliceSize = (std::size_t)mWidth*(mDimensions == 3 ? mHeight : 1)*getSizeOfDataType(mType, mChannels);
+    for(uint slab = start / m_slabSize; slab < m_slabIsLoaded.size() && slab*m_slabSize < end; ++slab) {
+        if(m_slabIsLoaded[slab])
+            continue;
+        m_slabLoader(slab, (uchar*)mHostData.get() + slab*m_slabSize*sliceSize);
+        m_slabIsLoaded[slab] = true;
+    }
+    // Release the loader, and any resources it holds, when everything is loaded
+    if(std::all_of(m_slabIsLoaded.begin(), m_slabIsLoaded.end(), [](bool loaded) { return loaded; })) {
+        m_slabLoader = nullptr;
+        m_slabIsLoaded.clear();
+    }
+}
+
+void Image::loadAllSlabs() {
+    loadSlabs(0, mDimensions == 3 ? mDepth : mHeight);
+}
+
 void Image::copyData(ExecutionDevice::pointer device, const void* const data) {
     if(!mIsInitialized)
         throw Exception("Image must be initialized");
     // We do not own this pointer, have to copy it
     if(device->isHost()) {
-        mHostData = allocatePixelArray(mWidth*mHeight*mDepth*mChannels, mType);
-        std::memcpy(mHostData.get(), data, getSizeOfDataType(mType, mChannels) * mWidth * mHeight * mDepth);
+        waitForHostReads();
+        mHostData = getMemoryPool()->allocateHost(getBufferSize());
+        std::memcpy(mHostData.get(), data, getBufferSize());
         mHostHasData = true;
         mHostDataIsUpToDate = true;
         updateModifiedTimestamp();
         mIsInitialized = true;
     } else {
         OpenCLDevice::pointer clDevice = std::static_pointer_cast<OpenCLDevice>(device);
-        cl::Image* clImage;
-        void* tempData;
-        if(mDimensions == 2) {
-            tempData = (void*)adaptDataToImage(data, getOpenCLImageFormat(clDevice, CL_MEM_OBJECT_IMAGE2D, mType,
-                                                                         mChannels).image_channel_order,
-                                              mWidth * mHeight, mType, mChannels);
-            clImage = new cl::Image2D(
-                    clDevice->getContext(),
-                    CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
-                    getOpenCLImageFormat(clDevice, CL_MEM_OBJECT_IMAGE2D, mType, mChannels),
-                    mWidth, mHeight,
-                    0,
-                    tempData
-            );
-        } else {
-            tempData = (void*)adaptDataToImage(data, getOpenCLImageFormat(clDevice, CL_MEM_OBJECT_IMAGE3D, mType, mChannels).image_channel_order, mWidth*mHeight*mDepth, mType, mChannels);
-            clImage = new cl::Image3D(
-                clDevice->getContext(),
-                CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
-                getOpenCLImageFormat(clDevice, CL_MEM_OBJECT_IMAGE3D, mType, mChannels),
-                mWidth, mHeight, mDepth,
-                0, 0,
-                tempData
-            );
-        }
+        cl::ImageFormat format = getOpenCLImageFormat(clDevice, mDimensions == 2 ? CL_MEM_OBJECT_IMAGE2D : CL_MEM_OBJECT_IMAGE3D, mType, mChannels);
+        void* tempData = (void*)adaptDataToImage(data, format.image_channel_order, (std::size_t)mWidth*mHeight*mDepth, mType, mChannels);
+        cl::Image* clImage = createOpenCLImage(clDevice);
+        clDevice->getCommandQueue().enqueueWriteImage(*clImage, CL_TRUE, createOrigoRegion(),
+                createRegion(mWidth, mHeight, mDepth), 0, 0, tempData);
         mCLImages[clDevice] = clImage;
         mCLImagesIsUpToDate[clDevice] = true;
         if(tempData != data) // If a new copy was made, delete it
@@ -636,6 +684,7 @@ void Image::setData(ExecutionDevice::pointer device, void* data) {
         throw Exception("Image must be initialized");
 
     if(device->isHost()) {
+        waitForHostReads();
         // Since we own the data pointer, we can put it in an unique_ptr:
         switch(mType) {
             fastSwitchTypeMacro(mHostData = make_unique_pixel<FAST_TYPE>((FAST_TYPE*)data))
@@ -643,9 +692,15 @@ void Image::setData(ExecutionDevice::pointer device, void* data) {
         mHostHasData = true;
         mHostDataIsUpToDate = true;
     } else {
-        // For OpenCL we have to do a copy
-        copyData(device, data);
-        deleteArray(data, mType); // data was copied, have to delete it
+        // Since we own the data, it is kept as host data while it is transferred in the background
+        waitForHostReads();
+        switch(mType) {
+            fastSwitchTypeMacro(mHostData = make_unique_pixel<FAST_TYPE>((FAST_TYPE*)data))
+        }
+        mHostHasData = true;
+        mHostDataIsUpToDate = true;
+        mIsInitialized = true;
+        prefetch(std::static_pointer_cast<OpenCLDevice>(device));
     }
     updateModifiedTimestamp();
     mIsInitialized = true;
@@ -658,34 +713,39 @@ bool Image::isInitialized() const {
 void Image::free(ExecutionDevice::pointer device) {
     // Delete data on a specific device
     if(device->isHost()) {
+        waitForHostReads();
         mHostData.reset();
         mHostHasData = false;
+        std::lock_guard<std::mutex> lock(m_slabMutex);
+        m_slabLoader = nullptr;
+        m_slabIsLoaded.clear();
     } else {
         OpenCLDevice::pointer clDevice = std::static_pointer_cast<OpenCLDevice>(device);
         // Delete any OpenCL images
-        delete mCLImages[clDevice];
+        if(mCLImages.count(clDevice) > 0)
+            getMemoryPool()->release(mCLImages[clDevice]);
         mCLImages.erase(clDevice);
         mCLImagesIsUpToDate.erase(clDevice);
         // Delete any OpenCL buffers
-        delete mCLBuffers[clDevice];
+        if(mCLBuffers.count(clDevice) > 0)
+            getMemoryPool()->release(mCLBuffers[clDevice]);
         mCLBuffers.erase(clDevice);
         mCLBuffersIsUpToDate.erase(clDevice);
     }
 }
 
 void Image::freeAll() {
-    // Delete OpenCL Images
+    // Give OpenCL images and buffers back to the memory pool
     std::unordered_map<OpenCLDevice::pointer, cl::Image*>::iterator it;
     for (it = mCLImages.begin(); it != mCLImages.end(); it++) {
-        delete it->second;
+        getMemoryPool()->release(it->second);
     }
     mCLImages.clear();
     mCLImagesIsUpToDate.clear();
 
-    // Delete OpenCL buffers
     std::unordered_map<OpenCLDevice::pointer, cl::Buffer*>::iterator it2;
     for (it2 = mCLBuffers.begin(); it2 != mCLBuffers.end(); it2++) {
-        delete it2->second;
+        getMemoryPool()->release(it2->second);
     }
     mCLBuffers.clear();
     mCLBuffersIsUpToDate.clear();
@@ -754,7 +814,7 @@ void Image::calculateMaxAndMinIntensity() {
     // Calculate max and min if image has changed or it is the first time
     if(!mMaxMinInitialized || mMaxMinTimestamp != getTimestamp()) {
 
-        unsigned int nrOfElements = mWidth*mHeight*mDepth*mChannels;
+        std::size_t nrOfElements = (std::size_t)mWidth*mHeight*mDepth*mChannels;
         if(mHostHasData && mHostDataIsUpToDate) {
             // Host data is up to date, calculate min and max on host
             ImageAccess::pointer access = getImageAccess(ACCESS_READ);
@@ -832,7 +892,7 @@ float Image::calculateAverageIntensity() {
 
     // Calculate max and min if image has changed or it is the first time
     if(!mAverageInitialized || mAverageIntensityTimestamp != getTimestamp()) {
-        unsigned int nrOfElements = mWidth*mHeight*mDepth;
+        std::size_t nrOfElements = (std::size_t)mWidth*mHeight*mDepth;
         if(mHostHasData && mHostDataIsUpToDate) {
             reportInfo() << "calculating sum on host" << Reporter::end();
             // Host data is up to date, calculate min and max on host
@@ -943,6 +1003,7 @@ void Image::createFromImage(
 
 Image::pointer Image::copy(ExecutionDevice::pointer device) {
     Image::pointer clone = Image::New();
+    clone->setMemoryPool(getMemoryPool());
     clone->createFromImage(std::static_pointer_cast<Image>(mPtr.lock()));
 
     // If device is host, get data from this image to host
@@ -1029,24 +1090,8 @@ void Image::fill(float value) {
     } catch(...) {
     	// Has no data
     	// Create an OpenCL image
-    	cl::Image* clImage;
         OpenCLDevice::pointer clDevice = std::dynamic_pointer_cast<OpenCLDevice>(DeviceManager::getInstance()->getDefaultComputationDevice());
-    	if(getDimensions() == 2) {
-			clImage = new cl::Image2D(
-				clDevice->getContext(),
-				CL_MEM_READ_WRITE,
-				getOpenCLImageFormat(clDevice, CL_MEM_OBJECT_IMAGE2D, mType, mChannels),
-				mWidth, mHeight
-			);
-    	} else {
-			clImage = new cl::Image3D(
-				clDevice->getContext(),
-				CL_MEM_READ_WRITE,
-				getOpenCLImageFormat(clDevice, CL_MEM_OBJECT_IMAGE3D, mType, mChannels),
-				mWidth, mHeight, mDepth
-			);
-    	}
-		mCLImages[clDevice] = clImage;
+		mCLImages[clDevice] = createOpenCLImage(clDevice);
 		mCLImagesIsUpToDate[clDevice] = true;
 		device = clDevice;
 		isOpenCLImage = true;
@@ -1109,7 +1154,11 @@ void Image::fill(float value) {
 }
 
 Image::pointer Image::crop(VectorXi offset, VectorXi size, bool allowOutOfBoundsCropping) {
+    if(offset.size() < getDimensions() || size.size() < getDimensions())
+        throw Exception("offset and size vectors given to Image::crop must have at least as many elements as the image has dimensions");
+
     Image::pointer newImage = Image::New();
+    newImage->setMemoryPool(getMemoryPool());
 
     bool needInitialization = false;
     VectorXi newImageSize = size;
@@ -1121,7 +1170,13 @@ Image::pointer Image::crop(VectorXi offset, VectorXi size, bool allowOutOfBounds
     	if(offset.x() < 0 || offset.y() < 0 || (getDimensions() == 3 && offset.z() < 0)) {
     		throw Exception("Out of bounds cropping not allowed, but offset was below 0.");
     	}
-    	// TODO validate size
+    	// Validate size
+    	for(int i = 0; i < getDimensions(); ++i) {
+    		if(size[i] <= 0)
+    			throw Exception("Size given to Image::crop must be above 0.");
+    		if(offset[i] + size[i] > (int)getSize()[i])
+    			throw Exception("Out of bounds cropping not allowed, but offset + size was larger than the image.");
+    	}
     } else {
     	// Calculate offsets and sizes
     	for(int i = 0; i < offset.size(); ++i) {
@@ -1145,17 +1200,11 @@ Image::pointer Image::crop(VectorXi offset, VectorXi size, bool allowOutOfBounds
     // Handle host
 
     OpenCLDevice::pointer clDevice;
-    if(device->isHost()) { // If data is only on host, copy data to GPU first
-        // TODO implement cropping on host instead
-        clDevice = std::dynamic_pointer_cast<OpenCLDevice>(DeviceManager::getInstance()->getDefaultComputationDevice());
-        copyData(clDevice, mHostData.get());
-    } else {
+    if(device->isHost()) {
+        // Crop on host, thus only the part of the image which is cropped is touched
+        newImage = cropOnHost(newImageSize, copySourceOffset, copyDestinationOffset, copySize, needInitialization);
+    } else if(getDimensions() == 2) {
         clDevice = std::static_pointer_cast<OpenCLDevice>(device);
-    }
-
-    if(getDimensions() == 2) {
-        if(offset.size() < 2 || size.size() < 2)
-            throw Exception("offset and size vectors given to Image::crop must have at least 2 channels");
         newImage->create(newImageSize.cast<uint>(), getDataType(), getNrOfChannels());
         if(needInitialization)
             newImage->fill(0);
@@ -1182,8 +1231,7 @@ Image::pointer Image::crop(VectorXi offset, VectorXi size, bool allowOutOfBounds
                 createRegion(copySize.x(), copySize.y(), 1)
         );
     } else {
-        if(offset.size() < 3 || size.size() < 3)
-            throw Exception("offset and size vectors given to Image::crop must have at least 3 channels");
+        clDevice = std::static_pointer_cast<OpenCLDevice>(device);
         newImage->create(newImageSize.cast<uint>(), getDataType(), getNrOfChannels());
         if(needInitialization)
             newImage->fill(0);
@@ -1212,6 +1260,46 @@ Image::pointer Image::crop(VectorXi offset, VectorXi size, bool allowOutOfBounds
     return newImage;
 }
 
+Image::pointer Image::cropOnHost(VectorXi size, VectorXi copySourceOffset, VectorXi copyDestinationOffset, VectorXi copySize, bool needInitialization) {
+    const bool is3D = getDimensions() == 3;
+    const int newWidth = size.x();
+    const int newHeight = size.y();
+    const int newDepth = is3D ? size.z() : 1;
+    const int copyDepth = is3D ? copySize.z() : 1;
+    const int sourceZ = is3D ? copySourceOffset.z() : 0;
+    const int destinationZ = is3D ? copyDestinationOffset.z() : 0;
+    const std::size_t pixelSize = getSizeOfDataType(mType, mChannels);
+
+    blockIfBeingWrittenTo();
+    if(is3D) {
+        loadSlabs(std::max(sourceZ, 0), std::max(sourceZ + copyDepth, 0));
+    } else {
+        loadSlabs(std::max(copySourceOffset.y(), 0), std::max(copySourceOffset.y() + copySize.y(), 0));
+    }
+
+    auto data = getMemoryPool()->allocateHost((std::size_t)newWidth*newHeight*newDepth*pixelSize);
+    if(needInitialization)
+        std::memset(data.get(), 0, (std::size_t)newWidth*newHeight*newDepth*pixelSize);
+    const auto source = (const uchar*)mHostData.get();
+    const auto destination = (uchar*)data.get();
+    if(copySize.x() > 0 && copySize.y() > 0 && copyDepth > 0) {
+        for(int z = 0; z < copyDepth; ++z) {
+            for(int y = 0; y < copySize.y(); ++y) {
+                std::memcpy(
+                    destination + (((std::size_t)(z + destinationZ)*newHeight + y + copyDestinationOffset.y())*newWidth + copyDestinationOffset.x())*pixelSize,
+                    source + (((std::size_t)(z + sourceZ)*mHeight + y + copySourceOffset.y())*mWidth + copySourceOffset.x())*pixelSize,
+                    copySize.x()*pixelSize
+                );
+            }
+        }
+    }
+
+    auto newImage = Image::New();
+    newImage->setMemoryPool(getMemoryPool());
+    newImage->create(size.cast<uint>(), mType, mChannels, std::move(data));
+    return newImage;
+}
+
 BoundingBox Image::getTransformedBoundingBox() const {
     AffineTransformation::pointer T = SceneGraph::getAffineTransformationFromNode(getSceneGraphNode());
 
@@ -1229,8 +1317,8 @@ BoundingBox Image::getBoundingBox() const {
     return SpatialDataObject::getBoundingBox().getTransformedBoundingBox(T);
 }
 
-int Image::getNrOfVoxels() const {
-    return mWidth*mHeight*mDepth;
+std::size_t Image::getNrOfVoxels() const {
+    return (std::size_t)mWidth*mHeight*mDepth;
 }
 
 Image::~Image() {
@@ -6,13 +6,12 @@
 #include <FAST/Data/Access/ImageAccess.hpp>
 #include <FAST/Data/Access/OpenCLImageAccess.hpp>
 #include <FAST/Data/Access/OpenCLBufferAccess.hpp>
+#include <FAST/Data/MemoryPool.hpp>
 #include <FAST/DeviceManager.hpp>
 #include <unordered_map>
 
 namespace fast {
 
-using pixel_deleter_t = std::function<void(void *)>;
-using unique_pixel_ptr = std::unique_ptr<void, pixel_deleter_t>;
 template<typename T>
 auto pixel_deleter(void const * data) -> void
 {
@@ -26,6 +25,10 @@ auto make_unique_pixel(T * ptr) -> unique_pixel_ptr {
     return unique_pixel_ptr(ptr, &pixel_deleter<T>);
 }
 unique_pixel_ptr allocatePixelArray(std::size_t size, DataType type);
+/**
+ * Function which fills in the given slab of an image, see Image::createLazy
+ */
+using SlabLoader = std::function<void(uint slab, void* destination)>;
 
 class FAST_EXPORT  Image : public SpatialDataObject {
     FAST_OBJECT(Image)
@@ -202,9 +205,40 @@ class FAST_EXPORT  Image : public SpatialDataObject {
         template <class T>
         void create(VectorXui, DataType type, uint nrOfChannels, std::unique_ptr<T> ptr);
 
+        /**
+         * Moves host data with a custom deleter to the host, no data is copied.
+         * This can be used to wrap memory which is not allocated with new[], such as a memory mapped file.
+         *
+         * @param size
+         * @param type
+         * @param nrOfChannels
+         * @param data
+         */
+        void create(VectorXui size, DataType type, uint nrOfChannels, unique_pixel_ptr data);
+        /**
+         * Setup a 2D/3D image on the host where the data is loaded lazily in slabs.
+         * A slab is slabSize slices (rows for 2D images), and the slab loader is called to fill in a slab
+         * the first time it is needed. crop only loads the slabs it needs, while all other accesses load the entire image.
+         *
+         * @param size
+         * @param type
+         * @param nrOfChannels
+         * @param slabSize
+         * @param slabLoader
+         */
+        void createLazy(VectorXui size, DataType type, uint nrOfChannels, uint slabSize, SlabLoader slabLoader);
+
         OpenCLImageAccess::pointer getOpenCLImageAccess(accessType type, OpenCLDevice::pointer);
         OpenCLBufferAccess::pointer getOpenCLBufferAccess(accessType type, OpenCLDevice::pointer);
         ImageAccess::pointer getImageAccess(accessType type);
+        /**
+         * Start transferring the image to the given device, without waiting for the transfer to finish.
+         * Kernels using the image on this device are enqueued after the transfer, thus they will not
+         * wait for it on the host. Streamers use this to upload the next frame while the previous frame is processed.
+         *
+         * @param device
+         */
+        void prefetch(OpenCLDevice::pointer device);
 
         ~Image();
 
@@ -214,7 +248,11 @@ class FAST_EXPORT  Image : public SpatialDataObject {
         /**
          * @return the number of pixels/voxels width*height*depth
          */
-        int getNrOfVoxels() const;
+        std::size_t getNrOfVoxels() const;
+        /**
+         * @return the size of the pixel data in bytes
+         */
+        std::size_t getBufferSize() const;
         Vector3ui getSize() const;
         uchar getDimensions() const;
         DataType getDataType() const;
@@ -296,8 +334,21 @@ class FAST_EXPORT  Image : public SpatialDataObject {
         void updateHostData();
 
         bool hasAnyData();
+        // Get an OpenCL image with the size and format of this image from the memory pool
+        cl::Image* createOpenCLImage(OpenCLDevice::pointer device);
+
+        // Lazy loading of host data, see createLazy
+        SlabLoader m_slabLoader;
+        uint m_slabSize = 0;
+        std::vector<bool> m_slabIsLoaded;
+        std::mutex m_slabMutex;
+        /**
+         * Make sure the slabs covering the slices (rows for 2D images) from start to end are loaded
+         */
+        void loadSlabs(uint start, uint end);
+        void loadAllSlabs();
+        Image::pointer cropOnHost(VectorXi size, VectorXi copySourceOffset, VectorXi copyDestinationOffset, VectorXi copySize, bool needInitialization);
 
-        uint getBufferSize() const;
 
         uint mWidth, mHeight, mDepth;
         uchar mDimensions;
@@ -0,0 +1,286 @@
+#include "MemoryPool.hpp"
+#include <new>
+
+namespace fast {
+
+static std::size_t getBytesPerPixel(cl::ImageFormat format) {
+    std::size_t channels;
+    switch(format.image_channel_order) {
+        case CL_RG:
+        case CL_RA:
+            channels = 2;
+            break;
+        case CL_RGB:
+            channels = 3;
+            break;
+        case CL_RGBA:
+        case CL_BGRA:
+        case CL_ARGB:
+            channels = 4;
+            break;
+        default:
+            channels = 1;
+    }
+    std::size_t bytes;
+    switch(format.image_channel_data_type) {
+        case CL_SIGNED_INT8:
+        case CL_UNSIGNED_INT8:
+        case CL_SNORM_INT8:
+        case CL_UNORM_INT8:
+            bytes = 1;
+            break;
+        case CL_SIGNED_INT16:
+        case CL_UNSIGNED_INT16:
+        case CL_SNORM_INT16:
+        case CL_UNORM_INT16:
+        case CL_HALF_FLOAT:
+            bytes = 2;
+            break;
+        default:
+            bytes = 4;
+    }
+    return channels*bytes;
+}
+
+/**
+ * OpenCL objects which have been handed out by any pool, and the pool which allocated them.
+ * Data objects may have their pool changed after allocating storage, so the object has to be given
+ * back to the pool which allocated it, not the one the data object uses when it is released.
+ */
+static std::mutex& getOwnersMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+static std::unordered_map<void*, std::weak_ptr<MemoryPool>>& getOwners() {
+    static std::unordered_map<void*, std::weak_ptr<MemoryPool>> owners;
+    return owners;
+}
+
+MemoryPool::pointer MemoryPool::getDefault() {
+    static MemoryPool::pointer pool = MemoryPool::New();
+    return pool;
+}
+
+MemoryPool::MemoryPool() {
+}
+
+MemoryPool::~MemoryPool() {
+    clear();
+}
+
+bool MemoryPool::Key::operator==(const Key& other) const {
+    return kind == other.kind && device == other.device && bytes == other.bytes &&
+        width == other.width && height == other.height && depth == other.depth &&
+        channelOrder == other.channelOrder && channelType == other.channelType;
+}
+
+std::size_t MemoryPool::KeyHash::operator()(const Key& key) const {
+    std::size_t hash = std::hash<std::size_t>()(key.bytes);
+    const auto combine = [&hash](std::size_t value) {
+        hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    };
+    combine(key.kind);
+    combine(std::hash<void*>()(key.device));
+    combine(key.width);
+    combine(key.height);
+    combine(key.depth);
+    combine(key.channelOrder);
+    combine(key.channelType);
+    return hash;
+}
+
+void MemoryPool::setMaximumCachedSize(std::size_t bytes) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_maximumCachedSize = bytes;
+    evict(lock);
+}
+
+std::size_t MemoryPool::getMaximumCachedSize() const {
+    return m_maximumCachedSize;
+}
+
+void* MemoryPool::acquire(const Key& key) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto found = m_cachedByKey.find(key);
+    if(found == m_cachedByKey.end()) {
+        m_statistics.misses += 1;
+        return nullptr;
+    }
+    // Reuse the most recently released storage of this size and format
+    auto it = found->second.back();
+    found->second.pop_back();
+    if(found->second.empty())
+        m_cachedByKey.erase(found);
+    Entry entry = *it;
+    m_cached.erase(it);
+    m_statistics.cachedBytes -= key.bytes;
+    m_statistics.cachedObjects -= 1;
+    m_statistics.hits += 1;
+    if(key.kind != STORAGE_HOST)
+        handOut(entry);
+    return entry.object;
+}
+
+void MemoryPool::handOut(const Entry& entry) {
+    m_outstanding[entry.object] = entry;
+    std::lock_guard<std::mutex> lock(getOwnersMutex());
+    getOwners()[entry.object] = std::static_pointer_cast<MemoryPool>(mPtr.lock());
+}
+
+unique_pixel_ptr MemoryPool::allocateHost(std::size_t bytes) {
+    Key key = {STORAGE_HOST, nullptr, bytes, 0, 0, 0, 0, 0};
+    void* data = acquire(key);
+    if(data == nullptr)
+        data = ::operator new[](bytes, std::align_val_t(64));
+
+    // The deleter must work even if this pool has been deleted
+    std::weak_ptr<MemoryPool> weakPool = std::static_pointer_cast<MemoryPool>(mPtr.lock());
+    return unique_pixel_ptr(data, [weakPool, bytes](void* data) {
+        auto pool = weakPool.lock();
+        if(pool) {
+            pool->releaseHost(data, bytes);
+        } else {
+            ::operator delete[](data, std::align_val_t(64));
+        }
+    });
+}
+
+void MemoryPool::releaseHost(void* data, std::size_t bytes) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    Entry entry = {{STORAGE_HOST, nullptr, bytes, 0, 0, 0, 0, 0}, data, nullptr};
+    m_cached.push_front(entry);
+    m_cachedByKey[entry.key].push_back(m_cached.begin());
+    m_statistics.cachedBytes += bytes;
+    m_statistics.cachedObjects += 1;
+    evict(lock);
+}
+
+cl::Image* MemoryPool::allocateImage(OpenCLDevice::pointer device, uchar dimensions, cl::ImageFormat format, uint width, uint height, uint depth) {
+    if(dimensions == 2)
+        depth = 1;
+    Key key = {STORAGE_IMAGE, device.get(), getBytesPerPixel(format)*width*height*depth, width, height, depth,
+               format.image_channel_order, format.image_channel_data_type};
+    cl::Image* image = (cl::Image*)acquire(key);
+    if(image != nullptr)
+        return image;
+
+    if(dimensions == 2) {
+        image = new cl::Image2D(device->getContext(), CL_MEM_READ_WRITE, format, width, height);
+    } else {
+        image = new cl::Image3D(device->getContext(), CL_MEM_READ_WRITE, format, width, height, depth);
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    handOut({key, image, device});
+    return image;
+}
+
+cl::Buffer* MemoryPool::allocateBuffer(OpenCLDevice::pointer device, std::size_t bytes) {
+    Key key = {STORAGE_BUFFER, device.get(), bytes, 0, 0, 0, 0, 0};
+    cl::Buffer* buffer = (cl::Buffer*)acquire(key);
+    if(buffer != nullptr)
+        return buffer;
+
+    buffer = new cl::Buffer(device->getContext(), CL_MEM_READ_WRITE, bytes);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    handOut({key, buffer, device});
+    return buffer;
+}
+
+void MemoryPool::release(cl::Image* image) {
+    if(image == nullptr)
+        return;
+    releaseObject(image);
+}
+
+void MemoryPool::release(cl::Buffer* buffer) {
+    if(buffer == nullptr)
+        return;
+    releaseObject(buffer);
+}
+
+void MemoryPool::releaseObject(void* object) {
+    MemoryPool::pointer owner;
+    {
+        std::lock_guard<std::mutex> lock(getOwnersMutex());
+        auto found = getOwners().find(object);
+        if(found != getOwners().end()) {
+            owner = found->second.lock();
+            getOwners().erase(found);
+        }
+    }
+    if(!owner) {
+        // Not allocated by a pool, it was created with other flags or host data, thus it can't be reused.
+        // Objects of a pool which has been deleted end up here as well.
+        // The pointer is either a cl::Image or a cl::Buffer, both only wrap a cl_mem.
+        delete (cl::Memory*)object;
+        return;
+    }
+    owner->releaseOutstanding(object);
+}
+
+void MemoryPool::releaseOutstanding(void* object) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto it = m_outstanding.find(object);
+    Entry entry = it->second;
+    m_outstanding.erase(it);
+    m_cached.push_front(entry);
+    m_cachedByKey[entry.key].push_back(m_cached.begin());
+    m_statistics.cachedBytes += entry.key.bytes;
+    m_statistics.cachedObjects += 1;
+    evict(lock);
+}
+
+void MemoryPool::evict(std::unique_lock<std::mutex>& lock) {
+    std::vector<Entry> evicted;
+    while(m_statistics.cachedBytes > m_maximumCachedSize && !m_cached.empty()) {
+        Entry entry = m_cached.back();
+        // The least recently released entry is also the first of its size and format
+        auto found = m_cachedByKey.find(entry.key);
+        found->second.pop_front();
+        if(found->second.empty())
+            m_cachedByKey.erase(found);
+        m_cached.pop_back();
+        m_statistics.cachedBytes -= entry.key.bytes;
+        m_statistics.cachedObjects -= 1;
+        m_statistics.evictions += 1;
+        evicted.push_back(entry);
+    }
+    lock.unlock();
+    for(auto&& entry : evicted)
+        deleteEntry(entry);
+}
+
+void MemoryPool::deleteEntry(const Entry& entry) {
+    switch(entry.key.kind) {
+        case STORAGE_HOST:
+            ::operator delete[](entry.object, std::align_val_t(64));
+            break;
+        case STORAGE_IMAGE:
+            delete (cl::Image*)entry.object;
+            break;
+        case STORAGE_BUFFER:
+            delete (cl::Buffer*)entry.object;
+            break;
+    }
+}
+
+MemoryPool::Statistics MemoryPool::getStatistics() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_statistics;
+}
+
+void MemoryPool::clear() {
+    std::list<Entry> cached;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        cached.swap(m_cached);
+        m_cachedByKey.clear();
+        m_statistics.cachedBytes = 0;
+        m_statistics.cachedObjects = 0;
+    }
+    for(auto&& entry : cached)
+        deleteEntry(entry);
+}
+
+}
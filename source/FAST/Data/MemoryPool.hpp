@@ -0,0 +1,120 @@
+#pragma once
+
+#include <FAST/Data/DataTypes.hpp>
+#include <list>
+#include <deque>
+#include <mutex>
+
+namespace fast {
+
+/**
+ * Pool of host pixel arrays, OpenCL images and OpenCL buffers.
+ *
+ * When a streaming pipeline creates a new output frame every timestep, all memory of the previous frame
+ * is freed, and the same amount of memory is allocated again for the next frame.
+ * Image and Tensor therefore get their storage from a memory pool, and give it back to the pool when they are freed.
+ * Storage with the same size and format is recycled, thus a pipeline in steady state does not allocate anything.
+ *
+ * Released storage is kept in the pool until the maximum cached size is reached,
+ * then the least recently released storage is deleted.
+ * Every data object uses the default pool, unless another pool is set on the process object or PipelineExecutor
+ * which creates it. This can be used to give each pipeline its own limit and statistics.
+ */
+class FAST_EXPORT MemoryPool : public Object {
+    FAST_OBJECT(MemoryPool)
+    public:
+        struct Statistics {
+            // Nr of allocations which reused storage from the pool
+            uint64_t hits = 0;
+            // Nr of allocations which had to allocate new storage
+            uint64_t misses = 0;
+            // Nr of released objects which were deleted because the pool was full
+            uint64_t evictions = 0;
+            // Nr of objects and bytes currently kept in the pool
+            std::size_t cachedObjects = 0;
+            std::size_t cachedBytes = 0;
+        };
+        /**
+         * @return the memory pool used by data objects when no other pool has been set
+         */
+        static MemoryPool::pointer getDefault();
+        /**
+         * Set the maximum number of bytes of released storage which is kept in the pool.
+         * Default is 256 MB. Setting this to 0 disables recycling.
+         * @param bytes
+         */
+        void setMaximumCachedSize(std::size_t bytes);
+        std::size_t getMaximumCachedSize() const;
+        /**
+         * Get uninitialized host memory, aligned to 64 bytes.
+         * The memory is returned to the pool when the pointer is destroyed.
+         * @param bytes
+         */
+        unique_pixel_ptr allocateHost(std::size_t bytes);
+        /**
+         * Get an OpenCL image of the given size and format. Give it back with release.
+         */
+        cl::Image* allocateImage(OpenCLDevice::pointer device, uchar dimensions, cl::ImageFormat format, uint width, uint height, uint depth = 1);
+        /**
+         * Get an OpenCL buffer of the given size in bytes. Give it back with release.
+         */
+        cl::Buffer* allocateBuffer(OpenCLDevice::pointer device, std::size_t bytes);
+        /**
+         * Give an image back to the pool which allocated it, even if that is not this pool.
+         * Images which were not allocated by any pool, or whose pool has been deleted, are deleted.
+         */
+        void release(cl::Image* image);
+        /**
+         * Give a buffer back to the pool which allocated it, even if that is not this pool.
+         * Buffers which were not allocated by any pool, or whose pool has been deleted, are deleted.
+         */
+        void release(cl::Buffer* buffer);
+        Statistics getStatistics();
+        /**
+         * Delete all storage kept in the pool
+         */
+        void clear();
+        ~MemoryPool();
+    protected:
+        MemoryPool();
+    private:
+        enum StorageKind { STORAGE_HOST, STORAGE_IMAGE, STORAGE_BUFFER };
+        struct Key {
+            StorageKind kind;
+            OpenCLDevice* device;
+            std::size_t bytes;
+            uint width, height, depth;
+            cl_channel_order channelOrder;
+            cl_channel_type channelType;
+            bool operator==(const Key& other) const;
+        };
+        struct KeyHash {
+            std::size_t operator()(const Key& key) const;
+        };
+        struct Entry {
+            Key key;
+            void* object;
+            // Keeps the device alive as long as the pool has storage belonging to it
+            OpenCLDevice::pointer device;
+        };
+
+        void* acquire(const Key& key);
+        void handOut(const Entry& entry);
+        void releaseObject(void* object);
+        void releaseOutstanding(void* object);
+        void releaseHost(void* data, std::size_t bytes);
+        static void deleteEntry(const Entry& entry);
+        void evict(std::unique_lock<std::mutex>& lock);
+
+        std::mutex m_mutex;
+        // Released storage, the most recently released first
+        std::list<Entry> m_cached;
+        // Released storage of each size and format, the least recently released first
+        std::unordered_map<Key, std::deque<std::list<Entry>::iterator>, KeyHash> m_cachedByKey;
+        // OpenCL objects which have been handed out, and what they are
+        std::unordered_map<void*, Entry> m_outstanding;
+        std::size_t m_maximumCachedSize = 256*1024*1024;
+        Statistics m_statistics;
+};
+
+}
@@ -1,12 +1,26 @@
 #include "Tensor.hpp"
 #include <FAST/Utility.hpp>
 #include <FAST/Data/Access/OpenCLBufferAccess.hpp>
+#include <FAST/Data/MemoryPool.hpp>
 
 namespace fast {
 
+std::shared_ptr<float> Tensor::allocateHostStorage(std::size_t size) {
+    auto data = getMemoryPool()->allocateHost(size*sizeof(float));
+    auto deleter = data.get_deleter();
+    return std::shared_ptr<float>((float*)data.release(), deleter);
+}
+
 void Tensor::create(std::unique_ptr<float[]> data, TensorShape shape) {
+    create(std::shared_ptr<float>(data.release(), std::default_delete<float[]>()), shape);
+}
+
+void Tensor::create(std::shared_ptr<float> data, TensorShape shape) {
     if(shape.empty())
         throw Exception("Shape can't be empty");
+    if(!data)
+        throw Exception("Data given to Tensor::create was empty");
+    waitForHostReads();
     m_data = std::move(data);
     m_shape = shape;
     m_spacing = VectorXf::Ones(shape.getDimensions());
@@ -23,7 +37,9 @@ void Tensor::create(TensorShape shape) {
         throw Exception("Shape can't be empty");
     if(shape.getUnknownDimensions() > 0)
         throw Exception("When creating a tensor, shape must be fully defined");
-    m_data = make_uninitialized_unique<float[]>(shape.getTotalSize());
+    waitForHostReads();
+    m_data = allocateHostStorage(shape.getTotalSize());
+    m_shape = shape;
     m_spacing = VectorXf::Ones(shape.getDimensions());
     mHostDataIsUpToDate = true;
     if(m_shape.getDimensions() >= 3) {
@@ -37,10 +53,11 @@ void Tensor::create(std::initializer_list<float> data) {
 	if(data.size() == 0)
 		throw Exception("Shape can't be empty");
 
-	m_data = std::make_unique<float[]>(data.size());
+    waitForHostReads();
+	m_data = allocateHostStorage(data.size());
 	int i = 0;
 	for(auto item : data) {
-		m_data[i] = item;
+		m_data.get()[i] = item;
 		++i;
 	}
 	m_shape = TensorShape({ (int)data.size() });
@@ -66,11 +83,23 @@ TensorShape Tensor::getShape() const {
     return m_shape;
 }
 
+void Tensor::updateFromParent() {
+    auto parent = m_parent.lock();
+    if(!parent || parent->mHostDataIsUpToDate)
+        return;
+    // The parent has been modified on a device, transfer it to the shared host storage
+    parent->updateHostData();
+    parent->mHostDataIsUpToDate = true;
+    setAllDataToOutOfDate();
+    mHostDataIsUpToDate = true;
+}
+
 TensorAccess::pointer Tensor::getAccess(accessType type) {
     if(!isInitialized())
         throw Exception("Tensor has not been initialized.");
 
     blockIfBeingWrittenTo();
+    updateFromParent();
 
     if(type == ACCESS_READ_WRITE) {
     	blockIfBeingAccessed();
@@ -79,8 +108,18 @@ TensorAccess::pointer Tensor::getAccess(accessType type) {
     }
     updateHostData();
     if(type == ACCESS_READ_WRITE) {
+        // Transfers to devices may still be reading the host data
+        waitForHostReads();
         setAllDataToOutOfDate();
         updateModifiedTimestamp();
+        // The host storage is shared with the parent of a view, thus its device data is out of date as well
+        auto parent = m_parent.lock();
+        if(parent) {
+            parent->waitForHostReads();
+            parent->setAllDataToOutOfDate();
+            parent->mHostDataIsUpToDate = true;
+            parent->updateModifiedTimestamp();
+        }
     }
     mHostDataIsUpToDate = true;
     {
@@ -92,19 +131,22 @@ TensorAccess::pointer Tensor::getAccess(accessType type) {
 
 void Tensor::free(ExecutionDevice::pointer device) {
     if(device->isHost()) {
+        waitForHostReads();
         m_data.reset();
     } else {
         auto clDevice = std::dynamic_pointer_cast<OpenCLDevice>(device);
-        delete mCLBuffers[clDevice];
+        if(mCLBuffers.count(clDevice) > 0)
+            getMemoryPool()->release(mCLBuffers[clDevice]);
         mCLBuffers.erase(clDevice);
         mCLBuffersIsUpToDate.erase(clDevice);
     }
 }
 
 void Tensor::freeAll() {
+    waitForHostReads();
     m_data.reset();
     for(auto buffer : mCLBuffers) {
-        delete buffer.second;
+        getMemoryPool()->release(buffer.second);
     }
     mCLBuffers.clear();
     mCLBuffersIsUpToDate.clear();
@@ -113,8 +155,11 @@ void Tensor::freeAll() {
 OpenCLBufferAccess::pointer Tensor::getOpenCLBufferAccess(accessType type, OpenCLDevice::pointer device) {
     if(!isInitialized())
         throw Exception("Tensor has not been initialized.");
+    if(type == ACCESS_READ_WRITE && !m_parent.expired())
+        throw Exception("Tensor views can not be written to with an OpenCL buffer access, use a host access instead");
 
     blockIfBeingWrittenTo();
+    updateFromParent();
 
     if(type == ACCESS_READ_WRITE) {
     	blockIfBeingAccessed();
@@ -154,12 +199,7 @@ void Tensor::updateOpenCLBufferData(OpenCLDevice::pointer device) {
     bool updated = false;
     if(mCLBuffers.count(device) == 0) {
         // Data is not on device, create it
-        unsigned int bufferSize = getShape().getTotalSize()*4;
-        cl::Buffer * newBuffer = new cl::Buffer(
-                device->getContext(),
-                CL_MEM_READ_WRITE,
-                bufferSize
-        );
+        cl::Buffer * newBuffer = getMemoryPool()->allocateBuffer(device, getShape().getTotalSize()*4);
 
         if(hasAnyData()) {
             mCLBuffersIsUpToDate[device] = false;
@@ -185,14 +225,18 @@ void Tensor::updateOpenCLBufferData(OpenCLDevice::pointer device) {
 
 void Tensor::transferCLBufferFromHost(OpenCLDevice::pointer device) {
     std::size_t bufferSize = m_shape.getTotalSize()*4;
+    // Non-blocking, kernels using the buffer are enqueued after the write in the same in-order queue
+    cl::Event event;
     device->getCommandQueue().enqueueWriteBuffer(*mCLBuffers[device],
-        CL_TRUE, 0, bufferSize, getHostDataPointer());
+        CL_FALSE, 0, bufferSize, getHostDataPointer(), nullptr, &event);
+    addHostReadEvent(device, event);
 }
 
 void Tensor::transferCLBufferToHost(OpenCLDevice::pointer device) {
+    waitForHostReads();
 	if(!m_data) {
 		// Must allocate memory for host data
-        m_data = make_uninitialized_unique<float[]>(m_shape.getTotalSize());
+        m_data = allocateHostStorage(m_shape.getTotalSize());
 	}
     std::size_t bufferSize = m_shape.getTotalSize()*4;
     device->getCommandQueue().enqueueReadBuffer(*mCLBuffers[device],
@@ -216,7 +260,7 @@ void Tensor::updateHostData() {
     bool updated = false;
     if(!m_data) {
         // Data is not initialized, do that first
-        m_data = make_uninitialized_unique<float[]>(m_shape.getTotalSize());
+        m_data = allocateHostStorage(m_shape.getTotalSize());
 
         if(hasAnyData()) {
             mHostDataIsUpToDate = false;
@@ -260,6 +304,31 @@ void Tensor::deleteDimension(int i) {
     }
 }
 
+Tensor::pointer Tensor::getSlice(int index) {
+    if(!isInitialized())
+        throw Exception("Tensor has not been initialized.");
+    if(m_shape.getDimensions() < 2)
+        throw Exception("Tensor must have at least 2 dimensions to get a slice");
+    if(index < 0 || index >= m_shape[0])
+        throw Exception("Slice index " + std::to_string(index) + " is out of bounds in Tensor::getSlice");
+
+    TensorShape sliceShape;
+    for(int i = 1; i < m_shape.getDimensions(); ++i)
+        sliceShape.addDimension(m_shape[i]);
+
+    // The view points into the storage of this tensor, but shares ownership of it
+    auto access = getAccess(ACCESS_READ);
+    auto data = access->getSharedRawData();
+    auto view = Tensor::New();
+    view->create(std::shared_ptr<float>(data, data.get() + index*sliceShape.getTotalSize()), sliceShape);
+    VectorXf spacing = VectorXf::Ones(sliceShape.getDimensions());
+    for(int i = 0; i < sliceShape.getDimensions(); ++i)
+        spacing[i] = m_spacing[i + 1];
+    view->setSpacing(spacing);
+    view->m_parent = std::static_pointer_cast<Tensor>(mPtr.lock());
+    return view;
+}
+
 BoundingBox Tensor::getTransformedBoundingBox() const {
     AffineTransformation::pointer T = SceneGraph::getAffineTransformationFromNode(getSceneGraphNode());
 
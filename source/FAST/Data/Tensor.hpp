@@ -18,6 +18,14 @@ class FAST_EXPORT Tensor : public SpatialDataObject {
          * @param shape
          */
         virtual void create(std::unique_ptr<float[]> data, TensorShape shape);
+        /**
+         * Create a tensor which uses externally owned, reference counted storage without copying it.
+         * The storage is released with the deleter of the shared pointer when no tensor or view uses it anymore.
+         * Inference engines use this to give their own output buffers to FAST.
+         * @param data must point to at least shape.getTotalSize() floats
+         * @param shape
+         */
+        virtual void create(std::shared_ptr<float> data, TensorShape shape);
         /**
          * Create an unitialized tensor with the provided shape
          * @param shape
@@ -41,6 +49,15 @@ class FAST_EXPORT Tensor : public SpatialDataObject {
         virtual void setSpacing(VectorXf spacing);
         virtual VectorXf getSpacing() const;
         virtual void deleteDimension(int dimension);
+        /**
+         * Get element index along the first dimension as a tensor, without copying any data.
+         * The view shares host storage with this tensor, and keeps it alive.
+         * Data written to the view with a host access is visible in this tensor, and invalidates the OpenCL
+         * buffers of this tensor. Views can not be written to with an OpenCL buffer access.
+         * @param index
+         * @return tensor with the first dimension removed
+         */
+        virtual Tensor::pointer getSlice(int index);
 
         virtual BoundingBox getTransformedBoundingBox() const override;
         virtual BoundingBox getBoundingBox() const override;
@@ -56,8 +73,21 @@ class FAST_EXPORT Tensor : public SpatialDataObject {
         virtual bool hasAnyData();
         void updateHostData();
         virtual float* getHostDataPointer();
+        /**
+         * Allocate host storage from the memory pool. It is aligned to 64 bytes,
+         * so that inference engines such as TensorFlow can use it directly
+         */
+        std::shared_ptr<float> allocateHostStorage(std::size_t size);
+        /**
+         * If this tensor is a view, make sure the shared host storage has the newest data of the parent tensor
+         */
+        void updateFromParent();
+
+        // The tensor this tensor is a view of, if created by getSlice
+        std::weak_ptr<Tensor> m_parent;
 
-        std::unique_ptr<float[]> m_data;
+        // Reference counted host storage. Views (getSlice) share the ownership of the storage of the parent tensor.
+        std::shared_ptr<float> m_data;
         std::unordered_map<SharedPointer<OpenCLDevice>, cl::Buffer*> mCLBuffers;
         std::unordered_map<SharedPointer<OpenCLDevice>, bool> mCLBuffersIsUpToDate;
         TensorShape m_shape;
@@ -15,8 +15,8 @@ bool TensorShape::empty() const {
     return m_data.empty();
 }
 
-int TensorShape::getTotalSize() const {
-    int product = 1;
+std::size_t TensorShape::getTotalSize() const {
+    std::size_t product = 1;
     for(auto i : m_data) {
         if(i >= 0)
             product *= i;
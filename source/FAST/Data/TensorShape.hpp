@@ -40,7 +40,7 @@ class FAST_EXPORT TensorShape {
          * Total size of tensor, excluding any unknown dimensions
          * @return
          */
-        int getTotalSize() const;
+        std::size_t getTotalSize() const;
         /**
          * Get nr of dimensions
          * @return
@@ -1,9 +1,13 @@
 #include "FAST/Testing.hpp"
 #include "FAST/Data/Image.hpp"
+#include "FAST/Data/TensorShape.hpp"
 #include "FAST/DeviceManager.hpp"
 #include "FAST/Tests/DataComparison.hpp"
 #include "FAST/Utility.hpp"
 #include <limits>
+#ifndef WIN32
+#include <sys/mman.h>
+#endif
 
 using namespace fast;
 
@@ -1184,7 +1188,7 @@ TEST_CASE("Calling calculate max or min intensity on uninitialized image throws
     CHECK_THROWS(image->calculateMinimumIntensity());
 }
 
-inline void getMaxAndMinFromData(void* data, unsigned int nrOfElements, float* min, float* max, DataType type) {
+inline void getMaxAndMinFromData(void* data, std::size_t nrOfElements, float* min, float* max, DataType type) {
     switch(type) {
     case TYPE_FLOAT:
         getMaxAndMinFromData<float>(data,nrOfElements,min,max);
@@ -1204,7 +1208,7 @@ inline void getMaxAndMinFromData(void* data, unsigned int nrOfElements, float* m
     }
 }
 
-inline float getSumFromData(void* data, unsigned int nrOfElements, DataType type) {
+inline float getSumFromData(void* data, std::size_t nrOfElements, DataType type) {
     float sum;
     switch(type) {
     case TYPE_FLOAT:
@@ -1482,4 +1486,106 @@ TEST_CASE("createFromImage on 3D image", "[fast][image]") {
     }
 }
 
+TEST_CASE("Out of bounds cropping of a host image throws when not allowed", "[fast][image]") {
+    // Images created from host data are cropped on the host
+    std::vector<uchar> data(32*16, 1);
+    auto image = Image::New();
+    image->create(32, 16, TYPE_UINT8, 1, data.data());
+    CHECK_THROWS_AS(image->crop(Vector2i(20, 0), Vector2i(16, 8)), Exception);
+    CHECK_THROWS_AS(image->crop(Vector2i(0, 10), Vector2i(8, 8)), Exception);
+    CHECK_THROWS_AS(image->crop(Vector2i(0, 0), Vector2i(0, 8)), Exception);
+    CHECK_THROWS_AS(image->crop(Vector2i(-1, 0), Vector2i(8, 8)), Exception);
+    auto cropped = image->crop(Vector2i(16, 8), Vector2i(16, 8));
+    CHECK(cropped->getWidth() == 16);
+    CHECK(cropped->getHeight() == 8);
+
+    std::vector<float> volumeData(8*8*8, 1.0f);
+    auto volume = Image::New();
+    volume->create(8, 8, 8, TYPE_FLOAT, 1, volumeData.data());
+    CHECK_THROWS_AS(volume->crop(Vector3i(0, 0, 4), Vector3i(8, 8, 5)), Exception);
+    CHECK_NOTHROW(volume->crop(Vector3i(0, 0, 4), Vector3i(8, 8, 4)));
+}
+
+TEST_CASE("Prefetched 2D image stays coherent when host data is changed during transfer", "[fast][image]") {
+    DeviceManager* deviceManager = DeviceManager::getInstance();
+    OpenCLDevice::pointer device = deviceManager->getOneOpenCLDevice();
+
+    unsigned int width = 256;
+    unsigned int height = 512;
+    DataType type = TYPE_FLOAT;
+
+    void* data = allocateRandomData(width*height, type);
+
+    Image::pointer image = Image::New();
+    image->create(width, height, type, 1, Host::getInstance(), data);
+    image->prefetch(device);
+    {
+        // Prefetch does not wait for the transfer, the host data is still being read
+        OpenCLImageAccess::pointer access = image->getOpenCLImageAccess(ACCESS_READ, device);
+        CHECK(compareImage2DWithDataArray(*access->get2DImage(), device, data, width, height, 1, type) == true);
+    }
 
+    image->prefetch(device);
+    {
+        // Write access must wait for any transfer reading the host data
+        ImageAccess::pointer access = image->getImageAccess(ACCESS_READ_WRITE);
+        float* changedData = (float*)access->get();
+        for(unsigned int i = 0; i < width*height; i++)
+            changedData[i] = ((float*)data)[i]*2;
+    }
+    for(unsigned int i = 0; i < width*height; i++)
+        ((float*)data)[i] *= 2;
+    image->prefetch(device);
+    OpenCLImageAccess::pointer access = image->getOpenCLImageAccess(ACCESS_READ, device);
+    CHECK(compareImage2DWithDataArray(*access->get2DImage(), device, data, width, height, 1, type) == true);
+    access->release();
+    // Freeing the image must also wait for the transfer
+    image->getImageAccess(ACCESS_READ_WRITE)->release();
+    image->prefetch(device);
+    image.reset();
+
+    deleteArray(data, type);
+}
+
+
+
+#ifndef WIN32
+TEST_CASE("Image larger than 4 GiB uses 64 bit addressing", "[fast][image]") {
+    // 2048*2048*1025 is just above 2^32 voxels. The pixel data is backed by an anonymous mapping,
+    // thus only the pages which are touched use any memory.
+    const uint width = 2048;
+    const uint height = 2048;
+    const uint depth = 1025;
+    const std::size_t voxels = (std::size_t)width*height*depth;
+    REQUIRE(voxels > std::numeric_limits<uint>::max());
+    void* data = mmap(nullptr, voxels, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    REQUIRE(data != MAP_FAILED);
+
+    auto image = Image::New();
+    image->create(Vector3ui(width, height, depth), TYPE_UINT8, 1, unique_pixel_ptr(data, [voxels](void* data) { munmap(data, voxels); }));
+    CHECK(image->getNrOfVoxels() == voxels);
+    CHECK(image->getBufferSize() == voxels);
+
+    // Linear position which would alias position 5 if addresses were calculated in 32 bit
+    const std::size_t farPosition = ((std::size_t)1 << 32) + 5;
+    {
+        auto access = image->getImageAccess(ACCESS_READ_WRITE);
+        access->setScalarFast<uchar>(Vector3i(width - 1, height - 1, depth - 1), 42);
+        access->setScalarFast<uchar>(farPosition, 7);
+        CHECK(access->getScalarFast<uchar>(voxels - 1) == 42);
+        CHECK(access->getScalarFast3D<uchar>(Vector3i(width - 1, height - 1, depth - 1)) == 42);
+        CHECK(access->getScalar(Vector3i(width - 1, height - 1, depth - 1)) == 42);
+        CHECK(access->getScalar(farPosition) == 7);
+        CHECK(access->getScalarFast<uchar>(5) == 0);
+    }
+
+    // Crop on host should only touch the region which is copied
+    auto cropped = image->crop(Vector3i(width - 8, height - 8, depth - 4), Vector3i(8, 8, 4));
+    CHECK(cropped->getNrOfVoxels() == 8*8*4);
+    auto croppedAccess = cropped->getImageAccess(ACCESS_READ);
+    CHECK(croppedAccess->getScalarFast<uchar>(Vector3i(7, 7, 3)) == 42);
+    CHECK(croppedAccess->getScalarFast<uchar>(Vector3i(0, 0, 0)) == 0);
+
+    CHECK(TensorShape({(int)depth, (int)height, (int)width}).getTotalSize() == voxels);
+}
+#endif
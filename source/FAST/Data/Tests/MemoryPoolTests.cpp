@@ -0,0 +1,89 @@
+#include "FAST/Testing.hpp"
+#include "FAST/Data/MemoryPool.hpp"
+#include "FAST/Data/Image.hpp"
+#include "FAST/Data/Tensor.hpp"
+#include "FAST/DeviceManager.hpp"
+
+using namespace fast;
+
+TEST_CASE("Memory pool recycles host memory of the same size", "[fast][MemoryPool]") {
+    auto pool = MemoryPool::New();
+    void* first;
+    {
+        auto data = pool->allocateHost(1024);
+        first = data.get();
+        CHECK((std::size_t)first % 64 == 0);
+    }
+    CHECK(pool->getStatistics().misses == 1);
+    CHECK(pool->getStatistics().cachedObjects == 1);
+    CHECK(pool->getStatistics().cachedBytes == 1024);
+
+    auto data = pool->allocateHost(1024);
+    CHECK(data.get() == first);
+    CHECK(pool->getStatistics().hits == 1);
+    CHECK(pool->getStatistics().cachedObjects == 0);
+
+    auto other = pool->allocateHost(2048);
+    CHECK(other.get() != first);
+    CHECK(pool->getStatistics().misses == 2);
+}
+
+TEST_CASE("Memory pool evicts storage when the maximum cached size is reached", "[fast][MemoryPool]") {
+    auto pool = MemoryPool::New();
+    pool->setMaximumCachedSize(1500);
+    {
+        auto data1 = pool->allocateHost(1024);
+        auto data2 = pool->allocateHost(1024);
+    }
+    CHECK(pool->getStatistics().cachedBytes == 1024);
+    CHECK(pool->getStatistics().evictions == 1);
+
+    pool->setMaximumCachedSize(0);
+    CHECK(pool->getStatistics().cachedBytes == 0);
+    CHECK(pool->getStatistics().cachedObjects == 0);
+
+    // Memory allocated from a pool can outlive the pool
+    auto data = pool->allocateHost(64);
+    pool.reset();
+    data.reset();
+}
+
+TEST_CASE("Images and tensors of the same shape reuse host memory", "[fast][MemoryPool]") {
+    auto pool = MemoryPool::New();
+    for(int frame = 0; frame < 10; ++frame) {
+        auto image = Image::New();
+        image->setMemoryPool(pool);
+        image->create(256, 256, TYPE_UINT8, 1);
+        auto access = image->getImageAccess(ACCESS_READ_WRITE);
+        access->setScalarFast<uchar>(0, 1);
+
+        auto tensor = Tensor::New();
+        tensor->setMemoryPool(pool);
+        tensor->create(TensorShape({16, 16}));
+        auto tensorAccess = tensor->getAccess(ACCESS_READ_WRITE);
+    }
+    // Only the first frame should allocate
+    CHECK(pool->getStatistics().misses == 2);
+    CHECK(pool->getStatistics().hits == 18);
+    CHECK(pool->getStatistics().cachedBytes == 256*256 + 16*16*sizeof(float));
+}
+
+TEST_CASE("OpenCL storage is given back to the pool which allocated it", "[fast][MemoryPool]") {
+    auto device = DeviceManager::getInstance()->getOneOpenCLDevice();
+    auto pool1 = MemoryPool::New();
+    auto pool2 = MemoryPool::New();
+    cl::Buffer* buffer = pool1->allocateBuffer(device, 1024);
+    // Releasing through another pool, e.g. when the pool of a data object was changed after allocation
+    pool2->release(buffer);
+    CHECK(pool1->getStatistics().cachedObjects == 1);
+    CHECK(pool2->getStatistics().cachedObjects == 0);
+    CHECK(pool1->allocateBuffer(device, 1024) == buffer);
+    CHECK(pool1->getStatistics().hits == 1);
+    pool1->release(buffer);
+
+    // Storage of a deleted pool is deleted when released
+    cl::Buffer* buffer2 = pool2->allocateBuffer(device, 1024);
+    pool2.reset();
+    pool1->release(buffer2);
+    CHECK(pool1->getStatistics().cachedObjects == 1);
+}
@@ -0,0 +1,92 @@
+#include "FAST/Testing.hpp"
+#include "FAST/Data/Tensor.hpp"
+#include "FAST/Data/Access/OpenCLBufferAccess.hpp"
+#include "FAST/DeviceManager.hpp"
+
+using namespace fast;
+
+TEST_CASE("Create tensor with shape", "[fast][tensor]") {
+    auto tensor = Tensor::New();
+    tensor->create(TensorShape({2, 3, 4}));
+    CHECK(tensor->getShape().getTotalSize() == 24);
+    auto access = tensor->getAccess(ACCESS_READ_WRITE);
+    CHECK(access->getShape().getDimensions() == 3);
+    CHECK(access->getRawData() != nullptr);
+}
+
+TEST_CASE("Create tensor with externally owned storage", "[fast][tensor]") {
+    bool deleted = false;
+    float* values = new float[6]{0, 1, 2, 3, 4, 5};
+    {
+        auto tensor = Tensor::New();
+        tensor->create(std::shared_ptr<float>(values, [&deleted](float* data) {
+            deleted = true;
+            delete[] data;
+        }), TensorShape({2, 3}));
+        auto access = tensor->getAccess(ACCESS_READ);
+        // No copy should be made
+        CHECK(access->getRawData() == values);
+        CHECK_FALSE(deleted);
+    }
+    CHECK(deleted);
+}
+
+TEST_CASE("Tensor slice is a view which keeps storage alive", "[fast][tensor]") {
+    Tensor::pointer slice;
+    float* parentData;
+    {
+        auto tensor = Tensor::New();
+        tensor->create(TensorShape({4, 2, 3}));
+        auto access = tensor->getAccess(ACCESS_READ_WRITE);
+        parentData = access->getRawData();
+        for(int i = 0; i < 24; ++i)
+            parentData[i] = i;
+        access->release();
+
+        slice = tensor->getSlice(2);
+        CHECK(slice->getShape().getDimensions() == 2);
+        CHECK(slice->getShape()[0] == 2);
+        CHECK(slice->getShape()[1] == 3);
+        CHECK_THROWS(tensor->getSlice(4));
+    }
+    // Parent tensor is deleted, but the view should still be valid
+    auto access = slice->getAccess(ACCESS_READ);
+    CHECK(access->getRawData() == parentData + 12);
+    auto data = access->getData<2>();
+    CHECK(data(0, 0) == 12);
+    CHECK(data(1, 2) == 17);
+}
+
+TEST_CASE("Writing to tensor slice invalidates OpenCL buffer of parent", "[fast][tensor]") {
+    auto device = DeviceManager::getInstance()->getOneOpenCLDevice();
+    auto tensor = Tensor::New();
+    tensor->create(TensorShape({4, 2, 3}));
+    {
+        auto access = tensor->getAccess(ACCESS_READ_WRITE);
+        float* data = access->getRawData();
+        for(int i = 0; i < 24; ++i)
+            data[i] = i;
+    }
+    // Get the data of the parent on the device before writing to the slice
+    tensor->getOpenCLBufferAccess(ACCESS_READ, device);
+
+    auto slice = tensor->getSlice(1);
+    {
+        auto access = slice->getAccess(ACCESS_READ_WRITE);
+        float* data = access->getRawData();
+        for(int i = 0; i < 6; ++i)
+            data[i] = -1;
+    }
+    CHECK_THROWS(slice->getOpenCLBufferAccess(ACCESS_READ_WRITE, device));
+
+    auto access = tensor->getOpenCLBufferAccess(ACCESS_READ, device);
+    std::vector<float> result(24);
+    device->getCommandQueue().enqueueReadBuffer(*access->get(), CL_TRUE, 0, 24*sizeof(float), result.data());
+    for(int i = 0; i < 24; ++i) {
+        if(i >= 6 && i < 12) {
+            CHECK(result[i] == -1);
+        } else {
+            CHECK(result[i] == i);
+        }
+    }
+}
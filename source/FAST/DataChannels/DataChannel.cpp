@@ -8,10 +8,70 @@ void DataChannel::stop() {
     }
 }
 
-DataChannel::DataChannel() {
+DataChannel::DataChannel() : m_enqueuedFrames(0), m_droppedFrames(0), m_maximumDepth(0) {
     m_stop = false;
 }
 
+void DataChannel::setBackpressurePolicy(BackpressurePolicy policy) {
+    m_backpressurePolicy = policy;
+}
+
+BackpressurePolicy DataChannel::getBackpressurePolicy() const {
+    return m_backpressurePolicy;
+}
+
+void DataChannel::setKeepEveryNthFrame(uint frames) {
+    if(frames == 0)
+        throw Exception("Keep every Nth frame must be larger than 0");
+    m_keepEveryNthFrame = frames;
+}
+
+void DataChannel::setMaximumFrameAge(float milliseconds) {
+    m_maximumFrameAge = std::chrono::duration<float, std::milli>(milliseconds);
+}
+
+uint64_t DataChannel::getNrOfEnqueuedFrames() const {
+    return m_enqueuedFrames.load();
+}
+
+uint64_t DataChannel::getNrOfDroppedFrames() const {
+    return m_droppedFrames.load();
+}
+
+int DataChannel::getMaximumDepth() const {
+    return m_maximumDepth.load();
+}
+
+void DataChannel::resetStatistics() {
+    m_enqueuedFrames = 0;
+    m_droppedFrames = 0;
+    m_maximumDepth = 0;
+}
+
+bool DataChannel::keepFrame(const DataObject::pointer& data) {
+    const bool keep = m_framesOffered % m_keepEveryNthFrame == 0 || data->isLastFrame();
+    ++m_framesOffered;
+    if(!keep)
+        frameDropped();
+    return keep;
+}
+
+bool DataChannel::isFrameTooOld(const DataObject::pointer& data, std::chrono::steady_clock::time_point added) const {
+    if(m_maximumFrameAge.count() <= 0 || data->isLastFrame())
+        return false;
+    return std::chrono::steady_clock::now() - added > m_maximumFrameAge;
+}
+
+void DataChannel::frameEnqueued(int depth) {
+    ++m_enqueuedFrames;
+    int previousMaximum = m_maximumDepth.load();
+    while(depth > previousMaximum && !m_maximumDepth.compare_exchange_weak(previousMaximum, depth));
+}
+
+void DataChannel::frameDropped() {
+    ++m_droppedFrames;
+}
+
 SharedPointer<ProcessObject> DataChannel::getProcessObject() const {
     return m_processObject;
 }
@@ -22,6 +82,7 @@ void DataChannel::setProcessObject(SharedPointer<ProcessObject> po) {
 
 template <>
 SharedPointer<DataObject> DataChannel::getNextFrame<DataObject>() {
+    TraceScope trace("getNextFrame", "wait");
     return getNextDataFrame();
 }
 
@@ -1,12 +1,24 @@
 #pragma once
 
 #include <FAST/Data/DataObject.hpp>
+#include <FAST/Tracer.hpp>
 #include <FAST/Data/DataTypes.hpp>
+#include <atomic>
+#include <chrono>
 
 namespace fast {
 
 class ProcessObject;
 
+/**
+ * Determines what a data channel does when a frame is added and the buffer is full
+ */
+enum BackpressurePolicy {
+    BACKPRESSURE_BLOCK, // Block the producer until there is room (default)
+    BACKPRESSURE_DROP_OLDEST, // Never block, drop the oldest frame in the buffer
+    BACKPRESSURE_DROP_NEWEST // Never block, drop the frame which is added
+};
+
 class FAST_EXPORT DataChannel : public Object {
     public:
         typedef SharedPointer<DataChannel> pointer;
@@ -49,11 +61,67 @@ class FAST_EXPORT DataChannel : public Object {
 
         SharedPointer<ProcessObject> getProcessObject() const;
         void setProcessObject(SharedPointer<ProcessObject> po);
+
+        /**
+         * Set what to do when a frame is added and the buffer is full.
+         * Only used by data channels which store more than one frame.
+         */
+        void setBackpressurePolicy(BackpressurePolicy policy);
+        BackpressurePolicy getBackpressurePolicy() const;
+        /**
+         * Only keep every Nth frame added to this data channel, the rest are dropped.
+         * Last frames are never dropped.
+         * @param frames Default is 1 which keeps all frames
+         */
+        void setKeepEveryNthFrame(uint frames);
+        /**
+         * Drop frames which have been stored in this data channel for longer than the given time
+         * when they are about to be retrieved. Last frames are never dropped.
+         * @param milliseconds A value of 0 or less disables this latency bound, which is the default
+         */
+        void setMaximumFrameAge(float milliseconds);
+
+        /**
+         * @return total number of frames which has been stored in this data channel
+         */
+        uint64_t getNrOfEnqueuedFrames() const;
+        /**
+         * @return total number of frames which has been dropped by this data channel
+         */
+        uint64_t getNrOfDroppedFrames() const;
+        /**
+         * @return the maximum number of frames which has been stored in this data channel at the same time
+         */
+        int getMaximumDepth() const;
+        void resetStatistics();
     protected:
         bool m_stop;
         std::mutex m_mutex;
         SharedPointer<ProcessObject> m_processObject;
 
+        BackpressurePolicy m_backpressurePolicy = BACKPRESSURE_BLOCK;
+        uint m_keepEveryNthFrame = 1;
+        uint64_t m_framesOffered = 0;
+        std::chrono::duration<float, std::milli> m_maximumFrameAge = std::chrono::duration<float, std::milli>(0);
+        std::atomic<uint64_t> m_enqueuedFrames;
+        std::atomic<uint64_t> m_droppedFrames;
+        std::atomic<int> m_maximumDepth;
+
+        /**
+         * Called by the producer for every frame added. Returns false if the frame should be dropped
+         * according to setKeepEveryNthFrame.
+         */
+        bool keepFrame(const DataObject::pointer& data);
+        /**
+         * Called by the consumer. Returns true if the frame is older than the maximum frame age
+         */
+        bool isFrameTooOld(const DataObject::pointer& data, std::chrono::steady_clock::time_point added) const;
+        /**
+         * Register that a frame was stored, and the number of frames stored after it was added
+         */
+        void frameEnqueued(int depth);
+        void frameDropped();
+
         virtual DataObject::pointer getNextDataFrame() = 0;
         DataChannel();
 };
@@ -64,7 +132,11 @@ FAST_EXPORT SharedPointer<DataObject> DataChannel::getNextFrame<DataObject>();
 
 template <class T>
 SharedPointer<T> DataChannel::getNextFrame() {
-    auto data = getNextDataFrame();
+    DataObject::pointer data;
+    {
+        TraceScope trace("getNextFrame", "wait");
+        data = getNextDataFrame();
+    }
     auto convertedData = std::dynamic_pointer_cast<T>(data);
     // Check if the conversion went ok
     if(!convertedData)
@@ -3,10 +3,17 @@
 namespace fast {
 
 void NewestFrameDataChannel::addFrame(DataObject::pointer data) {
+    if(!keepFrame(data))
+        return;
     // Simply replace any previous data
     {
         std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_frame && !m_frameRetrieved)
+            frameDropped();
         m_frame = data;
+        m_frameAdded = std::chrono::steady_clock::now();
+        m_frameRetrieved = false;
+        frameEnqueued(1);
     }
     m_frameConditionVariable.notify_one();
 }
@@ -14,21 +21,29 @@ void NewestFrameDataChannel::addFrame(DataObject::pointer data) {
 DataObject::pointer NewestFrameDataChannel::getNextDataFrame() {
     std::unique_lock<std::mutex> lock(m_mutex);
 
-    // Block until we get any data or a stop signal
-    while(getSize() == 0 && !m_stop) {
-        m_frameConditionVariable.wait(lock);
-    }
+    while(true) {
+        // Block until we get any data or a stop signal
+        while(getSize() == 0 && !m_stop) {
+            m_frameConditionVariable.wait(lock);
+        }
+
+        // If stop is signaled, throw an exception to stop the entire computation thread
+        if(m_stop)
+            throw ThreadStopped();
 
-    // If stop is signaled, throw an exception to stop the entire computation thread
-    if(m_stop)
-        throw ThreadStopped();
+        DataObject::pointer data = m_frame;
 
-    DataObject::pointer data = m_frame;
+        // Remove frame as we don't want to process the same frame again
+        m_frame.reset();
 
-    // Remove frame as we don't want to process the same frame again
-    m_frame.reset();
+        // Drop frame if it has been waiting for too long
+        if(isFrameTooOld(data, m_frameAdded)) {
+            frameDropped();
+            continue;
+        }
 
-    return data;
+        return data;
+    }
 }
 
 int NewestFrameDataChannel::getSize() {
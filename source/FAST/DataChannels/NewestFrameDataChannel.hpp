@@ -43,6 +43,9 @@ class FAST_EXPORT NewestFrameDataChannel : public DataChannel {
     protected:
         std::condition_variable m_frameConditionVariable;
         SharedPointer<DataObject> m_frame;
+        std::chrono::steady_clock::time_point m_frameAdded;
+        // Whether the current frame has been retrieved by getNextFrame, used to count dropped frames
+        bool m_frameRetrieved = false;
 
         DataObject::pointer getNextDataFrame() override;
 
@@ -7,6 +7,31 @@ void QueuedDataChannel::addFrame(DataObject::pointer data) {
     //if(!mGetCalled && mFillCount->getCount() == mMaximumNumberOfFrames)
     //    Reporter::error() << "EXECUTION BLOCKED by DataChannel from " << mProcessObject->getNameOfClass() << ". Do you have a DataChannel object that is not used?" << Reporter::end();
 
+    if(!keepFrame(data))
+        return;
+
+    if(m_backpressurePolicy != BACKPRESSURE_BLOCK && !data->isLastFrame() && !m_emptyCount->tryWait()) {
+        // Queue is full
+        if(m_backpressurePolicy == BACKPRESSURE_DROP_NEWEST) {
+            frameDropped();
+            return;
+        }
+        // Drop oldest: Replace the front of the queue, the number of frames in the queue stays the same
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if(m_stop)
+                throw ThreadStopped();
+            if(!m_queue.empty()) {
+                m_queue.pop();
+                frameDropped();
+                m_queue.push(std::make_pair(data, std::chrono::steady_clock::now()));
+                frameEnqueued(m_queue.size());
+                return;
+            }
+        }
+        // The consumer emptied the queue and is about to signal the free slot; wait for it
+    }
+
     // Increment semaphore by one, wait if queue is full
     m_emptyCount->wait();
 
@@ -17,7 +42,8 @@ void QueuedDataChannel::addFrame(DataObject::pointer data) {
         if(m_stop)
             throw ThreadStopped();
 
-        m_queue.push(data);
+        m_queue.push(std::make_pair(data, std::chrono::steady_clock::now()));
+        frameEnqueued(m_queue.size());
     }
 
     // Decrement semaphore by one, signal any waiting due to empty queue
@@ -25,29 +51,40 @@ void QueuedDataChannel::addFrame(DataObject::pointer data) {
 }
 
 DataObject::pointer QueuedDataChannel::getNextDataFrame() {
-    // Decrement semaphore by one, and wait if queue is empty
-    m_fillCount->wait();
-
-    DataObject::pointer data;
-    {
-        std::unique_lock<std::mutex> lock(m_mutex);
-
-        // If stop is signaled, throw an exception to stop the entire computation thread
-        if(m_stop)
-            throw ThreadStopped();
-
-        // Get frame next in queue and remove it from the queue
-        data = m_queue.front();
-        m_queue.pop();
+    while(true) {
+        // Decrement semaphore by one, and wait if queue is empty
+        m_fillCount->wait();
+
+        DataObject::pointer data;
+        std::chrono::steady_clock::time_point added;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            // If stop is signaled, throw an exception to stop the entire computation thread
+            if(m_stop)
+                throw ThreadStopped();
+
+            // Get frame next in queue and remove it from the queue
+            data = m_queue.front().first;
+            added = m_queue.front().second;
+            m_queue.pop();
+        }
+
+        // Increment semaphore by one and signal any waiting for next frame due to empty queue
+        m_emptyCount->signal();
+
+        // Drop frame if it has been in the queue for too long
+        if(isFrameTooOld(data, added)) {
+            frameDropped();
+            continue;
+        }
+
+        return data;
     }
-
-    // Increment semaphore by one and signal any waiting for next frame due to empty queue
-    m_emptyCount->signal();
-
-    return data;
 }
 
 int QueuedDataChannel::getSize() {
+    std::lock_guard<std::mutex> lock(m_mutex);
     return m_queue.size();
 }
 
@@ -76,7 +113,7 @@ DataObject::pointer QueuedDataChannel::getFrame() {
     std::lock_guard<std::mutex> lock(m_mutex);
     if(m_queue.empty())
         throw Exception("No frames available in getFrame");
-    return m_queue.front();
+    return m_queue.front().first;
 }
 
 QueuedDataChannel::QueuedDataChannel() {
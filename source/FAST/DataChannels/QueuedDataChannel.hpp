@@ -10,13 +10,15 @@ namespace fast {
  * This queued data channel implements the producser-consumer task
  * using a lightweight semaphore. It is used on the output data channelsl
  * of streamers when streaming mode is PROCESS_ALL_FRAMES
+ *
+ * Supports all backpressure policies; with the DROP policies the producer never blocks.
  */
 class FAST_EXPORT QueuedDataChannel : public DataChannel {
     FAST_OBJECT(QueuedDataChannel)
     public:
         /**
          * Add frame to the data channel. This call may block
-         * if the buffer is full.
+         * if the buffer is full and backpressure policy is BLOCK.
          */
         void addFrame(DataObject::pointer data) override;
 
@@ -43,7 +45,8 @@ class FAST_EXPORT QueuedDataChannel : public DataChannel {
          */
         DataObject::pointer getFrame() override;
     protected:
-        std::queue<SharedPointer<DataObject>> m_queue;
+        // Frames and the time they were added
+        std::queue<std::pair<SharedPointer<DataObject>, std::chrono::steady_clock::time_point>> m_queue;
         uint mMaximumNumberOfFrames;
         std::unique_ptr<LightweightSemaphore> m_fillCount;
         std::unique_ptr<LightweightSemaphore> m_emptyCount;
@@ -0,0 +1,176 @@
+#include "RingBufferDataChannel.hpp"
+#include <thread>
+
+namespace fast {
+
+// The ring buffer is a bounded MPMC queue where every cell has a sequence number, see
+// http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+
+bool RingBufferDataChannel::tryEnqueue(DataObject::pointer data) {
+    Cell* cell;
+    std::size_t position = m_enqueuePosition.load(std::memory_order_relaxed);
+    while(true) {
+        cell = &m_buffer[position & m_mask];
+        std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        auto difference = (std::intptr_t)sequence - (std::intptr_t)position;
+        if(difference == 0) {
+            // Cell is free, try to claim it
+            if(m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+        } else if(difference < 0) {
+            // Buffer is full
+            return false;
+        } else {
+            // Another producer claimed this cell
+            position = m_enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+    cell->data = std::move(data);
+    cell->added = std::chrono::steady_clock::now();
+    cell->sequence.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+bool RingBufferDataChannel::tryDequeue(DataObject::pointer& data, std::chrono::steady_clock::time_point& added) {
+    Cell* cell;
+    std::size_t position = m_dequeuePosition.load(std::memory_order_relaxed);
+    while(true) {
+        cell = &m_buffer[position & m_mask];
+        std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        auto difference = (std::intptr_t)sequence - (std::intptr_t)(position + 1);
+        if(difference == 0) {
+            if(m_dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+        } else if(difference < 0) {
+            // Buffer is empty
+            return false;
+        } else {
+            position = m_dequeuePosition.load(std::memory_order_relaxed);
+        }
+    }
+    data = std::move(cell->data);
+    added = cell->added;
+    cell->sequence.store(position + m_mask + 1, std::memory_order_release);
+    return true;
+}
+
+void RingBufferDataChannel::addFrame(DataObject::pointer data) {
+    if(!keepFrame(data))
+        return;
+
+    if(m_backpressurePolicy != BACKPRESSURE_BLOCK && !data->isLastFrame() && !m_emptyCount->tryWait()) {
+        // Buffer is full
+        if(m_stopped.load(std::memory_order_acquire))
+            throw ThreadStopped();
+        if(m_backpressurePolicy == BACKPRESSURE_DROP_NEWEST) {
+            frameDropped();
+            return;
+        }
+        // Drop oldest: Take the oldest frame out and put the new one in, the number of frames stays the same
+        DataObject::pointer oldest;
+        std::chrono::steady_clock::time_point added;
+        if(tryDequeue(oldest, added)) {
+            frameDropped();
+            while(!tryEnqueue(data))
+                std::this_thread::yield();
+            frameEnqueued(getSize());
+            return;
+        }
+        // The consumer emptied the buffer and is about to signal the free slot; wait for it
+    }
+
+    // Wait for a free slot: The fast path is a single atomic operation, then spin, then park
+    m_emptyCount->wait();
+
+    // If stop is signaled, throw an exception to stop the entire computation thread
+    if(m_stopped.load(std::memory_order_acquire))
+        throw ThreadStopped();
+
+    // The semaphore guarantees that there is room, but another consumer may not have released its cell yet
+    while(!tryEnqueue(data))
+        std::this_thread::yield();
+    frameEnqueued(getSize());
+
+    m_fillCount->signal();
+}
+
+DataObject::pointer RingBufferDataChannel::getNextDataFrame() {
+    while(true) {
+        m_fillCount->wait();
+
+        // If stop is signaled, throw an exception to stop the entire computation thread
+        if(m_stopped.load(std::memory_order_acquire))
+            throw ThreadStopped();
+
+        DataObject::pointer data;
+        std::chrono::steady_clock::time_point added;
+        while(!tryDequeue(data, added))
+            std::this_thread::yield();
+
+        m_emptyCount->signal();
+
+        // Drop frame if it has been in the buffer for too long
+        if(isFrameTooOld(data, added)) {
+            frameDropped();
+            continue;
+        }
+
+        return data;
+    }
+}
+
+int RingBufferDataChannel::getSize() {
+    std::size_t enqueued = m_enqueuePosition.load(std::memory_order_acquire);
+    std::size_t dequeued = m_dequeuePosition.load(std::memory_order_acquire);
+    return enqueued > dequeued ? (int)(enqueued - dequeued) : 0;
+}
+
+void RingBufferDataChannel::setMaximumNumberOfFrames(uint frames) {
+    if(frames == 0)
+        throw Exception("Maximum number of frames in RingBufferDataChannel must be larger than 0");
+    if(m_buffer && getSize() > 0)
+        throw Exception("Have to call setMaximumNumberOfFrames before executing pipeline");
+    mMaximumNumberOfFrames = frames;
+
+    // Capacity of ring buffer has to be a power of two
+    std::size_t capacity = 2;
+    while(capacity < frames)
+        capacity *= 2;
+    m_buffer = std::make_unique<Cell[]>(capacity);
+    for(std::size_t i = 0; i < capacity; ++i)
+        m_buffer[i].sequence.store(i, std::memory_order_relaxed);
+    m_mask = capacity - 1;
+    m_enqueuePosition.store(0, std::memory_order_relaxed);
+    m_dequeuePosition.store(0, std::memory_order_relaxed);
+
+    m_fillCount = std::make_unique<LightweightSemaphore>(0);
+    m_emptyCount = std::make_unique<LightweightSemaphore>(mMaximumNumberOfFrames);
+}
+
+void RingBufferDataChannel::stop() {
+    DataChannel::stop();
+    m_stopped.store(true, std::memory_order_release);
+    Reporter::info() << "SIGNALING SEMAPHORES in RingBufferDataChannel" << Reporter::end();
+
+    // Since getNextFrame or addFrame might be waiting, we need to signal the semaphores to stop them blocking
+    m_fillCount->signal();
+    m_emptyCount->signal();
+}
+
+bool RingBufferDataChannel::hasCurrentData() {
+    return getSize() > 0;
+}
+
+DataObject::pointer RingBufferDataChannel::getFrame() {
+    std::size_t position = m_dequeuePosition.load(std::memory_order_relaxed);
+    Cell& cell = m_buffer[position & m_mask];
+    if(cell.sequence.load(std::memory_order_acquire) != position + 1)
+        throw Exception("No frames available in getFrame");
+    return cell.data;
+}
+
+RingBufferDataChannel::RingBufferDataChannel() : m_stopped(false) {
+    setMaximumNumberOfFrames(50);
+}
+
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <FAST/DataChannels/DataChannel.hpp>
+#include <FAST/Semaphore.hpp>
+#include <atomic>
+
+namespace fast {
+
+/**
+ * This data channel implements the producer-consumer task
+ * using a bounded lock-free ring buffer (multi-producer, multi-consumer).
+ * No mutex is taken when adding or getting frames. Producers and consumers
+ * wait for free slots/frames using lightweight semaphores, which spin for a while
+ * before parking the thread. It is used on the output data channels
+ * of streamers when streaming mode is PROCESS_ALL_FRAMES_LOCK_FREE
+ *
+ * Supports all backpressure policies; with the DROP policies the producer never blocks.
+ */
+class FAST_EXPORT RingBufferDataChannel : public DataChannel {
+    FAST_OBJECT(RingBufferDataChannel)
+    public:
+        /**
+         * Add frame to the data channel. This call may block
+         * if the buffer is full and backpressure policy is BLOCK.
+         */
+        void addFrame(DataObject::pointer data) override;
+
+        /**
+         * @return the number of frames stored in this DataChannel
+         */
+        int getSize() override;
+
+        /**
+         * Set the maximum nr of frames that can be stored in this data channel
+         */
+        void setMaximumNumberOfFrames(uint frames) override;
+
+        /**
+         * This will unblock if this DataChannel is currently blocking. Used to stop a pipeline.
+         */
+        void stop() override;
+
+        // TODO consider removing, it is equal to getSize() > 0 atm
+        bool hasCurrentData() override;
+
+        /**
+         * Get current frame, throws if current frame is not available.
+         * Should only be called from the consumer thread.
+         */
+        DataObject::pointer getFrame() override;
+    protected:
+        struct Cell {
+            std::atomic<std::size_t> sequence;
+            DataObject::pointer data;
+            std::chrono::steady_clock::time_point added;
+        };
+        std::unique_ptr<Cell[]> m_buffer;
+        std::size_t m_mask;
+        uint mMaximumNumberOfFrames;
+        // Keep the positions on separate cache lines to avoid false sharing between producer and consumer
+        alignas(64) std::atomic<std::size_t> m_enqueuePosition;
+        alignas(64) std::atomic<std::size_t> m_dequeuePosition;
+        std::atomic<bool> m_stopped;
+        std::unique_ptr<LightweightSemaphore> m_fillCount;
+        std::unique_ptr<LightweightSemaphore> m_emptyCount;
+
+        bool tryEnqueue(DataObject::pointer data);
+        bool tryDequeue(DataObject::pointer& data, std::chrono::steady_clock::time_point& added);
+
+        DataObject::pointer getNextDataFrame() override;
+        RingBufferDataChannel();
+
+};
+
+}
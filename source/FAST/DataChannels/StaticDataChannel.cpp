@@ -17,6 +17,7 @@ DataObject::pointer StaticDataChannel::getNextDataFrame() {
     DataObject::pointer data = m_frame;
 
     // For static channels the data is not removed
+    m_frameRetrieved = true;
 
     return data;
 }
@@ -86,12 +86,12 @@ void DeviceManager::deleteInstance() {
 
 std::vector<OpenCLDevice::pointer> DeviceManager::getDevices(DeviceCriteria criteria, bool enableVisualization) {
     unsigned long * glContext = NULL;
-    if(!isGLInteropEnabled()) {
-        enableVisualization = false;
 #ifdef FAST_MODULE_VISUALIZATION
-        fast::Window::getMainGLContext(); // Still have to create GL context
+    // Create GL context first, headless rendering will disable interop
+    fast::Window::getMainGLContext();
 #endif
-    }
+    if(!isGLInteropEnabled())
+        enableVisualization = false;
     if(enableVisualization) {
         // Create GL context
 
@@ -224,7 +224,6 @@ DeviceManager::DeviceManager() {
     Reporter::info() << "Device manager initialize.." << Reporter::end();
     cl::Platform::get(&platforms);
 
-    mDisableGLInterop = false;
     // Only check on linux/mac
 #ifndef _WIN32
     // If NVIDIA platform is present on linux: disable OpenGL interop
@@ -252,6 +251,10 @@ bool DeviceManager::isGLInteropEnabled() {
     return !mDisableGLInterop;
 }
 
+void DeviceManager::disableGLInterop() {
+    mDisableGLInterop = true;
+}
+
 OpenCLDevice::pointer DeviceManager::getDevice(
         DeviceCriteria criteria) {
     bool interop = false;
@@ -47,6 +47,10 @@ class FAST_EXPORT  DeviceManager : public Object {
                 const DeviceCriteria& deviceCriteria,
                std::vector<PlatformDevices> &platformDevices);
     	static bool isGLInteropEnabled();
+        /**
+         * Disable OpenGL-OpenCL interop. Must be called before the OpenCL devices are created.
+         */
+        static void disableGLInterop();
     	void initialize();
     private:
         unsigned long * mGLContext;
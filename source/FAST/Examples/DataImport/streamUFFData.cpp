@@ -10,11 +10,14 @@ int main(int argc, char** argv) {
 	CommandLineParser parser("Stream UFF data");
 	parser.addPositionVariable(1, "filename", Config::getTestDataPath() + "US/b_data_IQ022_A4C.uff");
 	parser.addOption("loop", "Loop playback");
+	parser.addOption("no-scan-conversion", "Don't scan convert sector scans");
 	parser.parse(argc, argv);
 
 	auto streamer = UFFStreamer::New();
 	streamer->setFilename(parser.get("filename"));
 	streamer->setLooping(parser.getOption("loop"));
+	streamer->setLogCompression(true);
+	streamer->setScanConversion(!parser.getOption("no-scan-conversion"));
 
 	auto renderer = ImageRenderer::New();
 	renderer->addInputConnection(streamer->getOutputPort());
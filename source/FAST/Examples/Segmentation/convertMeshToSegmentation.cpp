@@ -1,4 +1,5 @@
 #include <FAST/Algorithms/MeshToSegmentation/MeshToSegmentation.hpp>
+#include <FAST/Algorithms/DistanceTransform/DistanceTransform.hpp>
 #include <FAST/Importers/VTKMeshFileImporter.hpp>
 #include <FAST/Tools/CommandLineParser.hpp>
 #include <FAST/Exporters/MetaImageExporter.hpp>
@@ -19,6 +20,7 @@ int main(int argc, char** argv) {
     parser.addVariable("segmentation-size", false, "Size of segmentation. Example: 256,256,256");
     parser.addVariable("image-filename", Config::getTestDataPath() + "/US/Ball/US-3Dt_0.mhd");
     parser.addVariable("output-filename", false, "Filename to store the segmentation in. Example: /path/to/file.mhd");
+    parser.addOption("distance-map", "Store the signed distance in millimeters to the mesh surface instead of the segmentation. Negative inside the mesh.");
 
     parser.parse(argc, argv);
 
@@ -51,7 +53,14 @@ int main(int argc, char** argv) {
         auto exporter = MetaImageExporter::New();
         exporter->setFilename(parser.get("output-filename"));
         exporter->enableCompression();
-        exporter->setInputConnection(converter->getOutputPort());
+        if(parser.getOption("distance-map")) {
+            auto distanceTransform = DistanceTransform::New();
+            distanceTransform->setInputConnection(converter->getOutputPort());
+            distanceTransform->setMode(DistanceTransform::Mode::SIGNED);
+            exporter->setInputConnection(distanceTransform->getOutputPort());
+        } else {
+            exporter->setInputConnection(converter->getOutputPort());
+        }
         exporter->update();
     } else {
         // Visualize
@@ -18,14 +18,35 @@ MetaImageExporter::MetaImageExporter() {
 }
 
 template <class T>
-inline std::size_t writeToRawFile(std::string filename, T * data, unsigned int numberOfElements, bool useCompression) {
+inline std::size_t writeToRawFile(std::string filename, T * data, std::size_t numberOfElements, bool useCompression, std::size_t chunkElements, std::vector<std::size_t>& chunkOffsets) {
     // TODO use mapped_file_sink form boost instead
     FILE* file = fopen(filename.c_str(), "wb");
     if(file == NULL) {
         throw Exception("Could not open file " + filename + " for writing");
     }
     std::size_t returnSize;
-    if(useCompression) {
+    if(useCompression && chunkElements > 0) {
+        // Compress each chunk as a separate stream, and store where each chunk starts
+        std::vector<Bytef> writeData(compressBound(sizeof(T)*chunkElements));
+        chunkOffsets = {0};
+        for(std::size_t start = 0; start < numberOfElements; start += chunkElements) {
+            uLongf sizeDataCompressed = writeData.size();
+            int z_result = compress(
+                    writeData.data(),
+                    &sizeDataCompressed,
+                    (Bytef*)(data + start),
+                    sizeof(T)*std::min(chunkElements, numberOfElements - start)
+            );
+            if(z_result != Z_OK) {
+                fclose(file);
+                throw Exception("Error while compressing raw file");
+            }
+            fwrite(writeData.data(), sizeDataCompressed, 1, file);
+            chunkOffsets.push_back(chunkOffsets.back() + sizeDataCompressed);
+        }
+        returnSize = chunkOffsets.back();
+        fclose(file);
+    } else if(useCompression) {
         // Have to allocate enough memory for compression: 1.1*DATA_SIZE_IN_BYTES + 12
         std::size_t sizeDataCompressed = compressBound(sizeof(T)*numberOfElements);
         std::size_t sizeDataOriginal = sizeof(T)*numberOfElements;
@@ -113,8 +134,11 @@ void MetaImageExporter::execute() {
         extension = ".zraw";
     }
     std::string rawFilename = mFilename.substr(0,mFilename.length()-4) + extension;
-    const unsigned int numberOfElements = input->getWidth()*input->getHeight()*
-            input->getDepth()*input->getNrOfChannels();
+    const std::size_t numberOfElements = input->getNrOfVoxels()*input->getNrOfChannels();
+
+    // Number of elements in each compressed chunk
+    const std::size_t chunkElements = (std::size_t)m_chunkSize*input->getWidth()*input->getNrOfChannels()*(input->getDimensions() == 3 ? input->getHeight() : 1);
+    std::vector<std::size_t> chunkOffsets;
 
     ImageAccess::pointer access = input->getImageAccess(ACCESS_READ);
     void* data = access->get();
@@ -122,29 +146,36 @@ void MetaImageExporter::execute() {
     switch(input->getDataType()) {
     case TYPE_FLOAT:
         mhdFile << "ElementType = MET_FLOAT\n";
-        compressedSize = writeToRawFile<float>(rawFilename,(float*)data,numberOfElements,mUseCompression);
+        compressedSize = writeToRawFile<float>(rawFilename,(float*)data,numberOfElements,mUseCompression,chunkElements,chunkOffsets);
         break;
     case TYPE_UINT8:
         mhdFile << "ElementType = MET_UCHAR\n";
-        compressedSize = writeToRawFile<uchar>(rawFilename,(uchar*)data,numberOfElements,mUseCompression);
+        compressedSize = writeToRawFile<uchar>(rawFilename,(uchar*)data,numberOfElements,mUseCompression,chunkElements,chunkOffsets);
         break;
     case TYPE_INT8:
         mhdFile << "ElementType = MET_CHAR\n";
-        compressedSize = writeToRawFile<char>(rawFilename,(char*)data,numberOfElements,mUseCompression);
+        compressedSize = writeToRawFile<char>(rawFilename,(char*)data,numberOfElements,mUseCompression,chunkElements,chunkOffsets);
         break;
     case TYPE_UINT16:
         mhdFile << "ElementType = MET_USHORT\n";
-        compressedSize = writeToRawFile<ushort>(rawFilename,(ushort*)data,numberOfElements,mUseCompression);
+        compressedSize = writeToRawFile<ushort>(rawFilename,(ushort*)data,numberOfElements,mUseCompression,chunkElements,chunkOffsets);
         break;
     case TYPE_INT16:
         mhdFile << "ElementType = MET_SHORT\n";
-        compressedSize = writeToRawFile<short>(rawFilename,(short*)data,numberOfElements,mUseCompression);
+        compressedSize = writeToRawFile<short>(rawFilename,(short*)data,numberOfElements,mUseCompression,chunkElements,chunkOffsets);
         break;
     }
 
     if(mUseCompression) {
         mhdFile << "CompressedData = True" << "\n";
         mhdFile << "CompressedDataSize = " << compressedSize << "\n";
+        if(!chunkOffsets.empty()) {
+            mhdFile << "CompressedDataChunkSize = " << m_chunkSize << "\n";
+            mhdFile << "CompressedDataChunkOffsets =";
+            for(auto offset : chunkOffsets)
+                mhdFile << " " << offset;
+            mhdFile << "\n";
+        }
     }
 
     // Add metadata
@@ -182,6 +213,11 @@ void MetaImageExporter::setCompression(bool compress) {
     mIsModified = true;
 }
 
+void MetaImageExporter::setCompressedChunkSize(uint slices) {
+    m_chunkSize = slices;
+    mIsModified = true;
+}
+
 void MetaImageExporter::setMetadata(std::string key, std::string value) {
     mMetadata[key] = value;
 }
@@ -15,6 +15,15 @@ class FAST_EXPORT MetaImageExporter : public ProcessObject {
          * @param compress
          */
         void setCompression(bool compress);
+        /**
+         * Compress the data in independent chunks of this many slices (rows for 2D images).
+         * This allows MetaImageImporter to decompress only the chunks needed when lazy loading is enabled.
+         * Note that other MetaImage readers, such as ITK, can not read chunked files.
+         * Default is 0, which compresses all data as one stream.
+         *
+         * @param slices
+         */
+        void setCompressedChunkSize(uint slices);
         /**
          * Deprecated
          */
@@ -38,6 +47,7 @@ class FAST_EXPORT MetaImageExporter : public ProcessObject {
         std::string mFilename;
         std::map<std::string, std::string> mMetadata;
         bool mUseCompression;
+        uint m_chunkSize = 0;
 };
 
 } // end namespace fast
@@ -0,0 +1,363 @@
+#include "RecordingFile.hpp"
+#include "FAST/Data/Image.hpp"
+#include "FAST/SceneGraph.hpp"
+#include <zlib.h>
+#include <algorithm>
+
+namespace fast {
+
+// File layout:
+// FileHeader, frame chunks, and when closed: IndexHeader, RecordingFrameIndex * nrOfFrames, IndexTrailer
+// Each frame chunk is: FrameHeader, frame data and metadata (frameDataSize bytes), pixel data (storedSize bytes)
+static const char fileMagic[8] = {'F', 'A', 'S', 'T', 'R', 'E', 'C', '\0'};
+static const char indexMagic[8] = {'F', 'A', 'S', 'T', 'I', 'D', 'X', '\0'};
+static const uint32_t frameMagic = 0x454D5246; // FRME
+static const uint32_t indexHeaderMagic = 0x58444E49; // INDX
+static const uint32_t fileVersion = 1;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+};
+
+struct FrameHeader {
+    uint32_t magic;
+    uint32_t compression;
+    uint64_t frameNr;
+    uint64_t timestamp;
+    // Size of pixel data when decompressed
+    uint64_t dataSize;
+    // Size of pixel data in the file
+    uint64_t storedSize;
+    uint32_t frameDataSize;
+    int32_t dataType;
+    int32_t size[3];
+    int32_t channels;
+    float spacing[3];
+    // Column major 4x4 matrix
+    float transform[16];
+    int32_t dimensions;
+};
+static_assert(sizeof(FrameHeader) == 144, "Recording frame header must not contain padding");
+
+struct IndexHeader {
+    uint32_t magic;
+    uint32_t reserved;
+    uint64_t nrOfFrames;
+};
+
+struct IndexTrailer {
+    uint64_t indexOffset;
+    char magic[8];
+};
+
+static void writeString(std::vector<uint8_t>& buffer, const std::string& string) {
+    const uint32_t length = string.size();
+    buffer.insert(buffer.end(), (const uint8_t*)&length, (const uint8_t*)&length + sizeof(length));
+    buffer.insert(buffer.end(), string.begin(), string.end());
+}
+
+static void writeMap(std::vector<uint8_t>& buffer, const std::unordered_map<std::string, std::string>& map) {
+    const uint32_t size = map.size();
+    buffer.insert(buffer.end(), (const uint8_t*)&size, (const uint8_t*)&size + sizeof(size));
+    for(auto&& item : map) {
+        writeString(buffer, item.first);
+        writeString(buffer, item.second);
+    }
+}
+
+static std::unordered_map<std::string, std::string> readMap(const std::vector<uint8_t>& buffer, std::size_t& position) {
+    auto readUInt = [&buffer, &position]() {
+        if(position + sizeof(uint32_t) > buffer.size())
+            throw Exception("Frame data in recording file is corrupt");
+        uint32_t value;
+        std::copy_n(&buffer[position], sizeof(value), (uint8_t*)&value);
+        position += sizeof(value);
+        return value;
+    };
+    auto readString = [&buffer, &position, &readUInt]() {
+        const uint32_t length = readUInt();
+        if(position + length > buffer.size())
+            throw Exception("Frame data in recording file is corrupt");
+        std::string string(buffer.begin() + position, buffer.begin() + position + length);
+        position += length;
+        return string;
+    };
+    std::unordered_map<std::string, std::string> map;
+    const uint32_t size = readUInt();
+    for(uint32_t i = 0; i < size; ++i) {
+        std::string key = readString();
+        map[key] = readString();
+    }
+    return map;
+}
+
+/**
+ * Check that the fields of a frame header can be used to read the frame, where remainingBytes is the
+ * size of the file after the header.
+ */
+static bool isValidFrameHeader(const FrameHeader& header, uint64_t remainingBytes) {
+    if(header.magic != frameMagic)
+        return false;
+    if(header.dimensions < 2 || header.dimensions > 3)
+        return false;
+    if(header.dataType < TYPE_FLOAT || header.dataType > TYPE_SNORM_INT16)
+        return false;
+    if(header.channels < 1 || header.channels > 4)
+        return false;
+    if(header.dimensions == 2 && header.size[2] != 1)
+        return false;
+    if(header.compression > (uint32_t)RecordingCompression::DEFAULT)
+        return false;
+    if(header.storedSize > remainingBytes || header.frameDataSize > remainingBytes - header.storedSize)
+        return false;
+    // Size of pixel data must match the image size, multiplied step by step to avoid overflow
+    uint64_t bytes = getSizeOfDataType((DataType)header.dataType, header.channels);
+    for(int i = 0; i < 3; ++i) {
+        if(header.size[i] < 1 || bytes > header.dataSize / header.size[i])
+            return false;
+        bytes *= header.size[i];
+    }
+    if(bytes != header.dataSize)
+        return false;
+    // zlib can compress at most about 1032:1
+    if(header.compression == (uint32_t)RecordingCompression::NONE)
+        return header.storedSize == header.dataSize;
+    return header.dataSize / 1032 <= header.storedSize;
+}
+
+RecordingFileWriter::RecordingFileWriter(std::string filename, RecordingCompression compression) {
+    m_compression = compression;
+    m_file.open(filename, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+    if(!m_file.is_open())
+        throw Exception("Could not open recording file " + filename + " for writing");
+
+    FileHeader header = {};
+    std::copy_n(fileMagic, sizeof(fileMagic), header.magic);
+    header.version = fileVersion;
+    m_file.write((const char*)&header, sizeof(header));
+}
+
+void RecordingFileWriter::addFrame(SharedPointer<Image> image) {
+    if(!m_file.is_open())
+        throw Exception("Can't add frames to a recording file which has been closed");
+
+    FrameHeader header = {};
+    header.magic = frameMagic;
+    header.frameNr = m_index.size();
+    header.timestamp = image->getCreationTimestamp();
+    header.dataType = image->getDataType();
+    header.size[0] = image->getWidth();
+    header.size[1] = image->getHeight();
+    header.size[2] = image->getDepth();
+    header.channels = image->getNrOfChannels();
+    header.dimensions = image->getDimensions();
+    const Vector3f spacing = image->getSpacing();
+    std::copy_n(spacing.data(), 3, header.spacing);
+    const Affine3f transform = SceneGraph::getAffineTransformationFromData(image)->getTransform();
+    std::copy_n(transform.matrix().data(), 16, header.transform);
+    header.dataSize = image->getNrOfVoxels()*getSizeOfDataType(image->getDataType(), image->getNrOfChannels());
+
+    std::vector<uint8_t> frameData;
+    writeMap(frameData, image->getFrameData());
+    writeMap(frameData, image->getMetadata());
+    header.frameDataSize = frameData.size();
+
+    auto access = image->getImageAccess(ACCESS_READ);
+    const uint8_t* data = (const uint8_t*)access->get();
+    const uint8_t* storedData = data;
+    header.storedSize = header.dataSize;
+    header.compression = (uint32_t)RecordingCompression::NONE;
+    // zlib can only compress 4 GB at a time on some platforms
+    if(m_compression != RecordingCompression::NONE && header.dataSize < std::numeric_limits<uint32_t>::max()) {
+        uLongf compressedSize = compressBound(header.dataSize);
+        m_compressedData.resize(compressedSize);
+        const int level = m_compression == RecordingCompression::FAST ? Z_BEST_SPEED : Z_DEFAULT_COMPRESSION;
+        if(compress2(m_compressedData.data(), &compressedSize, data, header.dataSize, level) != Z_OK)
+            throw Exception("Error while compressing frame in recording file");
+        // Store frames which don't compress as is
+        if(compressedSize < header.dataSize) {
+            storedData = m_compressedData.data();
+            header.storedSize = compressedSize;
+            header.compression = (uint32_t)m_compression;
+        }
+    }
+
+    const uint64_t offset = m_file.tellp();
+    m_file.write((const char*)&header, sizeof(header));
+    m_file.write((const char*)frameData.data(), frameData.size());
+    m_file.write((const char*)storedData, header.storedSize);
+    m_file.flush();
+    if(!m_file.good())
+        throw Exception("Error while writing frame to recording file");
+    m_index.push_back({offset, header.timestamp});
+}
+
+void RecordingFileWriter::close() {
+    if(!m_file.is_open())
+        return;
+
+    IndexTrailer trailer = {};
+    trailer.indexOffset = m_file.tellp();
+    std::copy_n(indexMagic, sizeof(indexMagic), trailer.magic);
+    IndexHeader header = {};
+    header.magic = indexHeaderMagic;
+    header.nrOfFrames = m_index.size();
+    m_file.write((const char*)&header, sizeof(header));
+    m_file.write((const char*)m_index.data(), m_index.size()*sizeof(RecordingFrameIndex));
+    m_file.write((const char*)&trailer, sizeof(trailer));
+    m_file.close();
+}
+
+uint64_t RecordingFileWriter::getNrOfFrames() const {
+    return m_index.size();
+}
+
+RecordingFileWriter::~RecordingFileWriter() {
+    try {
+        close();
+    } catch(std::exception& e) {
+        // Without an index, the recording can still be read by scanning the frames
+    }
+}
+
+RecordingFileReader::RecordingFileReader(std::string filename) {
+    m_filename = filename;
+    m_file.open(filename, std::ifstream::in | std::ifstream::binary);
+    if(!m_file.is_open())
+        throw FileNotFoundException(filename);
+
+    m_file.seekg(0, std::ifstream::end);
+    m_fileSize = m_file.tellg();
+    m_file.seekg(0);
+    FileHeader header;
+    m_file.read((char*)&header, sizeof(header));
+    if(!m_file.good() || !std::equal(fileMagic, fileMagic + sizeof(fileMagic), header.magic))
+        throw Exception(filename + " is not a recording file");
+    if(header.version != fileVersion)
+        throw Exception("Unsupported version " + std::to_string(header.version) + " of recording file " + filename);
+
+    readIndex();
+}
+
+void RecordingFileReader::readIndex() {
+    if(m_fileSize >= sizeof(FileHeader) + sizeof(IndexHeader) + sizeof(IndexTrailer)) {
+        IndexTrailer trailer;
+        m_file.seekg(m_fileSize - sizeof(IndexTrailer));
+        m_file.read((char*)&trailer, sizeof(trailer));
+        if(m_file.good() && std::equal(indexMagic, indexMagic + sizeof(indexMagic), trailer.magic) &&
+                trailer.indexOffset + sizeof(IndexHeader) + sizeof(IndexTrailer) <= m_fileSize) {
+            IndexHeader header;
+            m_file.seekg(trailer.indexOffset);
+            m_file.read((char*)&header, sizeof(header));
+            if(m_file.good() && header.magic == indexHeaderMagic && trailer.indexOffset + sizeof(IndexHeader) +
+                    header.nrOfFrames*sizeof(RecordingFrameIndex) + sizeof(IndexTrailer) == m_fileSize) {
+                m_index.resize(header.nrOfFrames);
+                m_file.read((char*)m_index.data(), m_index.size()*sizeof(RecordingFrameIndex));
+                if(m_file.good())
+                    return;
+            }
+        }
+    }
+    m_file.clear();
+    scanFrames();
+}
+
+void RecordingFileReader::scanFrames() {
+    Reporter::warning() << "Recording file " << m_filename << " has no index, scanning frames" << Reporter::end();
+    m_index.clear();
+    uint64_t offset = sizeof(FileHeader);
+    while(offset + sizeof(FrameHeader) <= m_fileSize) {
+        FrameHeader header;
+        m_file.seekg(offset);
+        m_file.read((char*)&header, sizeof(header));
+        if(!m_file.good() || header.magic != frameMagic)
+            break;
+        const uint64_t end = offset + sizeof(FrameHeader) + header.frameDataSize + header.storedSize;
+        // Last frame may only be partially written
+        if(end > m_fileSize)
+            break;
+        m_index.push_back({offset, header.timestamp});
+        offset = end;
+    }
+    m_file.clear();
+}
+
+uint64_t RecordingFileReader::getNrOfFrames() const {
+    return m_index.size();
+}
+
+uint64_t RecordingFileReader::getTimestamp(uint64_t frame) const {
+    if(frame >= m_index.size())
+        throw OutOfBoundsException();
+    return m_index[frame].timestamp;
+}
+
+uint64_t RecordingFileReader::findFrame(uint64_t timestamp) const {
+    auto it = std::upper_bound(m_index.begin(), m_index.end(), timestamp, [](uint64_t timestamp, const RecordingFrameIndex& frame) {
+        return timestamp < frame.timestamp;
+    });
+    if(it == m_index.begin())
+        return 0;
+    return (it - m_index.begin()) - 1;
+}
+
+SharedPointer<Image> RecordingFileReader::readFrame(uint64_t frame) {
+    if(frame >= m_index.size())
+        throw OutOfBoundsException();
+
+    FrameHeader header;
+    std::vector<uint8_t> frameData;
+    std::vector<uint8_t> storedData;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_file.seekg(m_index[frame].offset);
+        m_file.read((char*)&header, sizeof(header));
+        const uint64_t headerEnd = m_index[frame].offset + sizeof(header);
+        if(!m_file.good() || headerEnd > m_fileSize || !isValidFrameHeader(header, m_fileSize - headerEnd)) {
+            m_file.clear();
+            throw Exception("Frame " + std::to_string(frame) + " in recording file " + m_filename + " is corrupt");
+        }
+        frameData.resize(header.frameDataSize);
+        m_file.read((char*)frameData.data(), frameData.size());
+        storedData.resize(header.storedSize);
+        m_file.read((char*)storedData.data(), storedData.size());
+        if(!m_file.good()) {
+            m_file.clear();
+            throw Exception("Frame " + std::to_string(frame) + " in recording file " + m_filename + " is truncated");
+        }
+    }
+
+    const DataType type = (DataType)header.dataType;
+    const std::size_t elements = (std::size_t)header.size[0]*header.size[1]*header.size[2]*header.channels;
+    auto data = allocatePixelArray(elements, type);
+    if(header.compression == (uint32_t)RecordingCompression::NONE) {
+        std::copy(storedData.begin(), storedData.end(), (uint8_t*)data.get());
+    } else {
+        uLongf size = header.dataSize;
+        if(uncompress((Bytef*)data.get(), &size, storedData.data(), storedData.size()) != Z_OK || size != header.dataSize)
+            throw Exception("Error while decompressing frame " + std::to_string(frame) + " in recording file " + m_filename);
+    }
+
+    VectorXui size(header.dimensions);
+    for(int i = 0; i < header.dimensions; ++i)
+        size[i] = header.size[i];
+    auto image = Image::New();
+    image->create(size, type, header.channels, std::move(data));
+    image->setSpacing(Vector3f(header.spacing[0], header.spacing[1], header.spacing[2]));
+    image->setCreationTimestamp(header.timestamp);
+    std::size_t position = 0;
+    for(auto&& item : readMap(frameData, position))
+        image->setFrameData(item.first, item.second);
+    image->setMetadata(readMap(frameData, position));
+    Affine3f transform;
+    std::copy_n(header.transform, 16, transform.matrix().data());
+    auto T = AffineTransformation::New();
+    T->setTransform(transform);
+    image->getSceneGraphNode()->setTransformation(T);
+
+    return image;
+}
+
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "FAST/Data/DataTypes.hpp"
+#include "FAST/SmartPointers.hpp"
+#include <fstream>
+#include <mutex>
+
+namespace fast {
+
+class Image;
+
+/**
+ * Compression of the pixel data of each frame in a recording file
+ */
+enum class RecordingCompression {
+    // Store pixel data as is
+    NONE = 0,
+    // zlib with the fastest level, which is fast enough to keep up with most live streams
+    FAST = 1,
+    // zlib with the default level, which gives smaller files, but is several times slower
+    DEFAULT = 2,
+};
+
+/**
+ * Frame of a recording file. The frame itself is stored at offset in the file.
+ */
+struct RecordingFrameIndex {
+    uint64_t offset;
+    uint64_t timestamp;
+};
+
+/**
+ * Writes a stream of images to a single append-only recording file, typically with the extension .fastrec.
+ *
+ * The file consists of a header followed by one chunk per frame. Each chunk has the size, type, spacing,
+ * transformation, timestamp, frame data and metadata of the image, followed by the pixel data.
+ * Each frame is flushed to disk when it is added. When the writer is closed, an index of all frames is appended to
+ * the file, which lets RecordingFileReader seek to any frame without reading the file. If a recording was never
+ * closed, for instance because the application crashed, the reader rebuilds the index by scanning the chunks.
+ *
+ * The writer is not thread safe.
+ */
+class FAST_EXPORT RecordingFileWriter {
+    public:
+        /**
+         * Create a new recording file, overwriting any existing file
+         * @param filename
+         * @param compression
+         */
+        explicit RecordingFileWriter(std::string filename, RecordingCompression compression = RecordingCompression::FAST);
+        void addFrame(SharedPointer<Image> image);
+        /**
+         * Write the frame index and close the file. No more frames can be added after this.
+         */
+        void close();
+        uint64_t getNrOfFrames() const;
+        ~RecordingFileWriter();
+    private:
+        std::ofstream m_file;
+        RecordingCompression m_compression;
+        std::vector<RecordingFrameIndex> m_index;
+        // Reused between frames to avoid reallocating
+        std::vector<uint8_t> m_compressedData;
+};
+
+/**
+ * Reads frames in any order from a recording file created by RecordingFileWriter.
+ * The reader is thread safe.
+ */
+class FAST_EXPORT RecordingFileReader {
+    public:
+        explicit RecordingFileReader(std::string filename);
+        uint64_t getNrOfFrames() const;
+        uint64_t getTimestamp(uint64_t frame) const;
+        /**
+         * Find the frame with the given timestamp, or the last frame before it.
+         * Timestamps are assumed to be increasing.
+         * @param timestamp
+         * @return frame nr
+         */
+        uint64_t findFrame(uint64_t timestamp) const;
+        /**
+         * Read a frame into a new image on the host
+         * @param frame nr, starting at 0
+         * @return image
+         */
+        SharedPointer<Image> readFrame(uint64_t frame);
+    private:
+        void readIndex();
+        // Rebuild the index from the frame chunks, when the recording was not closed
+        void scanFrames();
+
+        std::string m_filename;
+        std::ifstream m_file;
+        uint64_t m_fileSize;
+        std::vector<RecordingFrameIndex> m_index;
+        std::mutex m_mutex;
+};
+
+}
@@ -30,10 +30,33 @@ void StreamToFileExporter::setFrameLimit(uint64_t limit) {
     m_frameLimit = limit;
 }
 
+void StreamToFileExporter::setFormat(Format format) {
+    if(m_hasStarted)
+        throw Exception("Format can't be changed during a recording in StreamToFileExporter, call reset first");
+    m_format = format;
+}
+
+void StreamToFileExporter::setCompression(RecordingCompression compression) {
+    if(m_hasStarted)
+        throw Exception("Compression can't be changed during a recording in StreamToFileExporter, call reset first");
+    m_compression = compression;
+}
+
+void StreamToFileExporter::setQueueSize(uint size) {
+    if(size == 0)
+        throw Exception("Queue size of StreamToFileExporter must be at least 1");
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    m_queueSize = size;
+}
+
 uint64_t StreamToFileExporter::getFrameCounter() const {
     return m_frameCounter;
 }
 
+uint64_t StreamToFileExporter::getNrOfDroppedFrames() const {
+    return m_droppedFrames;
+}
+
 void StreamToFileExporter::execute() {
     // Get data object
     auto input = getInputData<DataObject>();
@@ -43,6 +66,15 @@ void StreamToFileExporter::execute() {
         addOutputData(0, input);
         return;
     }
+    const bool isImage = std::dynamic_pointer_cast<Image>(input) != nullptr;
+    const bool isMesh = std::dynamic_pointer_cast<Mesh>(input) != nullptr;
+    if(!isImage && !isMesh)
+        throw Exception("StreamToFileExporter can only handle Image and Mesh data objects");
+    if(!isImage && m_format == Format::SINGLE_FILE)
+        throw Exception("StreamToFileExporter can only record Image data objects to a single file");
+    // Report errors from writing previous frames
+    throwWriterError();
+
     if(!m_hasStarted) {
         m_currentFolder = m_folder;
         // Use timestamp to create folder if one is not already set
@@ -51,6 +83,10 @@ void StreamToFileExporter::execute() {
         }
         // Create directory
         createDirectories(join(m_path, m_currentFolder));
+        if(m_format == Format::SINGLE_FILE)
+            m_recordingFile = std::make_unique<RecordingFileWriter>(join(m_path, m_currentFolder, m_filename + ".fastrec"), m_compression);
+        m_stopWriter = false;
+        m_writerThread = std::make_unique<std::thread>(std::bind(&StreamToFileExporter::writerThread, this));
         m_hasStarted = true;
         m_recordingStartTime = std::chrono::high_resolution_clock::now();
     }
@@ -58,10 +94,58 @@ void StreamToFileExporter::execute() {
     if(m_frameCounter >= m_frameLimit)
         throw Exception("Maximum nr of frames (" + std::to_string(m_frameLimit) + ") reached in StreamToFileExporter");
 
-    std::string currentFileName = join(m_path, m_currentFolder, m_filename + "_" + std::to_string(m_frameCounter));
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        if(m_queue.size() >= m_queueSize) {
+            // Never block the pipeline, drop the frame instead
+            m_droppedFrames += 1;
+            reportWarning() << "Writing is too slow in StreamToFileExporter, dropped frame" << reportEnd();
+        } else {
+            m_queue.push_back(std::make_pair(input, m_frameCounter));
+            m_frameCounter += 1;
+        }
+    }
+    m_queueCondition.notify_all();
+    addOutputData(0, input);
+}
+
+void StreamToFileExporter::writerThread() {
+    while(true) {
+        std::pair<DataObject::pointer, uint64_t> frame;
+        {
+            std::unique_lock<std::mutex> lock(m_queueMutex);
+            m_queueCondition.wait(lock, [this]() { return m_stopWriter || !m_queue.empty(); });
+            // Frames left in the queue are written before stopping
+            if(m_queue.empty())
+                break;
+            frame = m_queue.front();
+            m_queue.pop_front();
+            m_isWriting = true;
+        }
+        try {
+            writeFrame(frame.first, frame.second);
+        } catch(...) {
+            std::lock_guard<std::mutex> lock(m_queueMutex);
+            m_writerError = std::current_exception();
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_queueMutex);
+            m_isWriting = false;
+        }
+        m_queueCondition.notify_all();
+    }
+}
+
+void StreamToFileExporter::writeFrame(DataObject::pointer input, uint64_t frameNr) {
+    if(m_format == Format::SINGLE_FILE) {
+        m_recordingFile->addFrame(std::static_pointer_cast<Image>(input));
+        return;
+    }
+
+    std::string currentFileName = join(m_path, m_currentFolder, m_filename + "_" + std::to_string(frameNr));
     if(auto imageInput = std::dynamic_pointer_cast<Image>(input)) {
         auto exporter = MetaImageExporter::New();
-        exporter->enableCompression();
+        exporter->setCompression(m_compression != RecordingCompression::NONE);
         exporter->setFilename(currentFileName + ".mhd");
         exporter->setInputData(input);
         exporter->update();
@@ -70,17 +154,50 @@ void StreamToFileExporter::execute() {
         exporter->setFilename(currentFileName + ".vtk");
         exporter->setInputData(input);
         exporter->update();
-    } else {
-        throw Exception("StreamToFileExporter can only handle Image and Mesh data objects");
     }
-    m_frameCounter += 1;
-    addOutputData(0, input);
+}
+
+void StreamToFileExporter::throwWriterError() {
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        std::swap(error, m_writerError);
+    }
+    if(error)
+        std::rethrow_exception(error);
+}
+
+void StreamToFileExporter::flush() {
+    {
+        std::unique_lock<std::mutex> lock(m_queueMutex);
+        m_queueCondition.wait(lock, [this]() { return m_queue.empty() && !m_isWriting; });
+    }
+    throwWriterError();
+}
+
+void StreamToFileExporter::stopWriter() {
+    if(m_writerThread) {
+        {
+            std::lock_guard<std::mutex> lock(m_queueMutex);
+            m_stopWriter = true;
+        }
+        m_queueCondition.notify_all();
+        m_writerThread->join();
+        m_writerThread.reset();
+    }
+    if(m_recordingFile) {
+        m_recordingFile->close();
+        m_recordingFile.reset();
+    }
 }
 
 void StreamToFileExporter::reset() {
+    stopWriter();
     m_frameCounter = 0;
+    m_droppedFrames = 0;
     m_currentFolder = "";
     m_hasStarted = false;
+    throwWriterError();
 }
 
 StreamToFileExporter::StreamToFileExporter() {
@@ -88,6 +205,14 @@ StreamToFileExporter::StreamToFileExporter() {
     createOutputPort<DataObject>(0);
 }
 
+StreamToFileExporter::~StreamToFileExporter() {
+    try {
+        stopWriter();
+    } catch(std::exception& e) {
+        reportError() << "Error while finishing recording in StreamToFileExporter: " << e.what() << reportEnd();
+    }
+}
+
 bool StreamToFileExporter::isEnabled() {
     return m_enabled;
 }
@@ -1,26 +1,76 @@
 #pragma once
 
 #include <FAST/ProcessObject.hpp>
+#include <FAST/Exporters/RecordingFile.hpp>
+#include <atomic>
 #include <chrono>
+#include <deque>
+#include <thread>
+#include <condition_variable>
 
 namespace fast {
 
+/**
+ * Records a stream of images or meshes to disk, and passes each frame on unchanged.
+ *
+ * Frames are written by a background thread, thus recording does not slow down the pipeline.
+ * If the writer can't keep up, frames are queued up to the queue size, and frames arriving when the queue is full
+ * are dropped instead of blocking the pipeline. Use getNrOfDroppedFrames to check if this happened.
+ */
 class FAST_EXPORT StreamToFileExporter : public ProcessObject {
     FAST_OBJECT(StreamToFileExporter)
     public:
+        enum class Format {
+            // One .mhd/.zraw file pair per image frame, or one .vtk file per mesh frame
+            FILES,
+            // All frames in a single recording file, see RecordingFileWriter. Only supports images.
+            SINGLE_FILE,
+        };
         void setPath(std::string path);
         void setRecordingFolderName(std::string folder);
         void setFrameFilename(std::string name);
         void setEnabled(bool enabled);
         void setFrameLimit(uint64_t limit);
+        /**
+         * Set how frames are stored. Default is Format::FILES
+         * @param format
+         */
+        void setFormat(Format format);
+        /**
+         * Set compression of image frames. With Format::FILES, any compression other than NONE uses
+         * the default zlib compression of MetaImageExporter. Default is RecordingCompression::DEFAULT.
+         * @param compression
+         */
+        void setCompression(RecordingCompression compression);
+        /**
+         * Set max nr of frames waiting to be written. Default is 64.
+         * @param size
+         */
+        void setQueueSize(uint size);
         uint64_t getFrameCounter() const;
+        /**
+         * @return nr of frames which were not recorded because the queue was full
+         */
+        uint64_t getNrOfDroppedFrames() const;
         std::string getCurrentDestinationFolder() const;
         float getRecordingDuration() const;
+        /**
+         * Block until all queued frames have been written to disk
+         */
+        void flush();
+        /**
+         * Finish writing the current recording, and start a new recording with the next frame
+         */
         void reset();
         bool isEnabled();
+        ~StreamToFileExporter();
     private:
         StreamToFileExporter();
         void execute() override;
+        void writerThread();
+        void writeFrame(DataObject::pointer data, uint64_t frameNr);
+        void stopWriter();
+        void throwWriterError();
 
         std::string m_path = "";
         std::string m_folder;
@@ -31,6 +81,20 @@ class FAST_EXPORT StreamToFileExporter : public ProcessObject {
         std::chrono::high_resolution_clock::time_point m_recordingStartTime;
         bool m_enabled = true;
         bool m_hasStarted = false;
+        Format m_format = Format::FILES;
+        RecordingCompression m_compression = RecordingCompression::DEFAULT;
+
+        std::unique_ptr<std::thread> m_writerThread;
+        std::unique_ptr<RecordingFileWriter> m_recordingFile;
+        // Frames waiting to be written, with their frame nr
+        std::deque<std::pair<DataObject::pointer, uint64_t>> m_queue;
+        uint m_queueSize = 64;
+        std::atomic<uint64_t> m_droppedFrames = {0};
+        bool m_stopWriter = false;
+        bool m_isWriting = false;
+        std::exception_ptr m_writerError;
+        std::mutex m_queueMutex;
+        std::condition_variable m_queueCondition;
 };
 
-}
\ No newline at end of file
+}
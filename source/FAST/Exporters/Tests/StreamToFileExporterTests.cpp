@@ -0,0 +1,149 @@
+#include "FAST/Testing.hpp"
+#include "FAST/Exporters/StreamToFileExporter.hpp"
+#include "FAST/Exporters/RecordingFile.hpp"
+#include "FAST/Data/Image.hpp"
+#include "FAST/Data/Mesh.hpp"
+#include "FAST/SceneGraph.hpp"
+#include "FAST/Utility.hpp"
+#include <fstream>
+
+using namespace fast;
+
+static Image::pointer createFrame(int nr) {
+    auto image = Image::New();
+    image->create(64, 32, TYPE_UINT8, 1);
+    image->fill(nr);
+    image->setSpacing(Vector3f(0.5f, 0.25f, 1.0f));
+    image->setCreationTimestamp(1000 + nr*20);
+    image->setFrameData("nr", std::to_string(nr));
+    auto T = AffineTransformation::New();
+    Affine3f transform = Affine3f::Identity();
+    transform.translate(Vector3f(nr, 2, 3));
+    T->setTransform(transform);
+    image->getSceneGraphNode()->setTransformation(T);
+    return image;
+}
+
+static void checkFrame(Image::pointer image, int nr) {
+    CHECK(image->getWidth() == 64);
+    CHECK(image->getHeight() == 32);
+    CHECK(image->getDimensions() == 2);
+    CHECK(image->getDataType() == TYPE_UINT8);
+    CHECK(image->getSpacing().y() == Approx(0.25f));
+    CHECK(image->getCreationTimestamp() == 1000 + nr*20);
+    CHECK(image->getFrameData("nr") == std::to_string(nr));
+    CHECK(SceneGraph::getAffineTransformationFromData(image)->getTransform().translation().x() == Approx(nr));
+    auto access = image->getImageAccess(ACCESS_READ);
+    auto data = (uchar*)access->get();
+    CHECK(data[0] == nr);
+    CHECK(data[64*32 - 1] == nr);
+}
+
+TEST_CASE("Record stream to a single file and read it back", "[fast][StreamToFileExporter]") {
+    for(auto compression : {RecordingCompression::NONE, RecordingCompression::FAST, RecordingCompression::DEFAULT}) {
+        auto exporter = StreamToFileExporter::New();
+        exporter->setPath("StreamToFileExporterTest");
+        exporter->setRecordingFolderName("singleFile");
+        exporter->setFormat(StreamToFileExporter::Format::SINGLE_FILE);
+        exporter->setCompression(compression);
+        for(int i = 0; i < 10; ++i) {
+            exporter->setInputData(createFrame(i));
+            exporter->update();
+        }
+        exporter->flush();
+        CHECK(exporter->getFrameCounter() == 10);
+        CHECK(exporter->getNrOfDroppedFrames() == 0);
+        const std::string filename = join(exporter->getCurrentDestinationFolder(), "frame.fastrec");
+        // Finish recording, which writes the frame index
+        exporter->reset();
+
+        RecordingFileReader reader(filename);
+        REQUIRE(reader.getNrOfFrames() == 10);
+        CHECK(reader.getTimestamp(3) == 1060);
+        CHECK(reader.findFrame(1065) == 3);
+        for(int i : {7, 0, 9}) {
+            checkFrame(reader.readFrame(i), i);
+        }
+    }
+}
+
+TEST_CASE("Read recording file which was not closed", "[fast][StreamToFileExporter]") {
+    createDirectories("StreamToFileExporterTest");
+    RecordingFileWriter writer("StreamToFileExporterTest/notClosed.fastrec");
+    for(int i = 0; i < 5; ++i)
+        writer.addFrame(createFrame(i));
+
+    // Frames have been flushed to disk, but there is no index yet
+    RecordingFileReader reader("StreamToFileExporterTest/notClosed.fastrec");
+    REQUIRE(reader.getNrOfFrames() == 5);
+    checkFrame(reader.readFrame(4), 4);
+}
+
+TEST_CASE("Read recording file with corrupt frame header", "[fast][StreamToFileExporter]") {
+    // Offset in the file of a field of the first frame header, and an invalid value of it
+    const std::vector<std::pair<int, int64_t>> corruptions = {
+        {16 + 140, 7}, // dimensions
+        {16 + 140, -1}, // dimensions
+        {16 + 44, 42}, // data type
+        {16 + 60, 0}, // channels
+        {16 + 60, 5}, // channels
+        {16 + 56, 2}, // depth of 2D image
+        {16 + 48, -64}, // width
+        {16 + 32, (int64_t)1 << 40}, // stored size larger than the file
+        {16 + 40, 1 << 30}, // frame data size larger than the file
+    };
+    createDirectories("StreamToFileExporterTest");
+    for(auto&& corruption : corruptions) {
+        const std::string filename = "StreamToFileExporterTest/corrupt.fastrec";
+        {
+            RecordingFileWriter writer(filename, RecordingCompression::NONE);
+            for(int i = 0; i < 2; ++i)
+                writer.addFrame(createFrame(i));
+            writer.close();
+        }
+        {
+            std::fstream file(filename, std::ios::in | std::ios::out | std::ios::binary);
+            file.seekp(corruption.first);
+            // Stored size is 64 bit, the other fields are 32 bit
+            if(corruption.first == 16 + 32) {
+                const uint64_t value = corruption.second;
+                file.write((const char*)&value, sizeof(value));
+            } else {
+                const int32_t value = (int32_t)corruption.second;
+                file.write((const char*)&value, sizeof(value));
+            }
+        }
+        RecordingFileReader reader(filename);
+        REQUIRE(reader.getNrOfFrames() == 2);
+        std::string error;
+        try {
+            reader.readFrame(0);
+        } catch(Exception& e) {
+            error = e.what();
+        }
+        CHECK(error.find("is corrupt") != std::string::npos);
+        checkFrame(reader.readFrame(1), 1);
+    }
+}
+
+TEST_CASE("Record stream to files", "[fast][StreamToFileExporter]") {
+    auto exporter = StreamToFileExporter::New();
+    exporter->setPath("StreamToFileExporterTest");
+    exporter->setRecordingFolderName("files");
+    for(int i = 0; i < 3; ++i) {
+        exporter->setInputData(createFrame(i));
+        exporter->update();
+    }
+    exporter->flush();
+    for(int i = 0; i < 3; ++i) {
+        CHECK(fileExists(join(exporter->getCurrentDestinationFolder(), "frame_" + std::to_string(i) + ".mhd")));
+    }
+}
+
+TEST_CASE("StreamToFileExporter can't record meshes to a single file", "[fast][StreamToFileExporter]") {
+    auto exporter = StreamToFileExporter::New();
+    exporter->setPath("StreamToFileExporterTest");
+    exporter->setFormat(StreamToFileExporter::Format::SINGLE_FILE);
+    exporter->setInputData(Mesh::New());
+    CHECK_THROWS(exporter->update());
+}
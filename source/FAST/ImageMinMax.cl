@@ -5,7 +5,7 @@
 #define READ_IMAGE read_imagef
 #define WRITE_IMAGE write_imagef
 #define MAX_VALUE FLT_MAX
-#define MIN_VALUE FLT_MIN
+#define MIN_VALUE -FLT_MAX
 #elif TYPE_UINT8
 #define TYPE uint4
 #define BUFFER_TYPE uchar
@@ -144,15 +144,15 @@ __kernel void reduce(
         __global BUFFER_TYPE* buffer,
         __local BUFFER_TYPE* minScratch,
         __local BUFFER_TYPE* maxScratch,
-        __private int length,
-        __private int X,
+        __private ulong length,
+        __private ulong X,
         __global BUFFER_TYPE* result) {
 
-    int global_index = get_global_id(0)*X;
+    ulong global_index = get_global_id(0)*X;
     BUFFER_TYPE minAccumulator = MAX_VALUE;
     BUFFER_TYPE maxAccumulator = MIN_VALUE;
     // Loop sequentially over chunks of input vector
-    for(int i = 0; i < X && global_index < length; i++) {
+    for(ulong i = 0; i < X && global_index < length; i++) {
         float element = buffer[global_index];
         minAccumulator = (minAccumulator < element) ? minAccumulator : element;
         maxAccumulator = (maxAccumulator > element) ? maxAccumulator : element;
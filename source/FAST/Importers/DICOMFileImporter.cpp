@@ -4,6 +4,9 @@
 #include <dcmtk/dcmdata/dcdeftag.h>
 #include <dcmtk/dcmimgle/dcmimage.h>
 #include "FAST/Data/Image.hpp"
+#include <algorithm>
+#include <cstring>
+#include <sys/stat.h>
 
 namespace fast {
 
@@ -12,6 +15,9 @@ DICOMFileImporter::DICOMFileImporter() {
 }
 
 void DICOMFileImporter::setFilename(std::string filename) {
+    // Only headers of the current directory are kept
+    if(getDirName(filename) != getDirName(mFilename))
+        m_headerCache.clear();
     mFilename = filename;
     mIsModified = true;
 }
@@ -21,14 +27,6 @@ void DICOMFileImporter::setLoadSeries(bool load) {
     mIsModified = true;
 }
 
-template <class T>
-static void* readRawData(const DiPixel* pixelData) {
-    const void* data = pixelData->getData();
-    T* outputData = new T[pixelData->getCount()];
-    memcpy(outputData, data, pixelData->getCount()*sizeof(T));
-    return outputData;
-}
-
 static DataType getDataType(const DicomImage &image) {
     const DiPixel* pixelData = image.getInterData();
     EP_Representation rep = pixelData->getRepresentation();
@@ -54,71 +52,70 @@ static DataType getDataType(const DicomImage &image) {
     return type;
 }
 
-static void* getDataFromImage(const DicomImage &image, DataType &type) {
+/**
+ * Copy the decoded pixel data of a DICOM image directly to its place in the destination
+ */
+static void copySlice(const DicomImage& image, const std::string& filename, int width, int height, DataType type, void* destination) {
+    if(image.getStatus() != EIS_Normal)
+        throw Exception("Error: cannot decode DICOM file " + filename + " (" + DicomImage::getString(image.getStatus()) + ")");
+    if(image.getWidth() != (unsigned long)width || image.getHeight() != (unsigned long)height)
+        throw Exception("DICOM file " + filename + " has a different size than the rest of the series");
+    if(getDataType(image) != type)
+        throw Exception("DICOM file " + filename + " has a different data type than the rest of the series");
     const DiPixel* pixelData = image.getInterData();
-    EP_Representation rep = pixelData->getRepresentation();
-    void* data;
-    switch(rep) {
-        case EPR_Sint8:
-            type = TYPE_INT8;
-            data = readRawData<char>(pixelData);
-            break;
-        case EPR_Uint8:
-            type = TYPE_UINT8;
-            data = readRawData<uchar>(pixelData);
-            break;
-        case EPR_Sint16:
-            type = TYPE_INT16;
-            data = readRawData<short>(pixelData);
-            break;
-        case EPR_Uint16:
-            type = TYPE_UINT16;
-            data = readRawData<ushort>(pixelData);
-            break;
-        case EPR_Sint32:
-        case EPR_Uint32:
-            throw Exception("Unsupported data type of 32 bit integer in DICOMFileImporter");
-            break;
+    std::memcpy(destination, pixelData->getData(), (std::size_t)width*height*getSizeOfDataType(type, 1));
+}
+
+DICOMFileImporter::DICOMHeader DICOMFileImporter::readHeader(const std::string& filename) {
+    DICOMHeader header;
+    DcmFileFormat fileformat;
+    // Skip loading long element values, such as the pixel data
+    if(!fileformat.loadFile(filename.c_str(), EXS_Unknown, EGL_noChange, 256).good())
+        return header;
+    DcmDataset* dataset = fileformat.getDataset();
+    OFString seriesID;
+    Uint16 rows, columns;
+    if(!dataset->findAndGetOFString(DCM_SeriesInstanceUID, seriesID).good() ||
+        !dataset->findAndGetUint16(DCM_Rows, rows).good() ||
+        !dataset->findAndGetUint16(DCM_Columns, columns).good())
+        return header;
+    header.valid = true;
+    header.seriesInstanceUID = seriesID.c_str();
+    header.width = columns;
+    header.height = rows;
+    Sint32 instanceNumber = 0;
+    dataset->findAndGetSint32(DCM_InstanceNumber, instanceNumber);
+    header.instanceNumber = instanceNumber;
+
+    Float64 position[3];
+    Float64 orientation[6];
+    header.hasPosition = true;
+    for(int i = 0; i < 3; ++i)
+        header.hasPosition = header.hasPosition && dataset->findAndGetFloat64(DCM_ImagePositionPatient, position[i], i).good();
+    for(int i = 0; i < 6; ++i)
+        header.hasPosition = header.hasPosition && dataset->findAndGetFloat64(DCM_ImageOrientationPatient, orientation[i], i).good();
+    if(header.hasPosition) {
+        header.position = Vector3f(position[0], position[1], position[2]);
+        const Vector3f rowDirection(orientation[0], orientation[1], orientation[2]);
+        const Vector3f columnDirection(orientation[3], orientation[4], orientation[5]);
+        header.normal = rowDirection.cross(columnDirection);
     }
 
-    return data;
+    return header;
 }
 
-static void* inserSliceFromImage(const DicomImage &image, int width, int height, int sliceNr, void* data) {
-    const DiPixel* pixelData = image.getInterData();
-    EP_Representation rep = pixelData->getRepresentation();
-    int currentPosition = width*height*sliceNr;
-    DataType type;
-    void* sliceData;
-    switch(rep) {
-        case EPR_Sint8:
-            type = TYPE_INT8;
-            sliceData = readRawData<char>(pixelData);
-            memcpy((char*)data + currentPosition, sliceData, width*height*getSizeOfDataType(type, 1));
-            break;
-        case EPR_Uint8:
-            type = TYPE_UINT8;
-            sliceData = readRawData<uchar>(pixelData);
-            memcpy((uchar*)data + currentPosition, sliceData, width*height*getSizeOfDataType(type, 1));
-            break;
-        case EPR_Sint16:
-            type = TYPE_INT16;
-            sliceData = readRawData<short>(pixelData);
-            memcpy((short*)data + currentPosition, sliceData, width*height*getSizeOfDataType(type, 1));
-            break;
-        case EPR_Uint16:
-            type = TYPE_UINT16;
-            sliceData = readRawData<ushort>(pixelData);
-            memcpy((ushort*)data + currentPosition, sliceData, width*height*getSizeOfDataType(type, 1));
-            break;
-        case EPR_Sint32:
-        case EPR_Uint32:
-            throw Exception("Unsupported data type of 32 bit integer in DICOMFileImporter");
-            break;
+DICOMFileImporter::CachedHeader DICOMFileImporter::getHeader(const std::string& filename) const {
+    CachedHeader result;
+    struct stat status;
+    if(stat(filename.c_str(), &status) == 0) {
+        result.fileSize = status.st_size;
+        result.modifiedTime = status.st_mtime;
     }
-    deleteArray(sliceData, type);
-
-    return data;
+    auto cached = m_headerCache.find(filename);
+    if(cached != m_headerCache.end() && cached->second.fileSize == result.fileSize && cached->second.modifiedTime == result.modifiedTime)
+        return cached->second;
+    result.header = readHeader(filename);
+    return result;
 }
 
 void DICOMFileImporter::execute() {
@@ -126,71 +123,109 @@ void DICOMFileImporter::execute() {
         throw Exception("DICOMFileImporter needs filename to be set");
 
     DcmFileFormat fileformat;
-    OFCondition status = fileformat.loadFile(mFilename.c_str());
+    OFCondition status = fileformat.loadFile(mFilename.c_str(), EXS_Unknown, EGL_noChange, 256);
     if(status.good()) {
         Image::pointer output = getOutputData<Image>();
         // Get pixel spacing
-        Float64 spacingX;
-        Float64 spacingY;
-        Float64 spacingZ;
+        Float64 spacingX = 1;
+        Float64 spacingY = 1;
+        Float64 spacingZ = 1;
         fileformat.getDataset()->findAndGetFloat64(DCM_PixelSpacing, spacingX, 0);
         fileformat.getDataset()->findAndGetFloat64(DCM_PixelSpacing, spacingY, 1);
         fileformat.getDataset()->findAndGetFloat64(DCM_SliceThickness, spacingZ);
         if(mLoadSeries) {
-            // Get series ID first
-            OFString seriesID;
-            if(!fileformat.getDataset()->findAndGetOFString(DCM_SeriesInstanceUID, seriesID).good())
-                throw Exception("Could not get series instance UID of DICOM file.");
+            m_headerCache[mFilename] = getHeader(mFilename);
+            const DICOMHeader selectedHeader = m_headerCache[mFilename].header;
+            if(!selectedHeader.valid)
+                throw Exception("Could not get series instance UID and size of DICOM file.");
 
-            // Get all files in directory which has same series instance UID
+            // Read headers of all files in directory which are not cached or have changed, in parallel
             std::string dirName = getDirName(mFilename);
             std::vector<std::string> files = getDirectoryList(dirName);
-            std::vector<std::string> seriesFiles;
-            for(auto&& file : files) {
-                OFString seriesID2;
-                DcmFileFormat fileformat2;
-                OFCondition status = fileformat2.loadFile((dirName + "/" + file).c_str());
-                fileformat2.getDataset()->findAndGetOFString(DCM_SeriesInstanceUID, seriesID2);
-                if(seriesID == seriesID2) {
-                    seriesFiles.push_back(dirName + "/" + file);
+            std::vector<CachedHeader> headers(files.size());
+            #pragma omp parallel for schedule(dynamic)
+            for(int i = 0; i < files.size(); ++i)
+                headers[i] = getHeader(dirName + "/" + files[i]);
+
+            // Get all files in directory which has same series instance UID and size
+            std::vector<std::pair<std::string, DICOMHeader>> series;
+            for(int i = 0; i < files.size(); ++i) {
+                const std::string path = dirName + "/" + files[i];
+                m_headerCache[path] = headers[i];
+                const DICOMHeader& header = headers[i].header;
+                if(header.valid && header.seriesInstanceUID == selectedHeader.seriesInstanceUID) {
+                    if(header.width == selectedHeader.width && header.height == selectedHeader.height) {
+                        series.push_back({path, header});
+                    } else {
+                        reportWarning() << "Skipping DICOM file " << path << " of series, as it has a different size" << reportEnd();
+                    }
                 }
             }
 
-            // Get size and type of image
-            DicomImage image(mFilename.c_str());
-            const int width = image.getWidth();
-            const int height = image.getHeight();
-            const int depth = seriesFiles.size();
-            const DataType type = getDataType(image);
+            if(series.empty())
+                throw Exception("Could not find any DICOM files of the series in " + dirName);
+
+            // Sort slices by position along the slice normal, or by instance number if positions are missing
+            const bool usePositions = std::all_of(series.begin(), series.end(), [](const std::pair<std::string, DICOMHeader>& slice) {
+                return slice.second.hasPosition;
+            });
+            auto getSliceLocation = [&](const DICOMHeader& header) {
+                return usePositions ? header.position.dot(selectedHeader.normal) : (float)header.instanceNumber;
+            };
+            std::stable_sort(series.begin(), series.end(), [&](const std::pair<std::string, DICOMHeader>& a, const std::pair<std::string, DICOMHeader>& b) {
+                return getSliceLocation(a.second) < getSliceLocation(b.second);
+            });
+            if(usePositions && series.size() > 1) {
+                const float sliceDistance = getSliceLocation(series[1].second) - getSliceLocation(series[0].second);
+                if(sliceDistance > 0)
+                    spacingZ = sliceDistance;
+            }
 
-			std::cout << "DEPTH: " << depth << std::endl;
-            // Allocate space for volume
-            void* data = allocateDataArray(width*height*depth, type, 1);
-
-            // Get data of each slice
-            for(auto&& file : seriesFiles) {
-                DcmFileFormat fileformat2;
-                OFCondition status = fileformat2.loadFile(file.c_str());
-                Sint32 sliceNr;
-                fileformat2.getDataset()->findAndGetSint32(DCM_InstanceNumber, sliceNr);
-                inserSliceFromImage(DicomImage(file.c_str()), width, height, sliceNr-1, data);
+            // Decode first slice to get type of image
+            const int width = selectedHeader.width;
+            const int height = selectedHeader.height;
+            const int depth = series.size();
+            DicomImage firstImage(series[0].first.c_str());
+            if(firstImage.getStatus() != EIS_Normal)
+                throw Exception("Error: cannot decode DICOM file " + series[0].first);
+            const DataType type = getDataType(firstImage);
+            const std::size_t sliceSize = (std::size_t)width*height*getSizeOfDataType(type, 1);
+            auto data = allocatePixelArray((std::size_t)width*height*depth, type);
+            copySlice(firstImage, series[0].first, width, height, type, data.get());
+
+            // Decode the other slices in parallel directly into the volume
+            std::string error;
+            #pragma omp parallel for schedule(dynamic)
+            for(int slice = 1; slice < depth; ++slice) {
+                try {
+                    DicomImage image(series[slice].first.c_str());
+                    copySlice(image, series[slice].first, width, height, type, (uchar*)data.get() + slice*sliceSize);
+                } catch(Exception& e) {
+                    #pragma omp critical
+                    error = e.what();
+                }
             }
+            if(!error.empty())
+                throw Exception(error);
 
-            output->create(image.getWidth(), image.getHeight(), seriesFiles.size(), type, 1, data);
+            output->create(Vector3ui(width, height, depth), type, 1, std::move(data));
             output->setSpacing(spacingX, spacingY, spacingZ);
-            deleteArray(data, type);
         } else {
             DicomImage image(mFilename.c_str());
-            DataType type;
-            void* data = getDataFromImage(image, type);
+            if(image.getStatus() != EIS_Normal)
+                throw Exception("Error: cannot decode DICOM file " + mFilename);
+            const int width = image.getWidth();
+            const int height = image.getHeight();
+            const DataType type = getDataType(image);
+            auto data = allocatePixelArray((std::size_t)width*height, type);
+            std::memcpy(data.get(), image.getInterData()->getData(), (std::size_t)width*height*getSizeOfDataType(type, 1));
 
-            output->create(image.getWidth(), image.getHeight(), type, 1, data);
+            output->create(Vector2ui(width, height), type, 1, std::move(data));
             output->setSpacing(spacingX, spacingY, 1);
-            deleteArray(data, type);
         }
     } else {
         throw Exception("Error: cannot read DICOM file " + mFilename + "(" + std::string(status.text()) + ")");
     }
 }
 
-}
\ No newline at end of file
+}
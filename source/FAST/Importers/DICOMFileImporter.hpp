@@ -3,20 +3,57 @@
 
 #include "Importer.hpp"
 #include <string>
+#include <unordered_map>
 
 namespace fast {
 
+/**
+ * Imports a DICOM image, or the entire series of the image if load series is enabled.
+ *
+ * When loading a series, the headers of all files in the directory are read in parallel without pixel data,
+ * and the slices of the series are sorted by their position along the slice normal (ImagePositionPatient),
+ * or by instance number if positions are missing. The slices are then decoded in parallel directly into the volume.
+ * Parsed headers are cached in the importer, thus loading another series from the same directory is faster.
+ * A cached header is only used if the size and modification time of the file are unchanged.
+ */
 class FAST_EXPORT DICOMFileImporter : public Importer {
     FAST_OBJECT(DICOMFileImporter)
     public:
         void setFilename(std::string filename);
         void setLoadSeries(bool load);
     private:
+        /**
+         * Header fields needed to find and sort the slices of a series
+         */
+        struct DICOMHeader {
+            bool valid = false;
+            std::string seriesInstanceUID;
+            int width = 0;
+            int height = 0;
+            int instanceNumber = 0;
+            bool hasPosition = false;
+            Vector3f position;
+            Vector3f normal;
+        };
+
+        /**
+         * Parsed header, and the size and modification time of the file when it was parsed
+         */
+        struct CachedHeader {
+            long long fileSize = -1;
+            long long modifiedTime = -1;
+            DICOMHeader header;
+        };
+
         DICOMFileImporter();
         void execute() override;
+        static DICOMHeader readHeader(const std::string& filename);
+        // Get header from the cache if the file is unchanged, or read it. Does not modify the cache.
+        CachedHeader getHeader(const std::string& filename) const;
 
         bool mLoadSeries = true;
         std::string mFilename = "";
+        std::unordered_map<std::string, CachedHeader> m_headerCache;
 };
 
 }
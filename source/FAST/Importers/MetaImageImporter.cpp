@@ -6,6 +6,14 @@
 #include <set>
 
 #include <zlib.h>
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 using namespace fast;
 
 void MetaImageImporter::setFilename(std::string filename) {
@@ -13,6 +21,11 @@ void MetaImageImporter::setFilename(std::string filename) {
     mIsModified = true;
 }
 
+void MetaImageImporter::setLazyLoading(bool lazy) {
+    m_lazyLoading = lazy;
+    mIsModified = true;
+}
+
 MetaImageImporter::MetaImageImporter() {
     mFilename = "";
     mIsModified = true;
@@ -38,10 +51,80 @@ std::vector<std::string> stringSplit(std::string str, std::string delimiter) {
     return values;
 }
 
+static void uncompressData(const Bytef* source, std::size_t sourceSize, void* destination, std::size_t destinationSize) {
+    uLongf uncompressedSize = destinationSize;
+    int z_result = uncompress((Bytef*)destination, &uncompressedSize, source, (uLong)sourceSize);
+    switch(z_result) {
+    case Z_OK:
+        break;
+    case Z_MEM_ERROR:
+        throw Exception("Out of memory while decompressing raw file");
+    case Z_BUF_ERROR:
+        throw Exception("Output buffer was not large enough while decompressing raw file");
+    case Z_DATA_ERROR:
+        throw Exception("Compressed data in raw file is corrupt");
+    }
+}
+
+/**
+ * Memory map a raw file. The mapping is private, thus pages are read from the file when first touched,
+ * and changes to the image are never written back to the file.
+ */
+static unique_pixel_ptr mapRawFile(const std::string& filename, std::size_t expectedSize) {
+#ifdef WIN32
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file == INVALID_HANDLE_VALUE)
+        throw FileNotFoundException(filename);
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(file, &size) || (std::size_t)size.QuadPart != expectedSize) {
+        CloseHandle(file);
+        throw Exception("Unexpected file size when opening " + filename + " expected: " + std::to_string(expectedSize));
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    CloseHandle(file);
+    if(mapping == NULL)
+        throw Exception("Failed to memory map " + filename);
+    void* data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+    CloseHandle(mapping); // The view keeps the mapping alive
+    if(data == NULL)
+        throw Exception("Failed to memory map " + filename);
+    return unique_pixel_ptr(data, [](void* data) { UnmapViewOfFile(data); });
+#else
+    int file = open(filename.c_str(), O_RDONLY);
+    if(file < 0)
+        throw FileNotFoundException(filename);
+    struct stat status;
+    if(fstat(file, &status) != 0 || (std::size_t)status.st_size != expectedSize) {
+        close(file);
+        throw Exception("Unexpected file size when opening " + filename + " expected: " + std::to_string(expectedSize));
+    }
+    void* data = mmap(nullptr, expectedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+    close(file); // The mapping keeps the file open
+    if(data == MAP_FAILED)
+        throw Exception("Failed to memory map " + filename);
+    return unique_pixel_ptr(data, [expectedSize](void* data) { munmap(data, expectedSize); });
+#endif
+}
+
 template <class T>
-static std::unique_ptr<T[]> readRawData(std::string rawFilename, std::size_t voxels, unsigned int nrOfComponents, bool compressed, std::size_t compressedFileSize) {
+static std::unique_ptr<T[]> readRawData(std::string rawFilename, std::size_t voxels, unsigned int nrOfComponents, bool compressed, std::size_t compressedFileSize,
+                                        std::size_t sliceSize = 0, uint chunkSize = 0, const std::vector<std::size_t>& chunkOffsets = {}) {
     auto data = make_uninitialized_unique<T[]>(voxels*nrOfComponents);
-    if(compressed) {
+    if(compressed && !chunkOffsets.empty()) {
+        // Data is compressed in chunks of chunkSize slices
+        std::ifstream file(rawFilename, std::ifstream::binary | std::ifstream::in);
+        if(!file.is_open())
+            throw FileNotFoundException(rawFilename);
+        auto fileData = make_uninitialized_unique<Bytef[]>(chunkOffsets.back());
+        file.read((char*)fileData.get(), chunkOffsets.back());
+        file.close();
+        const std::size_t chunkElements = sliceSize*chunkSize*nrOfComponents;
+        for(std::size_t chunk = 0; chunk + 1 < chunkOffsets.size(); ++chunk) {
+            const std::size_t start = chunk*chunkElements;
+            uncompressData(&fileData[chunkOffsets[chunk]], chunkOffsets[chunk + 1] - chunkOffsets[chunk],
+                           &data[start], std::min(chunkElements, voxels*nrOfComponents - start)*sizeof(T));
+        }
+    } else if(compressed) {
         // Read compressed data
         std::ifstream file(rawFilename, std::ifstream::binary | std::ifstream::in);
         if(!file.is_open())
@@ -56,33 +139,7 @@ static std::unique_ptr<T[]> readRawData(std::string rawFilename, std::size_t vox
         file.read((char*)&fileData[0], size);
         file.close();
 
-        unsigned long uncompressedSize = sizeof(T)*voxels*nrOfComponents;
-		int z_result = uncompress(
-            (Bytef*)data.get(),       // destination for the uncompressed
-                                    // data.  This should be the size of
-                                    // the original data, which you should
-                                    // already know.
-
-            (uLongf *)&uncompressedSize,  // length of destination (uncompressed)
-                                    // buffer
-
-            fileData.get(),   // source buffer - the compressed data
-
-            (uLong)compressedFileSize);   // length of compressed data in bytes
-        switch( z_result )
-        {
-        case Z_OK:
-            break;
-
-        case Z_MEM_ERROR:
-            throw Exception("Out of memory while decompressing raw file");
-            break;
-
-        case Z_BUF_ERROR:
-            throw Exception("Output buffer was not large enough while decompressing raw file");
-            break;
-        }
-        file.close();
+        uncompressData(fileData.get(), compressedFileSize, data.get(), sizeof(T)*voxels*nrOfComponents);
     } else {
         std::ifstream file(rawFilename, std::ifstream::binary | std::ifstream::in);
         if(!file.is_open())
@@ -148,6 +205,8 @@ void MetaImageImporter::execute() {
     Matrix3f transformMatrix = Matrix3f::Identity();
     bool isCompressed = false;
     std::size_t compressedDataSize = 0;
+    uint chunkSize = 0;
+    std::vector<std::size_t> chunkOffsets;
     std::unordered_map<std::string, std::string> metadata;
 
     // Blacklist of keys to avoid importing as metadata
@@ -192,7 +251,14 @@ void MetaImageImporter::execute() {
         } else if(key == "CompressedData" && value == "True") {
             isCompressed = true;
         } else if(key == "CompressedDataSize") {
-            compressedDataSize = std::stoi(value);
+            compressedDataSize = std::stoull(value);
+        } else if(key == "CompressedDataChunkSize") {
+            chunkSize = std::stoi(value);
+        } else if(key == "CompressedDataChunkOffsets") {
+            for(auto&& item : split(value)) {
+                if(!item.empty())
+                    chunkOffsets.push_back(std::stoull(item));
+            }
         } else if(key == "ElementDataFile") {
             rawFilename = value;
             rawFilenameFound = true;
@@ -343,18 +409,60 @@ void MetaImageImporter::execute() {
         throw Exception("Error reading the mhd file", __LINE__, __FILE__);
 
 
-    std::size_t voxels = size.x()*size.y();
+    std::size_t voxels = (std::size_t)size.x()*size.y();
     if(size.size() == 3)
         voxels *= size.z();
-    if(typeName == "MET_SHORT" || typeName == "MET_INT") {
+    // Number of voxels in a slice, or a row for 2D images, which is the unit of compressed chunks
+    const std::size_t sliceSize = size.size() == 3 ? (std::size_t)size.x()*size.y() : size.x();
+    const uint slices = size.size() == 3 ? size.z() : size.y();
+    if(!chunkOffsets.empty() && (chunkSize == 0 || chunkOffsets.size() - 1 != (slices + chunkSize - 1) / chunkSize))
+        throw Exception("CompressedDataChunkOffsets in MetaImage file does not match CompressedDataChunkSize");
+
+    const std::map<std::string, DataType> types = {
+        {"MET_SHORT", TYPE_INT16},
+        {"MET_USHORT", TYPE_UINT16},
+        {"MET_CHAR", TYPE_INT8},
+        {"MET_UCHAR", TYPE_UINT8},
+        {"MET_FLOAT", TYPE_FLOAT},
+    };
+    bool lazy = m_lazyLoading;
+    if(lazy && (!getMainDevice()->isHost() || types.count(typeName) == 0)) {
+        reportWarning() << "Lazy loading in MetaImageImporter is only supported on host for data types which need no conversion, loading entire file." << reportEnd();
+        lazy = false;
+    }
+    if(lazy && isCompressed && chunkOffsets.empty()) {
+        reportWarning() << "Lazy loading in MetaImageImporter requires compressed data to be chunked, loading entire file." << reportEnd();
+        lazy = false;
+    }
+
+    if(lazy) {
+        const DataType type = types.at(typeName);
+        const std::size_t bytesPerSlice = sliceSize*getSizeOfDataType(type, nrOfComponents);
+        if(isCompressed) {
+            auto file = std::make_shared<std::ifstream>(rawFilename, std::ifstream::binary | std::ifstream::in);
+            if(!file->is_open())
+                throw FileNotFoundException(rawFilename);
+            // The slab loader is only called by one thread at a time, thus the file stream can be shared
+            output->createLazy(size, type, nrOfComponents, chunkSize, [file, chunkOffsets, chunkSize, slices, bytesPerSlice](uint chunk, void* destination) {
+                const std::size_t compressedSize = chunkOffsets[chunk + 1] - chunkOffsets[chunk];
+                auto compressedData = make_uninitialized_unique<Bytef[]>(compressedSize);
+                file->seekg(chunkOffsets[chunk]);
+                file->read((char*)compressedData.get(), compressedSize);
+                const uint chunkSlices = std::min(chunkSize, slices - chunk*chunkSize);
+                uncompressData(compressedData.get(), compressedSize, destination, chunkSlices*bytesPerSlice);
+            });
+        } else {
+            output->create(size, type, nrOfComponents, mapRawFile(rawFilename, slices*bytesPerSlice));
+        }
+    } else if(typeName == "MET_SHORT" || typeName == "MET_INT") {
         std::unique_ptr<short[]> data;
         if(typeName == "MET_SHORT") {
-            data = std::move(readRawData<short>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize));
+            data = std::move(readRawData<short>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize, sliceSize, chunkSize, chunkOffsets));
         } else {
             reportWarning() << "Converting original dataset of type MET_INT (32 bit) to short (16 bit) overflow may occur." << reportEnd();
-            auto tmp = readRawData<int>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize);
+            auto tmp = readRawData<int>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize, sliceSize, chunkSize, chunkOffsets);
             auto tmp2 = make_uninitialized_unique<short[]>(voxels*nrOfComponents);
-            for(int i = 0; i < voxels*nrOfComponents; ++i)
+            for(std::size_t i = 0; i < voxels*nrOfComponents; ++i)
                 tmp2[i] = (short)tmp[i];
 
             data = std::move(tmp2);
@@ -364,25 +472,25 @@ void MetaImageImporter::execute() {
     } else if(typeName == "MET_USHORT" || typeName == "MET_UINT") {
         std::unique_ptr<ushort[]> data;
         if(typeName == "MET_USHORT") {
-            data = std::move(readRawData<unsigned short>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize));
+            data = std::move(readRawData<unsigned short>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize, sliceSize, chunkSize, chunkOffsets));
         } else {
             reportWarning() << "Converting original dataset of type MET_UINT (32 bit) to unsigned short (16 bit) overflow may occur." << reportEnd();
-            auto tmp = readRawData<unsigned int>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize);
+            auto tmp = readRawData<unsigned int>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize, sliceSize, chunkSize, chunkOffsets);
             auto tmp2 = make_uninitialized_unique<ushort[]>(voxels*nrOfComponents);
-            for(int i = 0; i < voxels*nrOfComponents; ++i)
+            for(std::size_t i = 0; i < voxels*nrOfComponents; ++i)
                 tmp2[i] = (unsigned short)tmp[i];
 
             data = std::move(tmp2);
         }
         output->create(size,TYPE_UINT16,nrOfComponents,getMainDevice(),std::move(data));
     } else if(typeName == "MET_CHAR") {
-        auto data = readRawData<char>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize);
+        auto data = readRawData<char>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize, sliceSize, chunkSize, chunkOffsets);
         output->create(size,TYPE_INT8,nrOfComponents,getMainDevice(),std::move(data));
     } else if(typeName == "MET_UCHAR") {
-        auto data = readRawData<unsigned char>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize);
+        auto data = readRawData<unsigned char>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize, sliceSize, chunkSize, chunkOffsets);
         output->create(size,TYPE_UINT8,nrOfComponents,getMainDevice(),std::move(data));
     } else if(typeName == "MET_FLOAT") {
-        auto data = readRawData<float>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize);
+        auto data = readRawData<float>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize, sliceSize, chunkSize, chunkOffsets);
         output->create(size,TYPE_FLOAT,nrOfComponents,getMainDevice(),std::move(data));
     }
 
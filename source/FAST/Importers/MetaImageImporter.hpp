@@ -9,9 +9,21 @@ class FAST_EXPORT  MetaImageImporter : public Importer {
     FAST_OBJECT(MetaImageImporter)
     public:
         void setFilename(std::string filename);
+        /**
+         * Load the data lazily instead of reading the entire file when importing.
+         * Uncompressed data is memory mapped, while compressed data is decompressed a chunk at a time when needed.
+         * Lazy loading of compressed data requires that it was exported in chunks, see MetaImageExporter::setCompressedChunkSize.
+         * Thus, cropping a lazily loaded image, e.g. with PatchGenerator, only reads the part of the file needed.
+         * Only supported when the main device is the host. The file must not be changed while the image exists.
+         * Default is false.
+         *
+         * @param lazy
+         */
+        void setLazyLoading(bool lazy);
     private:
         MetaImageImporter();
         std::string mFilename;
+        bool m_lazyLoading = false;
         void execute();
 };
 
@@ -1,8 +1,11 @@
 #include "FAST/Testing.hpp"
 #include "FAST/Importers/DICOMFileImporter.hpp"
+#include "FAST/Data/Image.hpp"
 #include "FAST/Visualization/ImageRenderer/ImageRenderer.hpp"
 #include "FAST/Visualization/SliceRenderer/SliceRenderer.hpp"
 #include "FAST/Visualization/SimpleWindow.hpp"
+#include <cstring>
+#include <fstream>
 
 using namespace fast;
 
@@ -43,3 +46,60 @@ TEST_CASE("Dicom image read 3D", "[DICOM][visual]") {
     CHECK_NOTHROW(window->start());
 
 }
+
+TEST_CASE("Dicom series read is sorted by slice position", "[fast][DICOM]") {
+    auto importer = DICOMFileImporter::New();
+    importer->setLoadSeries(true);
+    importer->setFilename(Config::getTestDataPath() + "/CT/LIDC-IDRI-0072/000001.dcm");
+    auto volume = importer->updateAndGetOutputData<Image>();
+    REQUIRE(volume->getDimensions() == 3);
+    CHECK(volume->getDepth() > 1);
+    CHECK(volume->getSpacing().z() > 0);
+
+    // A single slice of the series must be equal to one of the slices of the volume
+    auto sliceImporter = DICOMFileImporter::New();
+    sliceImporter->setLoadSeries(false);
+    sliceImporter->setFilename(Config::getTestDataPath() + "/CT/LIDC-IDRI-0072/000001.dcm");
+    auto slice = sliceImporter->updateAndGetOutputData<Image>();
+    REQUIRE(slice->getWidth() == volume->getWidth());
+    REQUIRE(slice->getHeight() == volume->getHeight());
+    const std::size_t sliceSize = (std::size_t)slice->getWidth()*slice->getHeight()*getSizeOfDataType(slice->getDataType(), 1);
+    auto volumeAccess = volume->getImageAccess(ACCESS_READ);
+    auto sliceAccess = slice->getImageAccess(ACCESS_READ);
+    int matches = 0;
+    for(int z = 0; z < volume->getDepth(); ++z) {
+        if(std::memcmp((uchar*)volumeAccess->get() + z*sliceSize, sliceAccess->get(), sliceSize) == 0)
+            ++matches;
+    }
+    CHECK(matches >= 1);
+}
+
+TEST_CASE("Dicom series read again after a file of the series has changed", "[fast][DICOM]") {
+    // Copy series to a new directory, so that a file can be changed
+    const std::string sourceDir = Config::getTestDataPath() + "/CT/LIDC-IDRI-0072/";
+    const std::string dir = "DICOMFileImporterCacheTest/";
+    createDirectories(dir);
+    auto files = getDirectoryList(sourceDir);
+    std::sort(files.begin(), files.end());
+    REQUIRE(files.size() > 2);
+    for(auto&& file : files) {
+        std::ifstream source(sourceDir + file, std::ios::binary);
+        std::ofstream destination(dir + file, std::ios::binary);
+        destination << source.rdbuf();
+    }
+
+    auto importer = DICOMFileImporter::New();
+    importer->setLoadSeries(true);
+    importer->setFilename(dir + files[0]);
+    auto volume = importer->updateAndGetOutputData<Image>();
+    const int depth = volume->getDepth();
+
+    // Replace a file of the series, the cached header of it must not be used
+    {
+        std::ofstream file(dir + files[1], std::ios::binary | std::ios::trunc);
+        file << "Not a DICOM file";
+    }
+    importer->setFilename(dir + files[0]);
+    volume = importer->updateAndGetOutputData<Image>();
+    CHECK(volume->getDepth() == depth - 1);
+}
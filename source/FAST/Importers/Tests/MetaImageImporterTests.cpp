@@ -2,6 +2,8 @@
 #include "FAST/Importers/MetaImageImporter.hpp"
 #include "FAST/DeviceManager.hpp"
 #include "FAST/Data/Image.hpp"
+#include "FAST/Exporters/MetaImageExporter.hpp"
+#include "FAST/Tests/DataComparison.hpp"
 
 using namespace fast;
 
@@ -103,3 +105,59 @@ TEST_CASE("Import MetaImage file to OpenCL device", "[fast][MetaImageImporter]")
     CHECK(image->getDataType() == TYPE_UINT8);
 }
 
+
+TEST_CASE("Lazy import of uncompressed and chunked compressed 3D MetaImage file", "[fast][MetaImageImporter]") {
+    const int width = 32;
+    const int height = 40;
+    const int depth = 20;
+    const int channels = 2;
+    auto data = (ushort*)allocateRandomData(width*height*depth*channels, TYPE_UINT16);
+    auto image = Image::New();
+    image->create(width, height, depth, TYPE_UINT16, channels, Host::getInstance(), data);
+
+    for(bool compressed : {false, true}) {
+        auto exporter = MetaImageExporter::New();
+        exporter->setFilename("MetaImageImporterLazyTest.mhd");
+        exporter->setCompression(compressed);
+        exporter->setCompressedChunkSize(3);
+        exporter->setInputData(image);
+        exporter->update();
+
+        auto importer = MetaImageImporter::New();
+        importer->setFilename("MetaImageImporterLazyTest.mhd");
+        importer->setLazyLoading(true);
+        auto port = importer->getOutputPort();
+        importer->update();
+        auto image2 = port->getNextFrame<Image>();
+        CHECK(image2->getWidth() == width);
+        CHECK(image2->getHeight() == height);
+        CHECK(image2->getDepth() == depth);
+        CHECK(image2->getNrOfChannels() == channels);
+
+        // Cropping should only load what is needed, and give the same result
+        auto cropped = image2->crop(Vector3i(3, 4, 5), Vector3i(10, 12, 6));
+        CHECK(cropped->getWidth() == 10);
+        CHECK(cropped->getDepth() == 6);
+        {
+            auto access = cropped->getImageAccess(ACCESS_READ);
+            auto croppedData = (ushort*)access->get();
+            bool equal = true;
+            for(int z = 0; z < 6; ++z) {
+                for(int y = 0; y < 12; ++y) {
+                    for(int x = 0; x < 10; ++x) {
+                        for(int c = 0; c < channels; ++c) {
+                            if(croppedData[((z*12 + y)*10 + x)*channels + c] != data[(((z + 5)*height + y + 4)*width + x + 3)*channels + c])
+                                equal = false;
+                        }
+                    }
+                }
+            }
+            CHECK(equal);
+        }
+
+        // Accessing the entire image should load all of it
+        auto access = image2->getImageAccess(ACCESS_READ);
+        CHECK(compareDataArrays(data, access->get(), width*height*depth*channels, TYPE_UINT16));
+    }
+    deleteArray(data, TYPE_UINT16);
+}
@@ -11,7 +11,8 @@
 
 namespace fast {
 
-enum StreamingMode { STREAMING_MODE_NEWEST_FRAME_ONLY, STREAMING_MODE_STORE_ALL_FRAMES, STREAMING_MODE_PROCESS_ALL_FRAMES };
+enum StreamingMode { STREAMING_MODE_NEWEST_FRAME_ONLY, STREAMING_MODE_STORE_ALL_FRAMES, STREAMING_MODE_PROCESS_ALL_FRAMES, STREAMING_MODE_PROCESS_ALL_FRAMES_LOCK_FREE };
+enum ExecutionMode { EXECUTION_MODE_SEQUENTIAL, EXECUTION_MODE_PARALLEL };
 
 class FAST_EXPORT  Object {
     public:
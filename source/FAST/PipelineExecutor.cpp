@@ -0,0 +1,255 @@
+#include "PipelineExecutor.hpp"
+#include <FAST/Streamers/Streamer.hpp>
+#include <FAST/DataChannels/QueuedDataChannel.hpp>
+#include <FAST/DataChannels/NewestFrameDataChannel.hpp>
+#include <FAST/DataChannels/RingBufferDataChannel.hpp>
+#include <FAST/Tracer.hpp>
+#include <functional>
+
+namespace fast {
+
+static bool isStreamer(ProcessObject* po) {
+    return dynamic_cast<Streamer*>(po) != nullptr;
+}
+
+PipelineExecutor::PipelineExecutor() {
+}
+
+void PipelineExecutor::addProcessObject(SharedPointer<ProcessObject> po) {
+    if(m_started)
+        throw Exception("Process objects have to be added to the PipelineExecutor before calling start");
+    m_sinks.push_back(po);
+}
+
+void PipelineExecutor::setMaximumNumberOfFramesInFlight(uint frames) {
+    if(frames == 0)
+        throw Exception("Maximum number of frames in flight must be larger than 0");
+    m_framesInFlight = frames;
+}
+
+void PipelineExecutor::setMemoryPool(SharedPointer<MemoryPool> pool) {
+    if(m_started)
+        throw Exception("The memory pool has to be set before calling start on the PipelineExecutor");
+    m_memoryPool = pool;
+}
+
+std::vector<SharedPointer<ProcessObject>> PipelineExecutor::getProcessObjects() const {
+    return m_processObjects;
+}
+
+void PipelineExecutor::buildGraph() {
+    m_processObjects.clear();
+    m_streamersUpstream.clear();
+
+    // Depth first search from the sinks, post-order gives a topological order where parents come first
+    std::unordered_set<ProcessObject*> visited;
+    std::function<void(SharedPointer<ProcessObject>)> visit = [&](SharedPointer<ProcessObject> po) {
+        if(visited.count(po.get()) > 0)
+            return;
+        visited.insert(po.get());
+        for(auto&& input : po->mInputConnections)
+            visit(input.second->getProcessObject());
+        m_processObjects.push_back(po);
+    };
+    for(auto&& sink : m_sinks)
+        visit(sink);
+
+    // Find which streamers each PO depends on
+    for(auto&& po : m_processObjects) {
+        std::unordered_set<std::string> streamers;
+        if(isStreamer(po.get()))
+            streamers.insert(po->getNameOfClass());
+        for(auto&& input : po->mInputConnections) {
+            auto parent = input.second->getProcessObject().get();
+            if(m_streamersUpstream.count(parent) > 0) {
+                for(auto&& name : m_streamersUpstream[parent])
+                    streamers.insert(name);
+            }
+        }
+        if(!streamers.empty())
+            m_streamersUpstream[po.get()] = streamers;
+    }
+}
+
+void PipelineExecutor::replaceDataChannels() {
+    // The static data channels between two stages never remove the data, so a stage would process
+    // the same frame repeatedly. Replace them with data channels which work as a queue between the two threads.
+    auto streamingMode = Config::getStreamingMode();
+    for(auto&& po : m_processObjects) {
+        if(m_streamersUpstream.count(po.get()) == 0)
+            continue;
+        for(auto&& input : po->mInputConnections) {
+            auto oldChannel = input.second;
+            auto parent = oldChannel->getProcessObject();
+            // Static parents keep their static channel, while streamers already have a streaming channel
+            if(m_streamersUpstream.count(parent.get()) == 0 || isStreamer(parent.get()))
+                continue;
+
+            DataChannel::pointer newChannel;
+            if(streamingMode == STREAMING_MODE_NEWEST_FRAME_ONLY) {
+                newChannel = NewestFrameDataChannel::New();
+            } else if(streamingMode == STREAMING_MODE_PROCESS_ALL_FRAMES_LOCK_FREE) {
+                newChannel = RingBufferDataChannel::New();
+                newChannel->setMaximumNumberOfFrames(m_framesInFlight);
+            } else {
+                newChannel = QueuedDataChannel::New();
+                newChannel->setMaximumNumberOfFrames(m_framesInFlight);
+            }
+            newChannel->setProcessObject(parent);
+
+            bool found = false;
+            for(auto&& outputPort : parent->mOutputConnections) {
+                for(auto&& output : outputPort.second) {
+                    if(output.lock() == oldChannel) {
+                        output = std::weak_ptr<DataChannel>(newChannel);
+                        found = true;
+                    }
+                }
+            }
+            if(!found)
+                throw Exception("Unable to find output connection of " + parent->getNameOfClass() + " in PipelineExecutor");
+            input.second = newChannel;
+        }
+    }
+}
+
+void PipelineExecutor::start() {
+    if(m_started)
+        throw Exception("PipelineExecutor has already been started");
+    m_started = true;
+    buildGraph();
+    replaceDataChannels();
+    if(m_memoryPool) {
+        for(auto&& po : m_processObjects) {
+            if(!po->m_memoryPool)
+                po->setMemoryPool(m_memoryPool);
+        }
+    }
+
+    // POs which do not depend on any streamers only have to be executed once
+    for(auto&& po : m_processObjects) {
+        if(m_streamersUpstream.count(po.get()) == 0)
+            po->update();
+    }
+
+    // Start one worker thread per stage
+    for(auto&& po : m_processObjects) {
+        if(m_streamersUpstream.count(po.get()) == 0)
+            continue;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_runningStages;
+        }
+        m_threads.push_back(std::make_unique<std::thread>(std::bind(&PipelineExecutor::runStage, this, po)));
+    }
+    reportInfo() << "PipelineExecutor started " << m_threads.size() << " stages" << reportEnd();
+}
+
+void PipelineExecutor::runStage(SharedPointer<ProcessObject> po) {
+    const auto& streamers = m_streamersUpstream.at(po.get());
+    if(Tracer::isEnabled())
+        Tracer::setThreadName("Stage " + po->getNameOfClass());
+    try {
+        if(isStreamer(po.get())) {
+            // Streamers run their own thread, this will only start the stream
+            po->executeWithoutParents(0);
+        } else {
+            int executeToken = 0;
+            while(true) {
+                po->executeWithoutParents(executeToken);
+                ++executeToken;
+                // Stop when the last frame of every streamer upstream has been processed
+                bool lastFrame = true;
+                for(auto&& name : streamers) {
+                    if(po->m_lastFrame.count(name) == 0) {
+                        lastFrame = false;
+                        break;
+                    }
+                }
+                if(lastFrame)
+                    break;
+            }
+        }
+    } catch(ThreadStopped &e) {
+        reportInfo() << "Stage " << po->getNameOfClass() << " was stopped" << reportEnd();
+    } catch(std::exception &e) {
+        reportError() << "Stage " << po->getNameOfClass() << " failed: " << e.what() << reportEnd();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if(!m_error)
+                m_error = std::current_exception();
+        }
+        // Unblock the stages upstream waiting to add data, and downstream waiting for data
+        stopStages();
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        --m_runningStages;
+    }
+    m_stageFinishedCondition.notify_all();
+}
+
+void PipelineExecutor::waitForStages() {
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while(m_runningStages > 0)
+            m_stageFinishedCondition.wait(lock);
+    }
+    for(auto&& thread : m_threads)
+        thread->join();
+    m_threads.clear();
+}
+
+void PipelineExecutor::stopStages() {
+    // Stopping all data channels will unblock any stage waiting for, or adding, data
+    for(auto&& po : m_sinks) {
+        po->stopPipeline();
+        // Also unblock anyone waiting for the output of the pipeline
+        for(auto&& outputPort : po->mOutputConnections) {
+            for(auto&& output : outputPort.second) {
+                auto channel = output.lock();
+                if(channel)
+                    channel->stop();
+            }
+        }
+    }
+}
+
+void PipelineExecutor::join() {
+    waitForStages();
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::swap(error, m_error);
+    }
+    if(error) {
+        for(auto&& po : m_processObjects) {
+            auto streamer = std::dynamic_pointer_cast<Streamer>(po);
+            if(streamer)
+                streamer->stop();
+        }
+        std::rethrow_exception(error);
+    }
+}
+
+bool PipelineExecutor::isRunning() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_runningStages > 0;
+}
+
+void PipelineExecutor::stop() {
+    stopStages();
+    waitForStages();
+    for(auto&& po : m_processObjects) {
+        auto streamer = std::dynamic_pointer_cast<Streamer>(po);
+        if(streamer)
+            streamer->stop();
+    }
+}
+
+PipelineExecutor::~PipelineExecutor() {
+    if(!m_threads.empty())
+        stop();
+}
+
+}
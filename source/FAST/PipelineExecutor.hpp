@@ -0,0 +1,87 @@
+#pragma once
+
+#include <FAST/ProcessObject.hpp>
+#include <thread>
+#include <condition_variable>
+#include <exception>
+
+namespace fast {
+
+/**
+ * Executes a pipeline in parallel instead of using the recursive ProcessObject::update pull.
+ *
+ * The graph of process objects upstream of the added process objects is sorted topologically.
+ * Every process object which is downstream of a streamer becomes a pipeline stage which runs in its own
+ * worker thread, and the data channels between stages are replaced with queued (or newest frame) data channels.
+ * Independent branches thus run concurrently, and consecutive timesteps are pipelined:
+ * stage N can process frame t+1 while stage N+1 processes frame t.
+ * Process objects which are not downstream of any streamer are executed once before the stages are started.
+ */
+class FAST_EXPORT PipelineExecutor : public Object {
+    FAST_OBJECT(PipelineExecutor)
+    public:
+        /**
+         * Add a process object to execute. All of its parents are executed as well.
+         * @param po
+         */
+        void addProcessObject(SharedPointer<ProcessObject> po);
+        /**
+         * Set the maximum number of frames which can be queued between two stages
+         * when streaming mode is PROCESS_ALL_FRAMES. Default is 4.
+         * @param frames
+         */
+        void setMaximumNumberOfFramesInFlight(uint frames);
+        /**
+         * Set a memory pool which all process objects of this pipeline allocate their output data from,
+         * unless another pool has been set on the process object.
+         * This gives the pipeline its own limit on cached memory, and its own statistics.
+         * @param pool
+         */
+        void setMemoryPool(SharedPointer<MemoryPool> pool);
+        /**
+         * Start executing all stages. This call does not block.
+         */
+        void start();
+        /**
+         * Block until all stages have processed the last frame, or the pipeline has been stopped.
+         * If a stage failed, the whole pipeline is stopped and the exception of the first failing stage is rethrown here.
+         */
+        void join();
+        /**
+         * Stop all stages and wait for the worker threads to finish
+         */
+        void stop();
+        /**
+         * @return true if any stage is still running
+         */
+        bool isRunning();
+        /**
+         * @return the process objects of the graph in topological order
+         */
+        std::vector<SharedPointer<ProcessObject>> getProcessObjects() const;
+        ~PipelineExecutor();
+    protected:
+        PipelineExecutor();
+        void buildGraph();
+        void replaceDataChannels();
+        void runStage(SharedPointer<ProcessObject> po);
+        void waitForStages();
+        void stopStages();
+
+        std::vector<SharedPointer<ProcessObject>> m_sinks;
+        // All POs in topological order (parents before children)
+        std::vector<SharedPointer<ProcessObject>> m_processObjects;
+        // POs which are downstream of a streamer, or is a streamer, and the name of the streamers upstream of them
+        std::unordered_map<ProcessObject*, std::unordered_set<std::string>> m_streamersUpstream;
+        std::vector<std::unique_ptr<std::thread>> m_threads;
+        std::mutex m_mutex;
+        std::condition_variable m_stageFinishedCondition;
+        uint m_runningStages = 0;
+        uint m_framesInFlight = 4;
+        SharedPointer<MemoryPool> m_memoryPool;
+        bool m_started = false;
+        // Exception of the first stage which failed
+        std::exception_ptr m_error;
+};
+
+}
@@ -6,6 +6,8 @@
 #include <FAST/DataChannels/QueuedDataChannel.hpp>
 #include <FAST/DataChannels/NewestFrameDataChannel.hpp>
 #include <FAST/DataChannels/StaticDataChannel.hpp>
+#include <FAST/DataChannels/RingBufferDataChannel.hpp>
+#include <FAST/Tracer.hpp>
 
 
 namespace fast {
@@ -96,27 +98,32 @@ void ProcessObject::update(int executeToken) {
         return;
     // If this object is modified, or any parents has new data for this PO: Call execute
     if(mIsModified || newInputData) {
-        this->mRuntimeManager->startRegularTimer("execute");
         // set isModified to false before executing to avoid recursive update calls
         if(mIsModified) {
             reportInfo() << "EXECUTING " << getNameOfClass() << " because PO is modified." << reportEnd();
         } else if(newInputData) {
             reportInfo() << "EXECUTING " << getNameOfClass() << " because PO has new input data." << reportEnd();
         }
-        mIsModified = false;
-        preExecute();
-        execute();
-        postExecute();
-        m_lastExecuteToken = executeToken;
-        if(this->mRuntimeManager->isEnabled())
-            this->waitToFinish();
-        this->mRuntimeManager->stopRegularTimer("execute");
+        executeWithoutParents(executeToken);
     }
     // TODO need to clear m_frameData m_lastFrame
     //m_frameData.clear();
     //m_lastFrame.clear();
 }
 
+void ProcessObject::executeWithoutParents(int executeToken) {
+    TraceScope trace(getNameOfClass(), "execute");
+    this->mRuntimeManager->startRegularTimer("execute");
+    mIsModified = false;
+    preExecute();
+    execute();
+    postExecute();
+    m_lastExecuteToken = executeToken;
+    if(this->mRuntimeManager->isEnabled())
+        this->waitToFinish();
+    this->mRuntimeManager->stopRegularTimer("execute");
+}
+
 DataChannel::pointer ProcessObject::getOutputPort(uint portID) {
     validateOutputPortExists(portID);
     // Create DataChannel, and it to list and return it
@@ -127,6 +134,8 @@ DataChannel::pointer ProcessObject::getOutputPort(uint portID) {
             dataChannel = QueuedDataChannel::New();
         } else if(streamingMode == STREAMING_MODE_NEWEST_FRAME_ONLY) {
             dataChannel = NewestFrameDataChannel::New();
+        } else if(streamingMode == STREAMING_MODE_PROCESS_ALL_FRAMES_LOCK_FREE) {
+            dataChannel = RingBufferDataChannel::New();
         } else {
             throw Exception("Unsupported streaming mode");
         }
@@ -173,6 +182,7 @@ void ProcessObject::addOutputData(uint portID, DataObject::pointer data) {
         for(auto output : mOutputConnections.at(portID)) {
             if(!output.expired()) {
                 DataChannel::pointer port = output.lock();
+                TraceScope trace("addFrame", "wait");
                 port->addFrame(data);
             }
         }
@@ -305,6 +315,10 @@ ExecutionDevice::pointer ProcessObject::getDevice(uint deviceNumber) const {
     return mDevices.at(deviceNumber);
 }
 
+void ProcessObject::setMemoryPool(SharedPointer<MemoryPool> pool) {
+    m_memoryPool = pool;
+}
+
 void ProcessObject::setMainDeviceCriteria(const DeviceCriteria& criteria) {
     mDeviceCriteria[0] = criteria;
     mDevices[0] = DeviceManager::getInstance()->getDevice(criteria);
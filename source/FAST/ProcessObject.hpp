@@ -18,6 +18,7 @@ namespace fast {
 
 class OpenCLProgram;
 class ProcessObject;
+class PipelineExecutor;
 
 class FAST_EXPORT  ProcessObject : public Object {
     public:
@@ -47,6 +48,12 @@ class FAST_EXPORT  ProcessObject : public Object {
         void setDevice(uint deviceNumber, ExecutionDevice::pointer device);
         void setDeviceCriteria(uint deviceNumber, const DeviceCriteria& criteria);
         ExecutionDevice::pointer getDevice(uint deviceNumber) const;
+        /**
+         * Set the memory pool which the output data of this process object is allocated from.
+         * If not set, the default memory pool is used, see MemoryPool::getDefault.
+         * @param pool
+         */
+        void setMemoryPool(SharedPointer<MemoryPool> pool);
 
         virtual DataChannel::pointer getOutputPort(uint portID = 0);
         virtual DataChannel::pointer getInputPort(uint portID = 0);
@@ -87,6 +94,11 @@ class FAST_EXPORT  ProcessObject : public Object {
 
         // Pure virtual method for executing the pipeline object
         virtual void execute()=0;
+        /**
+         * Run preExecute, execute and postExecute once, with runtime measurement,
+         * without updating any parent POs first. Used by update() and PipelineExecutor.
+         */
+        void executeWithoutParents(int executeToken = -1);
         virtual void preExecute();
         virtual void postExecute();
 
@@ -134,6 +146,7 @@ class FAST_EXPORT  ProcessObject : public Object {
         std::unordered_map<uint, std::vector<uint> > mInputDevices;
         std::unordered_map<uint, ExecutionDevice::pointer> mDevices;
         std::unordered_map<uint, DeviceCriteria> mDeviceCriteria;
+        SharedPointer<MemoryPool> m_memoryPool;
 
         // New pipeline
         std::unordered_map<uint, DataChannel::pointer> mInputConnections;
@@ -158,6 +171,8 @@ class FAST_EXPORT  ProcessObject : public Object {
         // Indicates whether this data object is the last frame in a stream, and if so, the name of the stream
         std::unordered_set<std::string> m_lastFrame;
 
+        friend class PipelineExecutor;
+
 
 };
 
@@ -198,6 +213,8 @@ SharedPointer<DataType> ProcessObject::getOutputData(uint portID) {
     validateOutputPortExists(portID);
     // Generate a new output data object
     SharedPointer<DataType> returnData = DataType::New();
+    if(m_memoryPool)
+        returnData->setMemoryPool(m_memoryPool);
 
     addOutputData(portID, returnData);
 
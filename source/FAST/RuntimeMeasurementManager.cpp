@@ -1,5 +1,6 @@
 #include "RuntimeMeasurementManager.hpp"
 #include "Exception.hpp"
+#include "Tracer.hpp"
 
 namespace fast {
 
@@ -57,6 +58,7 @@ void RuntimeMeasurementsManager::stopCLTimer(std::string name, cl::CommandQueue
 	cl::Event startEvent = startEvents[name];
 	startEvent.getProfilingInfo<cl_ulong>(CL_PROFILING_COMMAND_START, &start);
 	endEvent.getProfilingInfo<cl_ulong>(CL_PROFILING_COMMAND_START, &end);
+	Tracer::addDeviceEvent(name, "opencl", end - start, std::chrono::steady_clock::now());
 	if (timings.count(name) == 0) {
 		// No timings with this name exists, create a new one
 		RuntimeMeasurement::pointer runtime(new RuntimeMeasurement(name));
@@ -85,6 +87,10 @@ void RuntimeMeasurementsManager::stopRegularTimer(std::string name) {
 	    return;
 
 	std::chrono::duration<double, std::milli> time = std::chrono::system_clock::now() - startTimes[name];
+	if(Tracer::isEnabled()) {
+		const auto end = std::chrono::steady_clock::now();
+		Tracer::addEvent(name, "timer", end - std::chrono::duration_cast<std::chrono::steady_clock::duration>(time), end);
+	}
     if (timings.count(name) == 0) {
 		// No timings with this name exists, create a new one
 		RuntimeMeasurement::pointer runtime(new RuntimeMeasurement(name));
@@ -167,6 +167,7 @@ void FileStreamer::generateStream() {
             if(!fileExists(getFilename(i+1, currentSequence)) && !mLoop)
                 dataFrame->setLastFrame(getNameOfClass());
 
+            prefetchToDevice(dataFrame);
             addOutputData(0, dataFrame);
             frameAdded();
             if(mSleepTime > 0)
@@ -0,0 +1,131 @@
+#include "RecordingFileStreamer.hpp"
+#include "FAST/Data/Image.hpp"
+#include <chrono>
+
+namespace fast {
+
+RecordingFileStreamer::RecordingFileStreamer() {
+    createOutputPort<Image>(0);
+}
+
+void RecordingFileStreamer::setFilename(std::string filename) {
+    if(m_streamIsStarted)
+        throw Exception("Filename can't be changed while streaming in RecordingFileStreamer");
+    m_filename = filename;
+    m_reader.reset();
+    mIsModified = true;
+}
+
+void RecordingFileStreamer::enableLooping() {
+    m_loop = true;
+}
+
+void RecordingFileStreamer::disableLooping() {
+    m_loop = false;
+}
+
+void RecordingFileStreamer::setSleepTime(uint milliseconds) {
+    m_sleepTime = milliseconds;
+}
+
+void RecordingFileStreamer::setUseTimestamp(bool use) {
+    m_useTimestamp = use;
+}
+
+void RecordingFileStreamer::seek(uint64_t frame) {
+    if(frame >= getNrOfFrames())
+        throw OutOfBoundsException();
+    m_nextFrame = frame;
+}
+
+void RecordingFileStreamer::seekToTimestamp(uint64_t timestamp) {
+    openFile();
+    m_nextFrame = m_reader->findFrame(timestamp);
+}
+
+uint64_t RecordingFileStreamer::getNrOfFrames() {
+    openFile();
+    return m_reader->getNrOfFrames();
+}
+
+uint64_t RecordingFileStreamer::getCurrentFrameIndex() const {
+    return m_currentFrame;
+}
+
+void RecordingFileStreamer::openFile() {
+    if(m_reader)
+        return;
+    if(m_filename.empty())
+        throw Exception("No filename was given to the RecordingFileStreamer");
+    m_reader = std::make_unique<RecordingFileReader>(m_filename);
+}
+
+void RecordingFileStreamer::execute() {
+    if(getNrOfFrames() == 0)
+        throw Exception("Recording file " + m_filename + " has no frames");
+
+    startStream();
+    waitForFirstFrame();
+}
+
+void RecordingFileStreamer::generateStream() {
+    const uint64_t nrOfFrames = m_reader->getNrOfFrames();
+    uint64_t previousTimestamp = 0;
+    auto previousTimestampTime = std::chrono::steady_clock::now();
+    while(true) {
+        {
+            std::unique_lock<std::mutex> lock(m_stopMutex);
+            if(m_stop) {
+                m_streamIsStarted = false;
+                m_firstFrameIsInserted = false;
+                break;
+            }
+        }
+        uint64_t expectedFrame = m_nextFrame;
+        uint64_t frame = expectedFrame;
+        if(frame >= nrOfFrames) {
+            if(!m_loop)
+                break;
+            frame = 0;
+        }
+        // Start the timing over after seeking or looping
+        if(frame != m_currentFrame + 1)
+            previousTimestamp = 0;
+        // Don't overwrite a seek done since the frame nr was read
+        m_nextFrame.compare_exchange_strong(expectedFrame, frame + 1);
+        try {
+            auto image = m_reader->readFrame(frame);
+
+            const uint64_t timestamp = image->getCreationTimestamp();
+            if(m_useTimestamp && timestamp != 0) {
+                // Wait until as much time as between the timestamps has passed since the previous frame
+                if(previousTimestamp != 0 && timestamp > previousTimestamp) {
+                    std::this_thread::sleep_until(previousTimestampTime + std::chrono::milliseconds(timestamp - previousTimestamp));
+                }
+                previousTimestamp = timestamp;
+                previousTimestampTime = std::chrono::steady_clock::now();
+            }
+
+            if(frame == nrOfFrames - 1 && !m_loop)
+                image->setLastFrame(getNameOfClass());
+            m_currentFrame = frame;
+            prefetchToDevice(image);
+            addOutputData(0, image);
+            frameAdded();
+            if(m_sleepTime > 0)
+                std::this_thread::sleep_for(std::chrono::milliseconds(m_sleepTime));
+        } catch(ThreadStopped &e) {
+            break;
+        } catch(std::exception &e) {
+            // Corrupt or truncated frame, end the stream instead of letting the exception escape the thread
+            streamError("Error reading frame " + std::to_string(frame) + " of recording file " + m_filename + ": " + e.what());
+            break;
+        }
+    }
+}
+
+RecordingFileStreamer::~RecordingFileStreamer() {
+    stop();
+}
+
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <FAST/Streamers/Streamer.hpp>
+#include <FAST/Exporters/RecordingFile.hpp>
+#include <atomic>
+
+namespace fast {
+
+/**
+ * Streams the image frames of a single file recording made with StreamToFileExporter or RecordingFileWriter.
+ * Frames are read directly from the frame index of the file, thus the stream can be moved to any frame with seek,
+ * also while streaming.
+ */
+class FAST_EXPORT RecordingFileStreamer : public Streamer {
+    FAST_OBJECT(RecordingFileStreamer)
+    public:
+        void setFilename(std::string filename);
+        void enableLooping();
+        void disableLooping();
+        /**
+         * Set a sleep time after each frame is read
+         */
+        void setSleepTime(uint milliseconds);
+        /**
+         * Enable or disable the use of timestamps to stream frames at the rate they were recorded. Default is enabled.
+         *
+         * @param use
+         */
+        void setUseTimestamp(bool use);
+        /**
+         * Continue the stream from the given frame
+         * @param frame nr, starting at 0
+         */
+        void seek(uint64_t frame);
+        /**
+         * Continue the stream from the frame with the given timestamp, or the last frame before it
+         * @param timestamp
+         */
+        void seekToTimestamp(uint64_t timestamp);
+        uint64_t getNrOfFrames();
+        /**
+         * @return nr of the last frame which was streamed
+         */
+        uint64_t getCurrentFrameIndex() const;
+        ~RecordingFileStreamer();
+    private:
+        RecordingFileStreamer();
+        void execute() override;
+        void generateStream() override;
+        void openFile();
+
+        std::string m_filename;
+        std::unique_ptr<RecordingFileReader> m_reader;
+        bool m_loop = false;
+        bool m_useTimestamp = true;
+        uint m_sleepTime = 0;
+        std::atomic<uint64_t> m_nextFrame = {0};
+        std::atomic<uint64_t> m_currentFrame = {0};
+};
+
+}
@@ -1,13 +1,41 @@
 #include "Streamer.hpp"
+#include "FAST/Data/Image.hpp"
 
 namespace fast {
 
 void Streamer::waitForFirstFrame() {
     // Wait here for first frame
     std::unique_lock<std::mutex> lock(m_firstFrameMutex);
-    while(!m_firstFrameIsInserted) {
+    while(!m_firstFrameIsInserted && m_streamError.empty()) {
         m_firstFrameCondition.wait(lock);
     }
+    if(!m_streamError.empty())
+        throw Exception(m_streamError);
+}
+
+void Streamer::streamError(std::string message) {
+    reportError() << message << reportEnd();
+    {
+        std::unique_lock<std::mutex> lock(m_firstFrameMutex);
+        m_streamError = message;
+    }
+    m_firstFrameCondition.notify_all();
+    {
+        std::unique_lock<std::mutex> lock(m_stopMutex);
+        m_stop = true;
+    }
+    for(auto&& outputPort : mOutputConnections) {
+        for(auto&& output : outputPort.second) {
+            auto channel = output.lock();
+            if(channel)
+                channel->stop();
+        }
+    }
+}
+
+std::string Streamer::getStreamError() {
+    std::unique_lock<std::mutex> lock(m_firstFrameMutex);
+    return m_streamError;
 }
 
 void Streamer::startStream() {
@@ -25,6 +53,18 @@ void Streamer::frameAdded() {
     m_firstFrameCondition.notify_one();
 }
 
+void Streamer::setPrefetchToDevice(bool prefetch) {
+    m_prefetchToDevice = prefetch;
+}
+
+void Streamer::prefetchToDevice(DataObject::pointer data) {
+    if(!m_prefetchToDevice || getMainDevice()->isHost())
+        return;
+    auto image = std::dynamic_pointer_cast<Image>(data);
+    if(image)
+        image->prefetch(std::static_pointer_cast<OpenCLDevice>(getMainDevice()));
+}
+
 Streamer::Streamer() {
     m_firstFrameIsInserted = false;
     m_streamIsStarted = false;
@@ -30,6 +30,18 @@ class FAST_EXPORT Streamer : public ProcessObject {
          * Stop the stream
          */
         virtual void stop();
+        /**
+         * Start transferring each image frame to the main device of this streamer before it is sent downstream.
+         * The transfer does not block the streamer, thus the next frame is uploaded while the previous
+         * frame is being processed. Has no effect if the main device is the host. Default is off.
+         *
+         * @param prefetch
+         */
+        void setPrefetchToDevice(bool prefetch);
+        /**
+         * @return the error message if the stream was ended by an error, otherwise an empty string
+         */
+        std::string getStreamError();
     protected:
         /**
          * Block until the first data frame has been sent using a condition variable
@@ -46,14 +58,28 @@ class FAST_EXPORT Streamer : public ProcessObject {
          */
         virtual void frameAdded();
 
+        /**
+         * End the stream because of an error, from the thread producing the stream. The error is reported,
+         * waitForFirstFrame will throw an exception with the error message, and the output data channels are
+         * stopped so that consumers waiting for more frames are unblocked instead of receiving a truncated stream.
+         */
+        void streamError(std::string message);
+
         /**
          * The function producing the data stream
          */
         virtual void generateStream() = 0;
 
+        /**
+         * Start the transfer of an image frame to the main device, if prefetching has been enabled
+         */
+        void prefetchToDevice(DataObject::pointer data);
+
         bool m_firstFrameIsInserted = false;
         bool m_streamIsStarted = false;
         bool m_stop = false;
+        bool m_prefetchToDevice = false;
+        std::string m_streamError;
 
         std::mutex m_firstFrameMutex;
         std::mutex m_stopMutex;
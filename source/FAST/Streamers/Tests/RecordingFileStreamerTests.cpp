@@ -0,0 +1,93 @@
+#include "FAST/Testing.hpp"
+#include "FAST/Streamers/RecordingFileStreamer.hpp"
+#include "FAST/Exporters/RecordingFile.hpp"
+#include "FAST/Data/Image.hpp"
+#include <fstream>
+#include <iterator>
+
+using namespace fast;
+
+static std::string createRecording(int frames) {
+    const std::string filename = "RecordingFileStreamerTest.fastrec";
+    RecordingFileWriter writer(filename);
+    for(int i = 0; i < frames; ++i) {
+        auto image = Image::New();
+        image->create(16, 16, TYPE_UINT8, 1);
+        image->fill(i);
+        image->setCreationTimestamp(1000 + i*10);
+        writer.addFrame(image);
+    }
+    writer.close();
+    return filename;
+}
+
+TEST_CASE("No filename given to RecordingFileStreamer", "[fast][RecordingFileStreamer]") {
+    auto streamer = RecordingFileStreamer::New();
+    CHECK_THROWS(streamer->update());
+}
+
+TEST_CASE("RecordingFileStreamer streams all frames", "[fast][RecordingFileStreamer]") {
+    auto streamer = RecordingFileStreamer::New();
+    streamer->setFilename(createRecording(10));
+    CHECK(streamer->getNrOfFrames() == 10);
+    auto port = streamer->getOutputPort();
+    streamer->update();
+    for(int i = 0; i < 10; ++i) {
+        auto image = port->getNextFrame<Image>();
+        CHECK(image->getCreationTimestamp() == 1000 + i*10);
+        CHECK(image->isLastFrame() == (i == 9));
+    }
+}
+
+TEST_CASE("RecordingFileStreamer seek", "[fast][RecordingFileStreamer]") {
+    auto streamer = RecordingFileStreamer::New();
+    streamer->setFilename(createRecording(100));
+    streamer->setSleepTime(5);
+    streamer->seekToTimestamp(1505);
+    auto port = streamer->getOutputPort();
+    streamer->update();
+    CHECK(port->getNextFrame<Image>()->getCreationTimestamp() == 1500);
+
+    // Frames already streamed before the seek are received first
+    streamer->seek(20);
+    bool found = false;
+    for(int i = 0; i < 100 && !found; ++i) {
+        auto image = port->getNextFrame<Image>();
+        found = image->getCreationTimestamp() == 1200;
+    }
+    REQUIRE(found);
+    CHECK(port->getNextFrame<Image>()->getCreationTimestamp() == 1210);
+    CHECK_THROWS(streamer->seek(100));
+}
+
+TEST_CASE("RecordingFileStreamer with corrupt frame ends the stream with an error", "[fast][RecordingFileStreamer]") {
+    const std::string filename = createRecording(10);
+    {
+        // Overwrite the header of the fourth frame
+        std::fstream file(filename, std::ios::in | std::ios::out | std::ios::binary);
+        std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        std::size_t position = 0;
+        for(int i = 0; i < 4; ++i)
+            position = content.find("FRME", i == 0 ? 0 : position + 1);
+        REQUIRE(position != std::string::npos);
+        file.seekp(position);
+        file.write("XXXX", 4);
+    }
+
+    auto streamer = RecordingFileStreamer::New();
+    streamer->setFilename(filename);
+    REQUIRE(streamer->getNrOfFrames() == 10);
+    auto port = streamer->getOutputPort();
+    streamer->update();
+    // Frames before the corrupt one may be received, but the stream must not be marked as complete
+    bool stopped = false;
+    for(int i = 0; i < 10 && !stopped; ++i) {
+        try {
+            CHECK_FALSE(port->getNextFrame<Image>()->isLastFrame());
+        } catch(ThreadStopped &e) {
+            stopped = true;
+        }
+    }
+    CHECK(stopped);
+    CHECK(streamer->getStreamError().find("corrupt") != std::string::npos);
+}
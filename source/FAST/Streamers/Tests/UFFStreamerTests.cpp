@@ -0,0 +1,195 @@
+#include "FAST/Testing.hpp"
+#include "FAST/Streamers/UFFStreamer.hpp"
+#include "FAST/Data/Image.hpp"
+#define H5_BUILT_AS_DYNAMIC_LIB
+#include <H5Cpp.h>
+#include <complex>
+#include <functional>
+
+using namespace fast;
+
+static void writeClassAttribute(H5::Group& group, std::string className) {
+    H5::StrType type(H5::PredType::C_S1, H5T_VARIABLE);
+    auto attribute = group.createAttribute("class", type, H5::DataSpace(H5S_SCALAR));
+    attribute.write(type, className);
+}
+
+static void writeAxis(H5::Group& group, std::string name, const std::vector<float>& axis) {
+    hsize_t dims[2] = {1, axis.size()};
+    auto dataset = group.createDataSet(name, H5::PredType::NATIVE_FLOAT, H5::DataSpace(2, dims));
+    dataset.write(axis.data(), H5::PredType::NATIVE_FLOAT);
+}
+
+static std::vector<float> createAxis(float start, float end, int size) {
+    std::vector<float> axis(size);
+    for(int i = 0; i < size; ++i)
+        axis[i] = start + (end - start)*i/(size - 1);
+    return axis;
+}
+
+/**
+ * Create a UFF file with beamformed IQ data, where iq gives the sample of a frame at position x, y
+ */
+static std::string createUFFFile(std::string filename, bool sectorScan, int frames,
+        const std::vector<float>& xAxis, const std::vector<float>& yAxis,
+        std::function<std::complex<float>(int, int, int)> iq) {
+    H5::H5File file(filename, H5F_ACC_TRUNC);
+    auto group = file.createGroup("b_data");
+    writeClassAttribute(group, "uff.beamformed_data");
+    auto scanGroup = group.createGroup("scan");
+    writeClassAttribute(scanGroup, sectorScan ? "uff.sector_scan" : "uff.linear_scan");
+    writeAxis(scanGroup, sectorScan ? "azimuth_axis" : "x_axis", xAxis);
+    writeAxis(scanGroup, sectorScan ? "depth_axis" : "z_axis", yAxis);
+
+    // Data is stored column major, with depth as the fastest changing dimension
+    const int width = xAxis.size();
+    const int height = yAxis.size();
+    std::vector<float> real(frames*width*height);
+    std::vector<float> imag(frames*width*height);
+    for(int frame = 0; frame < frames; ++frame) {
+        for(int x = 0; x < width; ++x) {
+            for(int y = 0; y < height; ++y) {
+                const auto sample = iq(frame, x, y);
+                real[y + x*height + frame*width*height] = sample.real();
+                imag[y + x*height + frame*width*height] = sample.imag();
+            }
+        }
+    }
+    auto dataGroup = group.createGroup("data");
+    hsize_t dims[4] = {(hsize_t)frames, 1, 1, (hsize_t)(width*height)};
+    auto realDataset = dataGroup.createDataSet("real", H5::PredType::NATIVE_FLOAT, H5::DataSpace(4, dims));
+    realDataset.write(real.data(), H5::PredType::NATIVE_FLOAT);
+    auto imagDataset = dataGroup.createDataSet("imag", H5::PredType::NATIVE_FLOAT, H5::DataSpace(4, dims));
+    imagDataset.write(imag.data(), H5::PredType::NATIVE_FLOAT);
+    return filename;
+}
+
+static std::complex<float> linearScanSample(int frame, int x, int y) {
+    return std::complex<float>(frame*100.0f + x + 1.0f, 0.5f*y - 3.0f);
+}
+
+TEST_CASE("UFFStreamer streams frames in order with read ahead and detects envelope", "[fast][UFFStreamer]") {
+    const int width = 40;
+    const int height = 70;
+    const int frames = 12;
+    auto streamer = UFFStreamer::New();
+    streamer->setFilename(createUFFFile("UFFStreamerTest.uff", false, frames,
+            createAxis(-0.01f, 0.01f, width), createAxis(0.0f, 0.03f, height), linearScanSample));
+    streamer->setReadAheadFrames(2);
+    auto port = streamer->getOutputPort();
+    streamer->update();
+    for(int frame = 0; frame < frames; ++frame) {
+        auto image = port->getNextFrame<Image>();
+        REQUIRE(image->getWidth() == width);
+        REQUIRE(image->getHeight() == height);
+        REQUIRE(image->getDataType() == TYPE_FLOAT);
+        CHECK(image->isLastFrame() == (frame == frames - 1));
+        auto access = image->getImageAccess(ACCESS_READ);
+        const float* data = (const float*)access->get();
+        float maxError = 0.0f;
+        for(int y = 0; y < height; ++y) {
+            for(int x = 0; x < width; ++x) {
+                const float expected = std::abs(linearScanSample(frame, x, y));
+                maxError = std::max(maxError, std::fabs(data[x + y*width] - expected)/expected);
+            }
+        }
+        CHECK(maxError < 1e-5f);
+    }
+}
+
+TEST_CASE("UFFStreamer log compression", "[fast][UFFStreamer]") {
+    const int width = 16;
+    const int height = 256;
+    auto sample = [](int frame, int x, int y) {
+        // Envelope spanning more than the dynamic range
+        return std::complex<float>(std::pow(10.0f, -(float)y/height*4.0f)*(x + 1), 0.0f);
+    };
+    const float dynamicRange = 50.0f;
+    auto streamer = UFFStreamer::New();
+    streamer->setFilename(createUFFFile("UFFStreamerLogTest.uff", false, 1,
+            createAxis(-0.01f, 0.01f, width), createAxis(0.0f, 0.03f, height), sample));
+    streamer->setLogCompression(true);
+    streamer->setDynamicRange(dynamicRange);
+    auto port = streamer->getOutputPort();
+    streamer->update();
+    auto image = port->getNextFrame<Image>();
+    REQUIRE(image->getDataType() == TYPE_UINT8);
+    auto access = image->getImageAccess(ACCESS_READ);
+    const uchar* data = (const uchar*)access->get();
+    const float maximum = std::abs(sample(0, width - 1, 0));
+    int maxError = 0;
+    for(int y = 0; y < height; ++y) {
+        for(int x = 0; x < width; ++x) {
+            const float dB = 20.0f*std::log10(std::abs(sample(0, x, y))/maximum);
+            const int expected = (int)std::round(std::min(std::max((dB + dynamicRange)/dynamicRange*255.0f, 0.0f), 255.0f));
+            maxError = std::max(maxError, std::abs((int)data[x + y*width] - expected));
+        }
+    }
+    CHECK(maxError <= 1);
+}
+
+TEST_CASE("UFFStreamer scan conversion of sector scans", "[fast][UFFStreamer]") {
+    const auto azimuth = createAxis(-0.6f, 0.6f, 65);
+    const auto depth = createAxis(0.01f, 0.06f, 129);
+    const float depthStep = depth[1] - depth[0];
+    const float azimuthStep = azimuth[1] - azimuth[0];
+    // Envelope increases linearly with depth, thus bilinear interpolation is exact
+    auto sample = [](int frame, int x, int y) {
+        return std::complex<float>(y + 1.0f, 0.0f);
+    };
+    const int outputWidth = 200;
+    auto streamer = UFFStreamer::New();
+    streamer->setFilename(createUFFFile("UFFStreamerSectorTest.uff", true, 1, azimuth, depth, sample));
+    streamer->setScanConversion(true);
+    streamer->setScanConvertedWidth(outputWidth);
+    auto port = streamer->getOutputPort();
+    streamer->update();
+    auto image = port->getNextFrame<Image>();
+    REQUIRE(image->getWidth() == outputWidth);
+    REQUIRE(image->getDataType() == TYPE_FLOAT);
+
+    // Position of each pixel in meters
+    const float pixelSpacing = image->getSpacing().x()/1000.0f;
+    const float minX = depth.back()*std::sin(azimuth.front());
+    const float minZ = depth.front()*std::cos(azimuth.front());
+    auto access = image->getImageAccess(ACCESS_READ);
+    const float* data = (const float*)access->get();
+    float maxError = 0.0f;
+    int inside = 0;
+    int outside = 0;
+    for(int y = 0; y < (int)image->getHeight(); ++y) {
+        for(int x = 0; x < outputWidth; ++x) {
+            const float posX = minX + x*pixelSpacing;
+            const float posZ = minZ + y*pixelSpacing;
+            const float radius = std::sqrt(posX*posX + posZ*posZ);
+            const float angle = std::atan2(posX, posZ);
+            const float value = data[x + y*outputWidth];
+            // Pixels close to the border of the sector may be on either side of it
+            if(angle > azimuth.front() + azimuthStep && angle < azimuth.back() - azimuthStep &&
+                    radius > depth.front() + depthStep && radius < depth.back() - depthStep) {
+                const float expected = (radius - depth.front())/depthStep + 1.0f;
+                maxError = std::max(maxError, std::fabs(value - expected));
+                ++inside;
+            } else if(angle < azimuth.front() - azimuthStep || angle > azimuth.back() + azimuthStep ||
+                    radius < depth.front() - depthStep || radius > depth.back() + depthStep) {
+                CHECK(value == 0.0f);
+                ++outside;
+            }
+        }
+    }
+    CHECK(inside > 0);
+    CHECK(outside > 0);
+    CHECK(maxError < 0.01f);
+}
+
+TEST_CASE("UFFStreamer with missing data ends the stream with an error", "[fast][UFFStreamer]") {
+    {
+        H5::H5File file("UFFStreamerInvalidTest.uff", H5F_ACC_TRUNC);
+        auto group = file.createGroup("b_data");
+        writeClassAttribute(group, "uff.beamformed_data");
+    }
+    auto streamer = UFFStreamer::New();
+    streamer->setFilename("UFFStreamerInvalidTest.uff");
+    CHECK_THROWS(streamer->update());
+    CHECK_FALSE(streamer->getStreamError().empty());
+}
@@ -1,5 +1,6 @@
 #include "UFFStreamer.hpp"
 #include <FAST/Data/Image.hpp>
+#include <deque>
 #define H5_BUILT_AS_DYNAMIC_LIB
 #include <H5Cpp.h>
 
@@ -12,12 +13,22 @@ namespace fast {
         createStringAttribute("filename", "Filename", "File to stream UFF data from", "");
         createStringAttribute("name", "Group name", "Name of which beamformed_data group to stream from", "");
         createBooleanAttribute("loop", "Loop", "Loop recordin", false);
+        createIntegerAttribute("read-ahead", "Read ahead frames", "Nr of frames to read ahead from file", m_readAheadFrames);
+        createBooleanAttribute("log-compression", "Log compression", "Log compress envelope of IQ data to 8 bit image", m_logCompression);
+        createFloatAttribute("dynamic-range", "Dynamic range", "Dynamic range in dB used for log compression", m_dynamicRange);
+        createBooleanAttribute("scan-conversion", "Scan conversion", "Scan convert sector scans", m_scanConversion);
+        createIntegerAttribute("scan-converted-width", "Scan converted width", "Width of scan converted image", m_scanConvertedWidth);
     }
 
     void UFFStreamer::loadAttributes() {
         setFilename(getStringAttribute("filename"));
         setLooping(getBooleanAttribute("loop"));
         setName(getStringAttribute("name"));
+        setReadAheadFrames(getIntegerAttribute("read-ahead"));
+        setLogCompression(getBooleanAttribute("log-compression"));
+        setDynamicRange(getFloatAttribute("dynamic-range"));
+        setScanConversion(getBooleanAttribute("scan-conversion"));
+        setScanConvertedWidth(getIntegerAttribute("scan-converted-width"));
     }
 
     void UFFStreamer::setLooping(bool loop) {
@@ -34,7 +45,38 @@ namespace fast {
         setModified(true);
     }
 
-    static std::string readStringAttribute(const H5::Attribute& att) {        
+    void UFFStreamer::setReadAheadFrames(uint frames) {
+        if(frames == 0)
+            throw Exception("Nr of read ahead frames in UFFStreamer must be at least 1");
+        m_readAheadFrames = frames;
+        setModified(true);
+    }
+
+    void UFFStreamer::setLogCompression(bool compress) {
+        m_logCompression = compress;
+        setModified(true);
+    }
+
+    void UFFStreamer::setDynamicRange(float dynamicRange) {
+        if(dynamicRange <= 0)
+            throw Exception("Dynamic range in UFFStreamer must be larger than 0");
+        m_dynamicRange = dynamicRange;
+        setModified(true);
+    }
+
+    void UFFStreamer::setScanConversion(bool convert) {
+        m_scanConversion = convert;
+        setModified(true);
+    }
+
+    void UFFStreamer::setScanConvertedWidth(uint width) {
+        if(width < 2)
+            throw Exception("Scan converted width in UFFStreamer must be at least 2");
+        m_scanConvertedWidth = width;
+        setModified(true);
+    }
+
+    static std::string readStringAttribute(const H5::Attribute& att) {
         std::string result;
         att.read(att.getDataType(), result);
         return result;
@@ -55,7 +97,7 @@ namespace fast {
                 throw Exception("You must set filename in UFFImageImporter with setFilename()");
             if (!fileExists(m_filename))
                 throw FileNotFoundException(m_filename);
-                       
+
             m_streamIsStarted = true;
             m_thread = std::make_unique<std::thread>(std::bind(&UFFStreamer::generateStream, this));
         }
@@ -63,12 +105,168 @@ namespace fast {
         waitForFirstFrame();
     }
 
-    void UFFStreamer::generateStream() {
+    /**
+     * A frame read from file. UFF data is stored column major, i.e. with depth as the fastest changing dimension.
+     */
+    struct UFFFrame {
+        // IQ data. The envelope is computed in place in real.
+        std::vector<float> real;
+        std::vector<float> imag;
+        // Already scan converted data
+        std::vector<uchar> data;
+        int frameNr;
+    };
+
+    /**
+     * Sample of the scan conversion lookup table. index is the position of the nearest sample with lower depth and azimuth
+     * in the column major frame, or -1 if the pixel is outside the sector.
+     */
+    struct ScanConversionSample {
+        int index;
+        float depthWeight;
+        float azimuthWeight;
+    };
+
+    /**
+     * Compute envelope in place in frame.real, and optionally log compress it to the range 0-255
+     */
+    static void envelopeDetection(UFFFrame& frame, int width, int height, bool logCompression, float dynamicRange) {
+        std::vector<float> columnMax(width);
+        #pragma omp parallel for
+        for(int x = 0; x < width; ++x) {
+            Eigen::Map<Eigen::ArrayXf> real(&frame.real[x*height], height);
+            Eigen::Map<const Eigen::ArrayXf> imag(&frame.imag[x*height], height);
+            real = (real.square() + imag.square()).sqrt();
+            columnMax[x] = real.maxCoeff();
+        }
+        if(!logCompression)
+            return;
+
+        const float maximum = std::max(*std::max_element(columnMax.begin(), columnMax.end()), std::numeric_limits<float>::min());
+        // 20*log10(envelope/max) mapped from [-dynamicRange, 0] dB to [0, 255].
+        // 0.5 is added so that truncating when converting to uchar rounds to nearest, also after interpolation.
+        const float scale = 20.0f/std::log(10.0f)*255.0f/dynamicRange;
+        const float offset = 255.0f - scale*std::log(maximum) + 0.5f;
+        #pragma omp parallel for
+        for(int x = 0; x < width; ++x) {
+            Eigen::Map<Eigen::ArrayXf> envelope(&frame.real[x*height], height);
+            envelope = (envelope.max(std::numeric_limits<float>::min()).log()*scale + offset).max(0.0f).min(255.5f);
+        }
+    }
+
+    /**
+     * Transpose column major frame to a row major image, in tiles to keep both reads and writes cache friendly
+     */
+    template <class InputType, class OutputType>
+    static void transpose(const InputType* input, OutputType* output, int width, int height) {
+        const int tileSize = 32;
+        const int tilesX = (width + tileSize - 1)/tileSize;
+        const int tilesY = (height + tileSize - 1)/tileSize;
+        const int tileCount = tilesX*tilesY;
+        #pragma omp parallel for
+        for(int tile = 0; tile < tileCount; ++tile) {
+            const int tileX = (tile % tilesX)*tileSize;
+            const int tileY = (tile / tilesX)*tileSize;
+            const int endX = std::min(tileX + tileSize, width);
+            const int endY = std::min(tileY + tileSize, height);
+            for(int x = tileX; x < endX; ++x) {
+                for(int y = tileY; y < endY; ++y) {
+                    output[x + y*width] = (OutputType)input[y + x*height];
+                }
+            }
+        }
+    }
 
+    template <class OutputType>
+    static void scanConvert(const float* input, OutputType* output, const std::vector<ScanConversionSample>& lookupTable, int height) {
+        const int size = lookupTable.size();
+        #pragma omp parallel for
+        for(int i = 0; i < size; ++i) {
+            const ScanConversionSample sample = lookupTable[i];
+            if(sample.index < 0) {
+                output[i] = 0;
+                continue;
+            }
+            const float* p = &input[sample.index];
+            const float nearAzimuth = p[0] + sample.depthWeight*(p[1] - p[0]);
+            const float farAzimuth = p[height] + sample.depthWeight*(p[height + 1] - p[height]);
+            output[i] = (OutputType)(nearAzimuth + sample.azimuthWeight*(farAzimuth - nearAzimuth));
+        }
+    }
 
+    /**
+     * Create lookup table from cartesian pixels to the sector given by the azimuth (radians) and depth (meters) axes.
+     * The axes are assumed to be uniformly sampled.
+     */
+    static std::vector<ScanConversionSample> createScanConversionLookupTable(
+            const std::vector<float>& azimuth,
+            const std::vector<float>& depth,
+            int outputWidth,
+            int& outputHeight,
+            float& pixelSpacing) {
+        const int width = azimuth.size();
+        const int height = depth.size();
+        const float minAzimuth = std::min(azimuth.front(), azimuth.back());
+        const float maxAzimuth = std::max(azimuth.front(), azimuth.back());
+        const float minDepth = std::min(depth.front(), depth.back());
+        const float maxDepth = std::max(depth.front(), depth.back());
+        const float minX = maxDepth*std::sin(minAzimuth);
+        const float maxX = maxDepth*std::sin(maxAzimuth);
+        const float minZ = minDepth*std::min(std::cos(minAzimuth), std::cos(maxAzimuth));
+        pixelSpacing = (maxX - minX)/(outputWidth - 1);
+        outputHeight = (int)std::ceil((maxDepth - minZ)/pixelSpacing) + 1;
+
+        const float azimuthStep = azimuth[1] - azimuth[0];
+        const float depthStep = depth[1] - depth[0];
+        std::vector<ScanConversionSample> lookupTable(outputWidth*outputHeight);
+        #pragma omp parallel for
+        for(int y = 0; y < outputHeight; ++y) {
+            for(int x = 0; x < outputWidth; ++x) {
+                const float posX = minX + x*pixelSpacing;
+                const float posZ = minZ + y*pixelSpacing;
+                const float azimuthIndex = (std::atan2(posX, posZ) - azimuth[0])/azimuthStep;
+                const float depthIndex = (std::sqrt(posX*posX + posZ*posZ) - depth[0])/depthStep;
+                ScanConversionSample& sample = lookupTable[x + y*outputWidth];
+                if(azimuthIndex < 0 || azimuthIndex > width - 1 || depthIndex < 0 || depthIndex > height - 1) {
+                    sample.index = -1;
+                    continue;
+                }
+                const int i = std::min((int)azimuthIndex, width - 2);
+                const int j = std::min((int)depthIndex, height - 2);
+                sample.index = j + i*height;
+                sample.azimuthWeight = azimuthIndex - i;
+                sample.depthWeight = depthIndex - j;
+            }
+        }
+        return lookupTable;
+    }
+
+    static std::vector<float> readAxis(H5::Group& group, std::string name) {
+        auto dataset = group.openDataSet(name);
+        auto dataspace = dataset.getSpace();
+        hsize_t dims_out[2];
+        dataspace.getSimpleExtentDims(dims_out, NULL);
+        if(dims_out[1] < 2)
+            throw Exception("UFF axis " + name + " must have at least 2 elements");
+        std::vector<float> axis(dims_out[0]*dims_out[1]);
+        dataset.read(axis.data(), H5::PredType::NATIVE_FLOAT);
+        return axis;
+    }
+
+    void UFFStreamer::generateStream() {
+        // Exceptions can't escape the streamer thread, errors end the stream instead
+        try {
+            streamFile();
+        } catch(H5::Exception &e) {
+            streamError("Error reading UFF file " + m_filename + ": " + e.getDetailMsg());
+        } catch(std::exception &e) {
+            streamError("Error streaming UFF file " + m_filename + ": " + e.what());
+        }
+    }
+
+    void UFFStreamer::streamFile() {
         // Open file
         H5::H5File file(m_filename.c_str(), H5F_ACC_RDONLY);
-        
 
         std::string selectedGroupName = m_name;
         if (m_name.empty()) {
@@ -89,15 +287,13 @@ namespace fast {
             selectedGroupName = beamformedDataGroups[0];
         }
         reportInfo() << "Using HDF5 group: " << selectedGroupName << reportEnd();
-       
-        int width;
-        int height;
 
         auto scanGroup = file.openGroup(selectedGroupName + "/scan");
         auto classAttribute = scanGroup.openAttribute("class");
         auto className = readStringAttribute(classAttribute);
+        const bool linearScan = className == "uff.linear_scan";
         std::string x_axis_name, y_axis_name;
-        if (className == "uff.linear_scan") {
+        if (linearScan) {
             x_axis_name = "x_axis";
             y_axis_name = "z_axis";
         } else {
@@ -105,40 +301,18 @@ namespace fast {
             y_axis_name = "depth_axis";
         }
         // First get image size
-            {
-                auto dataset = scanGroup.openDataSet(x_axis_name);
-                auto dataspace = dataset.getSpace();
-                hsize_t dims_out[2];
-                int ndims = dataspace.getSimpleExtentDims(dims_out, NULL);
-                width = dims_out[1];
-            }
-            {
-                auto dataset = scanGroup.openDataSet(y_axis_name);
-                auto dataspace = dataset.getSpace();
-                hsize_t dims_out[2];
-                int ndims = dataspace.getSimpleExtentDims(dims_out, NULL);
-                height = dims_out[1];
-            }     
-            reportInfo() << "UFF Image size was found to be " << width << " " << height << reportEnd();
+        const auto x_axis = readAxis(scanGroup, x_axis_name);
+        const auto y_axis = readAxis(scanGroup, y_axis_name);
+        const int width = x_axis.size();
+        const int height = y_axis.size();
+        reportInfo() << "UFF Image size was found to be " << width << " " << height << reportEnd();
 
         // Get spacing
         Vector3f spacing = Vector3f::Ones();
-        {
-            // TODO only read 2 elements
-            auto dataset = scanGroup.openDataSet(x_axis_name);
-            auto x_axis = std::make_unique<float[]>(width);
-            dataset.read(x_axis.get(), H5::PredType::NATIVE_FLOAT);
-            spacing.x() = std::fabs(x_axis[0] - x_axis[1])*1000;
-        }
-        {
-            // TODO only read 2 elements
-            auto dataset = scanGroup.openDataSet(y_axis_name);
-            auto z_axis = std::make_unique<float[]>(height);
-            dataset.read(z_axis.get(), H5::PredType::NATIVE_FLOAT);
-            spacing.y() = std::fabs(z_axis[0] - z_axis[1])*1000;
-        }
+        spacing.x() = std::fabs(x_axis[0] - x_axis[1])*1000;
+        spacing.y() = std::fabs(y_axis[0] - y_axis[1])*1000;
         reportInfo() << "Spacing in UFF file was " << spacing.transpose() << reportEnd();
-          
+
         H5::Group group;
         bool scanconverted = false;
         try {
@@ -149,118 +323,188 @@ namespace fast {
             scanconverted = true;
         }
 
-        // TODO refactor duplication of code
-        if (!scanconverted) {
-            auto dataset = group.openDataSet("imag");
-            auto dataspace = dataset.getSpace();
-            hsize_t dims_out[4];
-            int ndims = dataspace.getSimpleExtentDims(dims_out, NULL);
-            if (ndims != 4)
-                throw Exception("Exepected 4 dimensions in UFF file, got " + std::to_string(ndims));
-            int frameCount = dims_out[0];
-            reportInfo() << "Nr of frames in UFF file: " << frameCount << reportEnd();
-
-            auto imagDataset = group.openDataSet("imag");
-            auto imagDataspace = imagDataset.getSpace();
-            auto realDataset = group.openDataSet("real");
-            auto realDataspace = realDataset.getSpace();
-
-            hsize_t count[4] = { 1, 1, 1, 1 }; // how many blocks to extract
-            hsize_t blockSize[4] = { 1, 1, 1, width * height }; // block 
-            hsize_t offset[4] = { 0, 0, 0, 0 };   // hyperslab offset in the file     
-
-            H5::DataSpace memspace(4, blockSize);
-
-            while (true) {
-                for (int frameNr = 0; frameNr < frameCount; ++frameNr) {
+        // IQ data is stored as two datasets imag and real, while already scan converted data is stored as uchar in data
+        auto dataset = group.openDataSet(scanconverted ? "data" : "imag");
+        auto dataspace = dataset.getSpace();
+        H5::DataSet realDataset;
+        H5::DataSpace realDataspace;
+        if(!scanconverted) {
+            realDataset = group.openDataSet("real");
+            realDataspace = realDataset.getSpace();
+        }
+        hsize_t dims_out[4];
+        int ndims = dataspace.getSimpleExtentDims(dims_out, NULL);
+        if (ndims != 4)
+            throw Exception("Exepected 4 dimensions in UFF file, got " + std::to_string(ndims));
+        const int frameCount = dims_out[0];
+        reportInfo() << "Nr of frames in UFF file: " << frameCount << reportEnd();
+
+        const int size = width*height;
+        hsize_t count[4] = { 1, 1, 1, 1 }; // how many blocks to extract
+        hsize_t blockSize[4] = { 1, 1, 1, (hsize_t)size }; // block
+        hsize_t offset[4] = { 0, 0, 0, 0 };   // hyperslab offset in the file
+        H5::DataSpace memspace(4, blockSize);
+
+        // Sector scans of IQ data are scan converted using a lookup table
+        const bool convertSector = m_scanConversion && !linearScan && !scanconverted;
+        std::vector<ScanConversionSample> lookupTable;
+        int outputWidth = width;
+        int outputHeight = height;
+        if(convertSector) {
+            float pixelSpacing;
+            outputWidth = m_scanConvertedWidth;
+            lookupTable = createScanConversionLookupTable(x_axis, y_axis, outputWidth, outputHeight, pixelSpacing);
+            spacing = Vector3f(pixelSpacing*1000, pixelSpacing*1000, 1);
+        }
+        const DataType outputType = scanconverted || m_logCompression ? TYPE_UINT8 : TYPE_FLOAT;
+        // Azimuth spacing of sector scans which are not scan converted is in radians, thus it is not set
+        const bool setSpacing = scanconverted || linearScan || convertSector;
+
+        // Frames are read by a separate thread into a fixed set of buffers, which are reused when they have been processed.
+        // Only the reader thread uses the HDF5 file after this point.
+        std::vector<UFFFrame> frames(m_readAheadFrames + 1);
+        std::vector<UFFFrame*> freeFrames;
+        for(auto& frame : frames) {
+            if(scanconverted) {
+                frame.data.resize(size);
+            } else {
+                frame.real.resize(size);
+                frame.imag.resize(size);
+            }
+            freeFrames.push_back(&frame);
+        }
+        // A nullptr marks the end of the stream
+        std::deque<UFFFrame*> readyFrames;
+        bool stopReading = false;
+        std::string readError;
+        std::mutex queueMutex;
+        std::condition_variable queueCondition;
+
+        std::thread reader([&]() {
+            try {
+                int frameNr = 0;
+                while(true) {
+                    UFFFrame* frame;
+                    {
+                        std::unique_lock<std::mutex> lock(queueMutex);
+                        queueCondition.wait(lock, [&]() { return stopReading || !freeFrames.empty(); });
+                        if(stopReading)
+                            return;
+                        frame = freeFrames.back();
+                        freeFrames.pop_back();
+                    }
                     reportInfo() << "Extracting frame " << frameNr << " in UFF file" << reportEnd();
-                    // Extract 1 frame
-                    auto imaginary = std::make_unique<float[]>(width * height);
-                    auto real = std::make_unique<float[]>(width * height);
                     offset[0] = frameNr;
-                    imagDataspace.selectHyperslab(H5S_SELECT_SET, count, offset, NULL, blockSize);
-                    imagDataset.read(imaginary.get(), H5::PredType::NATIVE_FLOAT, memspace, imagDataspace);
-                    realDataspace.selectHyperslab(H5S_SELECT_SET, count, offset, NULL, blockSize);
-                    realDataset.read(real.get(), H5::PredType::NATIVE_FLOAT, memspace, realDataspace);
-
-                    // TODO start env
-                    auto image_data = std::make_unique<float[]>(width * height);
-                    for (int y = 0; y < height; ++y) {
-                        for (int x = 0; x < width; ++x) {
-
-                            int pos = y + x * height;
-                            image_data[x + y * width] = std::sqrt(imaginary[pos] * imaginary[pos] + real[pos] * real[pos]);
-                        }
+                    dataspace.selectHyperslab(H5S_SELECT_SET, count, offset, NULL, blockSize);
+                    if(scanconverted) {
+                        dataset.read(frame->data.data(), H5::PredType::NATIVE_UCHAR, memspace, dataspace);
+                    } else {
+                        dataset.read(frame->imag.data(), H5::PredType::NATIVE_FLOAT, memspace, dataspace);
+                        realDataspace.selectHyperslab(H5S_SELECT_SET, count, offset, NULL, blockSize);
+                        realDataset.read(frame->real.data(), H5::PredType::NATIVE_FLOAT, memspace, realDataspace);
                     }
-                    // TODO end env
-                    auto image = Image::New();
-                    image->create(width, height, DataType::TYPE_FLOAT, 1, std::move(image_data));
-                    //image->setSpacing(spacing);
-                    //std::cout << image->calculateMaximumIntensity() << " " << image->calculateMinimumIntensity() << std::endl;
-
-                    try {
-                        addOutputData(0, image);
-                        frameAdded();
+                    frame->frameNr = frameNr;
+                    {
+                        std::lock_guard<std::mutex> lock(queueMutex);
+                        readyFrames.push_back(frame);
                     }
-                    catch (ThreadStopped & e) {
-                        break;
+                    queueCondition.notify_all();
+                    ++frameNr;
+                    if(frameNr == frameCount) {
+                        if(!m_loop)
+                            break;
+                        frameNr = 0;
                     }
                 }
-                if (!m_loop) {
+            } catch(H5::Exception &e) {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                readError = e.getDetailMsg();
+            } catch(std::exception &e) {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                readError = e.what();
+            }
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                readyFrames.push_back(nullptr);
+            }
+            queueCondition.notify_all();
+        });
+
+        while(true) {
+            {
+                std::unique_lock<std::mutex> lock(m_stopMutex);
+                if(m_stop) {
+                    m_streamIsStarted = false;
+                    m_firstFrameIsInserted = false;
                     break;
                 }
             }
-        } else {
-            auto dataset = group.openDataSet("data");
-            auto dataspace = dataset.getSpace();
-            hsize_t dims_out[4];
-            int ndims = dataspace.getSimpleExtentDims(dims_out, NULL);
-            if (ndims != 4)
-                throw Exception("Exepected 4 dimensions in UFF file, got " + std::to_string(ndims));
-            int frameCount = dims_out[0];
-            reportInfo() << "Nr of frames in UFF file: " << frameCount << reportEnd();
-
-            hsize_t count[4] = { 1, 1, 1, 1 }; // how many blocks to extract
-            hsize_t blockSize[4] = { 1, 1, 1, width * height }; // block 
-            hsize_t offset[4] = { 0, 0, 0, 0 };   // hyperslab offset in the file     
-
-            H5::DataSpace memspace(4, blockSize);
-
-            while (true) {
-                for (int frameNr = 0; frameNr < frameCount; ++frameNr) {
-                    reportInfo() << "Extracting frame " << frameNr << " in UFF file" << reportEnd();
-                    // Extract 1 frame
-                    auto data = std::make_unique<uchar[]>(width * height);
-                    offset[0] = frameNr;
-                    dataspace.selectHyperslab(H5S_SELECT_SET, count, offset, NULL, blockSize);
-                    dataset.read(data.get(), H5::PredType::NATIVE_UCHAR, memspace, dataspace);
-
-                    auto image_data = std::make_unique<uchar[]>(width * height);
-                    for (int y = 0; y < height; ++y) {
-                        for (int x = 0; x < width; ++x) {
-
-                            int pos = y + x * height;
-                            image_data[x + y * width] = data[pos];
-                        }
-                    }
-
-                    auto image = Image::New();
-                    image->create(width, height, DataType::TYPE_UINT8, 1, std::move(image_data));
-                    image->setSpacing(spacing);
-
-                    try {
-                        addOutputData(0, image);
-                        frameAdded();
+            UFFFrame* frame;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                queueCondition.wait(lock, [&]() { return !readyFrames.empty(); });
+                frame = readyFrames.front();
+                readyFrames.pop_front();
+            }
+            if(frame == nullptr)
+                break;
+
+            auto image = Image::New();
+            if(m_memoryPool)
+                image->setMemoryPool(m_memoryPool);
+            auto data = image->getMemoryPool()->allocateHost(outputWidth*outputHeight*getSizeOfDataType(outputType, 1));
+            if(scanconverted) {
+                transpose(frame->data.data(), (uchar*)data.get(), width, height);
+            } else {
+                envelopeDetection(*frame, width, height, m_logCompression, m_dynamicRange);
+                if(convertSector) {
+                    if(outputType == TYPE_UINT8) {
+                        scanConvert(frame->real.data(), (uchar*)data.get(), lookupTable, height);
+                    } else {
+                        scanConvert(frame->real.data(), (float*)data.get(), lookupTable, height);
                     }
-                    catch (ThreadStopped & e) {
-                        break;
+                } else {
+                    if(outputType == TYPE_UINT8) {
+                        transpose(frame->real.data(), (uchar*)data.get(), width, height);
+                    } else {
+                        transpose(frame->real.data(), (float*)data.get(), width, height);
                     }
                 }
-                if (!m_loop) {
-                    break;
-                }
+            }
+            const bool lastFrame = !m_loop && frame->frameNr == frameCount - 1;
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                freeFrames.push_back(frame);
+            }
+            queueCondition.notify_all();
+
+            image->create(Vector2ui(outputWidth, outputHeight), outputType, 1, std::move(data));
+            if(setSpacing)
+                image->setSpacing(spacing);
+            if(lastFrame)
+                image->setLastFrame(getNameOfClass());
+
+            prefetchToDevice(image);
+            try {
+                addOutputData(0, image);
+                frameAdded();
+            } catch(ThreadStopped &e) {
+                break;
             }
         }
-}
 
-}
\ No newline at end of file
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            stopReading = true;
+        }
+        queueCondition.notify_all();
+        reader.join();
+        if(!readError.empty())
+            streamError("Error reading UFF file " + m_filename + ": " + readError);
+    }
+
+    UFFStreamer::~UFFStreamer() {
+        stop();
+    }
+
+}
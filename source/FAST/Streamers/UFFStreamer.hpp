@@ -4,6 +4,13 @@
 
 namespace fast {
 
+/**
+ * Streams beamformed data from an ultrasound file format (UFF) file.
+ *
+ * Frames are read ahead by a separate thread, while envelope detection, optional log compression and
+ * transposition of IQ data is done in parallel on the streamer thread.
+ * Sector scans may optionally be scan converted to a cartesian image.
+ */
 class FAST_EXPORT UFFStreamer : public Streamer {
 	FAST_OBJECT(UFFStreamer)
 public:
@@ -13,11 +20,45 @@ public:
 	void setLooping(bool loop);
 	// Set name of which HDF5 group to stream
 	void setName(std::string name);
+	/**
+	 * Set how many frames to read from the file ahead of the frame which is being processed. Default is 4.
+	 * @param frames
+	 */
+	void setReadAheadFrames(uint frames);
+	/**
+	 * Log compress the envelope of IQ data to an 8 bit B-mode image. Default is false, which
+	 * streams the envelope as a float image.
+	 * @param compress
+	 */
+	void setLogCompression(bool compress);
+	/**
+	 * Set the dynamic range in dB used for log compression. Default is 60 dB.
+	 * @param dynamicRange
+	 */
+	void setDynamicRange(float dynamicRange);
+	/**
+	 * Scan convert sector scans to a cartesian image. Has no effect on linear scans. Default is false.
+	 * @param convert
+	 */
+	void setScanConversion(bool convert);
+	/**
+	 * Set the width in pixels of the scan converted image. The height is set to keep the pixels isotropic.
+	 * Default is 512.
+	 * @param width
+	 */
+	void setScanConvertedWidth(uint width);
 	void loadAttributes() override;
+	~UFFStreamer();
 protected:
 	void generateStream() override;
+	void streamFile();
 	std::string m_filename;
 	std::string m_name;
 	bool m_loop;
+	uint m_readAheadFrames = 4;
+	bool m_logCompression = false;
+	float m_dynamicRange = 60.0f;
+	bool m_scanConversion = false;
+	uint m_scanConvertedWidth = 512;
 };
-}
\ No newline at end of file
+}
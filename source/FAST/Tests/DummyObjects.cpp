@@ -39,7 +39,11 @@ void DummyStreamer::generateStream() {
         image->create(i);
         if(i == mFramesToGenerate-1)
             image->setLastFrame(getNameOfClass());
-        addOutputData(0, image);
+        try {
+            addOutputData(0, image);
+        } catch(ThreadStopped &e) {
+            break;
+        }
         {
             std::unique_lock<std::mutex> lock(mFramesGeneratedMutex);
             mFramesGenerated++;
@@ -83,6 +87,23 @@ int DummyProcessObject2::getStaticDataID() const {
     return mStaticID;
 }
 
+DummyFailingProcessObject::DummyFailingProcessObject() {
+    createInputPort<DummyDataObject>(0);
+    createOutputPort<DummyDataObject>(0);
+}
+
+void DummyFailingProcessObject::execute() {
+    DummyDataObject::pointer input = getInputData<DummyDataObject>(0);
+    if(input->getID() == mFailAtFrame)
+        throw Exception("DummyFailingProcessObject failed at frame " + std::to_string(mFailAtFrame));
+    DummyDataObject::pointer output = getOutputData<DummyDataObject>(0);
+    output->create(input->getID());
+}
+
+void DummyFailingProcessObject::setFailAtFrame(int id) {
+    mFailAtFrame = id;
+}
+
 
 DummyImporter::DummyImporter() {
     createOutputPort<DummyDataObject>(0);
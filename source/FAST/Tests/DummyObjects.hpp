@@ -72,6 +72,21 @@ class DummyProcessObject2 : public ProcessObject {
 
 };
 
+/**
+ * Passes its input through, and throws an exception when receiving the frame with the given ID
+ */
+class DummyFailingProcessObject : public ProcessObject {
+    FAST_OBJECT(DummyFailingProcessObject)
+    public:
+        void setFailAtFrame(int id);
+    private:
+        DummyFailingProcessObject();
+        void execute();
+
+        int mFailAtFrame = 0;
+
+};
+
 class DummyStreamer : public Streamer {
     FAST_OBJECT(DummyStreamer)
     public:
@@ -0,0 +1,105 @@
+#include <FAST/Testing.hpp>
+#include <FAST/PipelineExecutor.hpp>
+#include "DummyObjects.hpp"
+
+using namespace fast;
+
+TEST_CASE("Pipeline executor - two step pipeline with stream", "[fast][PipelineExecutor]") {
+    Config::setStreamingMode(STREAMING_MODE_PROCESS_ALL_FRAMES);
+    auto streamer = DummyStreamer::New();
+    streamer->setSleepTime(1);
+    streamer->setTotalFrames(20);
+
+    auto po1 = DummyProcessObject::New();
+    po1->setInputConnection(streamer->getOutputPort());
+
+    auto po2 = DummyProcessObject::New();
+    po2->setInputConnection(po1->getOutputPort());
+    auto port = po2->getOutputPort();
+    po1->enableRuntimeMeasurements();
+    po2->enableRuntimeMeasurements();
+
+    auto executor = PipelineExecutor::New();
+    executor->addProcessObject(po2);
+    executor->start();
+    executor->join();
+    CHECK_FALSE(executor->isRunning());
+    CHECK(executor->getProcessObjects().size() == 3);
+
+    // All frames should have passed through both stages
+    auto data = port->getNextFrame<DummyDataObject>();
+    CHECK(data->getID() == 19);
+    CHECK(data->isLastFrame());
+    CHECK(po1->getRuntime()->getSamples() == 20);
+    CHECK(po2->getRuntime()->getSamples() == 20);
+}
+
+TEST_CASE("Pipeline executor - branches and static input", "[fast][PipelineExecutor]") {
+    Config::setStreamingMode(STREAMING_MODE_PROCESS_ALL_FRAMES);
+    auto streamer = DummyStreamer::New();
+    streamer->setSleepTime(1);
+    streamer->setTotalFrames(10);
+
+    auto importer = DummyImporter::New();
+
+    auto branch1 = DummyProcessObject::New();
+    branch1->setInputConnection(streamer->getOutputPort());
+    auto port1 = branch1->getOutputPort();
+
+    auto branch2 = DummyProcessObject2::New();
+    branch2->setInputConnection(0, streamer->getOutputPort());
+    branch2->setInputConnection(1, importer->getOutputPort());
+    auto port2 = branch2->getOutputPort();
+
+    auto executor = PipelineExecutor::New();
+    executor->addProcessObject(branch1);
+    executor->addProcessObject(branch2);
+    executor->start();
+    executor->join();
+
+    CHECK(port1->getNextFrame<DummyDataObject>()->getID() == 9);
+    CHECK(port2->getNextFrame<DummyDataObject>()->getID() == 9);
+    // Static importer should only execute once
+    CHECK(branch2->getStaticDataID() == 0);
+}
+
+TEST_CASE("Pipeline executor - stop", "[fast][PipelineExecutor]") {
+    Config::setStreamingMode(STREAMING_MODE_PROCESS_ALL_FRAMES);
+    auto streamer = DummyStreamer::New();
+    streamer->setSleepTime(10);
+    streamer->setTotalFrames(1000);
+
+    auto po = DummyProcessObject::New();
+    po->setInputConnection(streamer->getOutputPort());
+
+    auto executor = PipelineExecutor::New();
+    executor->addProcessObject(po);
+    executor->start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    CHECK(executor->isRunning());
+    executor->stop();
+    CHECK_FALSE(executor->isRunning());
+}
+
+TEST_CASE("Pipeline executor - stage failing mid-stream", "[fast][PipelineExecutor]") {
+    Config::setStreamingMode(STREAMING_MODE_PROCESS_ALL_FRAMES);
+    auto streamer = DummyStreamer::New();
+    streamer->setSleepTime(1);
+    streamer->setTotalFrames(1000);
+
+    auto po1 = DummyFailingProcessObject::New();
+    po1->setFailAtFrame(5);
+    po1->setInputConnection(streamer->getOutputPort());
+
+    auto po2 = DummyProcessObject::New();
+    po2->setInputConnection(po1->getOutputPort());
+
+    auto executor = PipelineExecutor::New();
+    executor->setMaximumNumberOfFramesInFlight(2);
+    executor->addProcessObject(po2);
+    executor->start();
+    // Both the streamer upstream and the stage downstream must be unblocked, and the error rethrown
+    CHECK_THROWS_AS(executor->join(), Exception);
+    CHECK_FALSE(executor->isRunning());
+    CHECK_FALSE(streamer->hasReachedEnd());
+}
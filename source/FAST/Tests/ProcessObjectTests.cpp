@@ -54,6 +54,116 @@ TEST_CASE("Two step pipeline with stream", "[two_step][process_all_frames][Proce
     CHECK(timestep == 20);
 }
 
+TEST_CASE("Two step pipeline with stream PROCESS_ALL_FRAMES_LOCK_FREE", "[two_step][lock_free][ProcessObject][fast]") {
+    Config::setStreamingMode(STREAMING_MODE_PROCESS_ALL_FRAMES_LOCK_FREE);
+    auto streamer = DummyStreamer::New();
+    streamer->setSleepTime(1);
+    streamer->setTotalFrames(20);
+
+    auto streamerPort = streamer->getOutputPort();
+    streamerPort->setMaximumNumberOfFrames(3); // Producer has to wrap around the ring buffer
+    auto po1 = DummyProcessObject::New();
+    po1->setInputConnection(streamerPort);
+
+    auto po2 = DummyProcessObject::New();
+    po2->setInputConnection(po1->getOutputPort());
+
+    auto port = po2->getOutputPort();
+
+    int timestep = 0;
+    bool lastFrame = false;
+    while(!lastFrame) {
+        po2->update();
+        auto image = port->getNextFrame<DummyDataObject>();
+        lastFrame = image->isLastFrame();
+        CHECK(image->getID() == timestep);
+        timestep++;
+    }
+    CHECK(timestep == 20);
+    Config::setStreamingMode(STREAMING_MODE_PROCESS_ALL_FRAMES);
+}
+
+TEST_CASE("Stream with backpressure policy DROP_NEWEST", "[backpressure][ProcessObject][fast]") {
+    Config::setStreamingMode(STREAMING_MODE_PROCESS_ALL_FRAMES);
+    auto streamer = DummyStreamer::New();
+    streamer->setSleepTime(1);
+    streamer->setTotalFrames(20);
+
+    auto port = streamer->getOutputPort();
+    port->setMaximumNumberOfFrames(2);
+    port->setBackpressurePolicy(BACKPRESSURE_DROP_NEWEST);
+    streamer->update();
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    // Last frame is never dropped, and will block until there is room
+    CHECK(port->getNextFrame<DummyDataObject>()->getID() == 0);
+    CHECK(port->getNextFrame<DummyDataObject>()->getID() == 1);
+    CHECK(port->getNextFrame<DummyDataObject>()->getID() == 19);
+    CHECK(port->getNrOfEnqueuedFrames() == 3);
+    CHECK(port->getNrOfDroppedFrames() == 17);
+    CHECK(port->getMaximumDepth() == 2);
+}
+
+TEST_CASE("Stream with backpressure policy DROP_OLDEST", "[backpressure][ProcessObject][fast]") {
+    Config::setStreamingMode(STREAMING_MODE_PROCESS_ALL_FRAMES);
+    auto streamer = DummyStreamer::New();
+    streamer->setSleepTime(1);
+    streamer->setTotalFrames(20);
+
+    auto port = streamer->getOutputPort();
+    port->setMaximumNumberOfFrames(2);
+    port->setBackpressurePolicy(BACKPRESSURE_DROP_OLDEST);
+    streamer->update();
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    CHECK(port->getNextFrame<DummyDataObject>()->getID() == 17);
+    CHECK(port->getNextFrame<DummyDataObject>()->getID() == 18);
+    CHECK(port->getNextFrame<DummyDataObject>()->getID() == 19);
+    CHECK(port->getNrOfDroppedFrames() == 17);
+    CHECK(port->getMaximumDepth() == 2);
+}
+
+TEST_CASE("Stream which keeps every Nth frame", "[backpressure][ProcessObject][fast]") {
+    Config::setStreamingMode(STREAMING_MODE_PROCESS_ALL_FRAMES);
+    auto streamer = DummyStreamer::New();
+    streamer->setSleepTime(1);
+    streamer->setTotalFrames(20);
+
+    auto port = streamer->getOutputPort();
+    port->setKeepEveryNthFrame(5);
+    auto po = DummyProcessObject::New();
+    po->setInputConnection(port);
+    auto outputPort = po->getOutputPort();
+
+    std::vector<int> IDs;
+    bool lastFrame = false;
+    while(!lastFrame) {
+        po->update();
+        auto data = outputPort->getNextFrame<DummyDataObject>();
+        lastFrame = data->isLastFrame();
+        IDs.push_back(data->getID());
+    }
+    CHECK(IDs == std::vector<int>({0, 5, 10, 15, 19}));
+    CHECK(port->getNrOfDroppedFrames() == 15);
+}
+
+TEST_CASE("Stream with maximum frame age", "[backpressure][ProcessObject][fast]") {
+    Config::setStreamingMode(STREAMING_MODE_PROCESS_ALL_FRAMES);
+    auto streamer = DummyStreamer::New();
+    streamer->setSleepTime(1);
+    streamer->setTotalFrames(20);
+
+    auto port = streamer->getOutputPort();
+    port->setMaximumFrameAge(100);
+    streamer->update();
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    // All frames except the last one are too old
+    CHECK(port->getNextFrame<DummyDataObject>()->getID() == 19);
+    CHECK(port->getNrOfEnqueuedFrames() == 20);
+    CHECK(port->getNrOfDroppedFrames() == 19);
+}
+
 TEST_CASE("Simple pipeline with stream NEWEST_FRAME_ONLY", "[ProcessObject][fast][newest_frame_only]") {
     Config::setStreamingMode(STREAMING_MODE_NEWEST_FRAME_ONLY);
     auto streamer = DummyStreamer::New();
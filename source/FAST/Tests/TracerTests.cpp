@@ -0,0 +1,71 @@
+#include <FAST/Testing.hpp>
+#include <FAST/Tracer.hpp>
+#include <FAST/PipelineExecutor.hpp>
+#include "DummyObjects.hpp"
+#include <fstream>
+#include <sstream>
+
+using namespace fast;
+
+TEST_CASE("Tracer does not record events when disabled", "[fast][Tracer]") {
+    Tracer::disable();
+    Tracer::clear();
+    {
+        TraceScope trace("test", "test");
+    }
+    CHECK(Tracer::getNumberOfEvents() == 0);
+}
+
+TEST_CASE("Tracer records events from multiple threads", "[fast][Tracer]") {
+    Tracer::clear();
+    Tracer::enable();
+    std::vector<std::thread> threads;
+    for(int i = 0; i < 4; ++i) {
+        threads.emplace_back([]() {
+            // More than one chunk per thread
+            for(int j = 0; j < 2000; ++j)
+                TraceScope trace("test", "test");
+        });
+    }
+    for(auto&& thread : threads)
+        thread.join();
+    Tracer::disable();
+    CHECK(Tracer::getNumberOfEvents() == 8000);
+    Tracer::clear();
+    CHECK(Tracer::getNumberOfEvents() == 0);
+}
+
+TEST_CASE("Tracer records pipeline execution as Chrome trace", "[fast][Tracer][PipelineExecutor]") {
+    Config::setStreamingMode(STREAMING_MODE_PROCESS_ALL_FRAMES);
+    Tracer::clear();
+    Tracer::enable();
+    auto streamer = DummyStreamer::New();
+    streamer->setSleepTime(1);
+    streamer->setTotalFrames(10);
+
+    auto po1 = DummyProcessObject::New();
+    po1->setInputConnection(streamer->getOutputPort());
+
+    auto po2 = DummyProcessObject::New();
+    po2->setInputConnection(po1->getOutputPort());
+
+    auto executor = PipelineExecutor::New();
+    executor->addProcessObject(po2);
+    executor->start();
+    executor->join();
+    Tracer::disable();
+
+    const std::string filename = "TracerTest.json";
+    Tracer::writeChromeTrace(filename);
+    std::ifstream file(filename);
+    REQUIRE(file.is_open());
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    const std::string trace = buffer.str();
+    CHECK(trace.find("\"traceEvents\"") != std::string::npos);
+    CHECK(trace.find("\"name\":\"DummyProcessObject\",\"cat\":\"execute\"") != std::string::npos);
+    CHECK(trace.find("\"name\":\"getNextFrame\",\"cat\":\"wait\"") != std::string::npos);
+    CHECK(trace.find("\"name\":\"addFrame\",\"cat\":\"wait\"") != std::string::npos);
+    CHECK(trace.find("Stage DummyProcessObject") != std::string::npos);
+    Tracer::clear();
+}
@@ -1,6 +1,7 @@
 #include <FAST/Tools/CommandLineParser.hpp>
 #include <FAST/Pipeline.hpp>
 #include <FAST/Visualization/MultiViewWindow.hpp>
+#include <FAST/Tracer.hpp>
 
 using namespace fast;
 
@@ -8,8 +9,17 @@ int main(int argc, char** argv) {
     
     CommandLineParser parser("FAST Pipeline Executor", "Use this tool to execute pipelines described in text files", true);
     parser.addPositionVariable(1, "pipeline-filename", true, "Pipeline filename");
+    parser.addOption("parallel", "Execute each process object of the pipeline in a separate thread");
+    parser.addVariable("trace", false, "Record a trace of the pipeline execution and write it to this file when the window is closed. "
+                                       "The trace is in the Chrome trace format which can be opened in chrome://tracing or https://ui.perfetto.dev");
 
     parser.parse(argc, argv);
+    if(parser.getOption("parallel"))
+        Config::setExecutionMode(EXECUTION_MODE_PARALLEL);
+    if(parser.gotValue("trace")) {
+        Tracer::enable();
+        Tracer::setThreadName("Main thread");
+    }
 
     auto pipeline = Pipeline(parser.get("pipeline-filename"), parser.getVariables());
     pipeline.parsePipelineFile();
@@ -19,4 +29,9 @@ int main(int argc, char** argv) {
         window->addView(view);
     }
     window->start();
+
+    if(parser.gotValue("trace")) {
+        Tracer::disable();
+        Tracer::writeChromeTrace(parser.get("trace"));
+    }
 }
\ No newline at end of file
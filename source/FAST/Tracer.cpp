@@ -0,0 +1,228 @@
+#include "Tracer.hpp"
+#include "Exception.hpp"
+#include "Reporter.hpp"
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstdlib>
+
+namespace fast {
+
+std::atomic<bool> Tracer::m_enabled(false);
+
+namespace {
+
+struct TraceEvent {
+    std::string name;
+    const char* category;
+    // Microseconds since the trace epoch
+    int64_t start;
+    int64_t duration;
+    bool device;
+};
+
+/**
+ * Append-only list of events recorded by a single thread. Only the owning thread writes,
+ * while writeChromeTrace may read concurrently, thus the size and next pointer of each chunk are atomic.
+ */
+class TraceBuffer {
+    public:
+        static constexpr std::size_t chunkSize = 1024;
+        struct Chunk {
+            TraceEvent events[chunkSize];
+            std::atomic<std::size_t> size{0};
+            std::atomic<Chunk*> next{nullptr};
+            ~Chunk() {
+                delete next.load();
+            }
+        };
+        explicit TraceBuffer(uint64_t threadID) : threadID(threadID), m_first(new Chunk), m_last(m_first.get()) {
+        }
+        void add(TraceEvent event) {
+            if(m_last->size.load(std::memory_order_relaxed) == chunkSize) {
+                auto chunk = new Chunk;
+                m_last->next.store(chunk, std::memory_order_release);
+                m_last = chunk;
+            }
+            const std::size_t index = m_last->size.load(std::memory_order_relaxed);
+            m_last->events[index] = std::move(event);
+            m_last->size.store(index + 1, std::memory_order_release);
+            m_count.fetch_add(1, std::memory_order_release);
+        }
+        template <class Function>
+        void forEach(Function function) const {
+            // Skip events recorded before the last clear
+            std::size_t skip = m_cleared.load(std::memory_order_acquire);
+            for(const Chunk* chunk = m_first.get(); chunk != nullptr; chunk = chunk->next.load(std::memory_order_acquire)) {
+                const std::size_t size = chunk->size.load(std::memory_order_acquire);
+                for(std::size_t i = 0; i < size; ++i) {
+                    if(skip > 0) {
+                        --skip;
+                        continue;
+                    }
+                    function(chunk->events[i]);
+                }
+            }
+        }
+        std::size_t size() const {
+            return m_count.load(std::memory_order_acquire) - m_cleared.load(std::memory_order_acquire);
+        }
+        void clear() {
+            // Memory is not released, as the owning thread may be writing
+            m_cleared.store(m_count.load(std::memory_order_acquire), std::memory_order_release);
+        }
+
+        const uint64_t threadID;
+        std::string threadName;
+    private:
+        std::unique_ptr<Chunk> m_first;
+        Chunk* m_last;
+        std::atomic<std::size_t> m_count{0};
+        std::atomic<std::size_t> m_cleared{0};
+};
+
+// The buffers are owned by the registry, so that events of threads which have finished are kept
+std::mutex registryMutex;
+std::vector<std::unique_ptr<TraceBuffer>> registry;
+thread_local TraceBuffer* threadBuffer = nullptr;
+const auto epoch = std::chrono::steady_clock::now();
+
+TraceBuffer* getThreadBuffer() {
+    if(threadBuffer == nullptr) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        // Thread ID 0 is used for device events
+        registry.push_back(std::make_unique<TraceBuffer>(registry.size() + 1));
+        threadBuffer = registry.back().get();
+    }
+    return threadBuffer;
+}
+
+int64_t toMicroseconds(Tracer::TimePoint time) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(time - epoch).count();
+}
+
+std::string escape(const std::string& str) {
+    std::string result;
+    result.reserve(str.size());
+    for(char c : str) {
+        if(c == '"' || c == '\\') {
+            result += '\\';
+            result += c;
+        } else if((unsigned char)c < 0x20) {
+            result += ' ';
+        } else {
+            result += c;
+        }
+    }
+    return result;
+}
+
+// Enables tracing if the FAST_TRACE environment variable is set, and writes the trace at exit
+struct EnvironmentTrace {
+    std::string filename;
+    EnvironmentTrace() {
+        const char* value = std::getenv("FAST_TRACE");
+        if(value != nullptr && std::string(value) != "") {
+            filename = value;
+            Tracer::enable();
+        }
+    }
+    ~EnvironmentTrace() {
+        if(filename.empty())
+            return;
+        try {
+            Tracer::writeChromeTrace(filename);
+        } catch(Exception& e) {
+            Reporter::error() << e.what() << Reporter::end();
+        }
+    }
+} environmentTrace;
+
+}
+
+void Tracer::enable() {
+    m_enabled.store(true);
+}
+
+void Tracer::disable() {
+    m_enabled.store(false);
+}
+
+void Tracer::addEvent(std::string name, const char* category, TimePoint start, TimePoint end) {
+    if(!isEnabled())
+        return;
+    const int64_t startTime = toMicroseconds(start);
+    getThreadBuffer()->add({std::move(name), category, startTime, toMicroseconds(end) - startTime, false});
+}
+
+void Tracer::addDeviceEvent(std::string name, const char* category, uint64_t duration, TimePoint end) {
+    if(!isEnabled())
+        return;
+    // The device clock is not synchronized with the host clock, place the event so that it ends when the host knew it was finished
+    const int64_t durationMicroseconds = duration / 1000;
+    const int64_t endTime = toMicroseconds(end);
+    getThreadBuffer()->add({std::move(name), category, endTime - durationMicroseconds, durationMicroseconds, true});
+}
+
+void Tracer::setThreadName(std::string name) {
+    auto buffer = getThreadBuffer();
+    std::lock_guard<std::mutex> lock(registryMutex);
+    buffer->threadName = std::move(name);
+}
+
+std::size_t Tracer::getNumberOfEvents() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    std::size_t count = 0;
+    for(auto&& buffer : registry)
+        count += buffer->size();
+    return count;
+}
+
+void Tracer::clear() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for(auto&& buffer : registry)
+        buffer->clear();
+}
+
+void Tracer::writeChromeTrace(std::string filename) {
+    std::ofstream file(filename);
+    if(!file.is_open())
+        throw Exception("Unable to open file " + filename + " for writing trace");
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"OpenCL device\"}}";
+    for(auto&& buffer : registry) {
+        std::string threadName = buffer->threadName.empty() ? "Thread " + std::to_string(buffer->threadID) : buffer->threadName;
+        file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadID <<
+            ",\"args\":{\"name\":\"" << escape(threadName) << "\"}}";
+        buffer->forEach([&file, &buffer](const TraceEvent& event) {
+            file << ",\n{\"name\":\"" << escape(event.name) << "\",\"cat\":\"" << event.category <<
+                "\",\"ph\":\"X\",\"ts\":" << event.start << ",\"dur\":" << event.duration <<
+                ",\"pid\":1,\"tid\":" << (event.device ? 0 : buffer->threadID) << "}";
+        });
+    }
+    file << "\n]}\n";
+}
+
+TraceScope::TraceScope(const char* name, const char* category) : m_enabled(Tracer::isEnabled()), m_category(category) {
+    if(m_enabled) {
+        m_name = name;
+        m_start = std::chrono::steady_clock::now();
+    }
+}
+
+TraceScope::TraceScope(const std::string& name, const char* category) : m_enabled(Tracer::isEnabled()), m_category(category) {
+    if(m_enabled) {
+        m_name = name;
+        m_start = std::chrono::steady_clock::now();
+    }
+}
+
+TraceScope::~TraceScope() {
+    if(m_enabled)
+        Tracer::addEvent(std::move(m_name), m_category, m_start, std::chrono::steady_clock::now());
+}
+
+}
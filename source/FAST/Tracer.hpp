@@ -0,0 +1,82 @@
+#pragma once
+
+#include "FASTExport.hpp"
+#include <atomic>
+#include <chrono>
+#include <string>
+
+namespace fast {
+
+/**
+ * Global recorder of trace events, such as process object executions, data channel waits,
+ * data transfers and OpenCL commands, with a timestamp and the thread they happened in.
+ * Unlike RuntimeMeasurementsManager, which only keeps statistics, the trace shows when things happen
+ * and thus where stages overlap and where threads block.
+ *
+ * Each thread records into its own buffer, thus recording an event never takes a lock.
+ * When disabled, which is the default, the cost of a trace point is a single atomic load.
+ *
+ * Tracing can be enabled with Tracer::enable(), with the --trace option of runPipeline, or by setting
+ * the environment variable FAST_TRACE to a filename; the trace is then written to this file when the program exits.
+ * The trace is written in the Chrome trace event format which can be opened in chrome://tracing or https://ui.perfetto.dev
+ */
+class FAST_EXPORT Tracer {
+    public:
+        typedef std::chrono::steady_clock::time_point TimePoint;
+        static void enable();
+        static void disable();
+        static bool isEnabled() {
+            return m_enabled.load(std::memory_order_relaxed);
+        }
+        /**
+         * Record an event which happened on the calling thread
+         */
+        static void addEvent(std::string name, const char* category, TimePoint start, TimePoint end);
+        /**
+         * Record an event which happened on an OpenCL device, such as a kernel or a transfer.
+         * Device events are shown on a separate track.
+         * @param name
+         * @param category
+         * @param duration of the event in nanoseconds, as measured by the device
+         * @param end host time when the event was known to be finished
+         */
+        static void addDeviceEvent(std::string name, const char* category, uint64_t duration, TimePoint end);
+        /**
+         * Set the name shown for the calling thread in the trace
+         */
+        static void setThreadName(std::string name);
+        /**
+         * @return number of events recorded since the last call to clear
+         */
+        static std::size_t getNumberOfEvents();
+        /**
+         * Remove all recorded events. Events recorded while clearing may or may not be kept.
+         */
+        static void clear();
+        /**
+         * Write all recorded events to a file in the Chrome trace event (JSON) format
+         * @param filename
+         */
+        static void writeChromeTrace(std::string filename);
+    private:
+        static std::atomic<bool> m_enabled;
+};
+
+/**
+ * Records the lifetime of the object as an event on the calling thread, if tracing is enabled.
+ */
+class FAST_EXPORT TraceScope {
+    public:
+        TraceScope(const char* name, const char* category);
+        TraceScope(const std::string& name, const char* category);
+        ~TraceScope();
+        TraceScope(const TraceScope&) = delete;
+        TraceScope& operator=(const TraceScope&) = delete;
+    private:
+        bool m_enabled;
+        std::string m_name;
+        const char* m_category;
+        Tracer::TimePoint m_start;
+};
+
+}
@@ -33,8 +33,8 @@ double round(double n, int decimals) {
     return round(n*factor)/factor;
 }
 
-void* allocateDataArray(unsigned int voxels, DataType type, unsigned int nrOfComponents) {
-    unsigned int size = voxels*nrOfComponents;
+void* allocateDataArray(std::size_t voxels, DataType type, unsigned int nrOfComponents) {
+    std::size_t size = voxels*nrOfComponents;
     void * data;
     switch(type) {
         fastSwitchTypeMacro(data = new FAST_TYPE[size])
@@ -44,11 +44,11 @@ void* allocateDataArray(unsigned int voxels, DataType type, unsigned int nrOfCom
 }
 
 template <class T>
-inline void getMaxAndMinFromOpenCLImageResult(void* voidData, unsigned int size, unsigned int nrOfComponents, float* min, float* max) {
+inline void getMaxAndMinFromOpenCLImageResult(void* voidData, std::size_t size, unsigned int nrOfComponents, float* min, float* max) {
     T* data = (T*)voidData;
     *min = data[0];
     *max = data[1];
-    for(unsigned int i = nrOfComponents; i < size*nrOfComponents; i += nrOfComponents) {
+    for(std::size_t i = nrOfComponents; i < size*nrOfComponents; i += nrOfComponents) {
         if(data[i] < *min) {
             *min = data[i];
         }
@@ -350,7 +350,7 @@ void getMaxAndMinFromOpenCLImage(OpenCLDevice::pointer device, cl::Image3D image
 
 }
 
-void getMaxAndMinFromOpenCLBuffer(OpenCLDevice::pointer device, cl::Buffer buffer, unsigned int size, DataType type, float* min, float* max) {
+void getMaxAndMinFromOpenCLBuffer(OpenCLDevice::pointer device, cl::Buffer buffer, std::size_t size, DataType type, float* min, float* max) {
     // Compile OpenCL code
     std::string buildOptions = "";
     switch(type) {
@@ -379,20 +379,20 @@ void getMaxAndMinFromOpenCLBuffer(OpenCLDevice::pointer device, cl::Buffer buffe
     cl::CommandQueue queue = device->getCommandQueue();
 
     // Nr of work groups must be set so that work-group size does not exceed max work-group size (256 on AMD)
-    int length = size;
     cl::Kernel reduce(program, "reduce");
 
     cl::Buffer current = buffer;
     cl::Buffer clResult;
     int workGroupSize = 256;
     int workGroups = 256;
-    int X = ceil((float)length / (workGroups*workGroupSize));
+    // Number of elements each work-item reduces. The kernel uses 64 bit indexing, so buffers with more than 2^32 elements work.
+    const cl_ulong X = ((cl_ulong)size + workGroups*workGroupSize - 1) / (workGroups*workGroupSize);
 
     clResult = cl::Buffer(device->getContext(), CL_MEM_READ_WRITE, getSizeOfDataType(type,1)*workGroups*2);
     reduce.setArg(0, current);
     reduce.setArg(1, workGroupSize * getSizeOfDataType(type,1), NULL);
     reduce.setArg(2, workGroupSize * getSizeOfDataType(type,1), NULL);
-    reduce.setArg(3, size);
+    reduce.setArg(3, (cl_ulong)size);
     reduce.setArg(4, X);
     reduce.setArg(5, clResult);
 
@@ -403,10 +403,8 @@ void getMaxAndMinFromOpenCLBuffer(OpenCLDevice::pointer device, cl::Buffer buffe
             cl::NDRange(workGroupSize)
     );
 
-    length = workGroups;
-
-    void* result = allocateDataArray(length, type, 2);
-    unsigned int nrOfElements = length;
+    void* result = allocateDataArray(workGroups, type, 2);
+    std::size_t nrOfElements = workGroups;
     queue.enqueueReadBuffer(clResult,CL_TRUE,0,getSizeOfDataType(type,1)*workGroups*2,result);
     switch(type) {
     case TYPE_FLOAT:
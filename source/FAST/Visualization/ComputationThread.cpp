@@ -1,6 +1,7 @@
 #include "ComputationThread.hpp"
 #include "SimpleWindow.hpp"
 #include "View.hpp"
+#include <FAST/PipelineExecutor.hpp>
 #include <QGLContext>
 
 namespace fast {
@@ -37,6 +38,26 @@ void ComputationThread::run() {
     QGLContext* mainGLContext = Window::getMainGLContext();
     mainGLContext->makeCurrent();
 
+    PipelineExecutor::pointer executor;
+    if(Config::getExecutionMode() == EXECUTION_MODE_PARALLEL) {
+        // Let the executor run the process objects in worker threads,
+        // this thread will then only move the latest data to the renderers
+        executor = PipelineExecutor::New();
+        for(auto po : m_processObjects)
+            executor->addProcessObject(po);
+        for(View *view : mViews) {
+            for(auto renderer : view->getRenderers()) {
+                for(int i = 0; i < renderer->getNrOfInputConnections(); ++i)
+                    executor->addProcessObject(renderer->getInputPort(i)->getProcessObject());
+            }
+        }
+        try {
+            executor->start();
+        } catch(ThreadStopped &e) {
+            executor.reset();
+        }
+    }
+
     uint executeToken = 0;
     while(true) {
         {
@@ -45,10 +66,12 @@ void ComputationThread::run() {
                 break;
         }
         try {
-            for(auto po : m_processObjects)
-                po->update(executeToken);
-            for(View *view : mViews) {
-                view->updateRenderersInput(executeToken);
+            if(!executor) {
+                for(auto po : m_processObjects)
+                    po->update(executeToken);
+                for(View *view : mViews) {
+                    view->updateRenderersInput(executeToken);
+                }
             }
             for(View *view : mViews) {
                 view->updateRenderers();
@@ -58,6 +81,8 @@ void ComputationThread::run() {
         }
         ++executeToken;
     }
+    if(executor)
+        executor->stop();
 
     // Move GL context back to main thread
     mainGLContext->doneCurrent();
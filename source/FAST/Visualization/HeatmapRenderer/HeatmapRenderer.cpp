@@ -9,8 +9,8 @@ HeatmapRenderer::HeatmapRenderer() {
     createOpenCLProgram(Config::getKernelSourcePath() + "/Visualization/HeatmapRenderer/HeatmapRenderer.cl");
     createShaderProgram({
                                 Config::getKernelSourcePath() + "/Visualization/ImageRenderer/ImageRenderer.vert",
-                                Config::getKernelSourcePath() + "/Visualization/ImageRenderer/ImageRenderer.frag",
-                        });
+                                Config::getKernelSourcePath() + "/Visualization/HeatmapRenderer/HeatmapRenderer.frag",
+                        }, "heatmap");
     mIsModified = false;
     mColorsModified = true;
 }
@@ -50,9 +50,10 @@ void HeatmapRenderer::draw(Matrix4f perspectiveMatrix, Matrix4f viewingMatrix, f
         maxChannels = std::max(nrOfChannels, maxChannels);
     }
 
-    if(mColorsModified && maxChannels > 0) {
+    if((mColorsModified || (int)mColorData.size() < 4*maxChannels) && maxChannels > 0) {
         // Transfer colors to device (this doesn't have to happen every render call..)
-        auto colorData = make_uninitialized_unique<float[]>(4*maxChannels);
+        mColorData.resize(4*maxChannels);
+        auto& colorData = mColorData;
         Color defaultColor = Color::Green();
         for(int i = 0; i < maxChannels; ++i) {
             if(mColors.count(i) > 0) {
@@ -83,7 +84,7 @@ void HeatmapRenderer::draw(Matrix4f perspectiveMatrix, Matrix4f viewingMatrix, f
                 device->getContext(),
                 CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
                 sizeof(float)*4*maxChannels,
-                colorData.get()
+                colorData.data()
         );
 		mColorsModified = false;
     }
@@ -102,6 +103,19 @@ void HeatmapRenderer::draw(Matrix4f perspectiveMatrix, Matrix4f viewingMatrix, f
 
         const int width = input->getShape()[1];
         const int height = input->getShape()[0];
+        const int channels = input->getShape()[2];
+
+        // Without CL-GL interop, upload tensors with up to 4 channels as float textures and create colors in the shader
+        mNativeTexture[inputNr] = !DeviceManager::isGLInteropEnabled() && channels <= 4;
+        if(mNativeTexture[inputNr]) {
+            const int internalFormats[] = {GL_R32F, GL_RG32F, GL_RGB32F, GL_RGBA32F};
+            const uint formats[] = {GL_RED, GL_RG, GL_RGB, GL_RGBA};
+            auto access = input->getAccess(ACCESS_READ);
+            uploadTexture(inputNr, access->getRawData(), width, height, internalFormats[channels - 1], formats[channels - 1], GL_FLOAT, sizeof(float)*channels, GL_NEAREST);
+            mTensorUsed[inputNr] = input;
+            mDataTimestamp[inputNr] = input->getTimestamp();
+            continue;
+        }
 
         // Run kernel to fill the texture
 
@@ -113,6 +127,11 @@ void HeatmapRenderer::draw(Matrix4f perspectiveMatrix, Matrix4f viewingMatrix, f
             mTexturesToRender.erase(inputNr);
             glDeleteVertexArrays(1, &mVAO[inputNr]);
             mVAO.erase(inputNr);
+            // The texture is recreated, and can't be reused for uploads
+            if(mPixelBuffers.count(inputNr) > 0) {
+                glDeleteBuffers(2, mPixelBuffers[inputNr].buffers);
+                mPixelBuffers.erase(inputNr);
+            }
         }
 
         cl::Image2D image;
@@ -262,10 +281,10 @@ void HeatmapRenderer::drawTextures(Matrix4f &perspectiveMatrix, Matrix4f &viewin
 
     }
 
-    activateShader();
-
     // This is the actual rendering
     for(auto& it : mTensorUsed) {
+        const std::string shaderProgram = mNativeTexture[it.first] ? "heatmap" : "default";
+        activateShader(shaderProgram);
         AffineTransformation::pointer transform;
         if(mode2D) {
             // If rendering is in 2D mode we skip any transformations
@@ -277,12 +296,23 @@ void HeatmapRenderer::drawTextures(Matrix4f &perspectiveMatrix, Matrix4f &viewin
         Vector3f spacing = it.second->getSpacing();
         transform->getTransform().scale(spacing);
 
-        uint transformLoc = glGetUniformLocation(getShaderProgram(), "transform");
+        uint transformLoc = glGetUniformLocation(getShaderProgram(shaderProgram), "transform");
         glUniformMatrix4fv(transformLoc, 1, GL_FALSE, transform->getTransform().data());
-        transformLoc = glGetUniformLocation(getShaderProgram(), "perspectiveTransform");
+        transformLoc = glGetUniformLocation(getShaderProgram(shaderProgram), "perspectiveTransform");
         glUniformMatrix4fv(transformLoc, 1, GL_FALSE, perspectiveMatrix.data());
-        transformLoc = glGetUniformLocation(getShaderProgram(), "viewTransform");
+        transformLoc = glGetUniformLocation(getShaderProgram(shaderProgram), "viewTransform");
         glUniformMatrix4fv(transformLoc, 1, GL_FALSE, viewingMatrix.data());
+        if(mNativeTexture[it.first]) {
+            const int channels = it.second->getShape()[2];
+            glUniform4fv(getShaderUniformLocation("colors", shaderProgram), channels, mColorData.data());
+            setShaderUniform("channels", channels, shaderProgram);
+            setShaderUniform("minConfidence", mMinConfidence, shaderProgram);
+            setShaderUniform("maxOpacity", mMaxOpacity, shaderProgram);
+            setShaderUniform("useInterpolation", mUseInterpolation, shaderProgram);
+        } else {
+            // Texture is already colored by the kernel
+            setShaderUniform("useWindow", false);
+        }
 
         glBindTexture(GL_TEXTURE_2D, mTexturesToRender[it.first]);
         glBindVertexArray(mVAO[it.first]);
@@ -0,0 +1,66 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoord;
+
+// Tensor with up to 4 channels
+uniform sampler2D tensor;
+uniform vec4 colors[4];
+uniform int channels;
+uniform float minConfidence;
+uniform float maxOpacity;
+uniform bool useInterpolation;
+
+vec4 getColor(ivec2 position, ivec2 size) {
+    vec4 intensities = texelFetch(tensor, position, 0);
+    vec4 color = vec4(0.0);
+    for(int channel = 0; channel < channels; ++channel) {
+        float intensity = clamp(intensities[channel], 0.0, 1.0);
+
+        if(intensity >= minConfidence)
+            color += colors[channel]*intensity;
+    }
+    color = clamp(color, 0.0, 1.0);
+    if(color.a == 0.0) { // none with intensity >= minConfidence or 0 found
+        color = vec4(0.0);
+        // Look for neighbors instead
+        float highestConfidence = minConfidence;
+        for(int a = -1; a <= 1; ++a) {
+            for(int b = -1; b <= 1; ++b) {
+                ivec2 neighbor = position + ivec2(a, b);
+                // Out of bounds check:
+                if(any(lessThan(neighbor, ivec2(0))) || any(greaterThanEqual(neighbor, size)))
+                    continue;
+                vec4 neighborIntensities = texelFetch(tensor, neighbor, 0);
+                for(int channel = 0; channel < channels; ++channel) {
+                    if(neighborIntensities[channel] >= highestConfidence) {
+                        color = colors[channel];
+                        color.a = 0.0; // Set opacity to zero
+                        highestConfidence = neighborIntensities[channel];
+                    }
+                }
+            }
+        }
+    } else {
+        color.a *= maxOpacity;
+    }
+    return color;
+}
+
+void main()
+{
+    ivec2 size = textureSize(tensor, 0);
+    if(!useInterpolation) {
+        FragColor = getColor(clamp(ivec2(TexCoord*vec2(size)), ivec2(0), size - 1), size);
+        return;
+    }
+    // Interpolate the colors of the four nearest pixels, as linear filtering of a color texture would do
+    vec2 position = TexCoord*vec2(size) - 0.5;
+    ivec2 base = ivec2(floor(position));
+    vec2 fraction = position - floor(position);
+    vec4 color00 = getColor(clamp(base, ivec2(0), size - 1), size);
+    vec4 color10 = getColor(clamp(base + ivec2(1, 0), ivec2(0), size - 1), size);
+    vec4 color01 = getColor(clamp(base + ivec2(0, 1), ivec2(0), size - 1), size);
+    vec4 color11 = getColor(clamp(base + ivec2(1, 1), ivec2(0), size - 1), size);
+    FragColor = mix(mix(color00, color10, fraction.x), mix(color01, color11, fraction.x), fraction.y);
+}
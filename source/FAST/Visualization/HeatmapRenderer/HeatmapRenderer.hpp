@@ -23,10 +23,13 @@ class FAST_EXPORT HeatmapRenderer : public ImageRenderer {
         std::unordered_map<uint, Color> mColors;
         std::unordered_map<uint, bool> mHide;
         std::unordered_map<uint, SharedPointer<Tensor>> mTensorUsed;
+        // Whether the texture of an input is the tensor itself, instead of colors created by the kernel
+        std::unordered_map<uint, bool> mNativeTexture;
 
         float mMaxOpacity = 0.6;
         float mMinConfidence = 0.0f;
         cl::Buffer mColorBuffer;
+        std::vector<float> mColorData;
         bool mColorsModified;
         bool mUseInterpolation = true;
 };
@@ -3,6 +3,7 @@
 #include "FAST/DeviceManager.hpp"
 #include "FAST/Utility.hpp"
 #include "FAST/SceneGraph.hpp"
+#include <cstring>
 #if defined(__APPLE__) || defined(__MACOSX)
 #include <OpenCL/cl_gl.h>
 #include <OpenGL/gl.h>
@@ -24,8 +25,6 @@ namespace fast {
 
 ImageRenderer::ImageRenderer() : Renderer() {
     createInputPort<Image>(0, false);
-    createOpenCLProgram(Config::getKernelSourcePath() + "/Visualization/ImageRenderer/ImageRenderer.cl", "3D");
-    createOpenCLProgram(Config::getKernelSourcePath() + "/Visualization/ImageRenderer/ImageRenderer2D.cl", "2D");
     mIsModified = true;
     mWindow = -1;
     mLevel = -1;
@@ -59,6 +58,10 @@ void ImageRenderer::deleteAllTextures() {
         glDeleteTextures(1, &texture.second);
     }
     mTexturesToRender.clear();
+    for(auto& pixelBuffers : mPixelBuffers) {
+        glDeleteBuffers(2, pixelBuffers.second.buffers);
+    }
+    mPixelBuffers.clear();
 }
 
 void ImageRenderer::setIntensityLevel(float level) {
@@ -84,6 +87,48 @@ void ImageRenderer::loadAttributes() {
     mLevel = (getFloatAttribute("level"));
 }
 
+struct TextureFormat {
+    int internalFormat;
+    uint format;
+    uint type;
+    // Multiply normalized texture values with this to get the original intensities
+    float scale;
+};
+
+/**
+ * OpenGL texture format which stores an image in its native data type
+ */
+static TextureFormat getTextureFormat(DataType type, int channels) {
+    const uint formats[] = {GL_RED, GL_RG, GL_RGB, GL_RGBA};
+    const uint format = formats[channels - 1];
+    switch(type) {
+        case TYPE_UINT8: {
+            const int internalFormats[] = {GL_R8, GL_RG8, GL_RGB8, GL_RGBA8};
+            return {internalFormats[channels - 1], format, GL_UNSIGNED_BYTE, 255.0f};
+        }
+        case TYPE_INT8: {
+            const int internalFormats[] = {GL_R8_SNORM, GL_RG8_SNORM, GL_RGB8_SNORM, GL_RGBA8_SNORM};
+            return {internalFormats[channels - 1], format, GL_BYTE, 127.0f};
+        }
+        case TYPE_UINT16:
+        case TYPE_UNORM_INT16: {
+            const int internalFormats[] = {GL_R16, GL_RG16, GL_RGB16, GL_RGBA16};
+            // Normalized integer images are read as normalized values in OpenCL as well
+            return {internalFormats[channels - 1], format, GL_UNSIGNED_SHORT, type == TYPE_UINT16 ? 65535.0f : 1.0f};
+        }
+        case TYPE_INT16:
+        case TYPE_SNORM_INT16: {
+            const int internalFormats[] = {GL_R16_SNORM, GL_RG16_SNORM, GL_RGB16_SNORM, GL_RGBA16_SNORM};
+            return {internalFormats[channels - 1], format, GL_SHORT, type == TYPE_INT16 ? 32767.0f : 1.0f};
+        }
+        case TYPE_FLOAT: {
+            const int internalFormats[] = {GL_R32F, GL_RG32F, GL_RGB32F, GL_RGBA32F};
+            return {internalFormats[channels - 1], format, GL_FLOAT, 1.0f};
+        }
+    }
+    throw Exception("Unsupported data type in ImageRenderer");
+}
+
 void ImageRenderer::draw(Matrix4f perspectiveMatrix, Matrix4f viewingMatrix, float zNear, float zFar, bool mode2D) {
     std::lock_guard<std::mutex> lock(mMutex);
 
@@ -98,127 +143,88 @@ void ImageRenderer::draw(Matrix4f perspectiveMatrix, Matrix4f viewingMatrix, flo
         if (mTexturesToRender.count(inputNr) > 0 && mImageUsed[inputNr] == input && mDataTimestamp[inputNr] == input->getTimestamp())
             continue; // If it has already been created, skip it
 
-        // If it has not been created, create the texture
+        // Upload the image in its native format, the intensity level and window are applied in the shader
+        const TextureFormat format = getTextureFormat(input->getDataType(), input->getNrOfChannels());
+        ImageAccess::pointer access = input->getImageAccess(ACCESS_READ);
+        uploadTexture(inputNr, access->get(), input->getWidth(), input->getHeight(), format.internalFormat,
+                      format.format, format.type, getSizeOfDataType(input->getDataType(), input->getNrOfChannels()), GL_LINEAR);
 
-        // Determine level and window
-        float window = mWindow;
-        float level = mLevel;
-        // If mWindow/mLevel is equal to -1 use default level/window values
-        if (window == -1) {
-            window = getDefaultIntensityWindow(input->getDataType());
-        }
-        if (level == -1) {
-            level = getDefaultIntensityLevel(input->getDataType());
-        }
+        mImageUsed[inputNr] = input;
+        mDataTimestamp[inputNr] = input->getTimestamp();
+    }
 
-        OpenCLDevice::pointer device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
-
-        OpenCLImageAccess::pointer access = input->getOpenCLImageAccess(ACCESS_READ, device);
-        cl::Image2D *clImage = access->get2DImage();
-
-        mKernel = cl::Kernel(getOpenCLProgram(device, "3D"), "renderToTexture");
-        // Run kernel to fill the texture
-        cl::CommandQueue queue = device->getCommandQueue();
-
-        if(mTexturesToRender.count(inputNr) > 0) {
-            // If texture has correct size, we don't need to make a new one
-            int w, h;
-            glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &w);
-            glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &h);
-            //if(w != input->getWidth() && h != input->getHeight()) {
-                // Delete old texture
-                glDeleteTextures(1, &mTexturesToRender[inputNr]);
-                mTexturesToRender.erase(inputNr);
-                glDeleteVertexArrays(1, &mVAO[inputNr]);
-                mVAO.erase(inputNr);
-            //}
-        }
+    drawTextures(perspectiveMatrix, viewingMatrix, mode2D);
+
+}
 
-        cl::Image2D image;
-        cl::ImageGL imageGL;
-        std::vector<cl::Memory> v;
+void ImageRenderer::uploadTexture(uint inputNr, const void* data, int width, int height, int internalFormat, uint format, uint type, std::size_t bytesPerPixel, int filter) {
+    PixelBuffers& pixelBuffers = mPixelBuffers[inputNr];
+    const std::size_t rowSize = width*bytesPerPixel;
+    const std::size_t size = rowSize*height;
+    if(mTexturesToRender.count(inputNr) == 0 || pixelBuffers.width != width || pixelBuffers.height != height || pixelBuffers.internalFormat != internalFormat) {
+        // Create texture and pixel buffers
+        if(mTexturesToRender.count(inputNr) > 0)
+            glDeleteTextures(1, &mTexturesToRender[inputNr]);
         GLuint textureID;
-        if(DeviceManager::isGLInteropEnabled() && false) {
-            // Create OpenGL texture
-            glGenTextures(1, &textureID);
-            glBindTexture(GL_TEXTURE_2D, textureID);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            // TODO Why is this needed:
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, input->getWidth(), input->getHeight(), 0, GL_RGBA, GL_FLOAT, nullptr);
-
-            // Create CL-GL image
-            imageGL = cl::ImageGL(
-                    device->getContext(),
-                    CL_MEM_READ_WRITE,
-                    GL_TEXTURE_2D,
-                    0,
-                    textureID
-            );
-            glBindTexture(GL_TEXTURE_2D, 0);
-            glFinish();     // Make sure everything is ready for CL to take over the texture
-            v.push_back(imageGL);
-            queue.enqueueAcquireGLObjects(&v);
-            mKernel.setArg(1, imageGL);
-        } else {
-            image = cl::Image2D(
-                    device->getContext(),
-                    CL_MEM_READ_WRITE,
-                    cl::ImageFormat(CL_RGBA, CL_FLOAT),
-                    input->getWidth(), input->getHeight()
-            );
-            mKernel.setArg(1, image);
-        }
+        glGenTextures(1, &textureID);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, nullptr);
+        mTexturesToRender[inputNr] = textureID;
 
-        mKernel.setArg(0, *clImage);
-        mKernel.setArg(2, level);
-        mKernel.setArg(3, window);
-        queue.enqueueNDRangeKernel(
-                mKernel,
-                cl::NullRange,
-                cl::NDRange(input->getWidth(), input->getHeight()),
-                cl::NullRange
-        );
-
-        if(DeviceManager::isGLInteropEnabled() && false) {
-            queue.enqueueReleaseGLObjects(&v);
-            queue.finish(); // This is needed, otherwise seg fault can occur when doing GL stuff with this texture
-        } else {
-            // Copy data from CL image to CPU
-            auto data = make_uninitialized_unique<float[]>(input->getWidth() * input->getHeight() * 4);
-            queue.finish();
-            queue.enqueueReadImage(
-                    image,
-                    CL_TRUE,
-                    createOrigoRegion(),
-                    createRegion(input->getWidth(), input->getHeight(), 1),
-                    0, 0,
-                    data.get()
-            );
-            // Copy data from CPU to GL texture
-            glGenTextures(1, &textureID);
-            glBindTexture(GL_TEXTURE_2D, textureID);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            // TODO Why is this needed:
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, input->getWidth(), input->getHeight(), 0, GL_RGBA, GL_FLOAT, data.get());
-            glBindTexture(GL_TEXTURE_2D, 0);
-            glFinish();
+        if(pixelBuffers.buffers[0] == 0)
+            glGenBuffers(2, pixelBuffers.buffers);
+        for(uint buffer : pixelBuffers.buffers) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
         }
+        pixelBuffers.width = width;
+        pixelBuffers.height = height;
+        pixelBuffers.internalFormat = internalFormat;
+    }
 
-        mTexturesToRender[inputNr] = textureID;
-        mImageUsed[inputNr] = input;
-        mDataTimestamp[inputNr] = input->getTimestamp();
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffers.buffers[pixelBuffers.next]);
+    pixelBuffers.next = 1 - pixelBuffers.next;
+    auto destination = (uchar*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if(destination == nullptr) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        throw Exception("Unable to map pixel buffer object in ImageRenderer");
     }
+    auto source = (const uchar*)data;
+    for(int y = 0; y < height; ++y)
+        std::memcpy(&destination[(height - y - 1)*rowSize], &source[y*rowSize], rowSize);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    // Transfer from the bound pixel buffer to the texture
+    glBindTexture(GL_TEXTURE_2D, mTexturesToRender[inputNr]);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, type, nullptr);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
 
-    drawTextures(perspectiveMatrix, viewingMatrix, mode2D);
+void ImageRenderer::setTextureUniforms(uint inputNr) {
+    Image::pointer input = mImageUsed[inputNr];
 
+    // Determine level and window
+    float window = mWindow;
+    float level = mLevel;
+    // If mWindow/mLevel is equal to -1 use default level/window values
+    if (window == -1) {
+        window = getDefaultIntensityWindow(input->getDataType());
+    }
+    if (level == -1) {
+        level = getDefaultIntensityLevel(input->getDataType());
+    }
+    setShaderUniform("useWindow", true);
+    setShaderUniform("window", window);
+    setShaderUniform("level", level);
+    setShaderUniform("scale", getTextureFormat(input->getDataType(), input->getNrOfChannels()).scale);
+    setShaderUniform("channels", (int)input->getNrOfChannels());
 }
 
 void ImageRenderer::drawTextures(Matrix4f &perspectiveMatrix, Matrix4f &viewingMatrix, bool mode2D) {
@@ -296,6 +302,7 @@ void ImageRenderer::drawTextures(Matrix4f &perspectiveMatrix, Matrix4f &viewingM
         glUniformMatrix4fv(transformLoc, 1, GL_FALSE, perspectiveMatrix.data());
         transformLoc = glGetUniformLocation(getShaderProgram(), "viewTransform");
         glUniformMatrix4fv(transformLoc, 1, GL_FALSE, viewingMatrix.data());
+        setTextureUniforms(it.first);
 
         glBindTexture(GL_TEXTURE_2D, mTexturesToRender[it.first]);
         glBindVertexArray(mVAO[it.first]);
@@ -4,8 +4,22 @@ out vec4 FragColor;
 in vec2 TexCoord;
 
 uniform sampler2D ourTexture;
+// Apply intensity window and level to a texture in the native format of the image
+uniform bool useWindow;
+uniform float window;
+uniform float level;
+uniform float scale;
+uniform int channels;
 
 void main()
 {
-    FragColor = texture(ourTexture, TexCoord);
-}
\ No newline at end of file
+    vec4 value = texture(ourTexture, TexCoord);
+    if(useWindow) {
+        value = value*scale;
+        if(channels == 1)
+            value.gb = value.rr;
+        value = clamp((value - level + window/2.0) / window, 0.0, 1.0);
+        value.a = 1.0;
+    }
+    FragColor = value;
+}
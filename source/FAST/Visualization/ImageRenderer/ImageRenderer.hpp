@@ -18,6 +18,18 @@ class FAST_EXPORT  ImageRenderer : public Renderer {
         ImageRenderer();
         void draw(Matrix4f perspectiveMatrix, Matrix4f viewingMatrix, float zNear, float zFar, bool mode2D);
         void deleteAllTextures();
+        /**
+         * Upload 2D pixel data to the texture of an input in the given OpenGL format. The data is copied to one of
+         * two pixel buffer objects used every other time, so that the transfer to the texture is asynchronous
+         * and does not wait for the previous upload. The texture is reused as long as size and format don't change.
+         * Rows are flipped while copying to match the texture coordinates used in drawTextures.
+         */
+        void uploadTexture(uint inputNr, const void* data, int width, int height, int internalFormat, uint format, uint type, std::size_t bytesPerPixel, int filter);
+        /**
+         * Set uniforms of the active shader program for drawing the texture of an input. Called by drawTextures.
+         * @param inputNr
+         */
+        virtual void setTextureUniforms(uint inputNr);
 
 
         std::unordered_map<uint, uint> mTexturesToRender;
@@ -29,8 +41,14 @@ class FAST_EXPORT  ImageRenderer : public Renderer {
         std::unordered_map<uint, uint> mVAO;
         std::unordered_map<uint, uint> mVBO;
         std::unordered_map<uint, uint> mEBO;
-
-        cl::Kernel mKernel;
+        struct PixelBuffers {
+            uint buffers[2] = {0, 0};
+            int next = 0;
+            int width = 0;
+            int height = 0;
+            int internalFormat = 0;
+        };
+        std::unordered_map<uint, PixelBuffers> mPixelBuffers;
 
         // Level and window intensities
         float mWindow;
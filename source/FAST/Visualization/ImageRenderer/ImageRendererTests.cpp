@@ -59,3 +59,27 @@ TEST_CASE("ImageRenderer with dynamic 2D image in 3D mode", "[fast][ImageRendere
 
     CHECK_NOTHROW(window->start());
 }
+
+TEST_CASE("ImageRenderer with 16 bit and float images in 2D mode", "[fast][ImageRenderer][visual]") {
+    std::vector<ushort> data(256*256);
+    for(int i = 0; i < 256*256; ++i)
+        data[i] = (i % 256)*(i / 256);
+    auto image16 = Image::New();
+    image16->create(256, 256, TYPE_UINT16, 1, data.data());
+    auto imageFloat = Image::New();
+    std::vector<float> floatData(data.begin(), data.end());
+    imageFloat->create(256, 256, TYPE_FLOAT, 1, floatData.data());
+
+    for(auto image : {image16, imageFloat}) {
+        auto renderer = ImageRenderer::New();
+        renderer->setInputData(image);
+        renderer->setIntensityLevel(32768);
+        renderer->setIntensityWindow(65536);
+        auto window = SimpleWindow::New();
+        window->addRenderer(renderer);
+        window->set2DMode();
+        window->setTimeout(500);
+
+        CHECK_NOTHROW(window->start());
+    }
+}
@@ -0,0 +1,293 @@
+#include "RenderToImage.hpp"
+#include "FAST/Visualization/Window.hpp"
+#include "FAST/Visualization/VolumeRenderer/VolumeRenderer.hpp"
+#include "FAST/Data/Image.hpp"
+#include <QOpenGLContext>
+#include <QOffscreenSurface>
+#include <QThread>
+#include <cstring>
+
+namespace fast {
+
+RenderToImage::RenderToImage() {
+    createOutputPort<Image>(0);
+
+    // Use the main GL context, as the renderers create their shaders and textures in it
+    m_context = Window::getMainGLContext()->contextHandle();
+    m_surface = new QOffscreenSurface;
+    m_surface->setFormat(m_context->format());
+    m_surface->create();
+    makeContextCurrent();
+    initializeOpenGLFunctions();
+}
+
+RenderToImage::~RenderToImage() {
+    if(m_FBO != 0) {
+        makeContextCurrent();
+        glDeleteFramebuffers(1, &m_FBO);
+        glDeleteTextures(1, &m_textureColor);
+        glDeleteTextures(1, &m_textureDepth);
+    }
+    delete m_surface;
+}
+
+void RenderToImage::makeContextCurrent() {
+    if(QOpenGLContext::currentContext() == m_context)
+        return;
+    if(m_context->thread() != QThread::currentThread())
+        throw Exception("RenderToImage must be updated in the thread of the main GL context");
+    if(!m_context->makeCurrent(m_surface))
+        throw Exception("Unable to make GL context current in RenderToImage");
+}
+
+void RenderToImage::addRenderer(Renderer::pointer renderer) {
+    makeContextCurrent();
+    // Renderers are updated in execute, thus they should not wait for this object to render
+    renderer->setSynchronizedRendering(false);
+    renderer->initializeOpenGLFunctions();
+    m_renderers.push_back(renderer);
+    m_cameraIsSet = false;
+    mIsModified = true;
+}
+
+void RenderToImage::removeAllRenderers() {
+    m_renderers.clear();
+    m_cameraIsSet = false;
+    mIsModified = true;
+}
+
+std::vector<Renderer::pointer> RenderToImage::getRenderers() const {
+    return m_renderers;
+}
+
+void RenderToImage::setSize(uint width, uint height) {
+    if(width == 0 || height == 0)
+        throw Exception("Size of RenderToImage must be larger than 0");
+    m_width = width;
+    m_height = height;
+    m_cameraIsSet = false;
+    mIsModified = true;
+}
+
+void RenderToImage::set2DMode() {
+    m_2DMode = true;
+    m_cameraIsSet = false;
+    mIsModified = true;
+}
+
+void RenderToImage::set3DMode() {
+    m_2DMode = false;
+    m_cameraIsSet = false;
+    mIsModified = true;
+}
+
+void RenderToImage::setBackgroundColor(Color color) {
+    m_backgroundColor = color;
+    mIsModified = true;
+}
+
+void RenderToImage::setBenchmarkMode(bool benchmark) {
+    m_benchmark = benchmark;
+    if(benchmark)
+        enableRuntimeMeasurements();
+    mIsModified = true;
+}
+
+void RenderToImage::createFramebuffer() {
+    if(m_FBO != 0 && m_framebufferWidth == m_width && m_framebufferHeight == m_height)
+        return;
+
+    // Textures are used as attachments, since the volume renderers read the color and depth of the framebuffer
+    if(m_FBO == 0) {
+        glGenFramebuffers(1, &m_FBO);
+        glGenTextures(1, &m_textureColor);
+        glGenTextures(1, &m_textureDepth);
+    }
+    glBindTexture(GL_TEXTURE_2D, m_textureColor);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_width, m_height, 0, GL_RGBA, GL_FLOAT, NULL);
+    glBindTexture(GL_TEXTURE_2D, m_textureDepth);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32, m_width, m_height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_FBO);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_textureColor, 0);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_textureDepth, 0);
+    if(glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        throw Exception("Framebuffer of RenderToImage is incomplete");
+
+    m_framebufferWidth = m_width;
+    m_framebufferHeight = m_height;
+}
+
+void RenderToImage::recalculateCamera() {
+    // Get bounding box of all renderers
+    Vector3f min, max;
+    bool initialized = false;
+    for(auto&& renderer : m_renderers) {
+        try {
+            MatrixXf corners = renderer->getBoundingBox(!m_2DMode).getCorners();
+            for(int j = 0; j < 8; j++) {
+                for(uint k = 0; k < 3; k++) {
+                    if(!initialized || corners(j, k) < min[k])
+                        min[k] = corners(j, k);
+                    if(!initialized || corners(j, k) > max[k])
+                        max[k] = corners(j, k);
+                }
+                initialized = true;
+            }
+        } catch(Exception& e) {
+            // Renderer has no data yet
+        }
+    }
+    if(!initialized)
+        return;
+
+    // Look at the largest side of the bounding box, as in View
+    float area[3] = {(max[0] - min[0]) * (max[1] - min[1]), // XY plane
+                     (max[1] - min[1]) * (max[2] - min[2]), // YZ plane
+                     (max[2] - min[2]) * (max[0] - min[0])};
+    uint maxArea = 0;
+    for(uint i = 1; i < 3; i++) {
+        if(area[i] > area[maxArea])
+            maxArea = i;
+    }
+    const uint directions[3][3] = {{0, 1, 2}, {2, 1, 0}, {0, 2, 1}};
+    const uint xDirection = directions[maxArea][0];
+    const uint yDirection = directions[maxArea][1];
+    const uint zDirection = directions[maxArea][2];
+    const float angleX = maxArea == 2 ? 90.0f : 0.0f;
+    const float angleY = maxArea == 1 ? 90.0f : 0.0f;
+    const Vector3f centroid = max - (max - min) * 0.5f;
+    const float aspect = (float)m_width / m_height;
+
+    m_viewingTransformation = Affine3f::Identity();
+    if(m_2DMode) {
+        const float width = max[xDirection] - min[xDirection];
+        const float height = max[yDirection] - min[yDirection];
+        const float orthoAspect = width / height;
+        float scalingWidth = 1;
+        float scalingHeight = 1;
+        if(aspect > orthoAspect) {
+            scalingWidth = aspect / orthoAspect;
+        } else {
+            scalingHeight = orthoAspect / aspect;
+        }
+        const float left = min[xDirection] * scalingWidth;
+        const float right = max[xDirection] * scalingWidth;
+        const float bottom = min[yDirection] * scalingHeight;
+        const float top = max[yDirection] * scalingHeight;
+        m_zNear = -1;
+        m_zFar = 1;
+
+        Vector3f cameraPosition;
+        cameraPosition[0] = left + (right - left) * 0.5f - centroid[0]; // center camera
+        cameraPosition[1] = bottom + (top - bottom) * 0.5f - centroid[1];
+        cameraPosition[1] -= 2.0f * (bottom + (top - bottom) * 0.5f); // Compensate for Y flipping
+        cameraPosition[2] = 0;
+        m_viewingTransformation.scale(Vector3f(1, -1, 1)); // Flip y
+        m_viewingTransformation.translate(cameraPosition);
+        m_perspectiveMatrix = loadOrthographicMatrix(left, right, bottom, top, m_zNear, m_zFar);
+    } else {
+        const float fieldOfViewY = 45;
+        const float fieldOfViewX = aspect * fieldOfViewY;
+        // Move objects away from camera so that we see everything
+        const float zWidth = (max[xDirection] - min[xDirection]) * 0.5 / tan(fieldOfViewX * 0.5);
+        const float zHeight = (max[yDirection] - min[yDirection]) * 0.5 / tan(fieldOfViewY * 0.5);
+        const float minimumTranslationToSeeEntireObject = std::max(zWidth, zHeight);
+        const float boundingBoxDepth = max[zDirection] - min[zDirection];
+        Vector3f cameraPosition = -centroid;
+        cameraPosition[2] += -minimumTranslationToSeeEntireObject - boundingBoxDepth * 0.5f;
+        m_zFar = (minimumTranslationToSeeEntireObject + boundingBoxDepth) * 2;
+        m_zNear = std::min(minimumTranslationToSeeEntireObject * 0.5f, 0.1f);
+
+        Eigen::Quaternionf Q = Eigen::AngleAxisf(angleX * M_PI / 180.0f, Vector3f::UnitX()) *
+                Eigen::AngleAxisf(angleY * M_PI / 180.0f, Vector3f::UnitY());
+        m_viewingTransformation.pretranslate(-centroid); // Move to rotation point
+        m_viewingTransformation.prerotate(Q.toRotationMatrix()); // Rotate
+        m_viewingTransformation.pretranslate(centroid); // Move back from rotation point
+        m_viewingTransformation.pretranslate(cameraPosition);
+        m_perspectiveMatrix = loadPerspectiveMatrix(fieldOfViewY, aspect, m_zNear, m_zFar);
+    }
+    m_cameraIsSet = true;
+}
+
+void RenderToImage::execute() {
+    if(m_renderers.empty())
+        throw Exception("No renderers given to RenderToImage");
+
+    makeContextCurrent();
+
+    // Update the input of each renderer, and let the renderers get the latest data
+    for(auto&& renderer : m_renderers) {
+        for(int i = 0; i < renderer->getNrOfInputConnections(); ++i)
+            renderer->getInputPort(i)->getProcessObject()->update(m_executeToken);
+        renderer->execute();
+        for(auto&& lastFrame : renderer->m_lastFrame)
+            m_lastFrame.insert(lastFrame);
+    }
+    ++m_executeToken;
+
+    mRuntimeManager->startRegularTimer("render");
+    createFramebuffer();
+    if(!m_cameraIsSet)
+        recalculateCamera();
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_FBO);
+    glViewport(0, 0, m_width, m_height);
+    glEnable(GL_BLEND);
+    if(m_2DMode) {
+        glDisable(GL_DEPTH_TEST);
+    } else {
+        glEnable(GL_DEPTH_TEST);
+    }
+    glClearColor(m_backgroundColor.getRedValue(), m_backgroundColor.getGreenValue(), m_backgroundColor.getBlueValue(), 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // Draw volume renderers last, as they blend with the color and depth of what has been drawn
+    std::vector<Renderer::pointer> renderers;
+    std::vector<Renderer::pointer> volumeRenderers;
+    for(auto&& renderer : m_renderers) {
+        if(renderer->isDisabled())
+            continue;
+        if(std::dynamic_pointer_cast<VolumeRenderer>(renderer)) {
+            volumeRenderers.push_back(renderer);
+        } else {
+            renderers.push_back(renderer);
+        }
+    }
+    renderers.insert(renderers.end(), volumeRenderers.begin(), volumeRenderers.end());
+    for(int i = 0; i < renderers.size(); ++i) {
+        auto renderer = renderers[i];
+        const std::string timerName = "draw " + renderer->getNameOfClass() + " " + std::to_string(i);
+        if(m_benchmark)
+            mRuntimeManager->startRegularTimer(timerName);
+        renderer->draw(m_perspectiveMatrix, m_viewingTransformation.matrix(), m_zNear, m_zFar, m_2DMode);
+        renderer->postDraw();
+        if(m_benchmark) {
+            // Wait for the GPU to finish drawing, to measure the actual draw time
+            glFinish();
+            mRuntimeManager->stopRegularTimer(timerName);
+        }
+    }
+
+    // Read back the frame, flipping it since OpenGL has its origin in the lower left corner
+    m_pixels.resize((std::size_t)m_width*m_height*3);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_FBO);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, m_width, m_height, GL_RGB, GL_UNSIGNED_BYTE, m_pixels.data());
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    const std::size_t rowSize = (std::size_t)m_width*3;
+    auto data = make_uninitialized_unique<uchar[]>(rowSize*m_height);
+    for(uint y = 0; y < m_height; ++y)
+        std::memcpy(&data[y*rowSize], &m_pixels[(m_height - y - 1)*rowSize], rowSize);
+    auto image = Image::New();
+    image->create(m_width, m_height, TYPE_UINT8, 3, std::move(data));
+    mRuntimeManager->stopRegularTimer("render");
+
+    addOutputData(0, image);
+    // Render a new frame on every update
+    mIsModified = true;
+}
+
+}
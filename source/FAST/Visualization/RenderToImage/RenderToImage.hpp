@@ -0,0 +1,78 @@
+#pragma once
+
+#include "FAST/ProcessObject.hpp"
+#include "FAST/Data/Color.hpp"
+#include "FAST/Visualization/Renderer.hpp"
+#include <QOpenGLFunctions_3_3_Core>
+
+class QOpenGLContext;
+class QOffscreenSurface;
+
+namespace fast {
+
+/**
+ * Renders a set of renderers to an offscreen framebuffer, and outputs each frame as an RGB image of TYPE_UINT8.
+ *
+ * This makes it possible to render without a window and event loop, e.g. on servers without a display when
+ * Window::enableHeadlessRendering is used. Each update renders one frame with the latest data of the renderers, and
+ * the output image can be sent to exporters such as StreamToFileExporter.
+ * The camera is set up from the bounding boxes of the renderers in the same way as in View.
+ * Renderers which depend on a View, such as TextRenderer and the pyramid renderers, are not supported.
+ *
+ * RenderToImage uses the main GL context of FAST, and must be updated from the thread which this context belongs to.
+ */
+class FAST_EXPORT RenderToImage : public ProcessObject, protected QOpenGLFunctions_3_3_Core {
+    FAST_OBJECT(RenderToImage)
+    public:
+        void addRenderer(Renderer::pointer renderer);
+        void removeAllRenderers();
+        std::vector<Renderer::pointer> getRenderers() const;
+        /**
+         * Set size of the output images in pixels. Default is 512x512.
+         * @param width
+         * @param height
+         */
+        void setSize(uint width, uint height);
+        void set2DMode();
+        void set3DMode();
+        void setBackgroundColor(Color color);
+        /**
+         * In benchmark mode, OpenGL is synchronized after each renderer has drawn, and the draw time of each
+         * renderer is measured. The runtimes are named "draw <renderer name> <renderer nr>" and are available through
+         * getAllRuntimes(). Runtime measurements are enabled by this mode. Default is false.
+         * @param benchmark
+         */
+        void setBenchmarkMode(bool benchmark);
+        ~RenderToImage();
+    private:
+        RenderToImage();
+        void execute() override;
+        void makeContextCurrent();
+        void createFramebuffer();
+        void recalculateCamera();
+
+        std::vector<Renderer::pointer> m_renderers;
+        QOpenGLContext* m_context;
+        QOffscreenSurface* m_surface;
+        uint m_width = 512;
+        uint m_height = 512;
+        bool m_2DMode = false;
+        bool m_benchmark = false;
+        Color m_backgroundColor = Color::White();
+        int m_executeToken = 0;
+
+        uint m_FBO = 0;
+        uint m_textureColor = 0;
+        uint m_textureDepth = 0;
+        uint m_framebufferWidth = 0;
+        uint m_framebufferHeight = 0;
+
+        std::vector<uchar> m_pixels;
+
+        bool m_cameraIsSet = false;
+        Matrix4f m_perspectiveMatrix;
+        Affine3f m_viewingTransformation;
+        float m_zNear, m_zFar;
+};
+
+}
@@ -0,0 +1,69 @@
+#include "FAST/Testing.hpp"
+#include "FAST/Visualization/RenderToImage/RenderToImage.hpp"
+#include "FAST/Visualization/ImageRenderer/ImageRenderer.hpp"
+#include "FAST/Visualization/TriangleRenderer/TriangleRenderer.hpp"
+#include "FAST/Importers/ImageFileImporter.hpp"
+#include "FAST/Streamers/ImageFileStreamer.hpp"
+#include "FAST/Algorithms/SurfaceExtraction/SurfaceExtraction.hpp"
+#include "FAST/Exporters/StreamToFileExporter.hpp"
+#include "FAST/Data/Image.hpp"
+
+using namespace fast;
+
+TEST_CASE("RenderToImage renders 2D image to an RGB image", "[fast][RenderToImage]") {
+    auto importer = ImageFileImporter::New();
+    importer->setFilename(Config::getTestDataPath() + "US/US-2D.jpg");
+
+    auto renderer = ImageRenderer::New();
+    renderer->addInputConnection(importer->getOutputPort());
+
+    auto renderToImage = RenderToImage::New();
+    renderToImage->addRenderer(renderer);
+    renderToImage->set2DMode();
+    renderToImage->setSize(320, 240);
+    renderToImage->setBackgroundColor(Color::Black());
+    auto image = renderToImage->updateAndGetOutputData<Image>();
+
+    CHECK(image->getWidth() == 320);
+    CHECK(image->getHeight() == 240);
+    CHECK(image->getDataType() == TYPE_UINT8);
+    CHECK(image->getNrOfChannels() == 3);
+    // The ultrasound image covers the center of the frame
+    auto access = image->getImageAccess(ACCESS_READ);
+    bool hasContent = false;
+    for(int x = 140; x < 180 && !hasContent; ++x)
+        hasContent = access->getScalar(Vector2i(x, 120), 0) > 0;
+    CHECK(hasContent);
+}
+
+TEST_CASE("RenderToImage renders stream of 3D surfaces to files", "[fast][RenderToImage]") {
+    auto streamer = ImageFileStreamer::New();
+    streamer->setFilenameFormat(Config::getTestDataPath() + "/US/Ball/US-3Dt_#.mhd");
+    streamer->setMaximumNumberOfFrames(5);
+
+    auto extractor = SurfaceExtraction::New();
+    extractor->setInputConnection(streamer->getOutputPort());
+    extractor->setThreshold(200);
+
+    auto renderer = TriangleRenderer::New();
+    renderer->addInputConnection(extractor->getOutputPort());
+
+    auto renderToImage = RenderToImage::New();
+    renderToImage->addRenderer(renderer);
+    renderToImage->setBenchmarkMode(true);
+
+    auto exporter = StreamToFileExporter::New();
+    exporter->setInputConnection(renderToImage->getOutputPort());
+    exporter->setPath("RenderToImageTest");
+    exporter->setFormat(StreamToFileExporter::Format::SINGLE_FILE);
+    auto port = renderToImage->getOutputPort();
+    Image::pointer image;
+    do {
+        exporter->update();
+        image = port->getNextFrame<Image>();
+    } while(!image->isLastFrame());
+    exporter->flush();
+
+    CHECK(exporter->getFrameCounter() == 5);
+    CHECK(renderToImage->getRuntime("draw TriangleRenderer 0")->getSum() > 0);
+}
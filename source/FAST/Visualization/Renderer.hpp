@@ -91,6 +91,7 @@ class FAST_EXPORT  Renderer : public ProcessObject, protected QOpenGLFunctions_3
          */
         void unlock();
         friend class View;
+        friend class RenderToImage;
 
         View* m_view;
     private:
@@ -8,19 +8,17 @@ void SegmentationRenderer::setColor(Segmentation::LabelType labelType,
         Color color) {
     mLabelColors[labelType] = color;
     mColorsModified = true;
-    deleteAllTextures();
 }
 
 void SegmentationRenderer::setFillArea(Segmentation::LabelType labelType,
         bool fillArea) {
     mLabelFillArea[labelType] = fillArea;
     mFillAreaModified = true;
-    deleteAllTextures();
 }
 
 void SegmentationRenderer::setFillArea(bool fillArea) {
     mFillArea = fillArea;
-    deleteAllTextures();
+    mFillAreaModified = true;
 }
 
 void SegmentationRenderer::loadAttributes() {
@@ -39,7 +37,10 @@ SegmentationRenderer::SegmentationRenderer() {
     createFloatAttribute("opacity", "Segmentation Opacity", "", mOpacity);
     createStringAttribute("label-colors", "Label color", "Label color set as <label1> <color1> <label2> <color2>", "");
 
-    createOpenCLProgram(Config::getKernelSourcePath() + "/Visualization/SegmentationRenderer/SegmentationRenderer.cl");
+    createShaderProgram({
+        Config::getKernelSourcePath() + "/Visualization/ImageRenderer/ImageRenderer.vert",
+        Config::getKernelSourcePath() + "/Visualization/SegmentationRenderer/SegmentationRenderer.frag",
+    });
     mIsModified = false;
     mColorsModified = true;
     mFillAreaModified = true;
@@ -62,60 +63,46 @@ SegmentationRenderer::SegmentationRenderer() {
     mLabelColors[Segmentation::LABEL_BLUE] = Color::Blue();
 }
 
+SegmentationRenderer::~SegmentationRenderer() {
+    if(mColorTexture != 0)
+        glDeleteTextures(1, &mColorTexture);
+}
+
 void
 SegmentationRenderer::draw(Matrix4f perspectiveMatrix, Matrix4f viewingMatrix, float zNear, float zFar, bool mode2D) {
     std::lock_guard<std::mutex> lock(mMutex);
     if(mDataToRender.empty())
         return;
-    OpenCLDevice::pointer device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
 
-
-    if(mColorsModified) {
-        // Transfer colors to device (this doesn't have to happen every render call..)
-        std::unique_ptr<float[]> colorData(new float[3*mLabelColors.size()]);
-        std::unordered_map<int, Color>::iterator it;
-        for(it = mLabelColors.begin(); it != mLabelColors.end(); it++) {
-            colorData[it->first*3] = it->second.getRedValue();
-            colorData[it->first*3+1] = it->second.getGreenValue();
-            colorData[it->first*3+2] = it->second.getBlueValue();
+    if(mColorsModified || mFillAreaModified || mColorTexture == 0) {
+        // Transfer colors and fill area of each label to a lookup texture (this doesn't have to happen every render call..)
+        std::vector<float> colorData(4*256, 0.0f);
+        for(int label = 0; label < 256; ++label)
+            colorData[label*4 + 3] = mFillArea ? 1.0f : 0.0f;
+        for(auto&& labelColor : mLabelColors) {
+            if(labelColor.first < 0 || labelColor.first > 255)
+                continue;
+            colorData[labelColor.first*4] = labelColor.second.getRedValue();
+            colorData[labelColor.first*4 + 1] = labelColor.second.getGreenValue();
+            colorData[labelColor.first*4 + 2] = labelColor.second.getBlueValue();
         }
-
-        mColorBuffer = cl::Buffer(
-                device->getContext(),
-                CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
-                sizeof(float)*3*mLabelColors.size(),
-                colorData.get()
-        );
-    }
-
-    if(mFillAreaModified) {
-        // Transfer colors to device (this doesn't have to happen every render call..)
-        std::unique_ptr<char[]> fillAreaData(new char[mLabelColors.size()]);
-        std::unordered_map<int, Color>::iterator it;
-        for(it = mLabelColors.begin(); it != mLabelColors.end(); it++) {
-            if(mLabelFillArea.count(it->first) == 0) {
-                // Use default value
-                fillAreaData[it->first] = mFillArea;
-            } else {
-                fillAreaData[it->first] = mLabelFillArea[it->first];
-            }
+        for(auto&& fillArea : mLabelFillArea) {
+            if(fillArea.first < 0 || fillArea.first > 255)
+                continue;
+            colorData[fillArea.first*4 + 3] = fillArea.second ? 1.0f : 0.0f;
         }
 
-        mFillAreaBuffer = cl::Buffer(
-                device->getContext(),
-                CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
-                sizeof(char)*mLabelColors.size(),
-                fillAreaData.get()
-        );
+        if(mColorTexture == 0)
+            glGenTextures(1, &mColorTexture);
+        glBindTexture(GL_TEXTURE_2D, mColorTexture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, 256, 1, 0, GL_RGBA, GL_FLOAT, colorData.data());
+        glBindTexture(GL_TEXTURE_2D, 0);
+        mColorsModified = false;
+        mFillAreaModified = false;
     }
 
-    mKernel = cl::Kernel(getOpenCLProgram(device), "renderToTexture");
-    mKernel.setArg(2, mColorBuffer);
-    mKernel.setArg(3, mFillAreaBuffer);
-    mKernel.setArg(4, mBorderRadius);
-    mKernel.setArg(5, mOpacity);
-
-
     for(auto it : mDataToRender) {
         Image::pointer input = std::static_pointer_cast<Image>(it.second);
         uint inputNr = it.first;
@@ -123,109 +110,54 @@ SegmentationRenderer::draw(Matrix4f perspectiveMatrix, Matrix4f viewingMatrix, f
         if(input->getDimensions() != 2)
             throw Exception("SegmentationRenderer only supports 2D images. Use ImageSlicer to extract a 2D slice from a 3D image.");
 
-        if(input->getDataType() != TYPE_UINT8)
-            throw Exception("SegmentationRenderer only support images with dat type uint8.");
+        // Labels are sampled as unsigned integers in the shader
+        GLint internalFormat;
+        GLenum type;
+        std::size_t bytesPerPixel;
+        switch(input->getDataType()) {
+            case TYPE_UINT8:
+                internalFormat = GL_R8UI;
+                type = GL_UNSIGNED_BYTE;
+                bytesPerPixel = 1;
+                break;
+            case TYPE_UINT16:
+                internalFormat = GL_R16UI;
+                type = GL_UNSIGNED_SHORT;
+                bytesPerPixel = 2;
+                break;
+            default:
+                throw Exception("SegmentationRenderer only supports images with data type uint8 or uint16.");
+        }
 
         // Check if a texture has already been created for this image
         if(mTexturesToRender.count(inputNr) > 0 && mImageUsed[inputNr] == input && mDataTimestamp[inputNr] == input->getTimestamp())
             continue; // If it has already been created, skip it
 
-        // If it has not been created, create the texture
-
-        OpenCLImageAccess::pointer access = input->getOpenCLImageAccess(ACCESS_READ, device);
-        cl::Image2D *clImage = access->get2DImage();
-
-        // Run kernel to fill the texture
-        cl::CommandQueue queue = device->getCommandQueue();
-
-        if (mTexturesToRender.count(inputNr) > 0) {
-            // Delete old texture
-            glDeleteTextures(1, &mTexturesToRender[inputNr]);
-            mTexturesToRender.erase(inputNr);
-            glDeleteVertexArrays(1, &mVAO[inputNr]);
-            mVAO.erase(inputNr);
-        }
+        // Upload the labels, colors and borders are created in the shader
+        ImageAccess::pointer access = input->getImageAccess(ACCESS_READ);
+        uploadTexture(inputNr, access->get(), input->getWidth(), input->getHeight(), internalFormat, GL_RED_INTEGER, type, bytesPerPixel, GL_NEAREST);
 
-        cl::Image2D image;
-        cl::ImageGL imageGL;
-        std::vector<cl::Memory> v;
-        GLuint textureID;
-        // TODO The GL-CL interop here is causing glClear to not work on AMD systems and therefore disabled
-        /*
-        if(DeviceManager::isGLInteropEnabled()) {
-            // Create OpenGL texture
-            glGenTextures(1, &textureID);
-            glBindTexture(GL_TEXTURE_2D, textureID);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, input->getWidth(), input->getHeight(), 0, GL_RGBA, GL_FLOAT, 0);
-
-            // Create CL-GL image
-            imageGL = cl::ImageGL(
-                    device->getContext(),
-                    CL_MEM_READ_WRITE,
-                    GL_TEXTURE_2D,
-                    0,
-                    textureID
-            );
-            glBindTexture(GL_TEXTURE_2D, 0);
-            glFinish();
-            mKernel.setArg(1, imageGL);
-            v.push_back(imageGL);
-            queue.enqueueAcquireGLObjects(&v);
-        } else {
-         */
-        image = cl::Image2D(
-                device->getContext(),
-                CL_MEM_READ_WRITE,
-                cl::ImageFormat(CL_RGBA, CL_FLOAT),
-                input->getWidth(), input->getHeight()
-        );
-        mKernel.setArg(1, image);
-        //}
-
-
-        mKernel.setArg(0, *clImage);
-        queue.enqueueNDRangeKernel(
-                mKernel,
-                cl::NullRange,
-                cl::NDRange(input->getWidth(), input->getHeight()),
-                cl::NullRange
-        );
-
-        /*if(DeviceManager::isGLInteropEnabled()) {
-            queue.enqueueReleaseGLObjects(&v);
-        } else {*/
-        // Copy data from CL image to CPU
-        auto data = make_uninitialized_unique<float[]>(input->getWidth() * input->getHeight() * 4);
-        queue.enqueueReadImage(
-                image,
-                CL_TRUE,
-                createOrigoRegion(),
-                createRegion(input->getWidth(), input->getHeight(), 1),
-                0, 0,
-                data.get()
-        );
-        // Copy data from CPU to GL texture
-        glGenTextures(1, &textureID);
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, input->getWidth(), input->getHeight(), 0, GL_RGBA, GL_FLOAT, data.get());
-        glBindTexture(GL_TEXTURE_2D, 0);
-        glFinish();
-        //}
-
-        mTexturesToRender[inputNr] = textureID;
         mImageUsed[inputNr] = input;
         mDataTimestamp[inputNr] = input->getTimestamp();
-        queue.finish();
     }
 
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     drawTextures(perspectiveMatrix, viewingMatrix, mode2D);
     glDisable(GL_BLEND);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void SegmentationRenderer::setTextureUniforms(uint inputNr) {
+    setShaderUniform("segmentation", 0);
+    setShaderUniform("colors", 1);
+    setShaderUniform("borderRadius", mBorderRadius);
+    setShaderUniform("opacity", mOpacity);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, mColorTexture);
+    glActiveTexture(GL_TEXTURE0);
 }
 
 void SegmentationRenderer::setBorderRadius(int radius) {
@@ -233,20 +165,17 @@ void SegmentationRenderer::setBorderRadius(int radius) {
         throw Exception("Border radius must be >= 0");
 
     mBorderRadius = radius;
-    deleteAllTextures();
 }
 
 void SegmentationRenderer::setOpacity(float opacity) {
     if(opacity < 0 || opacity > 1)
         throw Exception("SegmentationRenderer opacity has to be >= 0 and <= 1");
     mOpacity = opacity;
-    deleteAllTextures();
 }
 
 void SegmentationRenderer::setColor(int label, Color color) {
     mLabelColors[label] = color;
     mColorsModified = true;
-    deleteAllTextures();
 }
 
 }
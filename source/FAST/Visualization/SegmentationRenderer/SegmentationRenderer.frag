@@ -0,0 +1,55 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoord;
+
+uniform usampler2D segmentation;
+// Color (rgb) and whether to fill the area (a) of each label
+uniform sampler2D colors;
+uniform int borderRadius;
+uniform float opacity;
+
+vec4 getColor(ivec2 position, ivec2 size) {
+    // Default color
+    vec4 color = vec4(1, 1, 1, 0);
+
+    uint label = texelFetch(segmentation, position, 0).r;
+    // Only labels 1-255 have a color
+    if(label > 0u && label < 256u) {
+        vec4 labelColor = texelFetch(colors, ivec2(int(label), 0), 0);
+        // Fill area check
+        bool useColor = labelColor.a > 0.5;
+        if(!useColor) {
+            // Check neighbors
+            // If any neighbors have a different label, we are at the border
+            for(int a = -borderRadius; a <= borderRadius; ++a) {
+                for(int b = -borderRadius; b <= borderRadius; ++b) {
+                    ivec2 offset = ivec2(a, b);
+                    ivec2 neighbor = position + offset;
+                    uint neighborLabel = 0u;
+                    if(all(greaterThanEqual(neighbor, ivec2(0))) && all(lessThan(neighbor, size)))
+                        neighborLabel = texelFetch(segmentation, neighbor, 0).r;
+                    if(neighborLabel != label && (borderRadius == 1 || length(vec2(offset)) < float(borderRadius)))
+                        useColor = true;
+                }
+            }
+        }
+        if(useColor)
+            color = vec4(labelColor.rgb, opacity);
+    }
+    return color;
+}
+
+void main()
+{
+    // Interpolate the colors of the four nearest pixels, as linear filtering of a color texture would do
+    ivec2 size = textureSize(segmentation, 0);
+    vec2 position = TexCoord*vec2(size) - 0.5;
+    ivec2 base = ivec2(floor(position));
+    vec2 fraction = position - floor(position);
+    vec4 color00 = getColor(clamp(base, ivec2(0), size - 1), size);
+    vec4 color10 = getColor(clamp(base + ivec2(1, 0), ivec2(0), size - 1), size);
+    vec4 color01 = getColor(clamp(base + ivec2(0, 1), ivec2(0), size - 1), size);
+    vec4 color11 = getColor(clamp(base + ivec2(1, 1), ivec2(0), size - 1), size);
+    FragColor = mix(mix(color00, color10, fraction.x), mix(color01, color11, fraction.x), fraction.y);
+}
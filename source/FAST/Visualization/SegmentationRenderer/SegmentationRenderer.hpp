@@ -19,9 +19,11 @@ class FAST_EXPORT  SegmentationRenderer : public ImageRenderer {
         void setBorderRadius(int radius);
         void setOpacity(float opacity);
         void loadAttributes() override;
+        ~SegmentationRenderer();
     private:
         SegmentationRenderer();
         void draw(Matrix4f perspectiveMatrix, Matrix4f viewingMatrix, float zNear, float zFar, bool mode2D) override;
+        void setTextureUniforms(uint inputNr) override;
 
         bool mColorsModified;
         bool mFillAreaModified;
@@ -31,7 +33,8 @@ class FAST_EXPORT  SegmentationRenderer : public ImageRenderer {
         bool mFillArea;
         int mBorderRadius = 1;
         float mOpacity = 1;
-        cl::Buffer mColorBuffer, mFillAreaBuffer;
+        // Lookup texture with color and fill area of each label
+        uint mColorTexture = 0;
 };
 
 } // end namespace fast
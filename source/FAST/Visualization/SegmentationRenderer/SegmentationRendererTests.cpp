@@ -157,3 +157,27 @@ TEST_CASE("SegmentationRenderer on a stream of thresholded 2D images and set dif
 }
 
 
+
+TEST_CASE("SegmentationRenderer on a 2D image with uint16 labels", "[fast][SegmentationRenderer][visual]") {
+    const int width = 256;
+    const int height = 256;
+    std::vector<ushort> labels(width*height);
+    for(int y = 0; y < height; ++y) {
+        for(int x = 0; x < width; ++x) {
+            // Labels above 255 have no color and are not drawn
+            labels[x + y*width] = x < 64 ? 0 : (x < 128 ? 1 : (x < 192 ? 2 : 1000));
+        }
+    }
+    auto image = Image::New();
+    image->create(width, height, TYPE_UINT16, 1, labels.data());
+
+    SegmentationRenderer::pointer renderer = SegmentationRenderer::New();
+    renderer->addInputData(image);
+    renderer->setColor(2, Color::Red());
+
+    SimpleWindow::pointer window = SimpleWindow::New();
+    window->set2DMode();
+    window->addRenderer(renderer);
+    window->setTimeout(1000);
+    CHECK_NOTHROW(window->start());
+}
@@ -124,6 +124,11 @@ void VectorFieldColorRenderer::draw(Matrix4f perspectiveMatrix, Matrix4f viewing
     glDisable(GL_BLEND);
 }
 
+void VectorFieldColorRenderer::setTextureUniforms(uint inputNr) {
+    // Texture is already colored by the kernel
+    setShaderUniform("useWindow", false);
+}
+
 void VectorFieldColorRenderer::setMaxOpacity(float maxOpacity) {
     if(maxOpacity <= 0.0f || maxOpacity > 1.0f)
         throw Exception("Max opacity must be within (0.0, 1.0]");
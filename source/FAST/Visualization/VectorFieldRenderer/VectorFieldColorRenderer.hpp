@@ -17,6 +17,7 @@ class FAST_EXPORT VectorFieldColorRenderer : public ImageRenderer {
     private:
         VectorFieldColorRenderer();
         void draw(Matrix4f perspectiveMatrix, Matrix4f viewingMatrix, float zNear, float zFar, bool mode2D) override;
+        void setTextureUniforms(uint inputNr) override;
 
         float m_maxOpacity = 0.5f;
         float m_maxLength = -1.0;
@@ -1,6 +1,8 @@
 #include "Window.hpp"
+#include "FAST/DeviceManager.hpp"
 #include <QApplication>
 #include <QOffscreenSurface>
+#include <QOpenGLContext>
 #include <QEventLoop>
 #include <QScreen>
 #include <QIcon>
@@ -9,6 +11,7 @@
 namespace fast {
 
 QGLContext* Window::mMainGLContext = NULL;
+bool Window::mHeadless = false;
 
 class FAST_EXPORT FASTApplication : public QApplication {
 public:
@@ -112,6 +115,12 @@ void Window::initializeQtApp() {
     // First: Tell Qt where to finds its plugins
     QCoreApplication::setLibraryPaths({ Config::getQtPluginsPath().c_str() }); // Removes need for qt.conf
 
+    if(isHeadlessRenderingEnabled()) {
+        DeviceManager::disableGLInterop();
+        if(qgetenv("QT_QPA_PLATFORM").isEmpty())
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
     // Make sure only one QApplication is created
     if(!QApplication::instance()) {
         Reporter::info() << "Creating new QApp" << Reporter::end();
@@ -134,7 +143,21 @@ void Window::initializeQtApp() {
     }
 
      // Create computation GL context, if it doesn't exist
-    if(mMainGLContext == NULL) {
+    if(mMainGLContext == NULL && isHeadlessRenderingEnabled()) {
+        Reporter::info() << "Creating new offscreen GL context for headless rendering" << Reporter::end();
+
+        // The context is kept current on an offscreen surface in this thread
+        QSurfaceFormat format = QGLFormat::toSurfaceFormat(View::getGLFormat());
+        QOffscreenSurface* surface = new QOffscreenSurface;
+        surface->setFormat(format);
+        surface->create();
+        QOpenGLContext* context = new QOpenGLContext;
+        context->setFormat(format);
+        if(!context->create() || !context->makeCurrent(surface)) {
+            throw Exception("Unable to create offscreen GL context for headless rendering");
+        }
+        mMainGLContext = QGLContext::fromOpenGLContext(context);
+    } else if(mMainGLContext == NULL) {
         Reporter::info() << "Creating new GL context for computation thread" << Reporter::end();
 
         // Create GL context to be shared with the CL contexts
@@ -242,6 +265,18 @@ void Window::setTimeout(unsigned int milliseconds) {
     mTimeout = milliseconds;
 }
 
+void Window::enableHeadlessRendering() {
+    mHeadless = true;
+}
+
+bool Window::isHeadlessRenderingEnabled() {
+#if defined(__linux__)
+    if(qgetenv("DISPLAY").isEmpty() && qgetenv("WAYLAND_DISPLAY").isEmpty())
+        return true;
+#endif
+    return mHeadless;
+}
+
 QGLContext* Window::getMainGLContext() {
     if(mMainGLContext == NULL) {
         //throw Exception("No OpenGL context created");
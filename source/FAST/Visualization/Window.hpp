@@ -20,6 +20,15 @@ class FAST_EXPORT  Window : public QObject, public Object {
     Q_OBJECT
     public:
         static void initializeQtApp();
+        /**
+         * Render without a display. Must be called before any window, renderer or OpenCL device is created.
+         * The main GL context is then created on an offscreen surface, using the Qt offscreen platform
+         * plugin unless QT_QPA_PLATFORM is set (e.g. to eglfs for EGL surfaceless rendering).
+         * OpenGL interop is disabled. Use RenderToImage to render frames to images.
+         * Headless rendering is enabled automatically on Linux if neither DISPLAY nor WAYLAND_DISPLAY is set.
+         */
+        static void enableHeadlessRendering();
+        static bool isHeadlessRenderingEnabled();
         static QGLContext* getMainGLContext();
         static void setMainGLContext(QGLContext* context);
         /**
@@ -77,6 +86,7 @@ class FAST_EXPORT  Window : public QObject, public Object {
         std::vector<SharedPointer<ProcessObject>> m_processObjects;
     private:
         static QGLContext* mMainGLContext;
+        static bool mHeadless;
     public slots:
         void stop();
 